@@ -58,6 +58,26 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
             "Prints detail message before and after each command.",
             cxxopts::value<bool>()
         )
+        (
+            "overlay",
+            "Path to a JSON overlay (e.g. written by --autotune) that overrides the execution options of DML dispatchables",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "serve",
+            "Runs as a server on a local socket at this path, keeping the device and loaded models resident between requests",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "connect",
+            "Sends the model to a server started with --serve at this socket path instead of running it in this process",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "server_request",
+            "Request sent with --connect: run, load, unload, or shutdown",
+            cxxopts::value<std::string>()->default_value("run")
+        )
         ;
 
     // TIMING OPTIONS
@@ -87,6 +107,33 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
             "Max number of warmup samples to discard from timing statistics",
             cxxopts::value<uint32_t>()
         )
+        (
+            "target_precision",
+            "Enables adaptive iterations: dispatches until the 95% confidence interval of the hot median is narrower than this "
+            "fraction of the median (e.g. 0.01), with warmup detected automatically. Iterations are capped by -i and -t (default 10000 ms)",
+            cxxopts::value<double>()
+        )
+        (
+            "arrival_rate",
+            "Dispatches open-loop: requests arrive at this rate (per second) regardless of whether earlier dispatches "
+            "have completed, and queueing delay, service time, and end-to-end latency percentiles are reported",
+            cxxopts::value<double>()
+        )
+        (
+            "arrival_process",
+            "Distribution of open-loop arrivals: fixed or poisson",
+            cxxopts::value<std::string>()->default_value("fixed")
+        )
+        (
+            "arrival_trace",
+            "Dispatches open-loop with arrival times (in milliseconds, one per line) replayed from a text file",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "arrival_seed",
+            "Random seed for poisson arrivals",
+            cxxopts::value<uint32_t>()->default_value("0")
+        )
         (
             "v,timing_verbosity",
             "Timing verbosity level. 0 = show hot timings, 1 = init/cold/hot timings, 2 = show all timing info",
@@ -97,6 +144,26 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
             "Determines the size of the GPU timestamp buffer. A value of 0 will disable GPU timing.",
             cxxopts::value<uint32_t>()
         )
+        (
+            "trace",
+            "Writes a timeline of CPU phases, GPU work, and transfer counters to a Chrome Trace Event JSON file (view with chrome://tracing or ui.perfetto.dev)",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "sweep_results",
+            "Writes the timings of each point in the model's sweeps to a CSV file",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "autotune",
+            "Times each DML dispatchable with every combination of execution options and writes the fastest valid options to a JSON overlay",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "autotune_tolerance",
+            "Max relative difference from the model's own options before an autotune variant's output is rejected (float data types only)",
+            cxxopts::value<double>()->default_value("0.001")
+        )
         ;
 
     // DIRECTX OPTIONS
@@ -128,7 +195,17 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         )
         (
             "clear_shader_caches", 
-            "Clears D3D shader caches before running commands", 
+            "Clears D3D shader caches, the HLSL shader cache, and the ONNX model cache before running commands", 
+            cxxopts::value<bool>()
+        )
+        (
+            "hlsl_cache_path",
+            "Directory of the persistent cache of compiled HLSL dispatchables (default: <temp>/dxdispatch/hlsl_cache)",
+            cxxopts::value<std::filesystem::path>()
+        )
+        (
+            "disable_hlsl_cache",
+            "Always compile HLSL dispatchables with DXC instead of loading them from the HLSL shader cache",
             cxxopts::value<bool>()
         )
         (
@@ -171,6 +248,16 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
             "1.1, 2.0, 2.1, 3.0, 3.1, 4.0, 4.1, 5.0, 5.1, 5.2, 6.0, 6.1, 6.2",
             cxxopts::value<std::string>()->default_value("6.2f")
         )
+        (
+            "fuse_dml_dispatches",
+            "Compiles consecutive DML dispatch commands connected through intermediate resources into one graph",
+            cxxopts::value<bool>()
+        )
+        (
+            "lean_host_memory",
+            "Frees host copies of buffer initial values and DML operator descs once they are on the GPU",
+            cxxopts::value<bool>()
+        )
         // DxDispatch generates root signatures that are guaranteed to match HLSL source, which eliminates
         // having to write it inline in the HLSL file. DXC for Xbox precompiles shaders for Xbox (by default), 
         // but precompilation requires the root signature to be in the HLSL source itself; to allow use of the
@@ -247,6 +334,16 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
             "Captures a json file of the CPU and GPU execution that can be viewed in a chromium-based browser.",
             cxxopts::value<bool>()
         )
+        (
+            "onnx_streams",
+            "Comma-separated numbers of concurrent streams to benchmark ONNX dispatchables with. Example: --onnx_streams 1,2,4,8",
+            cxxopts::value<std::string>()
+        )
+        (
+            "onnx_cache_path",
+            "Directory of a persistent cache of optimized ONNX models. Disabled by default.",
+            cxxopts::value<std::filesystem::path>()
+        )
         ;
 
     options.positional_help("<PATH_TO_MODEL>");
@@ -264,6 +361,7 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
     if (result.count("dispatch_iterations"))
     {
         m_dispatchIterations = result["dispatch_iterations"].as<uint32_t>();
+        m_dispatchIterationsSpecified = true;
     }
     
     if (result.count("dispatch_repeat"))
@@ -275,6 +373,7 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
     {
         m_timeToRunInMilliseconds.emplace(result["milliseconds_to_run"].as<uint32_t>());
         m_dispatchIterations = std::numeric_limits<uint32_t>::max();   // override the "iterations" setting
+        m_dispatchIterationsSpecified = true;
     }
 
     if (result.count("dispatch_interval"))
@@ -287,6 +386,62 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         m_maxWarmupSamples =result["warmup_samples"].as<uint32_t>();
     }
 
+    if (result.count("target_precision"))
+    {
+        m_targetPrecision = result["target_precision"].as<double>();
+
+        // Adaptive runs stop once the target precision is reached, so they are only bounded by an explicit iteration
+        // count or a time limit (which defaults to 10 seconds).
+        if (!result.count("milliseconds_to_run"))
+        {
+            m_timeToRunInMilliseconds = 10000;
+            if (!result.count("dispatch_iterations"))
+            {
+                m_dispatchIterations = std::numeric_limits<uint32_t>::max();
+            }
+        }
+    }
+
+    if (result.count("arrival_rate"))
+    {
+        m_arrivalRate = result["arrival_rate"].as<double>();
+    }
+
+    if (result.count("arrival_process"))
+    {
+        auto value = result["arrival_process"].as<std::string>();
+        if (value == "fixed")
+        {
+            m_arrivalProcess = ArrivalSchedule::Process::Fixed;
+        }
+        else if (value == "poisson")
+        {
+            m_arrivalProcess = ArrivalSchedule::Process::Poisson;
+        }
+        else
+        {
+            throw std::invalid_argument("Unexpected value for arrival_process. Must be 'fixed' or 'poisson'");
+        }
+    }
+
+    if (result.count("arrival_trace"))
+    {
+        m_arrivalTracePath = result["arrival_trace"].as<std::filesystem::path>();
+    }
+
+    if (result.count("arrival_seed"))
+    {
+        m_arrivalSeed = result["arrival_seed"].as<uint32_t>();
+    }
+
+    // A single request says nothing about latency under load, so without -i or -t open-loop runs dispatch every 
+    // arrival in the schedule instead of one iteration. Generated schedules are unbounded, so they stop at a time 
+    // limit that defaults to 10 seconds.
+    if (m_arrivalRate && !m_arrivalTracePath && !result.count("dispatch_iterations") && !m_timeToRunInMilliseconds)
+    {
+        m_timeToRunInMilliseconds = 10000;
+    }
+
     if (result.count("model")) 
     { 
         m_modelPath = result["model"].as<std::filesystem::path>();
@@ -327,6 +482,50 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         m_maxGpuTimeMeasurements = result["max_gpu_time_measurements"].as<uint32_t>();
     }
 
+    if (result.count("trace"))
+    {
+        m_tracePath = result["trace"].as<std::filesystem::path>();
+    }
+
+    if (result.count("sweep_results"))
+    {
+        m_sweepResultsPath = result["sweep_results"].as<std::filesystem::path>();
+    }
+
+    if (result.count("autotune"))
+    {
+        m_autotunePath = result["autotune"].as<std::filesystem::path>();
+    }
+
+    if (result.count("autotune_tolerance"))
+    {
+        m_autotuneTolerance = result["autotune_tolerance"].as<double>();
+    }
+
+    if (result.count("overlay"))
+    {
+        m_overlayPath = result["overlay"].as<std::filesystem::path>();
+    }
+
+    if (result.count("serve"))
+    {
+        m_servePath = result["serve"].as<std::filesystem::path>();
+    }
+
+    if (result.count("connect"))
+    {
+        m_connectPath = result["connect"].as<std::filesystem::path>();
+    }
+
+    if (result.count("server_request"))
+    {
+        m_serverRequest = result["server_request"].as<std::string>();
+        if (m_serverRequest != "run" && m_serverRequest != "load" && m_serverRequest != "unload" && m_serverRequest != "shutdown")
+        {
+            throw std::invalid_argument("Unexpected value for server_request. Must be 'run', 'load', 'unload', or 'shutdown'");
+        }
+    }
+
     if (result.count("show_dependencies"))
     {
         m_showDependencies = result["show_dependencies"].as<bool>();
@@ -342,6 +541,25 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         m_clearShaderCaches = result["clear_shader_caches"].as<bool>();
     }
 
+    if (result.count("hlsl_cache_path"))
+    {
+        m_hlslShaderCachePath = result["hlsl_cache_path"].as<std::filesystem::path>();
+    }
+    else
+    {
+        std::error_code error;
+        auto tempPath = std::filesystem::temp_directory_path(error);
+        if (!error)
+        {
+            m_hlslShaderCachePath = tempPath / c_projectName / "hlsl_cache";
+        }
+    }
+
+    if (result.count("disable_hlsl_cache"))
+    {
+        m_disableHlslShaderCache = result["disable_hlsl_cache"].as<bool>();
+    }
+
     if (result.count("disable_gpu_timeout"))
     {
         m_disableGpuTimeout = result["disable_gpu_timeout"].as<bool>();
@@ -403,6 +621,16 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         m_dmlFeatureLevel = GetDmlFeatureLevelFromString(result["dml_feature_level"].as<std::string>());
     }
 
+    if (result.count("fuse_dml_dispatches"))
+    {
+        m_fuseDmlDispatches = result["fuse_dml_dispatches"].as<bool>();
+    }
+
+    if (result.count("lean_host_memory"))
+    {
+        m_leanHostMemory = result["lean_host_memory"].as<bool>();
+    }
+
     if (result.count("queue_type"))
     {
         auto temp = result["queue_type"];
@@ -551,6 +779,37 @@ CommandLineArgs::CommandLineArgs(int argc, char** argv)
         m_onnxProfilingEnabled = result["enable_onnx_profiling"].as<bool>();
     }
 
+    if (result.count("onnx_streams"))
+    {
+        auto streamCounts = result["onnx_streams"].as<std::string>();
+        size_t startPos = 0;
+        while (startPos != std::string::npos)
+        {
+            size_t endPos = streamCounts.find(",", startPos);
+            auto streamCount = streamCounts.substr(startPos, endPos == std::string::npos ? std::string::npos : endPos - startPos);
+            unsigned long value = 0;
+            try
+            {
+                value = std::stoul(streamCount);
+            }
+            catch (const std::exception&)
+            {
+                value = 0;
+            }
+            if (value == 0 || value > 1024)
+            {
+                throw std::invalid_argument("Unexpected value for onnx_streams. Must be a comma-separated list of stream counts between 1 and 1024");
+            }
+            m_onnxStreamCounts.push_back(static_cast<uint32_t>(value));
+            startPos = endPos == std::string::npos ? std::string::npos : endPos + 1;
+        }
+    }
+
+    if (result.count("onnx_cache_path"))
+    {
+        m_onnxModelCachePath = result["onnx_cache_path"].as<std::filesystem::path>();
+    }
+
     m_helpText = options.help();
 }
 
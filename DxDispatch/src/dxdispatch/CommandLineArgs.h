@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PixCaptureHelper.h"
+#include "LoadGenerator.h"
 
 enum TimingVerbosity
 {
@@ -24,6 +25,8 @@ public:
     uint32_t MaxGpuTimeMeasurements() const { return m_maxGpuTimeMeasurements; }
     bool ForceDisablePrecompiledShadersOnXbox() const { return m_forceDisablePrecompiledShadersOnXbox; }
     bool ClearShaderCaches() const { return m_clearShaderCaches; }
+    bool HlslShaderCacheEnabled() const { return !m_disableHlslShaderCache && !m_hlslShaderCachePath.empty(); }
+    const std::filesystem::path& HlslShaderCachePath() const { return m_hlslShaderCachePath; }
     bool DisableGpuTimeout() const { return m_disableGpuTimeout; }
     bool EnableDred() const { return m_enableDred; }
     bool DisableBackgroundProcessing() const { return m_disableBackgroundProcessing; }
@@ -35,14 +38,30 @@ public:
     const std::optional<std::filesystem::path>& ModelPath() const { return m_modelPath; }
     const std::optional<std::filesystem::path>& InputPath() const { return m_inputRelPath;; }
     const std::optional<std::filesystem::path>& OutputPath() const { return m_outputRelPath; }
+    const std::optional<std::filesystem::path>& TracePath() const { return m_tracePath; }
+    const std::optional<std::filesystem::path>& SweepResultsPath() const { return m_sweepResultsPath; }
+    const std::optional<std::filesystem::path>& AutotunePath() const { return m_autotunePath; }
+    double AutotuneTolerance() const { return m_autotuneTolerance; }
+    const std::optional<std::filesystem::path>& OverlayPath() const { return m_overlayPath; }
+    const std::optional<std::filesystem::path>& ServePath() const { return m_servePath; }
+    const std::optional<std::filesystem::path>& ConnectPath() const { return m_connectPath; }
+    const std::string& ServerRequest() const { return m_serverRequest; }
 
     DML_FEATURE_LEVEL DmlFeatureLevel() const { return m_dmlFeatureLevel; }
+    bool FuseDmlDispatches() const { return m_fuseDmlDispatches; }
+    bool LeanHostMemory() const { return m_leanHostMemory; }
     const std::string& HelpText() const { return m_helpText; }
     uint32_t DispatchIterations() const { return m_dispatchIterations; }
+    bool DispatchIterationsSpecified() const { return m_dispatchIterationsSpecified; } // Set by -i or -t, not the default
     uint32_t DispatchRepeat() const { return m_dispatchRepeat; }
     std::optional<uint32_t> TimeToRunInMilliseconds() const { return m_timeToRunInMilliseconds; }
     uint32_t MinimumDispatchIntervalInMilliseconds() const { return m_minDispatchIntervalInMilliseconds; }
     uint32_t MaxWarmupSamples() const { return m_maxWarmupSamples; }
+    std::optional<double> TargetPrecision() const { return m_targetPrecision; }
+    std::optional<double> ArrivalRate() const { return m_arrivalRate; }
+    ArrivalSchedule::Process ArrivalProcess() const { return m_arrivalProcess; }
+    const std::optional<std::filesystem::path>& ArrivalTracePath() const { return m_arrivalTracePath; }
+    uint32_t ArrivalSeed() const { return m_arrivalSeed; }
     D3D12_COMMAND_LIST_TYPE CommandListType() const 
     {
         if (D3D12_COMMAND_LIST_TYPE_NONE == m_commandListType)
@@ -69,6 +88,8 @@ public:
     bool PrintVerboseOnnxBindingInfo() const { return m_onnxPrintVerboseBindingInfo; } 
     bool OrtExtensionsEnabled() const { return m_ortExtensionsEnabled; }
     bool OnnxProfilingEnabled() const { return m_onnxProfilingEnabled; }
+    const std::optional<std::filesystem::path>& OnnxModelCachePath() const { return m_onnxModelCachePath; }
+    gsl::span<const uint32_t> OnnxStreamCounts() const { return m_onnxStreamCounts; }
 
     void SetAdapter(IAdapter* adapter);
 private:
@@ -81,6 +102,8 @@ private:
     uint32_t m_maxGpuTimeMeasurements = 8192;
     bool m_forceDisablePrecompiledShadersOnXbox = true;
     bool m_clearShaderCaches = false;
+    bool m_disableHlslShaderCache = false;
+    std::filesystem::path m_hlslShaderCachePath;
     bool m_disableGpuTimeout = false;
     bool m_enableDred = false;
     bool m_disableBackgroundProcessing = false;
@@ -91,17 +114,33 @@ private:
     bool m_uavBarrierAfterDispatch = true;
     bool m_aliasingBarrierAfterDispatch = false;
     DML_FEATURE_LEVEL m_dmlFeatureLevel = DML_FEATURE_LEVEL_5_0;
+    bool m_fuseDmlDispatches = false;
+    bool m_leanHostMemory = false;
     std::string m_adapterSubstring = "";
     std::optional<std::filesystem::path> m_modelPath;
     std::optional<std::filesystem::path> m_inputRelPath;
     std::optional<std::filesystem::path> m_outputRelPath;
+    std::optional<std::filesystem::path> m_tracePath;
+    std::optional<std::filesystem::path> m_sweepResultsPath;
+    std::optional<std::filesystem::path> m_autotunePath;
+    double m_autotuneTolerance = 0.001;
+    std::optional<std::filesystem::path> m_overlayPath;
+    std::optional<std::filesystem::path> m_servePath;
+    std::optional<std::filesystem::path> m_connectPath;
+    std::string m_serverRequest = "run";
     std::string m_pixCaptureName = "dxdispatch";
     std::string m_helpText;
     uint32_t m_dispatchIterations = 1;
+    bool m_dispatchIterationsSpecified = false;
     uint32_t m_dispatchRepeat = 1;
     std::optional<uint32_t> m_timeToRunInMilliseconds = {};
     uint32_t m_minDispatchIntervalInMilliseconds = 0;
     uint32_t m_maxWarmupSamples = 1;
+    std::optional<double> m_targetPrecision;
+    std::optional<double> m_arrivalRate;
+    ArrivalSchedule::Process m_arrivalProcess = ArrivalSchedule::Process::Fixed;
+    std::optional<std::filesystem::path> m_arrivalTracePath;
+    uint32_t m_arrivalSeed = 0;
 
     // Tools like PIX generally work better when work is recorded into a graphics queue, so it's set as the default here.
     D3D12_COMMAND_LIST_TYPE m_commandListType = D3D12_COMMAND_LIST_TYPE_NONE;
@@ -129,6 +168,8 @@ private:
     bool m_onnxPrintVerboseBindingInfo = false;
     bool m_ortExtensionsEnabled = false;
     bool m_onnxProfilingEnabled = false;
+    std::optional<std::filesystem::path> m_onnxModelCachePath;
+    std::vector<uint32_t> m_onnxStreamCounts;
     bool m_commandPrinting = false;
 };
 
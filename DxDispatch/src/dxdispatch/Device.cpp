@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "Device.h"
+#ifndef WIN32
+#include <time.h>
+#endif
 
 using Microsoft::WRL::ComPtr;
 
@@ -366,6 +369,8 @@ Microsoft::WRL::ComPtr<ID3D12Resource> Device::CreateCustomBuffer(
         nullptr, 
         IID_GRAPHICS_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
 
+    DXD_PERF_COUNTER_ADD(resourcesCreated, 1);
+    DXD_PERF_COUNTER_ADD(bytesAllocated, sizeInBytes);
     return resource;
 }
 
@@ -387,6 +392,8 @@ ComPtr<ID3D12Resource> Device::CreateDefaultBuffer(
         nullptr, 
         IID_GRAPHICS_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
 
+    DXD_PERF_COUNTER_ADD(resourcesCreated, 1);
+    DXD_PERF_COUNTER_ADD(bytesAllocated, sizeInBytes);
     return resource;
 }
 
@@ -408,6 +415,8 @@ ComPtr<ID3D12Resource> Device::CreateUploadBuffer(
         nullptr,
         IID_GRAPHICS_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
 
+    DXD_PERF_COUNTER_ADD(resourcesCreated, 1);
+    DXD_PERF_COUNTER_ADD(bytesAllocated, sizeInBytes);
     return resource;
 }
 
@@ -429,14 +438,25 @@ ComPtr<ID3D12Resource> Device::CreateReadbackBuffer(
         nullptr,
         IID_GRAPHICS_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
 
+    DXD_PERF_COUNTER_ADD(resourcesCreated, 1);
+    DXD_PERF_COUNTER_ADD(bytesAllocated, sizeInBytes);
     return resource;
 }
 
 void Device::WaitForGpuWorkToComplete()
 {
+#if DXD_PERF_COUNTERS
+    auto waitStart = std::chrono::steady_clock::now();
+#endif
+
     uint64_t nextFenceValue = m_fence->GetCompletedValue() + 1;
     THROW_IF_FAILED(m_queue->Signal(m_fence.Get(), nextFenceValue));
     THROW_IF_FAILED(m_fence->SetEventOnCompletion(nextFenceValue, nullptr));
+
+#if DXD_PERF_COUNTERS
+    DXD_PERF_COUNTER_ADD(fenceWaits, 1);
+    DXD_PERF_COUNTER_ADD(fenceWaitNanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count());
+#endif
 }
 
 void Device::RecordInitialize(IDMLDispatchable* dispatchable, IDMLBindingTable* bindingTable)
@@ -493,59 +513,81 @@ Microsoft::WRL::ComPtr<ID3D12Resource> Device::Upload(uint64_t totalSize, gsl::s
         throw std::invalid_argument("Attempting to upload more data than the size of the buffer");
     }
 
-    ComPtr<ID3D12Resource> buffer;
-    ComPtr<ID3D12Resource> uploadBuffer;
-    ComPtr<ID3D12Resource> resourceToMap;
+    ComPtr<ID3D12Resource> buffer = m_useCustomHeaps ? CreateCustomBuffer(totalSize) : CreateDefaultBuffer(totalSize);
 
-    if (m_useCustomHeaps)
+    if (!name.empty())
     {
-        buffer = CreateCustomBuffer(totalSize);
-        resourceToMap = data.empty() ? nullptr : buffer;
+        buffer->SetName(name.data());
     }
-    else
+
+    if (!data.empty())
     {
-        buffer = CreateDefaultBuffer(totalSize);
-        uploadBuffer = data.empty() ? nullptr : CreateUploadBuffer(totalSize);
-        uploadBuffer->SetName(L"Device::Upload");
-        resourceToMap = uploadBuffer;
+        Upload(buffer.Get(), data);
     }
 
-    if (!name.empty())
+    return buffer;
+}
+
+void Device::Upload(ID3D12Resource* buffer, gsl::span<const std::byte> data)
+{
+    uint64_t totalSize = buffer->GetDesc().Width;
+    if (data.size() > totalSize)
     {
-        buffer->SetName(name.data());
+        throw std::invalid_argument("Attempting to upload more data than the size of the buffer");
     }
 
-    if (resourceToMap)
+    ComPtr<ID3D12Resource> uploadBuffer;
+    ID3D12Resource* resourceToMap = buffer;
+    if (!IsCpuReadable(buffer))
     {
-        void* mappedBufferData = nullptr;
-        THROW_IF_FAILED(resourceToMap->Map(0, nullptr, &mappedBufferData));
-        memcpy(mappedBufferData, data.data(), data.size());
-        resourceToMap->Unmap(0, nullptr);
+        uploadBuffer = CreateUploadBuffer(totalSize);
+        uploadBuffer->SetName(L"Device::Upload");
+        resourceToMap = uploadBuffer.Get();
+    }
+
+    // The bytes after the data are zeroed, as they are in a newly created buffer.
+    void* mappedBufferData = nullptr;
+    THROW_IF_FAILED(resourceToMap->Map(0, nullptr, &mappedBufferData));
+    memcpy(mappedBufferData, data.data(), data.size());
+    memset(static_cast<std::byte*>(mappedBufferData) + data.size(), 0, static_cast<size_t>(totalSize - data.size()));
+    resourceToMap->Unmap(0, nullptr);
+    TraceRecorder::Get().IncrementCounter("Bytes uploaded", data.size());
 
-        if (resourceToMap == uploadBuffer)
+    if (uploadBuffer)
+    {
+        D3D12_RESOURCE_BARRIER barriers[] =
         {
-            D3D12_RESOURCE_BARRIER barriers[] =
-            {
-                CD3DX12_RESOURCE_BARRIER::Transition(
-                    buffer.Get(),
-                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                    D3D12_RESOURCE_STATE_COPY_DEST)
-            };
-
-            m_commandList->ResourceBarrier(_countof(barriers), barriers);
-            m_commandList->CopyResource(buffer.Get(), uploadBuffer.Get());
-            std::swap(barriers[0].Transition.StateBefore, barriers[0].Transition.StateAfter);
-            m_commandList->ResourceBarrier(_countof(barriers), barriers);
-
-            m_temporaryResources.push_back(std::move(uploadBuffer));
-        }
+            CD3DX12_RESOURCE_BARRIER::Transition(
+                buffer,
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                D3D12_RESOURCE_STATE_COPY_DEST)
+        };
+
+        m_commandList->ResourceBarrier(_countof(barriers), barriers);
+        m_commandList->CopyResource(buffer, uploadBuffer.Get());
+        std::swap(barriers[0].Transition.StateBefore, barriers[0].Transition.StateAfter);
+        m_commandList->ResourceBarrier(_countof(barriers), barriers);
+
+        m_temporaryResources.push_back(std::move(uploadBuffer));
     }
+}
 
-    return buffer;
+bool Device::IsCpuReadable(ID3D12Resource* buffer)
+{
+    // Can't assume the buffer was created as a custom heap (e.g., ONNX dispatchable with a deferred
+    // resource allocated by the DML EP), so check the heap properties.
+    D3D12_HEAP_PROPERTIES heapProps = {};
+    D3D12_HEAP_FLAGS heapFlags = {};
+
+    return SUCCEEDED(buffer->GetHeapProperties(&heapProps, &heapFlags)) && 
+        heapProps.MemoryPoolPreference == D3D12_MEMORY_POOL_L0 && 
+        heapProps.CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
 }
 
 std::vector<std::byte> Device::Download(Microsoft::WRL::ComPtr<ID3D12Resource> buffer)
 {
+    TraceScope traceScope("Download");
+
     if (buffer->GetDesc().Width > std::numeric_limits<size_t>::max())
     {
         throw std::invalid_argument(fmt::format("Buffer width '{}' is too large.", buffer->GetDesc().Width));
@@ -553,14 +595,7 @@ std::vector<std::byte> Device::Download(Microsoft::WRL::ComPtr<ID3D12Resource> b
 
     ComPtr<ID3D12Resource> resourceToMap;
 
-    // Can't assume the input buffer was created as a custom heap (e.g., ONNX dispatchable with a deferred
-    // resource allocated by the DML EP), so check the heap properties.
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    D3D12_HEAP_FLAGS heapFlags = {};
-
-    if (SUCCEEDED(buffer->GetHeapProperties(&heapProps, &heapFlags)) && 
-        heapProps.MemoryPoolPreference == D3D12_MEMORY_POOL_L0 && 
-        heapProps.CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE)
+    if (IsCpuReadable(buffer.Get()))
     {
         resourceToMap = buffer;
     }
@@ -592,16 +627,41 @@ std::vector<std::byte> Device::Download(Microsoft::WRL::ComPtr<ID3D12Resource> b
     THROW_IF_FAILED(resourceToMap->Map(0, &readRange, &mappedBufferData));
     memcpy(outputBuffer.data(), mappedBufferData, dataSize);
     resourceToMap->Unmap(0, nullptr);
+    TraceRecorder::Get().IncrementCounter("Bytes downloaded", dataSize);
 
     return outputBuffer;
 }
 
+void Device::RecordCopy(ID3D12Resource* destination, ID3D12Resource* source)
+{
+    D3D12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            destination,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_COPY_DEST),
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            source,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_COPY_SOURCE)
+    };
+
+    m_commandList->ResourceBarrier(_countof(barriers), barriers);
+    m_commandList->CopyResource(destination, source);
+    for (auto& barrier : barriers)
+    {
+        std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+    }
+    m_commandList->ResourceBarrier(_countof(barriers), barriers);
+}
+
 void Device::ExecuteCommandList()
 {
     THROW_IF_FAILED(m_commandList->Close());
 
     ID3D12CommandList* commandLists[] = { m_commandList.Get() };
     m_queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    DXD_PERF_COUNTER_ADD(commandListSubmissions, 1);
     THROW_IF_FAILED(m_commandList->Reset(m_commandAllocator.Get(), nullptr));
 }
 
@@ -611,6 +671,7 @@ void Device::ExecuteCommandListAndWait()
 
     ID3D12CommandList* commandLists[] = { m_commandList.Get() };
     m_queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    DXD_PERF_COUNTER_ADD(commandListSubmissions, 1);
     WaitForGpuWorkToComplete();
     THROW_IF_FAILED(m_d3d->GetDeviceRemovedReason());
     THROW_IF_FAILED(m_commandAllocator->Reset());
@@ -662,7 +723,23 @@ std::vector<uint64_t> Device::ResolveTimestamps()
     return timestamps;
 }
 
-std::vector<double> Device::ResolveTimingSamples()
+// Reads the CPU clock that ID3D12CommandQueue::GetClockCalibration reports, returning the timestamp and its ticks per
+// second: the performance counter on Windows, and CLOCK_MONOTONIC in nanoseconds on Linux (WSL).
+static std::pair<uint64_t, uint64_t> GetCalibrationCpuTimestamp()
+{
+#ifdef WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return { static_cast<uint64_t>(counter.QuadPart), static_cast<uint64_t>(frequency.QuadPart) };
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return { static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec), 1000000000ull };
+#endif
+}
+
+std::vector<double> Device::ResolveTimingSamples(std::string_view traceLabel)
 {
     std::vector<uint64_t> timestamps = ResolveTimestamps();
     if (timestamps.empty())
@@ -681,6 +758,30 @@ std::vector<double> Device::ResolveTimingSamples()
         samples[i] = double(timestampDelta) / frequency / m_dispatchRepeat;
     }
 
+    auto& trace = TraceRecorder::Get();
+    if (trace.IsEnabled())
+    {
+        // The calibration pair samples the GPU and CPU clocks at the same instant. Reading the CPU clock again
+        // alongside the trace clock gives the trace time of that instant, which anchors the GPU timestamps on the
+        // same timeline as CPU spans.
+        uint64_t gpuCalibrationTimestamp, cpuCalibrationTimestamp;
+        THROW_IF_FAILED(m_queue->GetClockCalibration(&gpuCalibrationTimestamp, &cpuCalibrationTimestamp));
+        auto [cpuTimestamp, cpuFrequency] = GetCalibrationCpuTimestamp();
+        double calibrationTraceTime = trace.NowInMicroseconds() - 
+            double(int64_t(cpuTimestamp - cpuCalibrationTimestamp)) * 1e6 / cpuFrequency;
+
+        auto ToTraceTime = [&](uint64_t timestamp)
+        {
+            return calibrationTraceTime - double(int64_t(gpuCalibrationTimestamp - timestamp)) * 1e6 / frequency;
+        };
+
+        for (uint32_t i = 0; i < samples.size(); ++i) 
+        {
+            double start = ToTraceTime(timestamps[2 * i]);
+            trace.AddGpuSpan(traceLabel, start, ToTraceTime(timestamps[2 * i + 1]) - start);
+        }
+    }
+
     return samples;
 }
 
@@ -745,34 +846,48 @@ void Device::ClearShaderCaches()
     }
 }
 
-/*static*/ uint32_t Device::GetSizeInBytes(DML_TENSOR_DATA_TYPE dataType)
+/*static*/ uint32_t Device::GetSizeInBits(DML_TENSOR_DATA_TYPE dataType)
 {
     switch (dataType)
     {
+        case DML_TENSOR_DATA_TYPE_INT4:
+        case DML_TENSOR_DATA_TYPE_UINT4:
+            return 4;
+
         case DML_TENSOR_DATA_TYPE_INT8:
         case DML_TENSOR_DATA_TYPE_UINT8:
-            return 1;
+            return 8;
 
         case DML_TENSOR_DATA_TYPE_FLOAT16:
         case DML_TENSOR_DATA_TYPE_INT16:
         case DML_TENSOR_DATA_TYPE_UINT16:
-            return 2;
+            return 16;
 
         case DML_TENSOR_DATA_TYPE_FLOAT32:
         case DML_TENSOR_DATA_TYPE_INT32:
         case DML_TENSOR_DATA_TYPE_UINT32:
-            return 4;
+            return 32;
     
         case DML_TENSOR_DATA_TYPE_FLOAT64:
         case DML_TENSOR_DATA_TYPE_INT64:
         case DML_TENSOR_DATA_TYPE_UINT64:
-            return 8;
+            return 64;
 
         default:
             throw std::invalid_argument("Unknown data type");
     }
 }
 
+/*static*/ uint32_t Device::GetSizeInBytes(DML_TENSOR_DATA_TYPE dataType)
+{
+    uint32_t sizeInBits = GetSizeInBits(dataType);
+    if (sizeInBits % 8 != 0)
+    {
+        throw std::invalid_argument("Data type elements are smaller than a byte");
+    }
+    return sizeInBits / 8;
+}
+
 /*static*/ DXGI_FORMAT Device::GetDxgiFormatFromDmlTensorDataType(DML_TENSOR_DATA_TYPE dataType)
 {
     switch (dataType)
@@ -103,8 +103,9 @@ public:
     // This is a blocking call that forces the CPU and GPU to sync.
     std::vector<uint64_t> ResolveTimestamps();
 
-    // Calls ResolveTimestamps() and converts timestamp pairs into timing samples.
-    std::vector<double> ResolveTimingSamples();
+    // Calls ResolveTimestamps() and converts timestamp pairs into timing samples. If tracing is enabled, 
+    // the timestamp pairs are also added to the trace's GPU track using the given label.
+    std::vector<double> ResolveTimingSamples(std::string_view traceLabel = "GPU work");
 
     bool GpuTimingEnabled() const { return m_timestampCapacity > 0; }
 
@@ -115,10 +116,22 @@ public:
 
     Microsoft::WRL::ComPtr<ID3D12Resource> Upload(uint64_t totalSize, gsl::span<const std::byte> data, std::wstring_view name = {});
 
+    // Records an upload that overwrites an existing buffer with the data followed by zeros.
+    void Upload(ID3D12Resource* buffer, gsl::span<const std::byte> data);
+
     std::vector<std::byte> Download(Microsoft::WRL::ComPtr<ID3D12Resource>);
 
+    // Records a copy of one buffer into another of the same size.
+    void RecordCopy(ID3D12Resource* destination, ID3D12Resource* source);
+
+    // True if the buffer is in a CPU-visible custom heap and can be mapped without a copy.
+    static bool IsCpuReadable(ID3D12Resource* buffer);
+
     void ClearShaderCaches();
 
+    static uint32_t GetSizeInBits(DML_TENSOR_DATA_TYPE dataType);
+
+    // Size of a single element. Throws for packed types smaller than a byte (e.g. INT4).
     static uint32_t GetSizeInBytes(DML_TENSOR_DATA_TYPE dataType);
     static DXGI_FORMAT GetDxgiFormatFromDmlTensorDataType(DML_TENSOR_DATA_TYPE dataType);
 
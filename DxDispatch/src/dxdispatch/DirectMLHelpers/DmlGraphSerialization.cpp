@@ -0,0 +1,384 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma warning(push)
+#pragma warning(disable:4244)
+// FlatBuffers does not downcast explicitly in few places like vector_downward.h, verifier.h
+// which causes possible loss of data warning.
+#include <unordered_set>
+#include "DmlGraphDesc_generated.h"
+#include "AbstractOperatorDesc.h"
+#include "DmlGraphSerialization.h"
+
+using FlatbufferStringVector = flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>;
+using FlatbufferAttributeOffset = flatbuffers::Offset<dml::ir::operatorFieldTypes::AttributeDesc>;
+
+flatbuffers::Offset<dml::ir::operatorFieldTypes::Activation> SerializeActivation(
+    flatbuffers::FlatBufferBuilder& builder,
+    const AbstractOperatorDesc& activationDesc);
+
+FlatbufferAttributeOffset SerializeAttribute(
+    flatbuffers::FlatBufferBuilder& builder,
+    const OperatorField& field)
+{
+    namespace fieldTypes = dml::ir::operatorFieldTypes;
+
+    const DML_SCHEMA_FIELD* schemaField = field.GetSchema();
+    auto name = builder.CreateString(schemaField->Name);
+
+    switch (schemaField->Type)
+    {
+        case DML_SCHEMA_FIELD_TYPE_OPERATOR_DESC:
+        {
+            const auto& activation = field.AsFusedActivationOperatorDesc();
+            if (!activation)
+            {
+                return fieldTypes::CreateAttributeDesc(builder, name);
+            }
+            auto value = SerializeActivation(builder, *activation);
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_Activation, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_OPERATOR_DESC_ARRAY:
+        {
+            const auto& activations = field.AsFusedActivationOperatorDescArray();
+            if (!activations)
+            {
+                return fieldTypes::CreateAttributeDesc(builder, name);
+            }
+            std::vector<flatbuffers::Offset<fieldTypes::Activation>> values;
+            for (const auto& activation : *activations)
+            {
+                values.push_back(SerializeActivation(builder, activation));
+            }
+            auto value = fieldTypes::CreateActivationArray(builder, builder.CreateVector(values));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_ActivationArray, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_UINT:
+        {
+            auto value = builder.CreateStruct(fieldTypes::UInt32(field.AsUInt()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_UInt32, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_UINT64:
+        {
+            auto value = builder.CreateStruct(fieldTypes::UInt64(field.AsUInt64()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_UInt64, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_INT:
+        {
+            auto value = builder.CreateStruct(fieldTypes::Int32(field.AsInt()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_Int32, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_FLOAT:
+        {
+            auto value = builder.CreateStruct(fieldTypes::Float32(field.AsFloat()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_Float32, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_UINT_ARRAY:
+        {
+            auto value = fieldTypes::CreateUIntArray(builder, builder.CreateVector(field.AsUIntArray()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_UIntArray, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_INT_ARRAY:
+        {
+            auto value = fieldTypes::CreateIntArray(builder, builder.CreateVector(field.AsIntArray()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_IntArray, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_FLOAT_ARRAY:
+        {
+            auto value = fieldTypes::CreateFloatArray(builder, builder.CreateVector(field.AsFloatArray()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_FloatArray, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_SCALE_BIAS:
+        {
+            const auto& scaleBias = field.AsScaleBias();
+            if (!scaleBias)
+            {
+                return fieldTypes::CreateAttributeDesc(builder, name);
+            }
+            auto value = builder.CreateStruct(fieldTypes::ScaleBias(scaleBias->Scale, scaleBias->Bias));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_ScaleBias, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_SIZE_2D:
+        {
+            const auto& size2d = field.AsSize2D();
+            auto value = builder.CreateStruct(fieldTypes::Size2D(size2d.Width, size2d.Height));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_Size2D, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_SCALAR_UNION:
+        {
+            const auto& scalarUnion = field.AsScalarUnion();
+            flatbuffers::span<const uint8_t, 8> bytes(reinterpret_cast<const uint8_t*>(scalarUnion.Bytes), 8);
+            auto byteArray = builder.CreateStruct(fieldTypes::ByteArray(bytes));
+            auto value = fieldTypes::CreateScalarUnionData(builder, fieldTypes::ScalarVariant_ByteArray, byteArray.Union());
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_ScalarUnionData, value.Union());
+        }
+        case DML_SCHEMA_FIELD_TYPE_BOOL:
+        {
+            auto value = builder.CreateStruct(fieldTypes::Bool(field.AsBool()));
+            return fieldTypes::CreateAttributeDesc(builder, name, fieldTypes::AttributeFieldVariant_Bool, value.Union());
+        }
+        default:
+        {
+            throw std::invalid_argument("Invalid attribute type.");
+        }
+    }
+}
+
+std::vector<FlatbufferAttributeOffset> SerializeAttributes(
+    flatbuffers::FlatBufferBuilder& builder,
+    const AbstractOperatorDesc& operatorDesc)
+{
+    std::vector<FlatbufferAttributeOffset> attributes;
+    for (const OperatorField& field : operatorDesc.fields)
+    {
+        if (field.GetSchema()->Kind == DML_SCHEMA_FIELD_KIND_ATTRIBUTE)
+        {
+            attributes.push_back(SerializeAttribute(builder, field));
+        }
+    }
+    return attributes;
+}
+
+// Fused activations only record their type and attributes; their tensors are implied by the parent operator.
+flatbuffers::Offset<dml::ir::operatorFieldTypes::Activation> SerializeActivation(
+    flatbuffers::FlatBufferBuilder& builder,
+    const AbstractOperatorDesc& activationDesc)
+{
+    auto type = builder.CreateString(ApiTraits::StringifyHelpers::ToString(activationDesc.schema->OperatorType));
+    auto attributes = builder.CreateVector(SerializeAttributes(builder, activationDesc));
+    return dml::ir::operatorFieldTypes::CreateActivation(builder, type, attributes);
+}
+
+flatbuffers::Offset<dml::ir::DmlBufferTensorDesc> SerializeBufferTensorDesc(
+    flatbuffers::FlatBufferBuilder& builder,
+    const DmlBufferTensorDesc& tensorDesc)
+{
+    auto dataType = builder.CreateString(ApiTraits::StringifyHelpers::ToString(tensorDesc.dataType));
+    auto sizes = builder.CreateVector(tensorDesc.sizes);
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> strides = 0;
+    if (tensorDesc.strides)
+    {
+        strides = builder.CreateVector(*tensorDesc.strides);
+    }
+    return dml::ir::CreateDmlBufferTensorDesc(builder, dataType, sizes, strides, tensorDesc.totalTensorSizeInBytes);
+}
+
+// Only present tensors are serialized; absent optional tensors are identified by an empty edge name.
+flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<dml::ir::DmlBufferTensorDesc>>> SerializeBufferTensorDescs(
+    flatbuffers::FlatBufferBuilder& builder,
+    const std::vector<const DmlBufferTensorDesc*>& tensorDescs)
+{
+    std::vector<flatbuffers::Offset<dml::ir::DmlBufferTensorDesc>> serializedDescs;
+    for (const DmlBufferTensorDesc* tensorDesc : tensorDescs)
+    {
+        if (tensorDesc)
+        {
+            serializedDescs.push_back(SerializeBufferTensorDesc(builder, *tensorDesc));
+        }
+    }
+    return builder.CreateVector(serializedDescs);
+}
+
+flatbuffers::Offset<FlatbufferStringVector> SerializeNames(
+    flatbuffers::FlatBufferBuilder& builder,
+    const std::vector<std::string>& names)
+{
+    std::vector<flatbuffers::Offset<flatbuffers::String>> serializedNames;
+    for (const std::string& name : names)
+    {
+        serializedNames.push_back(builder.CreateString(name));
+    }
+    return builder.CreateVector(serializedNames);
+}
+
+uint32_t GetNodeOutputCount(const DmlSerializedGraphNode& node)
+{
+    if (std::holds_alternative<AbstractOperatorDesc>(node.Desc))
+    {
+        return static_cast<uint32_t>(std::get<AbstractOperatorDesc>(node.Desc).GetOutputTensors().size());
+    }
+    return 1; // Constant nodes have a single output.
+}
+
+/*
+* Edges are not serialized directly. Instead, each node lists an edge name for every input and output (the
+* same layout DeserializeDmlGraph expects):
+* - Each node output that is present is named with the graph output name, if any, or "<node>_output<i>".
+* - Each node input is named after the graph input or node output it is connected to.
+* - Absent optional inputs and outputs have an empty name.
+*/
+flatbuffers::DetachedBuffer SerializeDmlGraph(const DmlSerializedGraphDesc& graphDesc)
+{
+    const uint32_t nodeCount = static_cast<uint32_t>(graphDesc.Nodes.size());
+
+    std::vector<std::string> graphInputNames(graphDesc.InputCount);
+    for (uint32_t index = 0; index < graphDesc.InputCount; index++)
+    {
+        graphInputNames[index] = "input" + std::to_string(index);
+    }
+    for (const auto& edge : graphDesc.InputEdges)
+    {
+        if (edge.GraphInputIndex >= graphDesc.InputCount)
+        {
+            throw std::invalid_argument("Input edge refers to graph input " + std::to_string(edge.GraphInputIndex) +
+                                        ", but the graph only has " + std::to_string(graphDesc.InputCount) + " inputs.");
+        }
+        if (!edge.Name.empty())
+        {
+            graphInputNames[edge.GraphInputIndex] = edge.Name;
+        }
+    }
+
+    std::vector<std::string> graphOutputNames(graphDesc.OutputCount);
+    for (uint32_t index = 0; index < graphDesc.OutputCount; index++)
+    {
+        graphOutputNames[index] = "output" + std::to_string(index);
+    }
+
+    // Name every node output.
+    std::vector<std::vector<std::string>> nodeOutputNames(nodeCount);
+    for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++)
+    {
+        const DmlSerializedGraphNode& node = graphDesc.Nodes[nodeIndex];
+        if (node.Name.empty())
+        {
+            throw std::invalid_argument("Graph node at index:" + std::to_string(nodeIndex) + " doesn't have any name");
+        }
+
+        nodeOutputNames[nodeIndex].resize(GetNodeOutputCount(node));
+        if (std::holds_alternative<AbstractOperatorDesc>(node.Desc))
+        {
+            auto outputTensors = std::get<AbstractOperatorDesc>(node.Desc).GetOutputTensors();
+            for (uint32_t outputIndex = 0; outputIndex < static_cast<uint32_t>(outputTensors.size()); outputIndex++)
+            {
+                if (outputTensors[outputIndex])
+                {
+                    nodeOutputNames[nodeIndex][outputIndex] = node.Name + "_output" + std::to_string(outputIndex);
+                }
+            }
+        }
+        else
+        {
+            nodeOutputNames[nodeIndex][0] = node.Name;
+        }
+    }
+
+    // A node output takes the name of the graph output it is connected to, so it can only be connected to one.
+    std::unordered_set<uint64_t> nodeOutputsWithGraphOutputs;
+    for (const auto& edge : graphDesc.OutputEdges)
+    {
+        if (edge.GraphOutputIndex >= graphDesc.OutputCount || edge.FromNodeIndex >= nodeCount ||
+            edge.FromNodeOutputIndex >= nodeOutputNames[edge.FromNodeIndex].size())
+        {
+            throw std::invalid_argument("Output edge to graph output " + std::to_string(edge.GraphOutputIndex) + " is out of range.");
+        }
+        if (!nodeOutputsWithGraphOutputs.insert((uint64_t(edge.FromNodeIndex) << 32) | edge.FromNodeOutputIndex).second)
+        {
+            throw std::invalid_argument("Output " + std::to_string(edge.FromNodeOutputIndex) + " of graph node '" + 
+                                        graphDesc.Nodes[edge.FromNodeIndex].Name + "' is connected to more than one graph output.");
+        }
+        if (!edge.Name.empty())
+        {
+            graphOutputNames[edge.GraphOutputIndex] = edge.Name;
+        }
+        nodeOutputNames[edge.FromNodeIndex][edge.FromNodeOutputIndex] = graphOutputNames[edge.GraphOutputIndex];
+    }
+
+    // Name every node input after the edge that feeds it.
+    std::vector<std::vector<std::string>> nodeInputNames(nodeCount);
+    for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++)
+    {
+        const DmlSerializedGraphNode& node = graphDesc.Nodes[nodeIndex];
+        if (std::holds_alternative<AbstractOperatorDesc>(node.Desc))
+        {
+            nodeInputNames[nodeIndex].resize(std::get<AbstractOperatorDesc>(node.Desc).GetInputTensors().size());
+        }
+    }
+
+    auto SetInputName = [&](uint32_t toNodeIndex, uint32_t toNodeInputIndex, const std::string& name)
+    {
+        if (toNodeIndex >= nodeCount || toNodeInputIndex >= nodeInputNames[toNodeIndex].size())
+        {
+            throw std::invalid_argument("Edge '" + name + "' targets a node input that is out of range.");
+        }
+        nodeInputNames[toNodeIndex][toNodeInputIndex] = name;
+    };
+
+    for (const auto& edge : graphDesc.InputEdges)
+    {
+        SetInputName(edge.ToNodeIndex, edge.ToNodeInputIndex, graphInputNames[edge.GraphInputIndex]);
+    }
+
+    for (const auto& edge : graphDesc.IntermediateEdges)
+    {
+        if (edge.FromNodeIndex >= edge.ToNodeIndex)
+        {
+            throw std::invalid_argument("Graph nodes must be in topological order, but node " + std::to_string(edge.FromNodeIndex) +
+                                        " is used as an input to node " + std::to_string(edge.ToNodeIndex) + ".");
+        }
+        if (edge.FromNodeOutputIndex >= nodeOutputNames[edge.FromNodeIndex].size())
+        {
+            throw std::invalid_argument("Intermediate edge from node " + std::to_string(edge.FromNodeIndex) + " is out of range.");
+        }
+        SetInputName(edge.ToNodeIndex, edge.ToNodeInputIndex, nodeOutputNames[edge.FromNodeIndex][edge.FromNodeOutputIndex]);
+    }
+
+    flatbuffers::FlatBufferBuilder builder;
+    std::vector<flatbuffers::Offset<dml::ir::DmlGraphNode>> nodes;
+    for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++)
+    {
+        const DmlSerializedGraphNode& node = graphDesc.Nodes[nodeIndex];
+
+        dml::ir::NodeDesc descType = dml::ir::NodeDesc_NONE;
+        flatbuffers::Offset<void> desc = 0;
+        if (std::holds_alternative<AbstractOperatorDesc>(node.Desc))
+        {
+            const auto& operatorDesc = std::get<AbstractOperatorDesc>(node.Desc);
+            auto inputTensors = operatorDesc.GetInputTensors();
+            for (uint32_t inputIndex = 0; inputIndex < static_cast<uint32_t>(inputTensors.size()); inputIndex++)
+            {
+                if (inputTensors[inputIndex] && nodeInputNames[nodeIndex][inputIndex].empty())
+                {
+                    throw std::invalid_argument("Input " + std::to_string(inputIndex) + " of graph node '" + node.Name + "' is not connected.");
+                }
+            }
+
+            auto type = builder.CreateString(ApiTraits::StringifyHelpers::ToString(operatorDesc.schema->OperatorType));
+            auto inputs = SerializeBufferTensorDescs(builder, inputTensors);
+            auto outputs = SerializeBufferTensorDescs(builder, operatorDesc.GetOutputTensors());
+            auto attributes = builder.CreateVector(SerializeAttributes(builder, operatorDesc));
+            descType = dml::ir::NodeDesc_OperatorNodeDesc;
+            desc = dml::ir::CreateOperatorNodeDesc(builder, type, inputs, outputs, attributes).Union();
+        }
+        else
+        {
+            const auto& constantVariant = std::get<DmlSerializedGraphNodeConstantVariant>(node.Desc);
+            if (std::holds_alternative<ConstantName>(constantVariant))
+            {
+                auto name = dml::ir::CreateConstantName(builder, builder.CreateString(std::get<ConstantName>(constantVariant).name));
+                desc = dml::ir::CreateConstantNodeDesc(builder, dml::ir::ConstantNodeDescDetail_ConstantName, name.Union()).Union();
+            }
+            else
+            {
+                const auto& constantData = std::get<ConstantData>(constantVariant);
+                auto data = builder.CreateVector(reinterpret_cast<const uint8_t*>(constantData.data), static_cast<size_t>(constantData.dataSize));
+                auto rawData = dml::ir::CreateConstantRawData(builder, data);
+                desc = dml::ir::CreateConstantNodeDesc(builder, dml::ir::ConstantNodeDescDetail_ConstantRawData, rawData.Union()).Union();
+            }
+            descType = dml::ir::NodeDesc_ConstantNodeDesc;
+        }
+
+        auto name = builder.CreateString(node.Name);
+        auto inputNames = SerializeNames(builder, nodeInputNames[nodeIndex]);
+        auto outputNames = SerializeNames(builder, nodeOutputNames[nodeIndex]);
+        nodes.push_back(dml::ir::CreateDmlGraphNode(builder, descType, desc, name, inputNames, outputNames));
+    }
+
+    auto serializedNodes = builder.CreateVector(nodes);
+    auto serializedInputNames = SerializeNames(builder, graphInputNames);
+    auto serializedOutputNames = SerializeNames(builder, graphOutputNames);
+    dml::ir::FinishDmlGraphDescBuffer(builder, dml::ir::CreateDmlGraphDesc(builder, serializedNodes, serializedInputNames, serializedOutputNames));
+
+    return builder.Release();
+}
+
+#pragma warning(pop)
@@ -0,0 +1,11 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#pragma once
+#include "flatbuffers/flatbuffers.h"
+#include "DmlSerializedGraphDesc.h"
+
+// Serializes a graph to the DmlGraphDesc flatbuffer format; this is the inverse of DeserializeDmlGraph. Nodes
+// must be in topological order and every node must have a unique name. Edge names are optional: graph inputs
+// and outputs without a name are named "input<i>" and "output<i>", and intermediate edges are named after the
+// node output they come from.
+flatbuffers::DetachedBuffer SerializeDmlGraph(const DmlSerializedGraphDesc& graphDesc);
@@ -0,0 +1,292 @@
+#include "pch.h"
+#include "Model.h"
+#include "Dispatchable.h"
+#include "DmlDispatchable.h"
+#include "DmlDispatchFusion.h"
+
+// Returns true if a tensor written by one DML operator can be read directly by another as a graph intermediate.
+static bool CanConnectTensors(const DmlBufferTensorDesc& producer, const DmlBufferTensorDesc& consumer)
+{
+    return producer.dataType == consumer.dataType &&
+        producer.sizes == consumer.sizes &&
+        producer.strides == consumer.strides &&
+        producer.totalTensorSizeInBytes == consumer.totalTensorSizeInBytes &&
+        !(consumer.flags & DML_TENSOR_FLAG_OWNED_BY_DML);
+}
+
+std::vector<DmlDispatchGroup> FindDmlDispatchGroups(const Model& model)
+{
+    using FusedGraphDesc = DmlDispatchable::FusedGraphDesc;
+
+    auto commands = model.GetCommands();
+    auto resourceCount = model.GetResourceDescs().size();
+    std::vector<DmlDispatchGroup> groups;
+
+    auto GetDmlDesc = [&](const Model::DispatchCommand& command) -> const Model::DmlDispatchableDesc*
+    {
+        return std::get_if<Model::DmlDispatchableDesc>(&model.GetDispatchable(command.dispatchableId).value);
+    };
+
+    auto FindTarget = [](const Model::BindingPlan& plan, std::string_view name) -> const Model::BindingPlan::Target*
+    {
+        auto target = std::find_if(plan.targets.begin(), plan.targets.end(), [&](auto& t) { return t.name == name; });
+        return target == plan.targets.end() ? nullptr : &*target;
+    };
+
+    // Commands that read each resource. Outputs of DML dispatches are the only bindings known to be write-only.
+    std::vector<std::vector<uint32_t>> readers(resourceCount);
+    for (uint32_t commandId = 0; commandId < commands.size(); commandId++)
+    {
+        auto& command = commands[commandId].command;
+        if (auto dispatchCommand = std::get_if<Model::DispatchCommand>(&command))
+        {
+            auto& plan = model.GetBindingPlan(dispatchCommand->bindingPlanId);
+            auto dmlDesc = GetDmlDesc(*dispatchCommand);
+            for (auto& source : plan.sources)
+            {
+                auto isOutput = dmlDesc && std::any_of(dmlDesc->bindPoints.outputs.begin(), dmlDesc->bindPoints.outputs.end(),
+                    [&](auto& bindPoint) { return bindPoint.name == plan.targets[source.targetIndex].name; });
+                if (!isOutput)
+                {
+                    readers[source.resourceId].push_back(commandId);
+                }
+            }
+        }
+        else if (auto printCommand = std::get_if<Model::PrintCommand>(&command))
+        {
+            readers[printCommand->resourceId].push_back(commandId);
+        }
+        else if (auto writeFileCommand = std::get_if<Model::WriteFileCommand>(&command))
+        {
+            readers[writeFileCommand->resourceId].push_back(commandId);
+        }
+    }
+
+    // Resources bound at initialization are read outside of any command.
+    for (auto& desc : model.GetDispatchableDescs())
+    {
+        auto dmlDesc = std::get_if<Model::DmlDispatchableDesc>(&desc.value);
+        if (dmlDesc && dmlDesc->initBindingPlanId != Model::InvalidId)
+        {
+            for (auto& source : model.GetBindingPlan(dmlDesc->initBindingPlanId).sources)
+            {
+                readers[source.resourceId].push_back(Model::InvalidId);
+            }
+        }
+    }
+
+    // State of the group being built.
+    struct Producer
+    {
+        uint32_t nodeIndex;
+        uint32_t outputIndex;
+        const DmlBufferTensorDesc* tensor;
+        uint64_t elementOffset;
+    };
+    std::vector<uint32_t> groupCommandIds;
+    std::vector<std::unique_ptr<AbstractOperatorDesc>> groupOperators; // Owns the tensor descs that producers point to.
+    std::vector<FusedGraphDesc::IntermediateEdge> groupIntermediates;
+    std::map<Model::ResourceId, Producer> groupProducers;
+    std::vector<bool> groupReads(resourceCount);
+
+    auto ResetGroup = [&]()
+    {
+        groupCommandIds.clear();
+        groupOperators.clear();
+        groupIntermediates.clear();
+        groupProducers.clear();
+        groupReads.assign(resourceCount, false);
+    };
+
+    auto CloseGroup = [&]()
+    {
+        if (groupCommandIds.size() < 2)
+        {
+            ResetGroup();
+            return;
+        }
+
+        DmlDispatchGroup group = {};
+        auto& graph = group.graph;
+        uint32_t lastCommandId = groupCommandIds.back();
+
+        for (uint32_t nodeIndex = 0; nodeIndex < groupCommandIds.size(); nodeIndex++)
+        {
+            auto& command = std::get<Model::DispatchCommand>(commands[groupCommandIds[nodeIndex]].command);
+            auto& dmlDesc = *GetDmlDesc(command);
+            auto& plan = model.GetBindingPlan(command.bindingPlanId);
+
+            group.name += (nodeIndex > 0 ? "+" : "") + command.dispatchableName;
+            graph.nodeNames.push_back(fmt::format("{}_{}", command.dispatchableName, nodeIndex));
+            graph.nodes.push_back(dmlDesc.desc);
+
+            // Graph edges are named after the node's bind points; the node index keeps the names unique when the same
+            // dispatchable appears more than once.
+            auto EdgeName = [&](const Model::DmlDispatchableDesc::BindPoint& bindPoint, uint32_t i)
+            {
+                return bindPoint.resourceCount > 1 ?
+                    fmt::format("{}:{}.{}[{}]", nodeIndex, command.dispatchableName, bindPoint.name, i) :
+                    fmt::format("{}:{}.{}", nodeIndex, command.dispatchableName, bindPoint.name);
+            };
+
+            uint32_t inputIndex = 0;
+            for (auto& bindPoint : dmlDesc.bindPoints.inputs)
+            {
+                for (uint32_t i = 0; bindPoint.requiredBinding && i < bindPoint.resourceCount; i++)
+                {
+                    bool isIntermediate = std::any_of(groupIntermediates.begin(), groupIntermediates.end(), [&](auto& edge)
+                    {
+                        return edge.toNodeIndex == nodeIndex && edge.toNodeInputIndex == inputIndex + i;
+                    });
+
+                    if (!isIntermediate)
+                    {
+                        graph.inputs.push_back({ EdgeName(bindPoint, i), nodeIndex, inputIndex + i });
+                        group.inputBindings.push_back({ bindPoint.name, i });
+                    }
+                }
+                inputIndex += bindPoint.resourceCount;
+            }
+
+            uint32_t outputIndex = 0;
+            for (auto& bindPoint : dmlDesc.bindPoints.outputs)
+            {
+                auto target = FindTarget(plan, bindPoint.name);
+                for (uint32_t i = 0; bindPoint.requiredBinding && i < bindPoint.resourceCount; i++)
+                {
+                    if (!target || i >= target->sourceCount)
+                    {
+                        continue;
+                    }
+
+                    // A resource consumed only by later operators in the group never needs to be written to memory.
+                    auto resourceId = plan.sources[target->firstSourceIndex + i].resourceId;
+                    bool isConsumed = std::any_of(groupIntermediates.begin(), groupIntermediates.end(), [&](auto& edge)
+                    {
+                        return edge.fromNodeIndex == nodeIndex && edge.fromNodeOutputIndex == outputIndex + i;
+                    });
+                    bool isReadElsewhere = std::any_of(readers[resourceId].begin(), readers[resourceId].end(), [&](uint32_t reader)
+                    {
+                        return reader <= groupCommandIds[nodeIndex] || reader > lastCommandId;
+                    });
+
+                    if (!isConsumed || isReadElsewhere)
+                    {
+                        graph.outputs.push_back({ EdgeName(bindPoint, i), nodeIndex, outputIndex + i });
+                        group.outputBindings.push_back({ bindPoint.name, i });
+                    }
+                }
+                outputIndex += bindPoint.resourceCount;
+            }
+        }
+
+        graph.executionFlags = GetDmlDesc(std::get<Model::DispatchCommand>(commands[groupCommandIds.front()].command))->executionFlags;
+        graph.intermediates = groupIntermediates;
+        group.commandIds = groupCommandIds;
+        groups.push_back(std::move(group));
+        ResetGroup();
+    };
+
+    for (uint32_t commandId = 0; commandId < commands.size(); commandId++)
+    {
+        auto command = std::get_if<Model::DispatchCommand>(&commands[commandId].command);
+        auto dmlDesc = command ? GetDmlDesc(*command) : nullptr;
+        if (!dmlDesc || !dmlDesc->desc || !model.GetBindingPlan(command->bindingPlanId).deferredSources.empty())
+        {
+            CloseGroup();
+            continue;
+        }
+
+        auto& plan = model.GetBindingPlan(command->bindingPlanId);
+        auto nodeOperator = std::make_unique<AbstractOperatorDesc>(SchemaHelpers::ConvertOperatorDesc(*dmlDesc->desc));
+        auto inputTensors = nodeOperator->GetInputTensors();
+        auto outputTensors = nodeOperator->GetOutputTensors();
+        auto nodeIndex = static_cast<uint32_t>(groupCommandIds.size());
+
+        bool canJoin = !groupCommandIds.empty() &&
+            dmlDesc->executionFlags == GetDmlDesc(std::get<Model::DispatchCommand>(commands[groupCommandIds.front()].command))->executionFlags;
+
+        std::vector<FusedGraphDesc::IntermediateEdge> edges;
+        uint32_t inputIndex = 0;
+        for (auto& bindPoint : dmlDesc->bindPoints.inputs)
+        {
+            auto target = FindTarget(plan, bindPoint.name);
+            for (uint32_t i = 0; target && i < target->sourceCount; i++)
+            {
+                auto& source = plan.sources[target->firstSourceIndex + i];
+                auto producer = groupProducers.find(source.resourceId);
+                if (producer == groupProducers.end())
+                {
+                    continue;
+                }
+
+                auto consumerTensor = inputIndex + i < inputTensors.size() ? inputTensors[inputIndex + i] : nullptr;
+                if (bindPoint.requiredBinding && bindPoint.resourceCount == 1 &&
+                    source.elementOffset == 0 && producer->second.elementOffset == 0 &&
+                    consumerTensor && producer->second.tensor && CanConnectTensors(*producer->second.tensor, *consumerTensor))
+                {
+                    edges.push_back({ producer->second.nodeIndex, producer->second.outputIndex, nodeIndex, inputIndex + i });
+                }
+                else
+                {
+                    canJoin = false;
+                }
+            }
+            inputIndex += bindPoint.resourceCount;
+        }
+
+        for (auto& bindPoint : dmlDesc->bindPoints.outputs)
+        {
+            auto target = FindTarget(plan, bindPoint.name);
+            for (uint32_t i = 0; target && i < target->sourceCount; i++)
+            {
+                auto resourceId = plan.sources[target->firstSourceIndex + i].resourceId;
+                if (groupProducers.count(resourceId) || groupReads[resourceId])
+                {
+                    canJoin = false;
+                }
+            }
+        }
+
+        if (!canJoin || edges.empty())
+        {
+            // Start a new group with this command.
+            CloseGroup();
+            edges.clear();
+            nodeIndex = 0;
+        }
+
+        groupCommandIds.push_back(commandId);
+        groupOperators.push_back(std::move(nodeOperator));
+        groupIntermediates.insert(groupIntermediates.end(), edges.begin(), edges.end());
+
+        for (auto& bindPoint : dmlDesc->bindPoints.inputs)
+        {
+            auto target = FindTarget(plan, bindPoint.name);
+            for (uint32_t i = 0; target && i < target->sourceCount; i++)
+            {
+                auto resourceId = plan.sources[target->firstSourceIndex + i].resourceId;
+                if (!groupProducers.count(resourceId))
+                {
+                    groupReads[resourceId] = true;
+                }
+            }
+        }
+
+        uint32_t outputIndex = 0;
+        for (auto& bindPoint : dmlDesc->bindPoints.outputs)
+        {
+            auto target = FindTarget(plan, bindPoint.name);
+            for (uint32_t i = 0; target && i < target->sourceCount; i++)
+            {
+                auto& source = plan.sources[target->firstSourceIndex + i];
+                auto tensor = outputIndex + i < outputTensors.size() ? outputTensors[outputIndex + i] : nullptr;
+                groupProducers[source.resourceId] = { nodeIndex, outputIndex + i, tensor, source.elementOffset };
+            }
+            outputIndex += bindPoint.resourceCount;
+        }
+    }
+    CloseGroup();
+
+    return groups;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Model.h"
+#include "Dispatchable.h"
+#include "DmlDispatchable.h"
+
+// Consecutive DML dispatch commands that can be compiled into a single graph (--fuse_dml_dispatches).
+struct DmlDispatchGroup
+{
+    // The binding of a graph input or output: a bind point of the node's dispatch command, and the index of the
+    // resource in that bind point.
+    struct EdgeBinding
+    {
+        std::string bindPointName;
+        uint32_t resourceIndex;
+    };
+
+    std::string name; // The fused dispatchable names joined with '+'.
+    std::vector<uint32_t> commandIds; // Consecutive command IDs, one per graph node.
+    DmlDispatchable::FusedGraphDesc graph;
+    std::vector<EdgeBinding> inputBindings; // Parallel to graph.inputs.
+    std::vector<EdgeBinding> outputBindings; // Parallel to graph.outputs.
+};
+
+// Groups consecutive DML dispatch commands where each command reads a resource written earlier in the group, so each
+// group can be compiled into one graph that lets DirectML fuse the operators and keep intermediates out of memory.
+// Only consecutive commands are considered, so no other command observes a resource between the fused operators. A
+// group is split wherever a command rewrites a resource that the group already read or wrote, or reads one through a
+// binding that can't become an intermediate edge (arrays, offsets, or mismatched tensor descs). Groups reference the
+// model's operator descs, and don't need a device.
+std::vector<DmlDispatchGroup> FindDmlDispatchGroups(const Model& model);
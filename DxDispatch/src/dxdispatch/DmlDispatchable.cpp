@@ -39,6 +39,46 @@ DmlDispatchable::DmlDispatchable(
 {
 }
 
+static Model::DmlDispatchableDesc GetFusedGraphDispatchableDesc(const DmlDispatchable::FusedGraphDesc& fusedGraph)
+{
+    Model::DmlDispatchableDesc desc = {};
+    desc.desc = nullptr;
+    desc.executionFlags = fusedGraph.executionFlags;
+    desc.compileType = Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph;
+    for (auto& input : fusedGraph.inputs)
+    {
+        desc.bindPoints.inputs.push_back({ input.name, 1, true, true });
+    }
+    for (auto& output : fusedGraph.outputs)
+    {
+        desc.bindPoints.outputs.push_back({ output.name, 1, true, true });
+    }
+    return desc;
+}
+
+DmlDispatchable::DmlDispatchable(
+    std::string_view name, 
+    std::shared_ptr<Device> device, 
+    FusedGraphDesc fusedGraph,
+    const Dispatchable::Bindings& initBindings,
+    IDxDispatchLogger* logger) : 
+    m_name(name), 
+    m_device(device), 
+    m_desc(GetFusedGraphDispatchableDesc(fusedGraph)), 
+    m_initBindings(initBindings), 
+    m_logger(logger), 
+    m_isSerializedGraph(false)
+{
+    m_bindPoints = std::get<Model::DmlDispatchableDesc>(m_desc).bindPoints;
+    for (auto nodeDesc : fusedGraph.nodes)
+    {
+        ComPtr<IDMLOperator> nodeOperator;
+        THROW_IF_FAILED(m_device->DML()->CreateOperator(nodeDesc, IID_PPV_ARGS(&nodeOperator)));
+        m_fusedOperators.push_back(std::move(nodeOperator));
+    }
+    m_fusedGraph = std::move(fusedGraph);
+}
+
 struct BindingData
 {
     std::vector<DML_BUFFER_BINDING> bufferBindings;
@@ -389,95 +429,166 @@ void DmlDispatchable::BuildAndCompileGraph()
         IID_PPV_ARGS(&m_compiledOperator)));
 }
 
+void DmlDispatchable::CompileFusedGraph()
+{
+    auto& fusedGraph = *m_fusedGraph;
+
+    std::vector<DML_OPERATOR_GRAPH_NODE_DESC> operatorNodeDescs(fusedGraph.nodes.size());
+    std::vector<DML_GRAPH_NODE_DESC> nodeDescs(fusedGraph.nodes.size());
+    for (size_t i = 0; i < fusedGraph.nodes.size(); i++)
+    {
+        operatorNodeDescs[i].Operator = m_fusedOperators[i].Get();
+        operatorNodeDescs[i].Name = fusedGraph.nodeNames[i].c_str();
+        nodeDescs[i] = { DML_GRAPH_NODE_TYPE_OPERATOR, &operatorNodeDescs[i] };
+    }
+
+    std::vector<DML_INPUT_GRAPH_EDGE_DESC> inputEdgeDescs(fusedGraph.inputs.size());
+    std::vector<DML_GRAPH_EDGE_DESC> inputEdges(fusedGraph.inputs.size());
+    for (size_t i = 0; i < fusedGraph.inputs.size(); i++)
+    {
+        inputEdgeDescs[i].GraphInputIndex = gsl::narrow_cast<UINT>(i);
+        inputEdgeDescs[i].ToNodeIndex = fusedGraph.inputs[i].toNodeIndex;
+        inputEdgeDescs[i].ToNodeInputIndex = fusedGraph.inputs[i].toNodeInputIndex;
+        inputEdgeDescs[i].Name = fusedGraph.inputs[i].name.c_str();
+        inputEdges[i] = { DML_GRAPH_EDGE_TYPE_INPUT, &inputEdgeDescs[i] };
+    }
+
+    std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> outputEdgeDescs(fusedGraph.outputs.size());
+    std::vector<DML_GRAPH_EDGE_DESC> outputEdges(fusedGraph.outputs.size());
+    for (size_t i = 0; i < fusedGraph.outputs.size(); i++)
+    {
+        outputEdgeDescs[i].FromNodeIndex = fusedGraph.outputs[i].fromNodeIndex;
+        outputEdgeDescs[i].FromNodeOutputIndex = fusedGraph.outputs[i].fromNodeOutputIndex;
+        outputEdgeDescs[i].GraphOutputIndex = gsl::narrow_cast<UINT>(i);
+        outputEdgeDescs[i].Name = fusedGraph.outputs[i].name.c_str();
+        outputEdges[i] = { DML_GRAPH_EDGE_TYPE_OUTPUT, &outputEdgeDescs[i] };
+    }
+
+    std::vector<DML_INTERMEDIATE_GRAPH_EDGE_DESC> intermediateEdgeDescs(fusedGraph.intermediates.size());
+    std::vector<DML_GRAPH_EDGE_DESC> intermediateEdges(fusedGraph.intermediates.size());
+    for (size_t i = 0; i < fusedGraph.intermediates.size(); i++)
+    {
+        intermediateEdgeDescs[i].FromNodeIndex = fusedGraph.intermediates[i].fromNodeIndex;
+        intermediateEdgeDescs[i].FromNodeOutputIndex = fusedGraph.intermediates[i].fromNodeOutputIndex;
+        intermediateEdgeDescs[i].ToNodeIndex = fusedGraph.intermediates[i].toNodeIndex;
+        intermediateEdgeDescs[i].ToNodeInputIndex = fusedGraph.intermediates[i].toNodeInputIndex;
+        intermediateEdges[i] = { DML_GRAPH_EDGE_TYPE_INTERMEDIATE, &intermediateEdgeDescs[i] };
+    }
+
+    DML_GRAPH_DESC dmlGraphDesc = {};
+    dmlGraphDesc.InputCount = gsl::narrow_cast<UINT>(inputEdges.size());
+    dmlGraphDesc.OutputCount = gsl::narrow_cast<UINT>(outputEdges.size());
+    dmlGraphDesc.NodeCount = gsl::narrow_cast<UINT>(nodeDescs.size());
+    dmlGraphDesc.Nodes = nodeDescs.data();
+    dmlGraphDesc.InputEdgeCount = dmlGraphDesc.InputCount;
+    dmlGraphDesc.InputEdges = inputEdges.data();
+    dmlGraphDesc.OutputEdgeCount = dmlGraphDesc.OutputCount;
+    dmlGraphDesc.OutputEdges = outputEdges.data();
+    dmlGraphDesc.IntermediateEdgeCount = gsl::narrow_cast<UINT>(intermediateEdges.size());
+    dmlGraphDesc.IntermediateEdges = intermediateEdges.data();
+
+    THROW_IF_FAILED(m_device->DML()->CompileGraph(&dmlGraphDesc, fusedGraph.executionFlags, IID_PPV_ARGS(&m_compiledOperator)));
+    m_compiledOperator->SetName(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(fmt::format("Graph_{}", m_name)).data());
+}
+
 void DmlDispatchable::Initialize()
 {
-    if (!m_isSerializedGraph)
     {
-        const auto& dmlDesc = std::get<Model::DmlDispatchableDesc>(m_desc);
-    
-        if (dmlDesc.compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileOp)
+        TraceScope traceScope("Compile");
+        if (m_fusedGraph)
         {
-            m_logger->LogInfo("Compile Op");
-            THROW_IF_FAILED(m_device->DML()->CompileOperator(
-                m_operator.Get(), 
-                dmlDesc.executionFlags, 
-                IID_PPV_ARGS(m_compiledOperator.ReleaseAndGetAddressOf())));
-            m_compiledOperator->SetName(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(m_name).data());
-
+            m_logger->LogInfo(fmt::format("Compiling {} fused ops using IDMLDevice1::CompileGraph", m_fusedGraph->nodes.size()).c_str());
+            CompileFusedGraph();
         }
-        else if (dmlDesc.compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph)
+        else if (!m_isSerializedGraph)
         {
-            m_logger->LogInfo("Compiling op using IDMLDevice1::CompileGraph");
-            DML_GRAPH_DESC dmlGraphDesc = {};
-            std::vector<DML_INPUT_GRAPH_EDGE_DESC> dmlInputGraphEdges;
-            std::vector<DML_GRAPH_EDGE_DESC> dmlInputEdges;
+            const auto& dmlDesc = std::get<Model::DmlDispatchableDesc>(m_desc);
+    
+            if (dmlDesc.compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileOp)
+            {
+                m_logger->LogInfo("Compile Op");
+                THROW_IF_FAILED(m_device->DML()->CompileOperator(
+                    m_operator.Get(), 
+                    dmlDesc.executionFlags, 
+                    IID_PPV_ARGS(m_compiledOperator.ReleaseAndGetAddressOf())));
+                m_compiledOperator->SetName(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(m_name).data());
+
+            }
+            else if (dmlDesc.compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph)
+            {
+                m_logger->LogInfo("Compiling op using IDMLDevice1::CompileGraph");
+                DML_GRAPH_DESC dmlGraphDesc = {};
+                std::vector<DML_INPUT_GRAPH_EDGE_DESC> dmlInputGraphEdges;
+                std::vector<DML_GRAPH_EDGE_DESC> dmlInputEdges;
             
-            std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> dmlOutputGraphEdges;
-            std::vector<DML_GRAPH_EDGE_DESC> dmlOutputEdges;
-            DML_GRAPH_NODE_DESC dmlGraphNodeDesc = {};
-            DML_OPERATOR_GRAPH_NODE_DESC nodeDesc{};
+                std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> dmlOutputGraphEdges;
+                std::vector<DML_GRAPH_EDGE_DESC> dmlOutputEdges;
+                DML_GRAPH_NODE_DESC dmlGraphNodeDesc = {};
+                DML_OPERATOR_GRAPH_NODE_DESC nodeDesc{};
 
-            nodeDesc.Operator = m_operator.Get();
-            nodeDesc.Name = m_name.c_str();
+                nodeDesc.Operator = m_operator.Get();
+                nodeDesc.Name = m_name.c_str();
 
-            {
-                dmlGraphNodeDesc.Type = DML_GRAPH_NODE_TYPE_OPERATOR;
-                dmlGraphNodeDesc.Desc = &nodeDesc;
-            }
+                {
+                    dmlGraphNodeDesc.Type = DML_GRAPH_NODE_TYPE_OPERATOR;
+                    dmlGraphNodeDesc.Desc = &nodeDesc;
+                }
 
-            dmlInputGraphEdges.resize(dmlDesc.bindPoints.inputs.size());
-            for (size_t i = 0; i < dmlDesc.bindPoints.inputs.size(); i++)
-            {
-                if (dmlDesc.bindPoints.inputs[i].requiredBinding)
+                dmlInputGraphEdges.resize(dmlDesc.bindPoints.inputs.size());
+                for (size_t i = 0; i < dmlDesc.bindPoints.inputs.size(); i++)
                 {
-                    DML_INPUT_GRAPH_EDGE_DESC desc = {};
-                    desc.GraphInputIndex = gsl::narrow_cast<UINT>(i);
-                    desc.ToNodeIndex = 0;
-                    desc.ToNodeInputIndex = gsl::narrow_cast<UINT>(i);
-                    desc.Name = dmlDesc.bindPoints.inputs[i].name.c_str();
-                    dmlInputGraphEdges[i] = desc;
-                    dmlInputEdges.push_back({ DML_GRAPH_EDGE_TYPE_INPUT, &dmlInputGraphEdges[i] });
+                    if (dmlDesc.bindPoints.inputs[i].requiredBinding)
+                    {
+                        DML_INPUT_GRAPH_EDGE_DESC desc = {};
+                        desc.GraphInputIndex = gsl::narrow_cast<UINT>(i);
+                        desc.ToNodeIndex = 0;
+                        desc.ToNodeInputIndex = gsl::narrow_cast<UINT>(i);
+                        desc.Name = dmlDesc.bindPoints.inputs[i].name.c_str();
+                        dmlInputGraphEdges[i] = desc;
+                        dmlInputEdges.push_back({ DML_GRAPH_EDGE_TYPE_INPUT, &dmlInputGraphEdges[i] });
+                    }
                 }
-            }
 
-            dmlOutputGraphEdges.resize(dmlDesc.bindPoints.outputs.size());
-            for (size_t i = 0; i < dmlDesc.bindPoints.outputs.size(); i++)
-            {
-                if (dmlDesc.bindPoints.outputs[i].requiredBinding)
+                dmlOutputGraphEdges.resize(dmlDesc.bindPoints.outputs.size());
+                for (size_t i = 0; i < dmlDesc.bindPoints.outputs.size(); i++)
                 {
-                    DML_OUTPUT_GRAPH_EDGE_DESC desc = {};
-                    desc.GraphOutputIndex = gsl::narrow_cast<UINT>(i);
-                    desc.FromNodeIndex = 0;
-                    desc.FromNodeOutputIndex = gsl::narrow_cast<UINT>(i);
-                    desc.Name = dmlDesc.bindPoints.outputs[i].name.c_str();
-                    dmlOutputGraphEdges[i] = desc;
-                    dmlOutputEdges.push_back({ DML_GRAPH_EDGE_TYPE_OUTPUT, &dmlOutputGraphEdges[i] });
+                    if (dmlDesc.bindPoints.outputs[i].requiredBinding)
+                    {
+                        DML_OUTPUT_GRAPH_EDGE_DESC desc = {};
+                        desc.GraphOutputIndex = gsl::narrow_cast<UINT>(i);
+                        desc.FromNodeIndex = 0;
+                        desc.FromNodeOutputIndex = gsl::narrow_cast<UINT>(i);
+                        desc.Name = dmlDesc.bindPoints.outputs[i].name.c_str();
+                        dmlOutputGraphEdges[i] = desc;
+                        dmlOutputEdges.push_back({ DML_GRAPH_EDGE_TYPE_OUTPUT, &dmlOutputGraphEdges[i] });
+                    }
                 }
-            }
 
-            dmlGraphDesc.InputCount = static_cast<uint32_t>(dmlInputEdges.size());
-            dmlGraphDesc.InputEdges = dmlInputEdges.data();
-            dmlGraphDesc.InputEdgeCount = dmlGraphDesc.InputCount;
+                dmlGraphDesc.InputCount = static_cast<uint32_t>(dmlInputEdges.size());
+                dmlGraphDesc.InputEdges = dmlInputEdges.data();
+                dmlGraphDesc.InputEdgeCount = dmlGraphDesc.InputCount;
 
-            dmlGraphDesc.OutputCount = static_cast<uint32_t>(dmlOutputEdges.size());
-            dmlGraphDesc.OutputEdges = dmlOutputEdges.data();
-            dmlGraphDesc.OutputEdgeCount = dmlGraphDesc.OutputCount;
+                dmlGraphDesc.OutputCount = static_cast<uint32_t>(dmlOutputEdges.size());
+                dmlGraphDesc.OutputEdges = dmlOutputEdges.data();
+                dmlGraphDesc.OutputEdgeCount = dmlGraphDesc.OutputCount;
 
-            dmlGraphDesc.IntermediateEdgeCount = 0;
-            dmlGraphDesc.IntermediateEdges = nullptr;
+                dmlGraphDesc.IntermediateEdgeCount = 0;
+                dmlGraphDesc.IntermediateEdges = nullptr;
 
-            dmlGraphDesc.NodeCount = 1;
-            dmlGraphDesc.Nodes = &dmlGraphNodeDesc;
+                dmlGraphDesc.NodeCount = 1;
+                dmlGraphDesc.Nodes = &dmlGraphNodeDesc;
 
-            THROW_IF_FAILED(m_device->DML()->CompileGraph(&dmlGraphDesc, dmlDesc.executionFlags, IID_PPV_ARGS(&m_compiledOperator)));
-            m_compiledOperator->SetName(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(fmt::format("Graph_{}", m_name)).data());
-        }   
-    }
-    else
-    {
-        BuildAndCompileGraph();
+                THROW_IF_FAILED(m_device->DML()->CompileGraph(&dmlGraphDesc, dmlDesc.executionFlags, IID_PPV_ARGS(&m_compiledOperator)));
+                m_compiledOperator->SetName(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(fmt::format("Graph_{}", m_name)).data());
+            }   
+        }
+        else
+        {
+            BuildAndCompileGraph();
+        }
     }
 
+    TraceScope traceScope("Execute initializer");
     ComPtr<IDMLOperatorInitializer> initializer;
     IDMLCompiledOperator* ops[] = { m_compiledOperator.Get() };
     THROW_IF_FAILED(m_device->DML()->CreateOperatorInitializer(
@@ -495,6 +606,7 @@ void DmlDispatchable::Initialize()
     descriptorHeapDesc.NumDescriptors = std::max(1u, initializer->GetBindingProperties().RequiredDescriptorCount);
     descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     THROW_IF_FAILED(m_device->D3D()->CreateDescriptorHeap(&descriptorHeapDesc, IID_GRAPHICS_PPV_ARGS(descriptorHeap.ReleaseAndGetAddressOf())));
+    DXD_PERF_COUNTER_ADD(descriptorHeapsCreated, 1);
 
     ID3D12DescriptorHeap* descriptorHeaps[] = { descriptorHeap.Get() };
     m_device->GetCommandList()->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
@@ -507,6 +619,7 @@ void DmlDispatchable::Initialize()
 
     ComPtr<IDMLBindingTable> bindingTable;
     THROW_IF_FAILED(m_device->DML()->CreateBindingTable(&bindingTableDesc, IID_PPV_ARGS(&bindingTable)));
+    DXD_PERF_COUNTER_ADD(bindingTablesCreated, 1);
 
     BindingData inputBindingData = {};
     std::optional<Model::DmlDispatchableDesc::DmlCompileType> compileType = std::nullopt;
@@ -583,6 +696,7 @@ void DmlDispatchable::Bind(const Bindings& bindings, uint32_t iteration)
     THROW_IF_FAILED(m_device->D3D()->CreateDescriptorHeap(
         &descriptorHeapDesc, 
         IID_GRAPHICS_PPV_ARGS(m_descriptorHeap.ReleaseAndGetAddressOf())));
+    DXD_PERF_COUNTER_ADD(descriptorHeapsCreated, 1);
 
     ID3D12DescriptorHeap* descriptorHeaps[] = { m_descriptorHeap.Get() };
     m_device->GetCommandList()->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
@@ -594,6 +708,7 @@ void DmlDispatchable::Bind(const Bindings& bindings, uint32_t iteration)
     bindingTableDesc.SizeInDescriptors = bindingProps.RequiredDescriptorCount;
 
     THROW_IF_FAILED(m_device->DML()->CreateBindingTable(&bindingTableDesc, IID_PPV_ARGS(m_bindingTable.ReleaseAndGetAddressOf())));
+    DXD_PERF_COUNTER_ADD(bindingTablesCreated, 1);
 
     if (inputBindingData.bindingDescs.size() > std::numeric_limits<uint32_t>::max())
     {
@@ -634,4 +749,13 @@ void DmlDispatchable::Dispatch(const Model::DispatchCommand& args, uint32_t iter
 {
     m_device->RecordDispatch(m_compiledOperator.Get(), m_bindingTable.Get());
     m_device->ExecuteCommandListAndWait();
+}
+
+void DmlDispatchable::Release()
+{
+    // Dispatch waits for the GPU, so nothing in flight refers to these.
+    m_bindingTable = nullptr;
+    m_descriptorHeap = nullptr;
+    m_persistentBuffer = nullptr;
+    m_compiledOperator = nullptr;
 }
\ No newline at end of file
@@ -4,6 +4,40 @@
 class DmlDispatchable : public Dispatchable
 {
 public:
+    // Several DML operators compiled into one graph. Every graph input and output is its own bind point with a
+    // single resource, and intermediate edges connect operators without a resource in between.
+    struct FusedGraphDesc
+    {
+        struct InputEdge
+        {
+            std::string name;
+            uint32_t toNodeIndex;
+            uint32_t toNodeInputIndex;
+        };
+
+        struct OutputEdge
+        {
+            std::string name;
+            uint32_t fromNodeIndex;
+            uint32_t fromNodeOutputIndex;
+        };
+
+        struct IntermediateEdge
+        {
+            uint32_t fromNodeIndex;
+            uint32_t fromNodeOutputIndex;
+            uint32_t toNodeIndex;
+            uint32_t toNodeInputIndex;
+        };
+
+        std::vector<std::string> nodeNames;
+        std::vector<const DML_OPERATOR_DESC*> nodes;
+        std::vector<InputEdge> inputs;      // Graph input i is inputs[i].
+        std::vector<OutputEdge> outputs;    // Graph output i is outputs[i].
+        std::vector<IntermediateEdge> intermediates;
+        DML_EXECUTION_FLAGS executionFlags;
+    };
+
     DmlDispatchable(
         std::string_view name, 
         std::shared_ptr<Device> device, 
@@ -17,10 +51,21 @@ public:
         const Model::DmlSerializedGraphDispatchableDesc& desc,
         IDxDispatchLogger* logger);
 
+    DmlDispatchable(
+        std::string_view name, 
+        std::shared_ptr<Device> device, 
+        FusedGraphDesc fusedGraph,
+        const Dispatchable::Bindings& initBindings,
+        IDxDispatchLogger* logger);
+
     void Initialize() final;
     void Bind(const Bindings& bindings, uint32_t iteration) final;
     void Dispatch(const Model::DispatchCommand& args, uint32_t iteration, DeferredBindings& deferredBindings) final;
 
+    // Releases the compiled operator and the GPU resources created by Initialize and Bind. The operator itself is 
+    // kept, so Initialize compiles it again before the next dispatch.
+    void Release();
+
 private:
     std::string m_name;
     std::shared_ptr<Device> m_device;
@@ -35,8 +80,11 @@ private:
     Microsoft::WRL::ComPtr<IDxDispatchLogger> m_logger;
     Model::DmlDispatchableDesc::BindPoints m_bindPoints;
     std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D12Resource>> m_resources;
+    std::optional<FusedGraphDesc> m_fusedGraph;
+    std::vector<Microsoft::WRL::ComPtr<IDMLOperator>> m_fusedOperators;
 
     void BuildAndCompileGraph();
+    void CompileFusedGraph();
     void CreateResourceFromConstantNode(
         const DmlSerializedGraphNode& node,
         const std::unordered_map<std::string, 
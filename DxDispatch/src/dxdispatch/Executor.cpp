@@ -5,6 +5,7 @@
 #include "Model.h"
 #include "Dispatchable.h"
 #include "DmlDispatchable.h"
+#include "DmlDispatchFusion.h"
 #ifndef DXCOMPILER_NONE
 #include "HlslDispatchable.h"
 #endif
@@ -15,7 +16,10 @@
 #include "NpyReaderWriter.h"
 #include "CommandLineArgs.h"
 #include "Executor.h"
+#include "Timings.h"
 #include <half.hpp>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
 
 using Microsoft::WRL::ComPtr;
 
@@ -29,85 +33,40 @@ struct Timer
     double DurationInMilliseconds() { return std::chrono::duration<double>(end - start).count() * 1000; }
 };
 
-struct Timings
-{
-    std::vector<double> rawSamples;
-
-    struct Stats
-    {
-        size_t count;
-        double sum;
-        double average;
-        double median;
-        double min;
-        double max;
-    };
+// Adaptive iteration control (--target_precision) tests for convergence periodically rather than every iteration.
+// The interval between checks grows with the sample count so the cost of sorting samples stays amortized.
+constexpr uint32_t c_adaptiveMinCheckInterval = 8;
+constexpr size_t c_adaptiveMinHotSamples = 10;
 
-    struct SampleStats
-    {
-        Stats cold;
-        Stats hot;
-    };
+// How long each stream count of --onnx_streams runs when neither -i nor -t is given.
+constexpr uint32_t c_defaultStreamTimeToRunInMilliseconds = 5000;
 
-    Stats ComputeStats(gsl::span<const double> sampleSpan) const
+Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLineArgs& args, IDxDispatchLogger* logger) : 
+    m_model(model), m_device(device), m_commandLineArgs(args), m_logger(logger)
+{
+    if (args.ArrivalTracePath())
     {
-        Stats stats = {};
-
-        if (!sampleSpan.empty())
-        {
-            std::vector<double> samples(sampleSpan.size());
-            std::copy(sampleSpan.begin(), sampleSpan.end(), samples.begin());
-            std::sort(samples.begin(), samples.end());
-
-            stats.count = sampleSpan.size();
-            stats.sum = std::accumulate(samples.begin(), samples.end(), 0.0);
-            stats.average = stats.sum / samples.size();
-            stats.median = samples[samples.size() / 2];
-            stats.min = samples[0];
-            stats.max = samples[samples.size() - 1];
-        }
-
-        return stats;
+        m_arrivalSchedule = ArrivalSchedule::FromTrace(*args.ArrivalTracePath());
     }
-
-    SampleStats ComputeStats(size_t maxWarmupSampleCount) const
+    else if (args.ArrivalRate())
     {
-        SampleStats stats = {};
-        if (rawSamples.empty())
-        {
-            return stats;
-        }
-
-        // The first samples may be from "warmup" runs that skew the results because of cold caches.
-        // We call the first few samples "cold" and the later samples "hot". We always want at least 
-        // 1 hot sample. Example:
-        //
-        // Raw Samples | maxWarmup | cold | hot
-        // ------------|-----------|------|----
-        //           0 |         2 |    0 |   0
-        //           1 |         2 |    0 |   1
-        //           2 |         2 |    1 |   1
-        //           3 |         2 |    2 |   1
-        //           4 |         2 |    2 |   2
-        //           5 |         2 |    2 |   3
-
-        size_t coldSampleCount = std::min(std::max<size_t>(rawSamples.size(), 1) - 1, maxWarmupSampleCount);
-        size_t hotSampleCount = rawSamples.size() - coldSampleCount;
-        assert(coldSampleCount + hotSampleCount == rawSamples.size());
+        m_arrivalSchedule = args.ArrivalProcess() == ArrivalSchedule::Process::Poisson ? 
+            ArrivalSchedule::Poisson(*args.ArrivalRate(), args.ArrivalSeed()) : 
+            ArrivalSchedule::FixedRate(*args.ArrivalRate());
+    }
 
-        stats.cold = ComputeStats(gsl::make_span<const double>(rawSamples.data(), coldSampleCount));
-        stats.hot = ComputeStats(gsl::make_span<const double>(rawSamples.data() + coldSampleCount, hotSampleCount));
+    m_readbackQueue = std::make_unique<ReadbackQueue>(device, logger);
 
-        return stats;
+    if (model.InitialValuesReleased())
+    {
+        throw std::invalid_argument("The model's initial values were released after an earlier upload (--lean_host_memory). Reload the model to run it again.");
     }
-};
 
-Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLineArgs& args, IDxDispatchLogger* logger) : 
-    m_model(model), m_device(device), m_commandLineArgs(args), m_logger(logger)
-{
     // Initialize buffer resources.
     {
         PIXScopedEvent(m_device->GetCommandList(), PIX_COLOR(255, 255, 0), "Initialize resources");
+        TraceScope traceScope("Initialize resources");
+        m_resources.resize(model.GetResourceDescs().size());
         for (auto& desc : model.GetResourceDescs())
         {
             // Only buffers are supported right now.
@@ -116,19 +75,49 @@ Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLi
             auto wName = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(desc.name);
             if (bufferDesc.sizeInBytes > 0)
             {
-                m_resources[desc.name] = std::move(device->Upload(bufferDesc.sizeInBytes, bufferDesc.initialValues, wName));
-            }
-            else
-            {
-                m_resources[desc.name] = nullptr;
+                m_resources[model.GetResourceId(desc.name)] = std::move(device->Upload(bufferDesc.sizeInBytes, bufferDesc.initialValues, wName));
             }
         }
     }
     device->ExecuteCommandListAndWait();
 
+    // The initial values now live on the GPU, and the upload buffers were released by the wait above. Only
+    // their sizes are needed from here on (e.g. to infer binding element counts).
+    if (args.LeanHostMemory())
+    {
+        model.ReleaseInitialValues();
+    }
+
+    // Resolve the model's binding plans once so that commands can be replayed without rebuilding bindings.
+    try
+    {
+        m_resolvedBindings.reserve(model.GetBindingPlans().size());
+        for (auto& plan : model.GetBindingPlans())
+        {
+            m_resolvedBindings.push_back(ResolveBindings(plan));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        m_logger->LogError(fmt::format("Failed to resolve bindings: {}", e.what()).c_str());
+        throw;
+    }
+
     // Create dispatchables.
+    m_dispatchables.resize(model.GetDispatchableDescs().size());
+    m_dispatchResults.resize(model.GetDispatchableDescs().size());
+    m_isSweepPoint.resize(model.GetDispatchableDescs().size());
+    for (auto& sweep : model.GetSweeps())
+    {
+        for (auto& point : sweep.points)
+        {
+            m_isSweepPoint[point.dispatchableId] = true;
+        }
+    }
     for (auto& desc : model.GetDispatchableDescs())
     {
+        TraceScope traceScope(fmt::format("Create '{}'", desc.name));
+        auto& dispatchable = m_dispatchables[model.GetDispatchableId(desc.name)];
         try
         {
             if (std::holds_alternative<Model::HlslDispatchableDesc>(desc.value))
@@ -136,7 +125,7 @@ Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLi
 #ifdef DXCOMPILER_NONE
                 throw std::invalid_argument("HLSL dispatchables require DXCompiler");
 #else
-                m_dispatchables[desc.name] = std::make_unique<HlslDispatchable>(device, std::get<Model::HlslDispatchableDesc>(desc.value), args, m_logger.Get());
+                dispatchable = std::make_unique<HlslDispatchable>(device, std::get<Model::HlslDispatchableDesc>(desc.value), args, m_logger.Get());
 #endif
             }
             else if (std::holds_alternative<Model::OnnxDispatchableDesc>(desc.value))
@@ -144,14 +133,14 @@ Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLi
 #ifdef ONNXRUNTIME_NONE
                 throw std::invalid_argument("ONNX dispatchables require ONNX Runtime");
 #else
-                m_dispatchables[desc.name] = std::make_unique<OnnxDispatchable>(device, std::get<Model::OnnxDispatchableDesc>(desc.value), args, m_logger.Get());
+                dispatchable = std::make_unique<OnnxDispatchable>(device, std::get<Model::OnnxDispatchableDesc>(desc.value), args, m_logger.Get());
 #endif
             }
             else if (std::holds_alternative<Model::DmlSerializedGraphDispatchableDesc>(desc.value)) 
             {
                 auto& dmlSerializedGraphDispatchableDesc = std::get<Model::DmlSerializedGraphDispatchableDesc>(desc.value);
 
-                m_dispatchables[desc.name] = std::make_unique<DmlDispatchable>(
+                dispatchable = std::make_unique<DmlDispatchable>(
                     desc.name, 
                     device, 
                     dmlSerializedGraphDispatchableDesc, 
@@ -160,19 +149,8 @@ Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLi
             else
             {
                 auto& dmlDispatchableDesc = std::get<Model::DmlDispatchableDesc>(desc.value);
-
-                Dispatchable::Bindings initBindings;
-                try
-                {
-                    initBindings = ResolveBindings(dmlDispatchableDesc.initBindings);
-                }
-                catch (const std::exception& e)
-                {
-                    m_logger->LogError(fmt::format("Failed to resolve bindings: {}", e.what()).c_str());
-                    return;
-                }
-
-                m_dispatchables[desc.name] = std::make_unique<DmlDispatchable>(desc.name, device, dmlDispatchableDesc, initBindings, m_logger.Get());
+                auto& initBindings = m_resolvedBindings[dmlDispatchableDesc.initBindingPlanId];
+                dispatchable = std::make_unique<DmlDispatchable>(desc.name, device, dmlDispatchableDesc, initBindings, m_logger.Get());
             }
         }
         catch(const std::exception& e)
@@ -181,33 +159,178 @@ Executor::Executor(Model& model, std::shared_ptr<Device> device, const CommandLi
         }
     }
 
+    if (args.FuseDmlDispatches())
+    {
+        if (args.AutotunePath())
+        {
+            m_logger->LogWarning("Ignoring --fuse_dml_dispatches: autotuning measures each dispatchable on its own");
+        }
+        else
+        {
+            FuseDmlDispatches();
+        }
+    }
+
     // Compile/initialize dispatchables.
     {
         Timer timer;
 
         PIXBeginEvent(m_device->GetCommandQueue(), PIX_COLOR(255, 255, 0), "Initialize dispatchables");
-        for (auto& dispatchable : m_dispatchables)
+        TraceScope traceScope("Initialize dispatchables");
+
+        auto InitializeDispatchable = [&](Dispatchable& dispatchable, const std::string& dispatchableName)
+        {
+            timer.Start();
+            PIXBeginEvent(PIX_COLOR(128,255,0), L"Init");
+            TraceScope traceScope(fmt::format("Initialize '{}'", dispatchableName));
+            dispatchable.Initialize();
+            PIXEndEvent();
+            timer.End();
+
+            if (m_commandLineArgs.GetTimingVerbosity() >= TimingVerbosity::Extended)
+            {
+                m_logger->LogInfo(fmt::format("Initialize '{}': {:.4f} ms", dispatchableName, timer.DurationInMilliseconds()).c_str());
+            }
+        };
+
+        // Fused graphs are initialized first. If DirectML can't compile one, its commands are dispatched separately.
+        for (auto& fusedDispatch : m_fusedDispatches)
         {
             try
             {
-                timer.Start();
-                PIXBeginEvent(PIX_COLOR(128,255,0), L"Init");
-                dispatchable.second->Initialize();
-                PIXEndEvent();
-                timer.End();
+                InitializeDispatchable(*m_dispatchables[fusedDispatch.command.dispatchableId], fusedDispatch.command.dispatchableName);
+            }
+            catch (const std::exception& e)
+            {
+                m_logger->LogWarning(fmt::format("Dispatching '{}' separately: {}", fusedDispatch.command.dispatchableName, e.what()).c_str());
+                std::fill_n(m_fusedDispatchIndices.begin() + fusedDispatch.firstCommandId, fusedDispatch.commandCount, Model::InvalidId);
+            }
+        }
+
+        // Dispatchables that are only dispatched as part of fused graphs are never initialized on their own.
+        std::vector<bool> dispatchedSeparately(model.GetDispatchableDescs().size(), m_fusedDispatches.empty());
+        for (uint32_t commandId = 0; commandId < m_fusedDispatchIndices.size(); commandId++)
+        {
+            auto dispatchCommand = std::get_if<Model::DispatchCommand>(&model.GetCommands()[commandId].command);
+            if (dispatchCommand && m_fusedDispatchIndices[commandId] == Model::InvalidId)
+            {
+                dispatchedSeparately[dispatchCommand->dispatchableId] = true;
+            }
+        }
 
-                if (m_commandLineArgs.GetTimingVerbosity() >= TimingVerbosity::Extended)
-                {
-                    m_logger->LogInfo(fmt::format("Initialize '{}': {:.4f} ms", dispatchable.first, timer.DurationInMilliseconds()).c_str());
-                }
+        // Sweep points are compiled when they're dispatched and released afterwards (see SweepPointScope), so a
+        // large sweep doesn't hold every point's compiled operator and persistent resource at once.
+        for (size_t i = 0; i < model.GetDispatchableDescs().size(); i++)
+        {
+            auto& dispatchableName = model.GetDispatchableDescs()[i].name;
+            if (!dispatchedSeparately[i] || m_isSweepPoint[i])
+            {
+                continue;
+            }
+
+            try
+            {
+                InitializeDispatchable(*m_dispatchables[i], dispatchableName);
             }
             catch (const std::exception& e)
             {
-                throw std::invalid_argument(fmt::format("ERROR while initializing '{}': {}", dispatchable.first, e.what()));
+                throw std::invalid_argument(fmt::format("ERROR while initializing '{}': {}", dispatchableName, e.what()));
             }
         }
         PIXEndEvent(m_device->GetCommandQueue());
     }
+
+    // Every DML operator has been created, so the parsed descs are no longer needed. Autotuning creates new 
+    // operators from the descs, so they are kept in that case.
+    if (args.LeanHostMemory() && !args.AutotunePath())
+    {
+        model.ReleaseOperatorDescs();
+    }
+}
+
+// Compiles each group of consecutive DML dispatch commands found by FindDmlDispatchGroups into one graph. A group
+// that DirectML can't compile is dispatched separately.
+void Executor::FuseDmlDispatches()
+{
+    auto commands = m_model.GetCommands();
+    m_fusedDispatchIndices.assign(commands.size(), Model::InvalidId);
+
+    for (auto& group : FindDmlDispatchGroups(m_model))
+    {
+        Dispatchable::Bindings bindings;
+        Dispatchable::Bindings initBindings;
+
+        auto CopyBinding = [](const Dispatchable::Bindings* source, const DmlDispatchGroup::EdgeBinding& edgeBinding, 
+            Dispatchable::Bindings& target, const std::string& edgeName)
+        {
+            if (!source) { return; }
+            auto binding = source->find(edgeBinding.bindPointName);
+            if (binding != source->end() && edgeBinding.resourceIndex < binding->second.size())
+            {
+                target[edgeName] = { binding->second[edgeBinding.resourceIndex] };
+            }
+        };
+
+        auto GetNodeBindings = [&](uint32_t nodeIndex, bool init) -> const Dispatchable::Bindings*
+        {
+            auto& command = std::get<Model::DispatchCommand>(commands[group.commandIds[nodeIndex]].command);
+            if (!init)
+            {
+                return &m_resolvedBindings[command.bindingPlanId];
+            }
+            auto& dmlDesc = std::get<Model::DmlDispatchableDesc>(m_model.GetDispatchable(command.dispatchableId).value);
+            return dmlDesc.initBindingPlanId != Model::InvalidId ? &m_resolvedBindings[dmlDesc.initBindingPlanId] : nullptr;
+        };
+
+        for (size_t i = 0; i < group.graph.inputs.size(); i++)
+        {
+            auto& edge = group.graph.inputs[i];
+            CopyBinding(GetNodeBindings(edge.toNodeIndex, false), group.inputBindings[i], bindings, edge.name);
+            CopyBinding(GetNodeBindings(edge.toNodeIndex, true), group.inputBindings[i], initBindings, edge.name);
+        }
+
+        for (size_t i = 0; i < group.graph.outputs.size(); i++)
+        {
+            auto& edge = group.graph.outputs[i];
+            CopyBinding(GetNodeBindings(edge.fromNodeIndex, false), group.outputBindings[i], bindings, edge.name);
+        }
+
+        auto commandCount = static_cast<uint32_t>(group.commandIds.size());
+        auto intermediateCount = group.graph.intermediates.size();
+
+        FusedDispatch fusedDispatch = {};
+        fusedDispatch.command.dispatchableName = std::move(group.name);
+        fusedDispatch.command.dispatchableId = static_cast<Model::DispatchableId>(m_dispatchables.size());
+        fusedDispatch.command.bindingPlanId = static_cast<Model::BindingPlanId>(m_resolvedBindings.size());
+        fusedDispatch.firstCommandId = group.commandIds.front();
+        fusedDispatch.commandCount = commandCount;
+
+        try
+        {
+            m_dispatchables.push_back(std::make_unique<DmlDispatchable>(
+                fusedDispatch.command.dispatchableName, 
+                m_device, 
+                std::move(group.graph), 
+                initBindings, 
+                m_logger.Get()));
+        }
+        catch (const std::exception& e)
+        {
+            m_logger->LogWarning(fmt::format("Dispatching '{}' separately: {}", fusedDispatch.command.dispatchableName, e.what()).c_str());
+            continue;
+        }
+
+        m_resolvedBindings.push_back(std::move(bindings));
+        m_dispatchResults.emplace_back();
+        for (uint32_t commandId : group.commandIds)
+        {
+            m_fusedDispatchIndices[commandId] = static_cast<uint32_t>(m_fusedDispatches.size());
+        }
+
+        m_logger->LogInfo(fmt::format("Fused {} dispatch commands into '{}' ({} intermediate edges)", 
+            commandCount, fusedDispatch.command.dispatchableName, intermediateCount).c_str());
+        m_fusedDispatches.push_back(std::move(fusedDispatch));
+    }
 }
 
 uint32_t Executor::GetCommandCount()
@@ -228,7 +351,33 @@ void Executor::RunCommand(UINT32 id)
 
         try
         {
-            std::visit(*this, commandDescs[id].command);
+            if (!m_fusedDispatchIndices.empty() && m_fusedDispatchIndices[id] != Model::InvalidId)
+            {
+                // The group's first command dispatches the fused graph, and the others were folded into it. Each
+                // fused dispatchable reports the timings of the graph.
+                auto& fusedDispatch = m_fusedDispatches[m_fusedDispatchIndices[id]];
+                if (id == fusedDispatch.firstCommandId)
+                {
+                    (*this)(fusedDispatch.command);
+                    for (uint32_t i = 0; i < fusedDispatch.commandCount; i++)
+                    {
+                        auto& command = std::get<Model::DispatchCommand>(commandDescs[id + i].command);
+                        m_dispatchResults[command.dispatchableId] = m_dispatchResults[fusedDispatch.command.dispatchableId];
+                    }
+                }
+            }
+            else
+            {
+                std::visit(*this, commandDescs[id].command);
+            }
+
+            // Print and write file commands complete in the background. Their output is flushed with each command
+            // when commands are logged, so it appears before the command's completion, and after the last command.
+            if (m_commandLineArgs.PrintCommands() || id + 1 == maxCommands)
+            {
+                m_readbackQueue->Flush();
+            }
+
             if (m_commandLineArgs.PrintCommands())
             {
                 m_logger->LogCommandCompleted((UINT32)id, S_OK, "");
@@ -254,7 +403,7 @@ void Executor::RunCommand(UINT32 id)
         m_logger->LogError(msg.c_str());
         throw std::invalid_argument(msg);
     }
-    if ((m_nextId++) >= maxCommands)
+    if (++m_nextId >= maxCommands)
     {
         m_nextId = 0;
     }
@@ -268,44 +417,664 @@ void Executor::Run()
     {
         RunCommand(i);
     }
-    return;
+
+    if (!m_model.GetSweeps().empty())
+    {
+        ReportSweeps();
+    }
 }
 
-void Executor::operator()(const Model::DispatchCommand& command)
+void Executor::ResetResources()
+{
+    if (m_model.InitialValuesReleased())
+    {
+        throw std::invalid_argument("The model's initial values were released after the first upload (--lean_host_memory)");
+    }
+
+    {
+        PIXScopedEvent(m_device->GetCommandList(), PIX_COLOR(255, 255, 0), "Reset resources");
+        TraceScope traceScope("Reset resources");
+        for (auto& desc : m_model.GetResourceDescs())
+        {
+            auto& bufferDesc = std::get<Model::BufferDesc>(desc.value);
+            auto& resource = m_resources[m_model.GetResourceId(desc.name)];
+            if (resource)
+            {
+                m_device->Upload(resource.Get(), bufferDesc.initialValues);
+            }
+        }
+    }
+    m_device->ExecuteCommandListAndWait();
+}
+
+// Returns the largest difference between the expected and actual values, relative to the magnitude of the expected
+// value (or absolute for values smaller than 1). NaNs must match.
+template <typename T>
+double MaxRelativeDifference(gsl::span<const std::byte> expected, gsl::span<const std::byte> actual)
+{
+    double maxDifference = 0;
+    for (size_t offset = 0; offset + sizeof(T) <= expected.size(); offset += sizeof(T))
+    {
+        T expectedElement, actualElement;
+        memcpy(&expectedElement, expected.data() + offset, sizeof(T));
+        memcpy(&actualElement, actual.data() + offset, sizeof(T));
+        double e = static_cast<double>(expectedElement);
+        double a = static_cast<double>(actualElement);
+
+        if (std::isnan(e) || std::isnan(a))
+        {
+            if (std::isnan(e) != std::isnan(a))
+            {
+                return std::numeric_limits<double>::infinity();
+            }
+        }
+        else if (e != a)
+        {
+            maxDifference = std::max(maxDifference, std::abs(e - a) / std::max(1.0, std::abs(e)));
+        }
+    }
+    return maxDifference;
+}
+
+// Floating-point outputs may differ within a tolerance (e.g. when half-precision computation is allowed), but
+// other data types must match exactly. Packed integer types (e.g. INT4) are compared byte by byte, since equal
+// bytes hold equal elements.
+double MaxRelativeDifference(gsl::span<const std::byte> expected, gsl::span<const std::byte> actual, DML_TENSOR_DATA_TYPE dataType)
+{
+    if (expected.size() != actual.size())
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    switch (dataType)
+    {
+    case DML_TENSOR_DATA_TYPE_FLOAT16: return MaxRelativeDifference<half_float::half>(expected, actual);
+    case DML_TENSOR_DATA_TYPE_FLOAT32: return MaxRelativeDifference<float>(expected, actual);
+    case DML_TENSOR_DATA_TYPE_FLOAT64: return MaxRelativeDifference<double>(expected, actual);
+    default: return memcmp(expected.data(), actual.data(), expected.size()) == 0 ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+}
+
+std::string ExecutionOptionsToString(DML_EXECUTION_FLAGS executionFlags, Model::DmlDispatchableDesc::DmlCompileType compileType)
+{
+    return fmt::format("{}{}{}",
+        compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph ? "graph" : "op",
+        (executionFlags & DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION) ? ", half precision" : "",
+        (executionFlags & DML_EXECUTION_FLAG_DISABLE_META_COMMANDS) ? ", no meta commands" : "");
+}
+
+// Initializes a sweep point's dispatchable for the lifetime of the scope and releases it afterwards. Dispatchables that
+// aren't sweep points were initialized when the executor was created, and are left alone.
+class SweepPointScope
+{
+public:
+    SweepPointScope(Dispatchable& dispatchable, bool isSweepPoint) : 
+        m_dispatchable(isSweepPoint ? static_cast<DmlDispatchable*>(&dispatchable) : nullptr)
+    {
+        if (m_dispatchable)
+        {
+            TraceScope traceScope("Initialize sweep point");
+            m_dispatchable->Initialize();
+        }
+    }
+
+    ~SweepPointScope()
+    {
+        if (m_dispatchable)
+        {
+            m_dispatchable->Release();
+        }
+    }
+
+    SweepPointScope(const SweepPointScope&) = delete;
+    SweepPointScope& operator=(const SweepPointScope&) = delete;
+
+private:
+    DmlDispatchable* m_dispatchable;
+};
+
+void Executor::Autotune(const std::filesystem::path& overlayPath)
+{
+    std::vector<std::pair<std::string_view, ExecutionOptions>> tunedOptions;
+    std::vector<bool> tuned(m_dispatchables.size());
+
+    // Each dispatchable is tuned the first time it's dispatched, when its inputs hold the values that earlier commands
+    // produced. The command then runs normally, so later commands see the outputs of the model's own options.
+    auto commands = m_model.GetCommands();
+    for (uint32_t i = 0; i < commands.size(); i++)
+    {
+        auto dispatchCommand = std::get_if<Model::DispatchCommand>(&commands[i].command);
+        if (dispatchCommand && !tuned[dispatchCommand->dispatchableId])
+        {
+            tuned[dispatchCommand->dispatchableId] = true;
+            auto& desc = m_model.GetDispatchable(dispatchCommand->dispatchableId);
+            if (auto dmlDesc = std::get_if<Model::DmlDispatchableDesc>(&desc.value))
+            {
+                tunedOptions.emplace_back(desc.name, AutotuneDispatchable(*dispatchCommand, *dmlDesc));
+            }
+        }
+
+        RunCommand(i);
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("dispatchables");
+    writer.StartObject();
+    for (auto& [name, options] : tunedOptions)
+    {
+        writer.Key(name.data(), static_cast<rapidjson::SizeType>(name.size()));
+        writer.StartObject();
+        writer.Key("executionFlags");
+        writer.StartArray();
+        for (auto [flag, flagName] : { 
+            std::make_pair(DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION, "DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION"),
+            std::make_pair(DML_EXECUTION_FLAG_DISABLE_META_COMMANDS, "DML_EXECUTION_FLAG_DISABLE_META_COMMANDS"),
+            std::make_pair(DML_EXECUTION_FLAG_DESCRIPTORS_VOLATILE, "DML_EXECUTION_FLAG_DESCRIPTORS_VOLATILE") })
+        {
+            if (options.executionFlags & flag)
+            {
+                writer.String(flagName);
+            }
+        }
+        writer.EndArray();
+        writer.Key("dmlCompileType");
+        writer.String(options.compileType == Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph ? "DmlCompileGraph" : "DmlCompileOp");
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+
+    std::ofstream file(overlayPath, std::ofstream::trunc);
+    if (!file.is_open())
+    {
+        throw std::ios::failure(fmt::format("Could not open autotune overlay '{}'", overlayPath.string()));
+    }
+    file << buffer.GetString() << "\n";
+    m_logger->LogInfo(fmt::format("Autotune overlay written to '{}'", overlayPath.string()).c_str());
+}
+
+Executor::ExecutionOptions Executor::AutotuneDispatchable(const Model::DispatchCommand& command, const Model::DmlDispatchableDesc& desc)
+{
+    using DmlCompileType = Model::DmlDispatchableDesc::DmlCompileType;
+
+    TraceScope traceScope(fmt::format("Autotune '{}'", command.dispatchableName));
+    auto& plan = m_model.GetBindingPlan(command.bindingPlanId);
+    auto& initBindings = m_resolvedBindings[desc.initBindingPlanId];
+
+    // Resources bound to the operator's outputs are compared against the results of the model's own options, using
+    // the data type of the tensor they're bound to (a resource's own data type is unknown unless it has initial values).
+    // Deferred resources don't exist until the dispatch runs, so they aren't compared.
+    std::vector<Model::ResourceId> outputResourceIds;
+    std::vector<DML_TENSOR_DATA_TYPE> outputDataTypes;
+    std::optional<AbstractOperatorDesc> operatorDesc;
+    std::vector<DmlBufferTensorDesc*> outputTensors;
+    if (desc.desc)
+    {
+        operatorDesc = SchemaHelpers::ConvertOperatorDesc(*desc.desc);
+        outputTensors = operatorDesc->GetOutputTensors();
+    }
+    uint32_t outputIndex = 0;
+    for (auto& bindPoint : desc.bindPoints.outputs)
+    {
+        auto target = std::find_if(plan.targets.begin(), plan.targets.end(), [&](auto& t) { return t.name == bindPoint.name; });
+        for (uint32_t i = 0; target != plan.targets.end() && i < target->sourceCount; i++)
+        {
+            auto resourceId = plan.sources[target->firstSourceIndex + i].resourceId;
+            if (m_resources[resourceId])
+            {
+                auto tensor = outputIndex + i < outputTensors.size() ? outputTensors[outputIndex + i] : nullptr;
+                outputResourceIds.push_back(resourceId);
+                outputDataTypes.push_back(tensor ? tensor->dataType : DML_TENSOR_DATA_TYPE_UNKNOWN);
+            }
+        }
+        outputIndex += bindPoint.resourceCount;
+    }
+
+    // Every variant starts from the contents the command's resources have now: the operator may read a resource it 
+    // also writes, and the variants are compared on their outputs. The contents are restored after the last variant
+    // too, so the command then runs as if autotuning hadn't happened.
+    std::vector<std::pair<ID3D12Resource*, ComPtr<ID3D12Resource>>> snapshots;
+    for (auto& source : plan.sources)
+    {
+        auto resource = m_resources[source.resourceId].Get();
+        auto isCopied = std::any_of(snapshots.begin(), snapshots.end(), [&](auto& snapshot) { return snapshot.first == resource; });
+        if (resource && !isCopied)
+        {
+            auto snapshot = m_device->CreatePreferredDeviceMemoryBuffer(resource->GetDesc().Width);
+            m_device->RecordCopy(snapshot.Get(), resource);
+            snapshots.emplace_back(resource, std::move(snapshot));
+        }
+    }
+    m_device->ExecuteCommandListAndWait();
+
+    auto RestoreResources = [&]()
+    {
+        for (auto& [resource, snapshot] : snapshots)
+        {
+            m_device->RecordCopy(resource, snapshot.Get());
+        }
+        m_device->ExecuteCommandListAndWait();
+    };
+
+    // The model's own options come first since they're the reference for the other variants.
+    const DML_EXECUTION_FLAGS tunedFlags = DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION | DML_EXECUTION_FLAG_DISABLE_META_COMMANDS;
+    std::vector<ExecutionOptions> variants = { { desc.executionFlags, desc.compileType } };
+    for (auto compileType : { DmlCompileType::DmlCompileOp, DmlCompileType::DmlCompileGraph })
+    {
+        for (auto flags : { DML_EXECUTION_FLAG_NONE, DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION, DML_EXECUTION_FLAG_DISABLE_META_COMMANDS, tunedFlags })
+        {
+            ExecutionOptions variant = { (desc.executionFlags & ~tunedFlags) | flags, compileType };
+            if (variant.executionFlags != desc.executionFlags || variant.compileType != desc.compileType)
+            {
+                variants.push_back(variant);
+            }
+        }
+    }
+
+    m_logger->LogInfo(fmt::format("Autotune '{}':", command.dispatchableName).c_str());
+
+    std::vector<std::vector<std::byte>> referenceOutputs;
+    ExecutionOptions bestOptions = variants[0];
+    double bestMedian = std::numeric_limits<double>::infinity();
+    for (size_t variantIndex = 0; variantIndex < variants.size(); variantIndex++)
+    {
+        auto& variant = variants[variantIndex];
+        auto variantName = ExecutionOptionsToString(variant.executionFlags, variant.compileType);
+
+        double median = 0;
+        std::vector<std::vector<std::byte>> outputs;
+        try
+        {
+            if (variantIndex > 0)
+            {
+                RestoreResources();
+            }
+
+            // The executor already created the dispatchable with the model's own options.
+            std::unique_ptr<Dispatchable> variantDispatchable;
+            if (variantIndex > 0)
+            {
+                Model::DmlDispatchableDesc variantDesc = desc;
+                variantDesc.executionFlags = variant.executionFlags;
+                variantDesc.compileType = variant.compileType;
+                variantDispatchable = std::make_unique<DmlDispatchable>(command.dispatchableName, m_device, variantDesc, initBindings, m_logger.Get());
+                variantDispatchable->Initialize();
+            }
+
+            if (variantDispatchable)
+            {
+                median = MeasureDispatch(*variantDispatchable, command);
+            }
+            else
+            {
+                SweepPointScope sweepPointScope(*m_dispatchables[command.dispatchableId], m_isSweepPoint[command.dispatchableId]);
+                median = MeasureDispatch(*m_dispatchables[command.dispatchableId], command);
+            }
+
+            for (auto resourceId : outputResourceIds)
+            {
+                outputs.push_back(m_device->Download(m_resources[resourceId]));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            if (variantIndex == 0)
+            {
+                throw;
+            }
+            m_logger->LogInfo(fmt::format("  {}: skipped ({})", variantName, e.what()).c_str());
+            continue;
+        }
+
+        if (variantIndex == 0)
+        {
+            referenceOutputs = std::move(outputs);
+        }
+        else
+        {
+            double maxDifference = 0;
+            for (size_t i = 0; i < outputResourceIds.size(); i++)
+            {
+                maxDifference = std::max(maxDifference, MaxRelativeDifference(referenceOutputs[i], outputs[i], outputDataTypes[i]));
+            }
+
+            if (maxDifference > m_commandLineArgs.AutotuneTolerance())
+            {
+                m_logger->LogInfo(fmt::format("  {}: {:.4f} ms median, rejected (max relative difference {:g})", variantName, median, maxDifference).c_str());
+                continue;
+            }
+        }
+
+        m_logger->LogInfo(fmt::format("  {}: {:.4f} ms median", variantName, median).c_str());
+        if (median < bestMedian)
+        {
+            bestMedian = median;
+            bestOptions = variant;
+        }
+    }
+
+    RestoreResources();
+
+    m_logger->LogInfo(fmt::format("  fastest: {}", ExecutionOptionsToString(bestOptions.executionFlags, bestOptions.compileType)).c_str());
+    return bestOptions;
+}
+
+double Executor::MeasureDispatch(Dispatchable& dispatchable, const Model::DispatchCommand& command)
 {
-    auto& dispatchable = m_dispatchables[command.dispatchableName];
+    auto& bindings = m_resolvedBindings[command.bindingPlanId];
+    ResetDeferredBindings(m_model.GetBindingPlan(command.bindingPlanId));
 
     Timings cpuTimings;
     Timings gpuTimings;
+    Timer loopTimer, dispatchTimer;
+    for (uint32_t iteration = 0; iteration < m_commandLineArgs.DispatchIterations(); iteration++)
+    {
+        if (m_commandLineArgs.TimeToRunInMilliseconds() &&
+            loopTimer.End().DurationInMilliseconds() > m_commandLineArgs.TimeToRunInMilliseconds().value())
+        {
+            break;
+        }
 
-    Dispatchable::Bindings bindings;
+        dispatchable.Bind(bindings, iteration);
+        dispatchTimer.Start();
+        dispatchable.Dispatch(command, iteration, m_deferredBinding);
+        cpuTimings.rawSamples.push_back(dispatchTimer.End().DurationInMilliseconds() / m_commandLineArgs.DispatchRepeat());
+    }
+
+    // GPU timings are preferred since they exclude the CPU cost of submitting and waiting on the work.
+    gpuTimings.rawSamples = m_device->ResolveTimingSamples(command.dispatchableName);
+    auto& timings = gpuTimings.rawSamples.empty() ? cpuTimings : gpuTimings;
+    return timings.ComputeStats(m_commandLineArgs.MaxWarmupSamples()).hot.median;
+}
+
+void Executor::ReportSweeps()
+{
+    std::ofstream csvFile;
+    if (m_commandLineArgs.SweepResultsPath())
+    {
+        csvFile.open(*m_commandLineArgs.SweepResultsPath(), std::ofstream::trunc);
+        if (!csvFile.is_open())
+        {
+            m_logger->LogError(fmt::format("Could not open sweep results file '{}'", m_commandLineArgs.SweepResultsPath()->string()).c_str());
+        }
+    }
+
+    bool csvHeaderWritten = false;
+    for (auto& sweep : m_model.GetSweeps())
+    {
+        // Each column is as wide as its longest value so the table lines up in a console.
+        std::vector<size_t> columnWidths;
+        for (auto& parameterName : sweep.parameterNames)
+        {
+            columnWidths.push_back(parameterName.size());
+        }
+        for (auto& point : sweep.points)
+        {
+            for (size_t i = 0; i < point.parameterValues.size(); i++)
+            {
+                columnWidths[i] = std::max(columnWidths[i], point.parameterValues[i].size());
+            }
+        }
+
+        std::string header;
+        for (size_t i = 0; i < sweep.parameterNames.size(); i++)
+        {
+            header += fmt::format("{:<{}}  ", sweep.parameterNames[i], columnWidths[i]);
+        }
+        header += fmt::format("{:>10}  {:>15}  {:>15}", "iterations", "CPU median (ms)", "GPU median (ms)");
+
+        m_logger->LogInfo(fmt::format("Sweep '{}':", sweep.name).c_str());
+        m_logger->LogInfo(header.c_str());
+
+        for (auto& point : sweep.points)
+        {
+            auto& result = m_dispatchResults[point.dispatchableId];
+
+            std::string row;
+            for (size_t i = 0; i < point.parameterValues.size(); i++)
+            {
+                row += fmt::format("{:<{}}  ", point.parameterValues[i], columnWidths[i]);
+            }
+            row += fmt::format("{:>10}  {:>15.4f}  {:>15}", 
+                result.iterations, 
+                result.cpuMedianInMilliseconds, 
+                result.gpuMedianInMilliseconds ? fmt::format("{:.6f}", *result.gpuMedianInMilliseconds) : "-");
+            m_logger->LogInfo(row.c_str());
+        }
+
+        if (csvFile.is_open())
+        {
+            // Sweeps may have different parameters, so the parameter names and values are written as a single 
+            // column of 'name=value' pairs rather than one column per parameter.
+            if (!csvHeaderWritten)
+            {
+                csvFile << "sweep,parameters,iterations,cpu_median_ms,gpu_median_ms\n";
+                csvHeaderWritten = true;
+            }
+
+            for (auto& point : sweep.points)
+            {
+                auto& result = m_dispatchResults[point.dispatchableId];
+
+                std::string parameters;
+                for (size_t i = 0; i < point.parameterValues.size(); i++)
+                {
+                    parameters += fmt::format("{}{}={}", i ? ";" : "", sweep.parameterNames[i], point.parameterValues[i]);
+                }
+
+                csvFile << fmt::format("{},\"{}\",{},{:.6f},{}\n",
+                    sweep.name,
+                    parameters,
+                    result.iterations,
+                    result.cpuMedianInMilliseconds,
+                    result.gpuMedianInMilliseconds ? fmt::format("{:.6f}", *result.gpuMedianInMilliseconds) : "");
+            }
+        }
+    }
+
+    if (csvFile.is_open())
+    {
+        m_logger->LogInfo(fmt::format("Sweep results written to '{}'", m_commandLineArgs.SweepResultsPath()->string()).c_str());
+    }
+}
+
+#ifndef ONNXRUNTIME_NONE
+void Executor::BenchmarkStreams(const Model::DispatchCommand& command, OnnxDispatchable& dispatchable)
+{
+    TraceScope traceScope(fmt::format("Benchmark streams '{}'", command.dispatchableName));
+
+    ResetDeferredBindings(m_model.GetBindingPlan(command.bindingPlanId));
     try
     {
-        m_deferredBinding.clear();
-        bindings = ResolveBindings(command.bindings);
+        dispatchable.Bind(m_resolvedBindings[command.bindingPlanId], 0);
     }
     catch (const std::exception& e)
     {
-        m_logger->LogError(fmt::format("Failed to resolve bindings: {}", e.what()).c_str());
+        m_logger->LogError(fmt::format("ERROR while binding resources: {}\n", e.what()).c_str());
         throw;
     }
 
+    struct StreamResult
+    {
+        uint32_t streamCount;
+        uint32_t inferences;
+        double throughput; // Inferences per second.
+        Timings::Stats latency;
+    };
+    std::vector<StreamResult> results;
+
+    // A single inference per stream says nothing about throughput, so without -i or -t each stream count runs for
+    // a fixed time.
+    uint32_t iterationsPerStream = m_commandLineArgs.DispatchIterations();
+    std::optional<uint32_t> timeToRunInMilliseconds = m_commandLineArgs.TimeToRunInMilliseconds();
+    if (!m_commandLineArgs.DispatchIterationsSpecified())
+    {
+        iterationsPerStream = std::numeric_limits<uint32_t>::max();
+        timeToRunInMilliseconds = c_defaultStreamTimeToRunInMilliseconds;
+    }
+
+    m_logger->LogInfo(fmt::format("Dispatch '{}' with concurrent streams:", command.dispatchableName).c_str());
+    for (uint32_t streamCount : m_commandLineArgs.OnnxStreamCounts())
+    {
+        OnnxDispatchable::StreamTimings streamTimings;
+        try
+        {
+            TraceScope streamScope(fmt::format("{} streams", streamCount));
+            streamTimings = dispatchable.RunConcurrentStreams(streamCount, iterationsPerStream, timeToRunInMilliseconds);
+        }
+        catch (const std::exception& e)
+        {
+            m_logger->LogError(fmt::format("Failed to execute dispatchable with {} streams: {}", streamCount, e.what()).c_str());
+            throw;
+        }
+
+        // Warmup samples are dropped from each stream before the latencies are combined.
+        Timings latencies;
+        for (auto& streamLatencies : streamTimings.latencies)
+        {
+            Timings streamSamples;
+            streamSamples.rawSamples = streamLatencies;
+            size_t coldSampleCount = streamSamples.ComputeStats(m_commandLineArgs.MaxWarmupSamples()).cold.count;
+            latencies.rawSamples.insert(latencies.rawSamples.end(), streamLatencies.begin() + coldSampleCount, streamLatencies.end());
+        }
+
+        StreamResult result = {};
+        result.streamCount = streamCount;
+        for (auto& streamLatencies : streamTimings.latencies)
+        {
+            result.inferences += static_cast<uint32_t>(streamLatencies.size()) * m_commandLineArgs.DispatchRepeat();
+        }
+        result.throughput = streamTimings.durationInMilliseconds > 0 ? result.inferences * 1000.0 / streamTimings.durationInMilliseconds : 0.0;
+        result.latency = latencies.ComputeStats(gsl::make_span<const double>(latencies.rawSamples.data(), latencies.rawSamples.size()));
+
+        // Scaling is relative to the first stream count: perfect scaling multiplies its throughput by the stream ratio.
+        double speedup = results.empty() ? 1.0 : result.throughput / results.front().throughput;
+        double efficiency = results.empty() ? 1.0 : speedup * results.front().streamCount / streamCount;
+        m_logger->LogInfo(fmt::format("Streams {:>4}       : {:.2f} inferences/s ({:.2f}x, {:.0f}% efficiency), latency {:.4f} ms median, {:.4f} ms p90, {:.4f} ms p99",
+            streamCount, result.throughput, speedup, efficiency * 100, result.latency.median, result.latency.p90, result.latency.p99
+        ).c_str());
+
+        if (m_commandLineArgs.GetTimingVerbosity() >= TimingVerbosity::Extended)
+        {
+            for (size_t stream = 0; stream < streamTimings.latencies.size(); stream++)
+            {
+                Timings streamSamples;
+                streamSamples.rawSamples = streamTimings.latencies[stream];
+                auto streamStats = streamSamples.ComputeStats(m_commandLineArgs.MaxWarmupSamples()).hot;
+                m_logger->LogInfo(fmt::format("  Stream {:>4}      : {} samples, {:.4f} ms average, {:.4f} ms median, {:.4f} ms p99, {:.4f} ms max",
+                    stream, streamStats.count, streamStats.average, streamStats.median, streamStats.p99, streamStats.max
+                ).c_str());
+            }
+        }
+
+        results.push_back(result);
+    }
+
+    // The knee is the fewest streams that get within 5% of the peak throughput; more streams mostly add latency.
+    auto peak = std::max_element(results.begin(), results.end(), [](auto& a, auto& b) { return a.throughput < b.throughput; });
+    auto knee = std::find_if(results.begin(), results.end(), [&](auto& result) { return result.throughput >= 0.95 * peak->throughput; });
+    if (results.size() > 1)
+    {
+        m_logger->LogInfo(fmt::format("Scaling            : peak {:.2f} inferences/s with {} streams, 95% of peak with {} streams",
+            peak->throughput, peak->streamCount, knee->streamCount
+        ).c_str());
+    }
+
+    // The streams write to their own copies of the bound resources, so the command's own bindings are dispatched
+    // once more for later print and write commands (and deferred outputs) to see results.
+    dispatchable.Dispatch(command, 0, m_deferredBinding);
+    m_device->ResolveTimingSamples(command.dispatchableName);
+
+    auto& dispatchResult = m_dispatchResults[command.dispatchableId];
+    dispatchResult.iterations = peak->inferences;
+    dispatchResult.cpuMedianInMilliseconds = peak->latency.median;
+    dispatchResult.gpuMedianInMilliseconds = std::nullopt;
+}
+#endif
+
+void Executor::operator()(const Model::DispatchCommand& command)
+{
+    TraceScope traceScope(fmt::format("Dispatch '{}'", command.dispatchableName));
+    auto& dispatchable = m_dispatchables[command.dispatchableId];
+    const bool isSweepPoint = command.dispatchableId < m_isSweepPoint.size() && m_isSweepPoint[command.dispatchableId];
+    SweepPointScope sweepPointScope(*dispatchable, isSweepPoint);
+
+#ifndef ONNXRUNTIME_NONE
+    if (!m_commandLineArgs.OnnxStreamCounts().empty() && command.dispatchableId < m_model.GetDispatchableDescs().size() &&
+        std::holds_alternative<Model::OnnxDispatchableDesc>(m_model.GetDispatchableDescs()[command.dispatchableId].value))
+    {
+        BenchmarkStreams(command, static_cast<OnnxDispatchable&>(*dispatchable));
+        return;
+    }
+#endif
+
+    Timings cpuTimings;
+    Timings gpuTimings;
+
+    // Bindings were resolved from the command's plan when the executor was created. Only deferred
+    // resources need to be tracked per command, since their contents are produced by the dispatch.
+    auto& bindings = m_resolvedBindings[command.bindingPlanId];
+    if (command.bindingPlanId < m_model.GetBindingPlans().size())
+    {
+        ResetDeferredBindings(m_model.GetBindingPlan(command.bindingPlanId));
+    }
+    else
+    {
+        m_deferredBinding.clear(); // Fused graphs never bind deferred resources.
+    }
+
     // Dispatch
     uint32_t iterationsCompleted = 0;
     bool timedOut = false;
+    auto targetPrecision = m_commandLineArgs.TargetPrecision();
+    bool converged = false;
+    uint32_t nextPrecisionCheck = c_adaptiveMinCheckInterval;
+
+    // In open-loop mode each iteration is a request that arrives on the schedule, whether or not earlier requests
+    // have completed. A request that arrives while the previous dispatch is still running waits in a queue.
+    uint32_t maxIterations = m_commandLineArgs.DispatchIterations();
+    Timings queueingDelays, serviceTimes, latencies;
+    if (m_arrivalSchedule)
+    {
+        // Without an explicit count, open-loop runs dispatch every arrival in the schedule (until the time limit).
+        m_arrivalSchedule->Reset();
+        maxIterations = m_commandLineArgs.DispatchIterationsSpecified() ? 
+            std::min(maxIterations, m_arrivalSchedule->Count()) : 
+            m_arrivalSchedule->Count();
+    }
+    double loopDurationInMilliseconds = 0;
+
+    auto countersBeforeDispatch = PerfCounters::Global();
     PIXBeginEvent(PIX_COLOR(128, 255, 0), L"Dispatch Loop");
     try
     {
+        TraceScope loopTraceScope("Dispatch loop");
         Timer loopTimer, iterationTimer, bindTimer, dispatchTimer;
 
-        for (; !timedOut && iterationsCompleted < m_commandLineArgs.DispatchIterations(); iterationsCompleted++)
+        for (; !timedOut && !converged && iterationsCompleted < maxIterations; iterationsCompleted++)
         {
+            std::chrono::steady_clock::time_point arrival;
+            if (m_arrivalSchedule)
+            {
+                double arrivalTime = m_arrivalSchedule->ArrivalTimeInMilliseconds(iterationsCompleted);
+                if (m_commandLineArgs.TimeToRunInMilliseconds() && arrivalTime > m_commandLineArgs.TimeToRunInMilliseconds().value())
+                {
+                    break;
+                }
+
+                arrival = loopTimer.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(arrivalTime));
+                m_pacer.WaitUntil(arrival);
+            }
+
             iterationTimer.Start();
 
             // Bind
             PIXBeginEvent(PIX_COLOR(128, 255, 0), L"Bind");
             try
             {
+                TraceScope traceScope("Bind");
                 dispatchable->Bind(bindings, iterationsCompleted);
             }
             catch (const std::exception& e)
@@ -317,29 +1086,65 @@ void Executor::operator()(const Model::DispatchCommand& command)
 
             // Dispatch
             dispatchTimer.Start();
-            dispatchable->Dispatch(command, iterationsCompleted, m_deferredBinding);
+            {
+                TraceScope traceScope("Dispatch");
+                dispatchable->Dispatch(command, iterationsCompleted, m_deferredBinding);
+            }
             cpuTimings.rawSamples.push_back(dispatchTimer.End().DurationInMilliseconds() / m_commandLineArgs.DispatchRepeat());
 
+            if (m_arrivalSchedule)
+            {
+                auto ToMilliseconds = [](std::chrono::steady_clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+                queueingDelays.rawSamples.push_back(ToMilliseconds(iterationTimer.start - arrival));
+                serviceTimes.rawSamples.push_back(ToMilliseconds(dispatchTimer.end - iterationTimer.start));
+                latencies.rawSamples.push_back(ToMilliseconds(dispatchTimer.end - arrival));
+            }
+
             // The dispatch interval defaults to 0 (dispatch as fast as possible). However, the user may increase it
-            // to potentially introduce a sleep between each iteration.
-            double timeToSleep = std::max(0.0, m_commandLineArgs.MinimumDispatchIntervalInMilliseconds() - iterationTimer.End().DurationInMilliseconds());
+            // to potentially introduce a sleep between each iteration. Open-loop requests are paced by their arrivals instead.
+            double timeToSleep = 0;
+            if (!m_arrivalSchedule)
+            {
+                timeToSleep = std::max(0.0, m_commandLineArgs.MinimumDispatchIntervalInMilliseconds() - iterationTimer.End().DurationInMilliseconds());
+            }
 
             if (m_commandLineArgs.TimeToRunInMilliseconds() &&
                 loopTimer.End().DurationInMilliseconds() + timeToSleep > m_commandLineArgs.TimeToRunInMilliseconds().value())
             {
                 timedOut = true;
             }
-            else
+            else if (timeToSleep > 0)
             {
-                // Not particularly precise (may be off by some milliseconds). Consider using OS APIs in the future.
-                std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<size_t>(timeToSleep)));
+                m_pacer.WaitUntil(iterationTimer.end + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(timeToSleep)));
             }
 
             if (m_commandLineArgs.GetPresentSeparator())
             {
                 m_device->DummyPresent();
             }
+
+            if (targetPrecision && iterationsCompleted + 1 >= nextPrecisionCheck)
+            {
+                // GPU samples are resolved at each check so convergence is tested on the same timings that are 
+                // reported. This also keeps the timestamp buffer from wrapping during long adaptive runs.
+                auto gpuSamples = m_device->ResolveTimingSamples(command.dispatchableName);
+                gpuTimings.rawSamples.insert(gpuTimings.rawSamples.end(), gpuSamples.begin(), gpuSamples.end());
+
+                auto& timings = gpuTimings.rawSamples.empty() ? cpuTimings : gpuTimings;
+                size_t warmupSamples = std::max<size_t>(m_commandLineArgs.MaxWarmupSamples(), timings.DetectWarmupSampleCount());
+                auto hotStats = timings.ComputeStats(warmupSamples).hot;
+                converged = hotStats.count >= c_adaptiveMinHotSamples && hotStats.MedianIntervalWidth() <= *targetPrecision;
+
+                uint32_t checkInterval = std::max(c_adaptiveMinCheckInterval, (iterationsCompleted + 1) / 8);
+                if (m_device->GpuTimingEnabled())
+                {
+                    checkInterval = std::min(checkInterval, m_commandLineArgs.MaxGpuTimeMeasurements());
+                }
+                nextPrecisionCheck = iterationsCompleted + 1 + checkInterval;
+            }
         }
+
+        loopDurationInMilliseconds = loopTimer.End().DurationInMilliseconds();
     }
     catch (const std::exception& e)
     {
@@ -348,14 +1153,43 @@ void Executor::operator()(const Model::DispatchCommand& command)
     }
     PIXEndEvent();
 
-    auto cpuStats = cpuTimings.ComputeStats(m_commandLineArgs.MaxWarmupSamples());
+    auto counters = PerfCounters::Global() - countersBeforeDispatch;
+
+    // In adaptive mode the warmup samples are detected from the timings themselves, with --warmup_samples as a minimum.
+    size_t cpuWarmupSamples = m_commandLineArgs.MaxWarmupSamples();
+    if (targetPrecision)
+    {
+        cpuWarmupSamples = std::max(cpuWarmupSamples, cpuTimings.DetectWarmupSampleCount());
+    }
+    auto cpuStats = cpuTimings.ComputeStats(cpuWarmupSamples);
 
     // GPU timings are capped at a fixed size ring buffer. The first samples may have been 
     // overwritten, in which case the warmup samples are dropped.
-    gpuTimings.rawSamples = m_device->ResolveTimingSamples();
+    auto gpuSamples = m_device->ResolveTimingSamples(command.dispatchableName);
+    gpuTimings.rawSamples.insert(gpuTimings.rawSamples.end(), gpuSamples.begin(), gpuSamples.end());
     assert(cpuTimings.rawSamples.size() >= gpuTimings.rawSamples.size());
     auto gpuSamplesOverwritten =  static_cast<uint32_t>(gpuTimings.rawSamples.empty() ? 0 : cpuTimings.rawSamples.size() - gpuTimings.rawSamples.size());
-    auto gpuStats = gpuTimings.ComputeStats(std::max(m_commandLineArgs.MaxWarmupSamples(), gpuSamplesOverwritten) - gpuSamplesOverwritten);
+    size_t gpuWarmupSamples = std::max(m_commandLineArgs.MaxWarmupSamples(), gpuSamplesOverwritten) - gpuSamplesOverwritten;
+    if (targetPrecision)
+    {
+        gpuWarmupSamples = std::max(gpuWarmupSamples, gpuTimings.DetectWarmupSampleCount());
+    }
+    auto gpuStats = gpuTimings.ComputeStats(gpuWarmupSamples);
+
+    // In adaptive mode, the achieved precision of the median is reported next to the timings.
+    auto PrecisionText = [&](const Timings::Stats& stats) -> std::string
+    {
+        if (!targetPrecision)
+        {
+            return "";
+        }
+        return fmt::format(", median 95% CI [{:.4f}, {:.4f}] ms ({:.2f}% wide)", stats.medianLow, stats.medianHigh, stats.MedianIntervalWidth() * 100);
+    };
+
+    auto& dispatchResult = m_dispatchResults[command.dispatchableId];
+    dispatchResult.iterations = iterationsCompleted;
+    dispatchResult.cpuMedianInMilliseconds = cpuStats.hot.median;
+    dispatchResult.gpuMedianInMilliseconds = gpuTimings.rawSamples.empty() ? std::nullopt : std::make_optional(gpuStats.hot.median);
 
     if (iterationsCompleted > 0)
     {
@@ -363,19 +1197,21 @@ void Executor::operator()(const Model::DispatchCommand& command)
         {
             if (gpuTimings.rawSamples.empty())
             {
-                m_logger->LogInfo(fmt::format("Dispatch '{}': {} iterations, {:.4f} ms median (CPU)",
+                m_logger->LogInfo(fmt::format("Dispatch '{}': {} iterations, {:.4f} ms median (CPU){}",
                     command.dispatchableName, 
                     iterationsCompleted,
-                    cpuStats.hot.median
+                    cpuStats.hot.median,
+                    PrecisionText(cpuStats.hot)
                 ).c_str());
             }
             else
             {
-                m_logger->LogInfo(fmt::format("Dispatch '{}': {} iterations, {:.4f} ms median (CPU), {:.6f} ms median (GPU)",
+                m_logger->LogInfo(fmt::format("Dispatch '{}': {} iterations, {:.4f} ms median (CPU), {:.6f} ms median (GPU){}",
                     command.dispatchableName, 
                     iterationsCompleted,
                     cpuStats.hot.median,
-                    gpuStats.hot.median
+                    gpuStats.hot.median,
+                    PrecisionText(gpuStats.hot)
                 ).c_str());
             }
         }
@@ -401,15 +1237,22 @@ void Executor::operator()(const Model::DispatchCommand& command)
 
             if (cpuStats.hot.count > 0)
             {
-                m_logger->LogInfo(fmt::format("CPU Timings (Hot)  : {} samples, {:.4f} ms average, {:.4f} ms min, {:.4f} ms median, {:.4f} ms max",
-                    cpuStats.hot.count, cpuStats.hot.average, cpuStats.hot.min, cpuStats.hot.median, cpuStats.hot.max
+                m_logger->LogInfo(fmt::format("CPU Timings (Hot)  : {} samples, {:.4f} ms average, {:.4f} ms min, {:.4f} ms median, {:.4f} ms max{}",
+                    cpuStats.hot.count, cpuStats.hot.average, cpuStats.hot.min, cpuStats.hot.median, cpuStats.hot.max, PrecisionText(cpuStats.hot)
                 ).c_str());
             }
 
             if (gpuStats.hot.count > 0)
             {
-                m_logger->LogInfo(fmt::format("GPU Timings (Hot)  : {} samples, {:.4f} ms average, {:.4f} ms min, {:.4f} ms median, {:.4f} ms max",
-                    gpuStats.hot.count, gpuStats.hot.average, gpuStats.hot.min, gpuStats.hot.median, gpuStats.hot.max
+                m_logger->LogInfo(fmt::format("GPU Timings (Hot)  : {} samples, {:.4f} ms average, {:.4f} ms min, {:.4f} ms median, {:.4f} ms max{}",
+                    gpuStats.hot.count, gpuStats.hot.average, gpuStats.hot.min, gpuStats.hot.median, gpuStats.hot.max, PrecisionText(gpuStats.hot)
+                ).c_str());
+            }
+
+            if (targetPrecision)
+            {
+                m_logger->LogInfo(fmt::format("Adaptive           : {} ({:.2f}% target), {} CPU and {} GPU warmup samples",
+                    converged ? "converged" : "not converged", *targetPrecision * 100, cpuStats.cold.count, gpuStats.cold.count
                 ).c_str());
             }
 
@@ -417,6 +1260,43 @@ void Executor::operator()(const Model::DispatchCommand& command)
             {
                 m_logger->LogInfo(fmt::format("GPU samples buffer has {} samples overwritten.", gpuSamplesOverwritten).c_str());
             }
+
+#if DXD_PERF_COUNTERS
+            m_logger->LogInfo(fmt::format("Counters           : {} resources ({} bytes), {} descriptor heaps, {} binding tables, {} submissions, {} fence waits ({:.4f} ms)",
+                counters.resourcesCreated, counters.bytesAllocated, counters.descriptorHeapsCreated, counters.bindingTablesCreated,
+                counters.commandListSubmissions, counters.fenceWaits, counters.fenceWaitMilliseconds
+            ).c_str());
+#endif
+        }
+
+        if (m_arrivalSchedule)
+        {
+            // Open-loop results are reported at every verbosity: the tail latencies under load are the point of the mode.
+            static constexpr const char* processNames[] = { "fixed", "poisson", "trace" };
+            m_logger->LogInfo(fmt::format("Open loop          : {} arrivals ({} at {:.2f}/s), {:.2f}/s completed",
+                iterationsCompleted, 
+                processNames[static_cast<size_t>(m_arrivalSchedule->GetProcess())], 
+                m_arrivalSchedule->RatePerSecond(),
+                loopDurationInMilliseconds > 0 ? iterationsCompleted * 1000.0 / loopDurationInMilliseconds : 0.0
+            ).c_str());
+
+            auto LogPercentiles = [&](const char* label, const Timings& timings)
+            {
+                auto stats = timings.ComputeStats(m_commandLineArgs.MaxWarmupSamples()).hot;
+                m_logger->LogInfo(fmt::format("{}: {} samples, {:.4f} ms p50, {:.4f} ms p90, {:.4f} ms p99, {:.4f} ms p99.9, {:.4f} ms max",
+                    label, stats.count, stats.median, stats.p90, stats.p99, stats.p999, stats.max
+                ).c_str());
+            };
+            LogPercentiles("Queueing Delay     ", queueingDelays);
+            LogPercentiles("Service Time       ", serviceTimes);
+            LogPercentiles("End-to-End Latency ", latencies);
+        }
+
+        if (targetPrecision && !converged)
+        {
+            m_logger->LogWarning(fmt::format("Dispatch '{}' did not reach the target precision of {:.2f}% before the iteration or time limit",
+                command.dispatchableName, *targetPrecision * 100
+            ).c_str());
         }
 
         if (m_commandLineArgs.GetTimingVerbosity() >= TimingVerbosity::All)
@@ -451,19 +1331,36 @@ struct BufferDataView
     const Model::BufferDesc& desc;
 };
 
+// Element types for printing packed 4-bit tensors, which are only unpacked as they are formatted.
+struct PackedInt4 {};
+struct PackedUInt4 {};
+
+template <typename T>
+auto ReadElement(gsl::span<const std::byte> byteValues, uint32_t elementIndex)
+{
+    if constexpr (std::is_same_v<T, PackedInt4> || std::is_same_v<T, PackedUInt4>)
+    {
+        int32_t nibble = (std::to_integer<int32_t>(byteValues[elementIndex / 2]) >> ((elementIndex % 2) * 4)) & 0xF;
+        return std::is_same_v<T, PackedInt4> ? (nibble ^ 8) - 8 : nibble;
+    }
+    else
+    {
+        return reinterpret_cast<const T*>(byteValues.data())[elementIndex];
+    }
+}
+
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const BufferDataView<T>& view)
 {
-    auto nBytes = std::max(view.desc.sizeInBytes, (uint64_t) view.desc.initialValues.size());
-    uint64_t elementCount = nBytes / Device::GetSizeInBytes(view.desc.initialValuesDataType);
+    auto nBytes = std::max(view.desc.sizeInBytes, view.desc.InitialValuesSizeInBytes());
+    uint64_t elementCount = nBytes * 8 / Device::GetSizeInBits(view.desc.initialValuesDataType);
     if (elementCount > std::numeric_limits<uint32_t>::max())
     {
         throw std::invalid_argument("Buffer size is too large");
     }
-    auto values = reinterpret_cast<const T*>(view.byteValues.data());
     for (uint32_t elementIndex = 0; elementIndex < elementCount; elementIndex++)
     {
-        os << values[elementIndex];
+        os << ReadElement<T>(view.byteValues, elementIndex);
         if (elementIndex < elementCount - 1)
         {
             os << ", ";
@@ -488,6 +1385,8 @@ std::string ToString(gsl::span<const std::byte> byteValues, const Model::BufferD
     case DML_TENSOR_DATA_TYPE_INT16: ss << BufferDataView<int16_t>{byteValues, desc}; break;
     case DML_TENSOR_DATA_TYPE_INT32: ss << BufferDataView<int32_t>{byteValues, desc}; break;
     case DML_TENSOR_DATA_TYPE_INT64: ss << BufferDataView<int64_t>{byteValues, desc}; break;
+    case DML_TENSOR_DATA_TYPE_UINT4: ss << BufferDataView<PackedUInt4>{byteValues, desc}; break;
+    case DML_TENSOR_DATA_TYPE_INT4: ss << BufferDataView<PackedInt4>{byteValues, desc}; break;
     default: throw std::invalid_argument("Unexpected DML_TENSOR_DATA_TYPE");
     }
     return ss.str();
@@ -496,15 +1395,15 @@ std::string ToString(gsl::span<const std::byte> byteValues, const Model::BufferD
 void Executor::operator()(const Model::PrintCommand& command)
 {
     PIXScopedEvent(m_device->GetCommandList(), PIX_COLOR(255,255,0), "Print: %s", command.resourceName.c_str());
+    TraceScope traceScope(fmt::format("Print '{}'", command.resourceName));
 
     try
     {
-        auto& resourceDesc = m_model.GetResource(command.resourceName);
+        auto& resourceDesc = m_model.GetResource(command.resourceId);
         auto& bufferDescTemp = std::get<Model::BufferDesc>(resourceDesc.value);
 
         std::optional<Model::BufferDesc> bufferDesc;
-        gsl::span<std::byte> outputValues;
-        std::vector<std::byte> outputValuesStorage;
+        std::vector<std::byte> cpuValues;
         ID3D12Resource* resource;
         if (bufferDescTemp.useDeferredBinding)
         {
@@ -519,7 +1418,7 @@ void Executor::operator()(const Model::PrintCommand& command)
             resource = deferredBinding->resource.Get();
             if (resource == nullptr)
             {
-                outputValues = gsl::span<std::byte>(deferredBinding->cpuValues);
+                cpuValues = deferredBinding->cpuValues;
             }
 
             bufferDesc = 
@@ -533,26 +1432,47 @@ void Executor::operator()(const Model::PrintCommand& command)
         }
         else
         {
-            resource = m_resources[command.resourceName].Get();
-            bufferDesc = bufferDescTemp;
+            resource = m_resources[command.resourceId].Get();
 
             // Buffers are padded up to a 4 byte alignment (DML requirement), but for printing the padding 
             // might be confusing. For example, a buffer initialized with 5x FP16 elements would would only
             // require 10 bytes, but the buffer's actual size would be 12 bytes. Printing the buffer based
             // on its size alone would show 6x FP16 elements (last element being padding) so this trims the 
-            // buffer view to match the non-padded region.
-            if (bufferDesc->initialValues.size() > 0)
+            // buffer view to match the non-padded region. The initial values themselves aren't needed.
+            bufferDesc = 
             {
-                bufferDesc->sizeInBytes = bufferDesc->initialValues.size();
-            }
+                bufferDescTemp.InitialValuesSizeInBytes() > 0 ? bufferDescTemp.InitialValuesSizeInBytes() : bufferDescTemp.sizeInBytes,
+                std::vector<std::byte>(),
+                bufferDescTemp.initialValuesDataType,
+                0,
+                false
+            };
         } 
+
+        // The values are formatted on the readback thread while later commands run; the queue logs the result.
+        auto print = [resourceName = command.resourceName, bufferDesc = std::move(*bufferDesc)](
+            gsl::span<const std::byte> values,
+            std::vector<ReadbackQueue::Message>& messages)
+        {
+            try
+            {
+                messages.push_back({ ReadbackQueue::Message::Level::Info, fmt::format("Resource '{}': {}", resourceName, ToString(values, bufferDesc)) });
+            }
+            catch (const std::exception& e)
+            {
+                messages.push_back({ ReadbackQueue::Message::Level::Error, fmt::format("Failed to print resource: {}", e.what()) });
+                throw;
+            }
+        };
+
         if (resource)
         {
-            outputValuesStorage = m_device->Download(resource);
-            outputValues = outputValuesStorage;
+            m_readbackQueue->Enqueue(resource, std::move(print));
+        }
+        else
+        {
+            m_readbackQueue->Enqueue(std::move(cpuValues), std::move(print));
         }
-
-        m_logger->LogInfo(fmt::format("Resource '{}': {}", command.resourceName, ToString(outputValues, bufferDesc.value())).c_str());
     }
     catch (const std::exception& e)
     {
@@ -564,13 +1484,13 @@ void Executor::operator()(const Model::PrintCommand& command)
 void Executor::operator()(const Model::WriteFileCommand& command)
 {
     PIXScopedEvent(m_device->GetCommandList(), PIX_COLOR(255,255,0), "WriteFile: %s", command.resourceName.c_str());
+    TraceScope traceScope(fmt::format("WriteFile '{}'", command.resourceName));
 
     try
     {
-        auto& resourceDesc = m_model.GetResource(command.resourceName);
+        auto& resourceDesc = m_model.GetResource(command.resourceId);
         auto& bufferDesc = std::get<Model::BufferDesc>(resourceDesc.value);
-        gsl::span<std::byte> fileData;
-        std::vector<std::byte> fileDataStorage;
+        std::vector<std::byte> cpuValues;
 
         std::vector<uint32_t> dimensions;
         ID3D12Resource* resource;
@@ -591,52 +1511,71 @@ void Executor::operator()(const Model::WriteFileCommand& command)
             resource = deferredBinding->resource.Get();
             if (resource == nullptr)
             {
-                fileData = gsl::span<std::byte>(deferredBinding->cpuValues);
+                cpuValues = deferredBinding->cpuValues;
             }
             tensorType = deferredBinding->type;
         }
         else
         {
-            resource = m_resources[command.resourceName].Get();
+            resource = m_resources[command.resourceId].Get();
             dimensions = std::vector<uint32_t>(command.dimensions);
             tensorType = bufferDesc.initialValuesDataType;
         } 
-        if (resource)
-        {
-            fileDataStorage = m_device->Download(resource);
-            fileData = fileDataStorage;
-        }
 
-        std::filesystem::path pathToFile(command.targetPath.c_str());
-        if (!std::filesystem::exists(pathToFile.parent_path()))
+        // Encoding and file I/O happen on the readback thread while later commands run; the queue logs the result.
+        auto writeFile = [
+            command,
+            sizeInBytes = bufferDesc.sizeInBytes,
+            dataType = bufferDesc.initialValuesDataType,
+            dimensions = std::move(dimensions),
+            tensorType](gsl::span<const std::byte> fileData, std::vector<ReadbackQueue::Message>& messages) mutable
         {
-            std::filesystem::create_directories(pathToFile.parent_path());
-        }
+            try
+            {
+                std::filesystem::path pathToFile(command.targetPath.c_str());
+                if (!std::filesystem::exists(pathToFile.parent_path()))
+                {
+                    std::filesystem::create_directories(pathToFile.parent_path());
+                }
 
-        std::ofstream file(command.targetPath.c_str(), std::ifstream::trunc | std::ifstream::binary);
-        if (!file.is_open())
-        {
-            throw std::ios::failure("Could not open file");
-        }
+                std::ofstream file(command.targetPath.c_str(), std::ifstream::trunc | std::ifstream::binary);
+                if (!file.is_open())
+                {
+                    throw std::ios::failure("Could not open file");
+                }
 
-        // If NumPy array, serialize data into .npy file.
-        if (IsNpyFilenameExtension(command.targetPath))
-        {
-            // If no dimensions were given, then treat as a 1D array.
-            if (dimensions.empty())
+                // If NumPy array, serialize data into .npy file.
+                std::vector<std::byte> npyFileData;
+                if (IsNpyFilenameExtension(command.targetPath))
+                {
+                    // If no dimensions were given, then treat as a 1D array.
+                    if (dimensions.empty())
+                    {
+                        uint32_t elementCount = static_cast<uint32_t>(sizeInBytes * 8 / Device::GetSizeInBits(dataType));
+                        dimensions.push_back(elementCount);
+                    }
+
+                    WriteNpy(fileData, tensorType, dimensions, /*out*/ npyFileData);
+                    fileData = npyFileData;
+                }
+
+                file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+                messages.push_back({ ReadbackQueue::Message::Level::Info, fmt::format("Resource '{}' written to '{}'", command.resourceName, command.targetPath) });
+            }
+            catch (const std::exception& e)
             {
-                uint32_t elementCount = static_cast<uint32_t>(bufferDesc.sizeInBytes / Device::GetSizeInBytes(bufferDesc.initialValuesDataType));
-                dimensions.push_back(elementCount);
+                messages.push_back({ ReadbackQueue::Message::Level::Error, fmt::format("Failed to write resource to file '{}': {}", command.targetPath, e.what()) });
             }
+        };
 
-            std::vector<std::byte> npyFileData;
-            WriteNpy(fileData, tensorType, dimensions, /*out*/ npyFileData);
-            std::swap(fileDataStorage, npyFileData);
-            fileData = fileDataStorage;
+        if (resource)
+        {
+            m_readbackQueue->Enqueue(resource, std::move(writeFile));
+        }
+        else
+        {
+            m_readbackQueue->Enqueue(std::move(cpuValues), std::move(writeFile));
         }
-
-        file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
-        m_logger->LogInfo(fmt::format("Resource '{}' written to '{}'", command.resourceName, command.targetPath).c_str());
     }
     catch (const std::exception& e)
     {
@@ -644,66 +1583,72 @@ void Executor::operator()(const Model::WriteFileCommand& command)
     }
 }
 
-Dispatchable::Bindings Executor::ResolveBindings(const Model::Bindings& modelBindings)
+void Executor::ResetDeferredBindings(const Model::BindingPlan& plan)
+{
+    m_deferredBinding.clear();
+    for (auto sourceIndex : plan.deferredSources)
+    {
+        auto& planSource = plan.sources[sourceIndex];
+        m_deferredBinding[m_model.GetResource(planSource.resourceId).name].name = plan.targets[planSource.targetIndex].name;
+    }
+}
+
+Dispatchable::Bindings Executor::ResolveBindings(const Model::BindingPlan& plan)
 {
     Dispatchable::Bindings bindings;
+    bindings.reserve(plan.targets.size());
 
-    for (auto& modelBinding : modelBindings)
+    for (auto& target : plan.targets)
     {
-        std::vector<Dispatchable::BindingSource> sourceResources;
+        auto& sourceResources = bindings[std::string(target.name)];
+        sourceResources.reserve(target.sourceCount);
 
-        for (auto& modelSource : modelBinding.second)
+        for (uint32_t i = 0; i < target.sourceCount; i++)
         {
-            // Validated when the model is constructed.
-            assert(m_resources.find(modelSource.name) != m_resources.end());
-            auto& resourceDesc = m_model.GetResource(modelSource.name);
+            // Resource IDs are validated when the model is constructed.
+            auto& planSource = plan.sources[target.firstSourceIndex + i];
+            assert(planSource.resourceId < m_resources.size());
+            auto& resourceDesc = m_model.GetResource(planSource.resourceId);
 
             Dispatchable::BindingSource source = {};
-            source.elementSizeInBytes = modelSource.elementSizeInBytes;
-            source.elementCount = modelSource.elementCount;
-            source.elementOffset = modelSource.elementOffset;
-            source.format = modelSource.format;
-            source.resource = m_resources[modelSource.name].Get();
+            source.elementSizeInBytes = planSource.elementSizeInBytes;
+            source.elementCount = planSource.elementCount;
+            source.elementOffset = planSource.elementOffset;
+            source.format = planSource.format;
+            source.resource = m_resources[planSource.resourceId].Get();
             source.resourceDesc = &resourceDesc;
-            source.shape = modelSource.shape;
+            source.shape.assign(planSource.shape.begin(), planSource.shape.end());
 
             if (std::holds_alternative<Model::BufferDesc>(resourceDesc.value))
             {
                 auto& modelBufferDesc = std::get<Model::BufferDesc>(resourceDesc.value);
-                if (modelBufferDesc.useDeferredBinding)
-                {
-                    auto key = modelSource.name;
-                    m_deferredBinding[key].name = modelBinding.first;
-                }
-                else
+                if (!modelBufferDesc.useDeferredBinding)
                 {
                     if (source.elementSizeInBytes == 0 && modelBufferDesc.initialValuesDataType != DML_TENSOR_DATA_TYPE_UNKNOWN)
                     {
                         // If the binding doesn't specify, assume the data type size used to initialize the buffer.
-                        source.elementSizeInBytes = Device::GetSizeInBytes(modelBufferDesc.initialValuesDataType);
+                        // Packed types smaller than a byte (e.g. INT4) are bound in units of whole bytes.
+                        source.elementSizeInBytes = std::max(Device::GetSizeInBits(modelBufferDesc.initialValuesDataType) / 8, 1u);
                     }
 
                     if (source.elementCount == 0 && source.elementSizeInBytes != 0)
                     {
                         // If the binding doesn't specify, assume the number of elements used to initialize the buffer.
-                        source.elementCount = modelBufferDesc.initialValues.size() / source.elementSizeInBytes;
+                        source.elementCount = modelBufferDesc.InitialValuesSizeInBytes() / source.elementSizeInBytes;
                     }
                 }
             }
 
-            if (modelSource.counterName)
+            if (planSource.counterResourceId != Model::InvalidId)
             {
-                // Validated when the model is constructed.
-                assert(m_resources.find(*modelSource.counterName) != m_resources.end());
-                source.counterResource = m_resources[*modelSource.counterName].Get();
-                source.counterOffsetBytes = modelSource.counterOffsetBytes;
+                assert(planSource.counterResourceId < m_resources.size());
+                source.counterResource = m_resources[planSource.counterResourceId].Get();
+                source.counterOffsetBytes = planSource.counterOffsetBytes;
             }
 
             sourceResources.push_back(source);
         }
-
-        bindings[modelBinding.first] = sourceResources;
     }
 
     return bindings;
-}
\ No newline at end of file
+}
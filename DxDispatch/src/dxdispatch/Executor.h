@@ -1,6 +1,10 @@
 #pragma once
 
+#include "LoadGenerator.h"
+#include "ReadbackQueue.h"
+
 class CommandLineArgs;
+class OnnxDispatchable;
 
 class Executor
 {
@@ -10,20 +14,66 @@ public:
     uint32_t GetCommandCount();
     void RunCommand(UINT32 id);
     void Run();
+
+    // Restores every buffer to its initial values so that another Run() starts from the state the model describes.
+    // Throws if the initial values were released (--lean_host_memory).
+    void ResetResources();
+    void Autotune(const std::filesystem::path& overlayPath);
     void operator()(const Model::DispatchCommand& command);
     void operator()(const Model::PrintCommand& command);
     void operator()(const Model::WriteFileCommand& command);
 
+    struct DispatchResult
+    {
+        uint32_t iterations = 0;
+        double cpuMedianInMilliseconds = 0;
+        std::optional<double> gpuMedianInMilliseconds;
+    };
+
+    // Timings from the most recent dispatch of a dispatchable (0 iterations if it hasn't been dispatched).
+    const DispatchResult& GetDispatchResult(Model::DispatchableId id) const { return m_dispatchResults[id]; }
+
 private:
-    Dispatchable::Bindings ResolveBindings(const Model::Bindings& modelBindings);
+
+    struct ExecutionOptions
+    {
+        DML_EXECUTION_FLAGS executionFlags;
+        Model::DmlDispatchableDesc::DmlCompileType compileType;
+    };
+
+    Dispatchable::Bindings ResolveBindings(const Model::BindingPlan& plan);
+    void ResetDeferredBindings(const Model::BindingPlan& plan);
+    void ReportSweeps();
+    ExecutionOptions AutotuneDispatchable(const Model::DispatchCommand& command, const Model::DmlDispatchableDesc& desc);
+    double MeasureDispatch(Dispatchable& dispatchable, const Model::DispatchCommand& command);
+    void BenchmarkStreams(const Model::DispatchCommand& command, OnnxDispatchable& dispatchable);
+    void FuseDmlDispatches();
 
 private:
     Model& m_model;
     std::shared_ptr<Device> m_device;
     const CommandLineArgs& m_commandLineArgs;
-    std::unordered_map<std::string, std::unique_ptr<Dispatchable>> m_dispatchables;
-    std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D12Resource>> m_resources;
+    std::vector<std::unique_ptr<Dispatchable>> m_dispatchables; // Indexed by Model::DispatchableId.
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_resources; // Indexed by Model::ResourceId.
+    std::vector<Dispatchable::Bindings> m_resolvedBindings; // Indexed by Model::BindingPlanId.
+    std::vector<DispatchResult> m_dispatchResults; // Indexed by Model::DispatchableId.
+    std::vector<bool> m_isSweepPoint; // Indexed by Model::DispatchableId.
     Dispatchable::DeferredBindings m_deferredBinding;
+    std::optional<ArrivalSchedule> m_arrivalSchedule; // Set for open-loop dispatching.
+    Pacer m_pacer;
     Microsoft::WRL::ComPtr<IDxDispatchLogger> m_logger;
     UINT32 m_nextId = 0;
+
+    // Consecutive DML dispatch commands compiled into a single graph (--fuse_dml_dispatches).
+    struct FusedDispatch
+    {
+        Model::DispatchCommand command; // Refers to a dispatchable and bindings appended after the model's own.
+        uint32_t firstCommandId;
+        uint32_t commandCount;
+    };
+    std::vector<FusedDispatch> m_fusedDispatches;
+    std::vector<uint32_t> m_fusedDispatchIndices; // Indexed by command ID; Model::InvalidId for commands that aren't fused.
+
+    // Declared last so that pending print and write file callbacks, which use the members above, finish first.
+    std::unique_ptr<ReadbackQueue> m_readbackQueue;
 };
\ No newline at end of file
@@ -11,6 +11,10 @@ using Microsoft::WRL::ComPtr;
 HlslDispatchable::HlslDispatchable(std::shared_ptr<Device> device, const Model::HlslDispatchableDesc& desc, const CommandLineArgs& args, IDxDispatchLogger* logger)
     : m_device(device), m_desc(desc), m_forceDisablePrecompiledShadersOnXbox(args.ForceDisablePrecompiledShadersOnXbox()), m_printHlslDisassembly(args.PrintHlslDisassembly()), m_logger(logger)
 {
+    if (args.HlslShaderCacheEnabled())
+    {
+        m_shaderCache.emplace(args.HlslShaderCachePath());
+    }
 }
 
 HlslDispatchable::BufferViewType GetViewType(const D3D12_SHADER_INPUT_BIND_DESC& desc)
@@ -73,15 +77,47 @@ D3D12_DESCRIPTOR_RANGE_TYPE GetDescriptorRangeType(const D3D12_SHADER_INPUT_BIND
     }
 }
 
-using BindingData = std::tuple<
-    std::vector<D3D12_DESCRIPTOR_RANGE1>, 
-    std::unordered_map<std::string, HlslDispatchable::BindPoint>>;
+// Root descriptors are only a GPU virtual address: there is no format, element count, or counter resource, 
+// so only single (non-array) raw buffers, structured buffers, and cbuffers can be bound this way.
+bool CanBindAsRootDescriptor(const D3D12_SHADER_INPUT_BIND_DESC& desc)
+{
+    if (desc.BindCount != 1)
+    {
+        return false;
+    }
 
-// Reflects descriptor ranges and binding points from the HLSL source.
-BindingData ReflectBindingData(gsl::span<D3D12_SHADER_INPUT_BIND_DESC> shaderInputDescs)
+    switch (desc.Type)
+    {
+    case D3D_SIT_CBUFFER: // cbuffer
+    case D3D_SIT_STRUCTURED: // StructuredBuffer
+    case D3D_SIT_BYTEADDRESS: // ByteAddresBuffer
+    case D3D_SIT_UAV_RWSTRUCTURED: // RWStructuredBuffer
+    case D3D_SIT_UAV_RWBYTEADDRESS: // RWByteAddressBuffer
+        return true;
+
+    default: return false;
+    }
+}
+
+D3D12_ROOT_PARAMETER_TYPE GetRootDescriptorParameterType(D3D12_DESCRIPTOR_RANGE_TYPE rangeType)
 {
-    std::vector<D3D12_DESCRIPTOR_RANGE1> descriptorRanges;
-    std::unordered_map<std::string, HlslDispatchable::BindPoint> bindPoints;
+    switch (rangeType)
+    {
+    case D3D12_DESCRIPTOR_RANGE_TYPE_CBV: return D3D12_ROOT_PARAMETER_TYPE_CBV;
+    case D3D12_DESCRIPTOR_RANGE_TYPE_SRV: return D3D12_ROOT_PARAMETER_TYPE_SRV;
+    case D3D12_DESCRIPTOR_RANGE_TYPE_UAV: return D3D12_ROOT_PARAMETER_TYPE_UAV;
+    default: throw std::invalid_argument("Unexpected binding type");
+    }
+}
+
+HlslDispatchable::BindingData HlslDispatchable::ReflectBindingData(
+    gsl::span<D3D12_SHADER_INPUT_BIND_DESC> shaderInputDescs,
+    Model::HlslDispatchableDesc::BindingMode bindingMode,
+    const std::unordered_map<std::string, uint32_t>& rootConstantSizes)
+{
+    BindingData data;
+    uint32_t rootConstantDwords = 0;
+    uint32_t rootDescriptorCount = 0;
 
     D3D12_DESCRIPTOR_RANGE1 currentRange = {};
     currentRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
@@ -94,41 +130,110 @@ BindingData ReflectBindingData(gsl::span<D3D12_SHADER_INPUT_BIND_DESC> shaderInp
         auto rangeType = GetDescriptorRangeType(shaderInputDesc);
         auto numDescriptors = shaderInputDesc.BindCount;
 
-        bindPoints[shaderInputDesc.Name] = { 
+        HlslDispatchable::BindPoint bindPoint = {
             viewType, 
             rangeType, 
-            currentOffsetInDescriptors,
-            (viewType == HlslDispatchable::BufferViewType::Structured ? shaderInputDesc.NumSamples : 0)
+            0,
+            (viewType == HlslDispatchable::BufferViewType::Structured ? shaderInputDesc.NumSamples : 0),
+            HlslDispatchable::RootParameterType::DescriptorTable,
+            0
         };
 
-        if (rangeType == currentRange.RangeType && shaderInputDesc.Space == currentRange.RegisterSpace)
+        auto rootConstantSize = rootConstantSizes.find(shaderInputDesc.Name);
+        if (rootConstantSize != rootConstantSizes.end() && shaderInputDesc.Type == D3D_SIT_CBUFFER)
+        {
+            D3D12_ROOT_PARAMETER1 rootParameter = {};
+            rootParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            rootParameter.Constants.ShaderRegister = shaderInputDesc.BindPoint;
+            rootParameter.Constants.RegisterSpace = shaderInputDesc.Space;
+            rootParameter.Constants.Num32BitValues = rootConstantSize->second;
+            rootConstantDwords += rootConstantSize->second;
+
+            bindPoint.rootParameterType = HlslDispatchable::RootParameterType::RootConstants;
+            bindPoint.rootParameterIndex = static_cast<uint32_t>(data.rootParameters.size());
+            data.rootParameters.push_back(rootParameter);
+        }
+        else if (bindingMode == Model::HlslDispatchableDesc::BindingMode::RootDescriptors && CanBindAsRootDescriptor(shaderInputDesc))
         {
-            currentRange.NumDescriptors += numDescriptors;
+            D3D12_ROOT_PARAMETER1 rootParameter = {};
+            rootParameter.ParameterType = GetRootDescriptorParameterType(rangeType);
+            rootParameter.Descriptor.ShaderRegister = shaderInputDesc.BindPoint;
+            rootParameter.Descriptor.RegisterSpace = shaderInputDesc.Space;
+            rootDescriptorCount++;
+
+            bindPoint.rootParameterType = HlslDispatchable::RootParameterType::RootDescriptor;
+            bindPoint.rootParameterIndex = static_cast<uint32_t>(data.rootParameters.size());
+            data.rootParameters.push_back(rootParameter);
         }
         else
         {
-            if (currentRange.NumDescriptors > 0)
+            bindPoint.offsetInDescriptorsFromTableStart = currentOffsetInDescriptors;
+
+            bool continuesCurrentRange = 
+                currentRange.NumDescriptors > 0 &&
+                rangeType == currentRange.RangeType && 
+                shaderInputDesc.Space == currentRange.RegisterSpace &&
+                shaderInputDesc.BindPoint == currentRange.BaseShaderRegister + currentRange.NumDescriptors;
+
+            if (continuesCurrentRange)
             {
-                descriptorRanges.push_back(currentRange);
+                currentRange.NumDescriptors += numDescriptors;
             }
+            else
+            {
+                if (currentRange.NumDescriptors > 0)
+                {
+                    data.descriptorRanges.push_back(currentRange);
+                }
 
-            currentRange.RangeType = rangeType;
-            currentRange.NumDescriptors = numDescriptors;
-            currentRange.RegisterSpace = shaderInputDesc.Space;
+                currentRange.RangeType = rangeType;
+                currentRange.NumDescriptors = numDescriptors;
+                currentRange.BaseShaderRegister = shaderInputDesc.BindPoint;
+                currentRange.RegisterSpace = shaderInputDesc.Space;
+            }
+
+            currentOffsetInDescriptors += numDescriptors;
         }
 
-        currentOffsetInDescriptors += numDescriptors;
+        data.bindPoints[shaderInputDesc.Name] = bindPoint;
     }
 
     if (currentRange.NumDescriptors > 0)
     {
-        descriptorRanges.push_back(currentRange);
+        data.descriptorRanges.push_back(currentRange);
+    }
+
+    // The descriptor table is always the last root parameter.
+    for (auto& bindPoint : data.bindPoints)
+    {
+        if (bindPoint.second.rootParameterType == HlslDispatchable::RootParameterType::DescriptorTable)
+        {
+            bindPoint.second.rootParameterIndex = static_cast<uint32_t>(data.rootParameters.size());
+        }
+    }
+
+    // Each root constant costs one DWORD, each root descriptor two, and the descriptor table one. The runtime 
+    // would reject an oversized root signature with a generic error, so say which bindings used up the space.
+    uint32_t descriptorTableDwords = data.descriptorRanges.empty() ? 0 : 1;
+    uint32_t rootSignatureDwords = rootConstantDwords + rootDescriptorCount * 2 + descriptorTableDwords;
+    if (rootSignatureDwords > D3D12_MAX_ROOT_COST)
+    {
+        throw std::invalid_argument(fmt::format(
+            "The root signature needs {} DWORDs, but the limit is {}: {} for root constants, {} for {} root descriptors, "
+            "and {} for the descriptor table. Use smaller root constants, or bind inputs with \"bindingMode\": \"descriptorTable\".",
+            rootSignatureDwords,
+            D3D12_MAX_ROOT_COST,
+            rootConstantDwords,
+            rootDescriptorCount * 2,
+            rootDescriptorCount,
+            descriptorTableDwords));
     }
 
-    return std::make_tuple(descriptorRanges, bindPoints);
+    data.descriptorTableSize = currentOffsetInDescriptors;
+    return data;
 }
 
-void HlslDispatchable::CreateRootSignatureAndBindingMap()
+void HlslDispatchable::CreateRootSignatureAndBindingMap(std::vector<std::byte>& serializedRootSignature)
 {
     D3D12_SHADER_DESC shaderDesc = {};
     THROW_IF_FAILED(m_shaderReflection->GetDesc(&shaderDesc));
@@ -139,47 +244,244 @@ void HlslDispatchable::CreateRootSignatureAndBindingMap()
         THROW_IF_FAILED(m_shaderReflection->GetResourceBindingDesc(resourceIndex, &shaderInputDescs[resourceIndex]));
     }
 
-    std::vector<D3D12_ROOT_PARAMETER1> rootParameters;
-    auto [descriptorRanges, bindPoints] = ReflectBindingData(shaderInputDescs);
-    m_bindPoints = bindPoints;
+    // Root constants are sized to the reflected cbuffer; values from the model that are shorter are zero padded.
+    std::unordered_map<std::string, uint32_t> rootConstantSizes;
+    std::unordered_map<std::string, std::vector<uint32_t>> rootConstantValues;
+    for (auto& [cbufferName, values] : m_desc.rootConstants)
+    {
+        auto isCbuffer = [&](const D3D12_SHADER_INPUT_BIND_DESC& desc) { return desc.Name == cbufferName && desc.Type == D3D_SIT_CBUFFER; };
+        if (std::none_of(shaderInputDescs.begin(), shaderInputDescs.end(), isCbuffer))
+        {
+            throw std::invalid_argument(fmt::format("Root constants were provided for '{}', which is not a cbuffer in the shader (or was optimized away).", cbufferName));
+        }
+
+        D3D12_SHADER_BUFFER_DESC cbufferDesc = {};
+        THROW_IF_FAILED(m_shaderReflection->GetConstantBufferByName(cbufferName.c_str())->GetDesc(&cbufferDesc));
+        if (values.size() > cbufferDesc.Size)
+        {
+            throw std::invalid_argument(fmt::format(
+                "Root constants for '{}' are {} bytes, but the cbuffer is only {} bytes.", 
+                cbufferName,
+                values.size(),
+                cbufferDesc.Size));
+        }
+
+        uint32_t num32BitValues = (cbufferDesc.Size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+        std::vector<uint32_t> paddedValues(num32BitValues);
+        std::memcpy(paddedValues.data(), values.data(), values.size());
 
-    if (!descriptorRanges.empty())
+        rootConstantSizes[cbufferName] = num32BitValues;
+        rootConstantValues[cbufferName] = std::move(paddedValues);
+    }
+
+    auto bindingData = ReflectBindingData(shaderInputDescs, m_desc.bindingMode, rootConstantSizes);
+    auto& rootParameters = bindingData.rootParameters;
+    auto& descriptorRanges = bindingData.descriptorRanges;
+    m_bindPoints = bindingData.bindPoints;
+    m_descriptorTableSize = bindingData.descriptorTableSize;
+    m_descriptorTableRootParameterIndex = static_cast<uint32_t>(rootParameters.size());
+
+    m_rootConstants.clear();
+    for (auto& [name, bindPoint] : m_bindPoints)
     {
-        D3D12_ROOT_PARAMETER1 rootParameter = {};
-        rootParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-        rootParameter.DescriptorTable.NumDescriptorRanges = static_cast<UINT>(descriptorRanges.size());
-        rootParameter.DescriptorTable.pDescriptorRanges = descriptorRanges.data();
-        rootParameters.push_back(rootParameter);
+        if (bindPoint.rootParameterType == RootParameterType::RootConstants)
+        {
+            m_rootConstants.emplace_back(bindPoint.rootParameterIndex, std::move(rootConstantValues[name]));
+        }
     }
 
-    D3D12_VERSIONED_ROOT_SIGNATURE_DESC rootSigDesc = {};
-    rootSigDesc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
-    rootSigDesc.Desc_1_1.NumParameters = static_cast<UINT>(rootParameters.size());
-    rootSigDesc.Desc_1_1.pParameters = rootParameters.data();
+    if (serializedRootSignature.empty())
+    {
+        if (!descriptorRanges.empty())
+        {
+            D3D12_ROOT_PARAMETER1 rootParameter = {};
+            rootParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+            rootParameter.DescriptorTable.NumDescriptorRanges = static_cast<UINT>(descriptorRanges.size());
+            rootParameter.DescriptorTable.pDescriptorRanges = descriptorRanges.data();
+            rootParameters.push_back(rootParameter);
+        }
+
+        D3D12_VERSIONED_ROOT_SIGNATURE_DESC rootSigDesc = {};
+        rootSigDesc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        rootSigDesc.Desc_1_1.NumParameters = static_cast<UINT>(rootParameters.size());
+        rootSigDesc.Desc_1_1.pParameters = rootParameters.data();
 
-    ComPtr<ID3DBlob> rootSignatureBlob;
-    ComPtr<ID3DBlob> rootSignatureErrors;
+        ComPtr<ID3DBlob> rootSignatureBlob;
+        ComPtr<ID3DBlob> rootSignatureErrors;
 #ifdef _GAMING_XBOX
-    HRESULT hr = D3D12SerializeVersionedRootSignature(&rootSigDesc, &rootSignatureBlob, &rootSignatureErrors);
+        HRESULT hr = D3D12SerializeVersionedRootSignature(&rootSigDesc, &rootSignatureBlob, &rootSignatureErrors);
 #else
-    HRESULT hr = m_device->D3DModule()->SerializeVersionedRootSignature(&rootSigDesc, &rootSignatureBlob, &rootSignatureErrors);
+        HRESULT hr = m_device->D3DModule()->SerializeVersionedRootSignature(&rootSigDesc, &rootSignatureBlob, &rootSignatureErrors);
 #endif
-    if (FAILED(hr))
-    {
-        if (rootSignatureErrors)
+        if (FAILED(hr))
         {
-            m_logger->LogError(static_cast<LPCSTR>(rootSignatureErrors->GetBufferPointer()));
+            if (rootSignatureErrors)
+            {
+                m_logger->LogError(static_cast<LPCSTR>(rootSignatureErrors->GetBufferPointer()));
+            }
+            THROW_HR(hr);
         }
-        THROW_HR(hr);
+
+        auto rootSignatureData = static_cast<const std::byte*>(rootSignatureBlob->GetBufferPointer());
+        serializedRootSignature.assign(rootSignatureData, rootSignatureData + rootSignatureBlob->GetBufferSize());
     }
 
     THROW_IF_FAILED(m_device->D3D()->CreateRootSignature(
         0, 
-        rootSignatureBlob->GetBufferPointer(), 
-        rootSignatureBlob->GetBufferSize(), 
+        serializedRootSignature.data(), 
+        serializedRootSignature.size(), 
         IID_GRAPHICS_PPV_ARGS(m_rootSignature.ReleaseAndGetAddressOf())));
 }
 
+// DXC 1.7 changed -P from "preprocess to file" to a flag that returns the preprocessed source as DXC_OUT_HLSL.
+// Older compilers expect an output file argument, so preprocessing fails and the cache can't be used.
+constexpr uint32_t c_minCacheDxcMajorVersion = 1;
+constexpr uint32_t c_minCacheDxcMinorVersion = 7;
+
+// Every dispatchable in the process would hit the same condition, so only the first bypass is reported.
+static void WarnShaderCacheBypassedOnce(IDxDispatchLogger* logger, const std::string& reason)
+{
+    static std::once_flag warned;
+    std::call_once(warned, [&]
+    {
+        logger->LogWarning(fmt::format("The HLSL shader cache is not used: {}", reason).c_str());
+    });
+}
+
+// Returns the -I directories in DXC compiler arguments, which accept both "-I dir" and "-Idir".
+static std::vector<std::filesystem::path> GetIncludeDirectories(gsl::span<const std::string> compilerArgs)
+{
+    std::vector<std::filesystem::path> includeDirectories;
+    for (size_t i = 0; i < compilerArgs.size(); i++)
+    {
+        auto& arg = compilerArgs[i];
+        if (arg == "-I" || arg == "/I")
+        {
+            if (i + 1 < compilerArgs.size())
+            {
+                includeDirectories.emplace_back(compilerArgs[++i]);
+            }
+        }
+        else if (arg.size() > 2 && (arg.compare(0, 2, "-I") == 0 || arg.compare(0, 2, "/I") == 0))
+        {
+            includeDirectories.emplace_back(arg.substr(2));
+        }
+    }
+    return includeDirectories;
+}
+
+// Fallback for sources whose includes can't be resolved without the preprocessor: the key is built from the 
+// preprocessed source, which costs a DXC -P pass on every launch. Returns std::nullopt if the compiler is too old
+// to preprocess into memory or the source fails to preprocess.
+std::optional<std::string> HlslDispatchable::DescribePreprocessedSource(
+    const DxcBuffer& sourceBuffer, 
+    gsl::span<const LPCWSTR> compilerArgs, 
+    uint32_t dxcMajorVersion, 
+    uint32_t dxcMinorVersion)
+{
+    if (std::make_pair(dxcMajorVersion, dxcMinorVersion) < std::make_pair(c_minCacheDxcMajorVersion, c_minCacheDxcMinorVersion))
+    {
+        WarnShaderCacheBypassedOnce(m_logger.Get(), fmt::format(
+            "DXC {}.{} can't preprocess shaders into memory (requires {}.{} or newer)", 
+            dxcMajorVersion, 
+            dxcMinorVersion, 
+            c_minCacheDxcMajorVersion, 
+            c_minCacheDxcMinorVersion));
+        return std::nullopt;
+    }
+
+    std::vector<LPCWSTR> preprocessArgs(compilerArgs.begin(), compilerArgs.end());
+    preprocessArgs.push_back(L"-P");
+
+    ComPtr<IDxcResult> result;
+    THROW_IF_FAILED(m_device->GetDxcCompiler()->Compile(
+        &sourceBuffer, 
+        preprocessArgs.data(), 
+        static_cast<UINT32>(preprocessArgs.size()), 
+        m_device->GetDxcIncludeHandler(), 
+        IID_PPV_ARGS(&result)));
+
+    HRESULT preprocessStatus = S_OK;
+    ComPtr<IDxcBlobUtf8> preprocessedSource;
+    if (FAILED(result->GetStatus(&preprocessStatus)) || FAILED(preprocessStatus) ||
+        FAILED(result->GetOutput(DXC_OUT_HLSL, IID_PPV_ARGS(&preprocessedSource), nullptr)) || !preprocessedSource)
+    {
+        WarnShaderCacheBypassedOnce(m_logger.Get(), fmt::format(
+            "'{}' could not be preprocessed to compute its cache key", 
+            m_desc.sourcePath.string()));
+        return std::nullopt;
+    }
+
+    auto preprocessedBytes = gsl::make_span(
+        static_cast<const std::byte*>(preprocessedSource->GetBufferPointer()), 
+        preprocessedSource->GetBufferSize());
+    return fmt::format("preprocessed {:016x} {}\n", HlslShaderCache::Hash(preprocessedBytes), preprocessedBytes.size());
+}
+
+// The cache key identifies everything that affects the compiled shader: the DXC build, the compiler arguments
+// (including defines), and the contents of the source and every file it includes. Includes are normally found by
+// scanning the sources, so a cache hit never runs DXC; only sources with includes that need the preprocessor
+// (e.g. macro includes) are preprocessed. Returns an empty key if the sources can't be described, in which case
+// the cache is bypassed and the full compile reports any errors.
+std::string HlslDispatchable::ComputeShaderCacheKey(const DxcBuffer& sourceBuffer, gsl::span<const LPCWSTR> compilerArgs)
+{
+    uint32_t dxcMajorVersion = 0;
+    uint32_t dxcMinorVersion = 0;
+    ComPtr<IDxcVersionInfo> versionInfo;
+    if (SUCCEEDED(m_device->GetDxcCompiler()->QueryInterface(IID_PPV_ARGS(&versionInfo))))
+    {
+        THROW_IF_FAILED(versionInfo->GetVersion(&dxcMajorVersion, &dxcMinorVersion));
+    }
+
+    // Builds with the same major/minor version can generate different code, so the commit is part of the key.
+    std::string key = fmt::format("dxc {}.{}", dxcMajorVersion, dxcMinorVersion);
+    ComPtr<IDxcVersionInfo2> versionInfo2;
+    if (SUCCEEDED(m_device->GetDxcCompiler()->QueryInterface(IID_PPV_ARGS(&versionInfo2))))
+    {
+        UINT32 commitCount = 0;
+        char* commitHash = nullptr;
+        if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)))
+        {
+            key += fmt::format(" {} {}", commitCount, commitHash ? commitHash : "");
+        }
+        CoTaskMemFree(commitHash);
+    }
+    key += '\n';
+
+    for (auto arg : compilerArgs)
+    {
+        key += std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(arg);
+        key += '\n';
+    }
+
+    // The root signature is cached with the shader, so the key includes everything that shapes it.
+    key += fmt::format("bindingMode {}\n", static_cast<int>(m_desc.bindingMode));
+    std::vector<std::string_view> rootConstantNames;
+    for (auto& rootConstant : m_desc.rootConstants)
+    {
+        rootConstantNames.push_back(rootConstant.first);
+    }
+    std::sort(rootConstantNames.begin(), rootConstantNames.end());
+    for (auto name : rootConstantNames)
+    {
+        key += fmt::format("rootConstants {}\n", name);
+    }
+
+    auto includeDirectories = GetIncludeDirectories(m_desc.compilerArgs);
+    auto sourceDescription = HlslShaderCache::DescribeSourceFiles(m_desc.sourcePath, includeDirectories);
+    if (!sourceDescription)
+    {
+        sourceDescription = DescribePreprocessedSource(sourceBuffer, compilerArgs, dxcMajorVersion, dxcMinorVersion);
+        if (!sourceDescription)
+        {
+            return {};
+        }
+    }
+    key += *sourceDescription;
+
+    return key;
+}
+
 void HlslDispatchable::CompileWithDxc()
 {
     if (!m_device->GetDxcCompiler())
@@ -218,58 +520,85 @@ void HlslDispatchable::CompileWithDxc()
         lpcwstrArgs[i] = compilerArgs[i].data();
     }
 
-    ComPtr<IDxcResult> result;
-    THROW_IF_FAILED(m_device->GetDxcCompiler()->Compile(
-        &sourceBuffer, 
-        lpcwstrArgs.data(), 
-        static_cast<UINT32>(lpcwstrArgs.size()), 
-        m_device->GetDxcIncludeHandler(), 
-        IID_PPV_ARGS(&result)));
-
-    ComPtr<IDxcBlobUtf8> errors;
-    THROW_IF_FAILED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr));
-    if (errors != nullptr && errors->GetStringLength() != 0)
+    std::string cacheKey;
+    std::optional<HlslShaderCache::Entry> cacheEntry;
+    if (m_shaderCache)
     {
-        std::string errorsString{ errors->GetStringPointer() };
-        m_logger->LogError(fmt::format("DXC failed to compile with errors: {}", errorsString).c_str());
+        cacheKey = ComputeShaderCacheKey(sourceBuffer, lpcwstrArgs);
+        if (!cacheKey.empty())
+        {
+            cacheEntry = m_shaderCache->Load(cacheKey);
+        }
     }
 
-    HRESULT compileStatus = S_OK;
-    THROW_IF_FAILED(result->GetStatus(&compileStatus));
-    if (FAILED(compileStatus))
+    bool cacheHit = cacheEntry.has_value();
+    if (!cacheHit)
     {
-        throw std::invalid_argument("Failed to compile.");
-    }
+        cacheEntry.emplace();
+
+        ComPtr<IDxcResult> result;
+        THROW_IF_FAILED(m_device->GetDxcCompiler()->Compile(
+            &sourceBuffer, 
+            lpcwstrArgs.data(), 
+            static_cast<UINT32>(lpcwstrArgs.size()), 
+            m_device->GetDxcIncludeHandler(), 
+            IID_PPV_ARGS(&result)));
+
+        ComPtr<IDxcBlobUtf8> errors;
+        THROW_IF_FAILED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr));
+        if (errors != nullptr && errors->GetStringLength() != 0)
+        {
+            std::string errorsString{ errors->GetStringPointer() };
+            m_logger->LogError(fmt::format("DXC failed to compile with errors: {}", errorsString).c_str());
+        }
+
+        HRESULT compileStatus = S_OK;
+        THROW_IF_FAILED(result->GetStatus(&compileStatus));
+        if (FAILED(compileStatus))
+        {
+            throw std::invalid_argument("Failed to compile.");
+        }
+
+        ComPtr<IDxcBlob> shaderBlob;
+        THROW_IF_FAILED(result->GetOutput(
+            DXC_OUT_OBJECT, 
+            IID_PPV_ARGS(&shaderBlob), 
+            nullptr));
 
-    ComPtr<IDxcBlob> shaderBlob;
-    THROW_IF_FAILED(result->GetOutput(
-        DXC_OUT_OBJECT, 
-        IID_PPV_ARGS(&shaderBlob), 
-        nullptr));
+        ComPtr<IDxcBlob> reflectionBlob;
+        THROW_IF_FAILED(result->GetOutput(
+            DXC_OUT_REFLECTION, 
+            IID_PPV_ARGS(&reflectionBlob), 
+            nullptr));
+
+        ComPtr<IDxcBlob> pdbBlob;
+        ComPtr<IDxcBlobUtf16> pdbName;
+        if (SUCCEEDED(result->GetOutput(
+            DXC_OUT_PDB, 
+            IID_PPV_ARGS(&pdbBlob), 
+            &pdbName)))
+        {
+            // TODO: store this in a temp directory?
+            FILE* fp = nullptr;
+            _wfopen_s(&fp, pdbName->GetStringPointer(), L"wb");
+            fwrite(pdbBlob->GetBufferPointer(), pdbBlob->GetBufferSize(), 1, fp);
+            fclose(fp);
+        }
 
-    ComPtr<IDxcBlob> reflectionBlob;
-    THROW_IF_FAILED(result->GetOutput(
-        DXC_OUT_REFLECTION, 
-        IID_PPV_ARGS(&reflectionBlob), 
-        nullptr));
+        auto shaderData = static_cast<const std::byte*>(shaderBlob->GetBufferPointer());
+        cacheEntry->shader.assign(shaderData, shaderData + shaderBlob->GetBufferSize());
 
-    ComPtr<IDxcBlob> pdbBlob;
-    ComPtr<IDxcBlobUtf16> pdbName;
-    if (SUCCEEDED(result->GetOutput(
-        DXC_OUT_PDB, 
-        IID_PPV_ARGS(&pdbBlob), 
-        &pdbName)))
+        auto reflectionData = static_cast<const std::byte*>(reflectionBlob->GetBufferPointer());
+        cacheEntry->reflection.assign(reflectionData, reflectionData + reflectionBlob->GetBufferSize());
+    }
+    else
     {
-        // TODO: store this in a temp directory?
-        FILE* fp = nullptr;
-        _wfopen_s(&fp, pdbName->GetStringPointer(), L"wb");
-        fwrite(pdbBlob->GetBufferPointer(), pdbBlob->GetBufferSize(), 1, fp);
-        fclose(fp);
+        m_logger->LogInfo(fmt::format("Loaded '{}' from the HLSL shader cache", m_desc.sourcePath.filename().string()).c_str());
     }
 
     DxcBuffer reflectionBuffer;
-    reflectionBuffer.Ptr = reflectionBlob->GetBufferPointer();
-    reflectionBuffer.Size = reflectionBlob->GetBufferSize();
+    reflectionBuffer.Ptr = cacheEntry->reflection.data();
+    reflectionBuffer.Size = cacheEntry->reflection.size();
     reflectionBuffer.Encoding = DXC_CP_ACP;
 
     THROW_IF_FAILED(m_device->GetDxcUtils()->CreateReflection(
@@ -279,8 +608,8 @@ void HlslDispatchable::CompileWithDxc()
     if (m_printHlslDisassembly)
     {
         DxcBuffer bytecodeBuffer;
-        bytecodeBuffer.Ptr = shaderBlob->GetBufferPointer();
-        bytecodeBuffer.Size = shaderBlob->GetBufferSize();
+        bytecodeBuffer.Ptr = cacheEntry->shader.data();
+        bytecodeBuffer.Size = cacheEntry->shader.size();
         bytecodeBuffer.Encoding = DXC_CP_ACP;
 
         ComPtr<IDxcResult> result;
@@ -301,24 +630,33 @@ void HlslDispatchable::CompileWithDxc()
         m_logger->LogInfo("---------------------------------------------------------");
     }
 
-    CreateRootSignatureAndBindingMap();
+    CreateRootSignatureAndBindingMap(cacheEntry->rootSignature);
+
+    if (!cacheHit && !cacheKey.empty() && !m_shaderCache->Store(cacheKey, *cacheEntry))
+    {
+        m_logger->LogInfo(fmt::format("Failed to write to the HLSL shader cache '{}'", m_shaderCache->GetDirectory().string()).c_str());
+    }
 
     D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
     psoDesc.pRootSignature = m_rootSignature.Get();
-    psoDesc.CS.pShaderBytecode = shaderBlob->GetBufferPointer();
-    psoDesc.CS.BytecodeLength = shaderBlob->GetBufferSize();
+    psoDesc.CS.pShaderBytecode = cacheEntry->shader.data();
+    psoDesc.CS.BytecodeLength = cacheEntry->shader.size();
     THROW_IF_FAILED(m_device->D3D()->CreateComputePipelineState(
         &psoDesc,
         IID_GRAPHICS_PPV_ARGS(m_pipelineState.ReleaseAndGetAddressOf())));
 
-    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-    D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-    descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    descriptorHeapDesc.NumDescriptors = static_cast<uint32_t>(m_bindPoints.size());
-    descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    THROW_IF_FAILED(m_device->D3D()->CreateDescriptorHeap(
-        &descriptorHeapDesc, 
-        IID_GRAPHICS_PPV_ARGS(m_descriptorHeap.ReleaseAndGetAddressOf())));
+    m_descriptorHeap = nullptr;
+    if (m_descriptorTableSize > 0)
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
+        descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        descriptorHeapDesc.NumDescriptors = m_descriptorTableSize;
+        descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        THROW_IF_FAILED(m_device->D3D()->CreateDescriptorHeap(
+            &descriptorHeapDesc, 
+            IID_GRAPHICS_PPV_ARGS(m_descriptorHeap.ReleaseAndGetAddressOf())));
+        DXD_PERF_COUNTER_ADD(descriptorHeapsCreated, 1);
+    }
 }
 
 void HlslDispatchable::Initialize()
@@ -336,6 +674,15 @@ void HlslDispatchable::Initialize()
 void HlslDispatchable::Bind(const Bindings& bindings, uint32_t iteration)
 {
     uint32_t descriptorIncrementSize = m_device->D3D()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    auto commandList = m_device->GetCommandList();
+
+    commandList->SetComputeRootSignature(m_rootSignature.Get());
+    commandList->SetPipelineState(m_pipelineState.Get());
+
+    for (auto& [rootParameterIndex, values] : m_rootConstants)
+    {
+        commandList->SetComputeRoot32BitConstants(rootParameterIndex, static_cast<UINT>(values.size()), values.data(), 0);
+    }
 
     for (auto& binding : bindings)
     {
@@ -360,6 +707,55 @@ void HlslDispatchable::Bind(const Bindings& bindings, uint32_t iteration)
         }
         auto& bindPoint = bindPointIterator->second;
 
+        if (bindPoint.rootParameterType == RootParameterType::RootConstants)
+        {
+            throw std::invalid_argument(fmt::format("Attempting to bind shader input '{}', which is set with root constants.", targetName));
+        }
+
+        if (bindPoint.rootParameterType == RootParameterType::RootDescriptor)
+        {
+            // Root descriptors have no view description, so the element offset is applied to the address 
+            // and the format must match the view the shader expects. A cbuffer has no element size, so an
+            // offset can't be expressed.
+            uint64_t elementSizeInBytes = 0;
+            if (bindPoint.descriptorType == D3D12_DESCRIPTOR_RANGE_TYPE_CBV)
+            {
+                if (source.elementOffset != 0)
+                {
+                    throw std::invalid_argument(fmt::format(
+                        "'{}' is a cbuffer bound as a root descriptor, which doesn't support an element offset (got {}).", 
+                        targetName, 
+                        source.elementOffset));
+                }
+            }
+            else if (bindPoint.viewType == BufferViewType::Structured)
+            {
+                if (source.format && *source.format != DXGI_FORMAT_UNKNOWN)
+                {
+                    throw std::invalid_argument(fmt::format("'{}' is a structured buffer, so the format must be omitted or UNKNOWN.", targetName));
+                }
+                elementSizeInBytes = bindPoint.structureByteStride;
+            }
+            else if (bindPoint.viewType == BufferViewType::Raw)
+            {
+                if (source.format && *source.format != DXGI_FORMAT_R32_TYPELESS)
+                {
+                    throw std::invalid_argument(fmt::format("'{}' is a raw buffer, so the format must be omitted or R32_TYPELESS.", targetName));
+                }
+                elementSizeInBytes = sizeof(uint32_t);
+            }
+
+            auto gpuAddress = source.resource->GetGPUVirtualAddress() + source.elementOffset * elementSizeInBytes;
+            switch (bindPoint.descriptorType)
+            {
+            case D3D12_DESCRIPTOR_RANGE_TYPE_UAV: commandList->SetComputeRootUnorderedAccessView(bindPoint.rootParameterIndex, gpuAddress); break;
+            case D3D12_DESCRIPTOR_RANGE_TYPE_SRV: commandList->SetComputeRootShaderResourceView(bindPoint.rootParameterIndex, gpuAddress); break;
+            case D3D12_DESCRIPTOR_RANGE_TYPE_CBV: commandList->SetComputeRootConstantBufferView(bindPoint.rootParameterIndex, gpuAddress); break;
+            default: throw std::invalid_argument("Unexpected binding type");
+            }
+            continue;
+        }
+
         CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle{
             m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), 
             static_cast<int>(bindPoint.offsetInDescriptorsFromTableStart), 
@@ -469,11 +865,12 @@ void HlslDispatchable::Bind(const Bindings& bindings, uint32_t iteration)
         }
     }
 
-    m_device->GetCommandList()->SetComputeRootSignature(m_rootSignature.Get());
-    m_device->GetCommandList()->SetPipelineState(m_pipelineState.Get());
-    ID3D12DescriptorHeap* descriptorHeaps[] = { m_descriptorHeap.Get() };
-    m_device->GetCommandList()->SetDescriptorHeaps(ARRAYSIZE(descriptorHeaps), descriptorHeaps);
-    m_device->GetCommandList()->SetComputeRootDescriptorTable(0, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    if (m_descriptorHeap)
+    {
+        ID3D12DescriptorHeap* descriptorHeaps[] = { m_descriptorHeap.Get() };
+        commandList->SetDescriptorHeaps(ARRAYSIZE(descriptorHeaps), descriptorHeaps);
+        commandList->SetComputeRootDescriptorTable(m_descriptorTableRootParameterIndex, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    }
 }
 
 void HlslDispatchable::Dispatch(const Model::DispatchCommand& args, uint32_t iteration, DeferredBindings& deferredBinings)
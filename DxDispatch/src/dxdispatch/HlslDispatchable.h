@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CommandLineArgs.h"
+#include "HlslShaderCache.h"
 
 class HlslDispatchable : public Dispatchable
 {
@@ -18,17 +19,52 @@ public:
         Raw         // (RW)ByteAddresBuffer
     };
 
+    enum class RootParameterType
+    {
+        DescriptorTable, // View written into the descriptor heap
+        RootDescriptor,  // GPU virtual address set directly in the root signature
+        RootConstants    // Values from the model set directly in the root signature
+    };
+
     struct BindPoint
     {
         BufferViewType viewType;
         D3D12_DESCRIPTOR_RANGE_TYPE descriptorType;
         uint32_t offsetInDescriptorsFromTableStart;
         uint32_t structureByteStride;
+        RootParameterType rootParameterType;
+        uint32_t rootParameterIndex;
+    };
+
+    struct BindingData
+    {
+        // Root constants and root descriptors, in root parameter order. The descriptor table (if any) follows them.
+        std::vector<D3D12_ROOT_PARAMETER1> rootParameters;
+        std::vector<D3D12_DESCRIPTOR_RANGE1> descriptorRanges;
+        std::unordered_map<std::string, BindPoint> bindPoints;
+        uint32_t descriptorTableSize = 0;
     };
 
+    // Reflects root parameters, descriptor ranges, and binding points from the HLSL source. Cbuffers with an
+    // entry in rootConstantSizes (size in 32-bit values) become root constants. Throws if the root signature 
+    // would exceed the 64-DWORD limit.
+    static BindingData ReflectBindingData(
+        gsl::span<D3D12_SHADER_INPUT_BIND_DESC> shaderInputDescs,
+        Model::HlslDispatchableDesc::BindingMode bindingMode,
+        const std::unordered_map<std::string, uint32_t>& rootConstantSizes);
+
 private:
     void CompileWithDxc();
-    void CreateRootSignatureAndBindingMap();
+    std::string ComputeShaderCacheKey(const DxcBuffer& sourceBuffer, gsl::span<const LPCWSTR> compilerArgs);
+    std::optional<std::string> DescribePreprocessedSource(
+        const DxcBuffer& sourceBuffer, 
+        gsl::span<const LPCWSTR> compilerArgs, 
+        uint32_t dxcMajorVersion, 
+        uint32_t dxcMinorVersion);
+
+    // Reflects bind points and creates the root signature. If serializedRootSignature is empty, the root 
+    // signature is serialized from the reflected bindings and returned in serializedRootSignature.
+    void CreateRootSignatureAndBindingMap(std::vector<std::byte>& serializedRootSignature);
 
 private:
     std::shared_ptr<Device> m_device;
@@ -39,6 +75,10 @@ private:
     Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pipelineState;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_descriptorHeap;
     std::unordered_map<std::string, BindPoint> m_bindPoints;
+    uint32_t m_descriptorTableSize = 0;
+    uint32_t m_descriptorTableRootParameterIndex = 0;
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> m_rootConstants;
     bool m_printHlslDisassembly = false;
+    std::optional<HlslShaderCache> m_shaderCache;
     Microsoft::WRL::ComPtr<IDxDispatchLogger> m_logger;
 };
\ No newline at end of file
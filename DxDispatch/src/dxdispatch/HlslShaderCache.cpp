@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "HlslShaderCache.h"
+#include <set>
+
+// Bump the version whenever the file layout or the contents of an entry change.
+constexpr char c_entryMagic[4] = { 'D', 'X', 'D', 'H' };
+constexpr uint32_t c_entryVersion = 1;
+
+HlslShaderCache::HlslShaderCache(std::filesystem::path directory) : m_directory(std::move(directory))
+{
+}
+
+uint64_t HlslShaderCache::Hash(gsl::span<const std::byte> data, uint64_t seed)
+{
+    uint64_t hash = seed;
+    for (auto value : data)
+    {
+        hash ^= static_cast<uint64_t>(value);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::filesystem::path HlslShaderCache::GetEntryPath(std::string_view key) const
+{
+    auto keyBytes = gsl::make_span(reinterpret_cast<const std::byte*>(key.data()), key.size());
+    return m_directory / fmt::format("{:016x}.bin", Hash(keyBytes));
+}
+
+// Returns the #include target of a line, or std::nullopt if the line isn't an include directive. An include whose
+// target isn't a quoted or bracketed name (e.g. a macro) returns an empty name.
+static std::optional<std::pair<std::string, bool>> ParseIncludeDirective(std::string_view line)
+{
+    auto skipSpaces = [&]
+    {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+        {
+            line.remove_prefix(1);
+        }
+    };
+
+    constexpr std::string_view include = "include";
+    skipSpaces();
+    if (line.empty() || line.front() != '#')
+    {
+        return std::nullopt;
+    }
+    line.remove_prefix(1);
+    skipSpaces();
+    if (line.substr(0, include.size()) != include)
+    {
+        return std::nullopt;
+    }
+    line.remove_prefix(include.size());
+    skipSpaces();
+
+    char close = line.empty() ? 0 : line.front() == '"' ? '"' : line.front() == '<' ? '>' : 0;
+    size_t end = close ? line.find(close, 1) : std::string_view::npos;
+    if (end == std::string_view::npos)
+    {
+        return std::make_pair(std::string(), false);
+    }
+    return std::make_pair(std::string(line.substr(1, end - 1)), close == '"');
+}
+
+std::optional<std::string> HlslShaderCache::DescribeSourceFiles(
+    const std::filesystem::path& sourcePath, 
+    gsl::span<const std::filesystem::path> includeDirectories)
+{
+    std::string description;
+    std::set<std::filesystem::path> visited;
+    std::vector<std::filesystem::path> pending = { sourcePath.lexically_normal() };
+    visited.insert(pending.back());
+
+    while (!pending.empty())
+    {
+        auto path = std::move(pending.back());
+        pending.pop_back();
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (file.bad())
+        {
+            return std::nullopt;
+        }
+
+        auto contentBytes = gsl::make_span(reinterpret_cast<const std::byte*>(contents.data()), contents.size());
+        description += fmt::format("file {} {:016x} {}\n", path.string(), Hash(contentBytes), contents.size());
+
+        // Includes are resolved the way DXC's default include handler does: quoted names relative to the including 
+        // file first, then the -I directories. Includes are found by scanning lines rather than preprocessing, so
+        // includes in disabled #if blocks are hashed too; that can only cause extra misses, never a stale hit.
+        std::vector<std::filesystem::path> includes;
+        std::istringstream lines(contents);
+        for (std::string line; std::getline(lines, line);)
+        {
+            auto directive = ParseIncludeDirective(line);
+            if (!directive)
+            {
+                continue;
+            }
+
+            auto& [name, quoted] = *directive;
+            if (name.empty())
+            {
+                return std::nullopt;
+            }
+
+            std::vector<std::filesystem::path> candidates;
+            if (quoted)
+            {
+                candidates.push_back(path.parent_path() / name);
+            }
+            for (auto& directory : includeDirectories)
+            {
+                candidates.push_back(directory / name);
+            }
+
+            auto found = std::find_if(candidates.begin(), candidates.end(), [](auto& candidate)
+            {
+                std::error_code error;
+                return std::filesystem::is_regular_file(candidate, error);
+            });
+            if (found == candidates.end())
+            {
+                return std::nullopt;
+            }
+
+            auto includePath = found->lexically_normal();
+            if (visited.insert(includePath).second)
+            {
+                includes.push_back(std::move(includePath));
+            }
+        }
+
+        // Visit includes in the order they appear so that the description is deterministic.
+        pending.insert(pending.end(), includes.rbegin(), includes.rend());
+    }
+
+    return description;
+}
+
+static void WriteSection(std::ofstream& file, gsl::span<const std::byte> data)
+{
+    uint64_t size = data.size();
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+static bool ReadSection(std::ifstream& file, uint64_t fileSize, std::vector<std::byte>& data)
+{
+    // The size is validated against the file size so that a truncated or corrupt entry can't trigger a huge allocation.
+    uint64_t size = 0;
+    if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > fileSize)
+    {
+        return false;
+    }
+
+    data.resize(gsl::narrow<size_t>(size));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), data.size()));
+}
+
+std::optional<HlslShaderCache::Entry> HlslShaderCache::Load(std::string_view key) const
+{
+    auto entryPath = GetEntryPath(key);
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::file_size(entryPath, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    std::ifstream file(entryPath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || memcmp(magic, c_entryMagic, sizeof(magic)) != 0 || version != c_entryVersion)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::byte> storedKey;
+    if (!ReadSection(file, fileSize, storedKey) || 
+        storedKey.size() != key.size() || 
+        memcmp(storedKey.data(), key.data(), key.size()) != 0)
+    {
+        return std::nullopt;
+    }
+
+    Entry entry;
+    if (!ReadSection(file, fileSize, entry.shader) || 
+        !ReadSection(file, fileSize, entry.reflection) || 
+        !ReadSection(file, fileSize, entry.rootSignature))
+    {
+        return std::nullopt;
+    }
+
+    return entry;
+}
+
+bool HlslShaderCache::Store(std::string_view key, const Entry& entry) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        return false;
+    }
+
+    auto entryPath = GetEntryPath(key);
+    auto tempPath = entryPath;
+    tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ 
+        static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.write(c_entryMagic, sizeof(c_entryMagic));
+        file.write(reinterpret_cast<const char*>(&c_entryVersion), sizeof(c_entryVersion));
+        WriteSection(file, gsl::make_span(reinterpret_cast<const std::byte*>(key.data()), key.size()));
+        WriteSection(file, entry.shader);
+        WriteSection(file, entry.reflection);
+        WriteSection(file, entry.rootSignature);
+
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, entryPath, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+void HlslShaderCache::Clear() const
+{
+    std::error_code error;
+    std::filesystem::remove_all(m_directory, error);
+    if (error)
+    {
+        throw std::runtime_error(fmt::format("Failed to clear HLSL shader cache '{}': {}", m_directory.string(), error.message()));
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Persistent, content-addressed cache of compiled HLSL shaders. Each entry lives in its own file named after
+// a hash of its key. The full key is stored in the file and compared on load, so hash collisions are treated
+// as misses. Entries are written to a temporary file and renamed, so concurrent processes can share a cache.
+class HlslShaderCache
+{
+public:
+    struct Entry
+    {
+        std::vector<std::byte> shader;          // DXIL container (DXC_OUT_OBJECT)
+        std::vector<std::byte> reflection;      // Reflection container (DXC_OUT_REFLECTION)
+        std::vector<std::byte> rootSignature;   // Serialized versioned root signature
+    };
+
+    explicit HlslShaderCache(std::filesystem::path directory);
+
+    // Returns std::nullopt if the entry doesn't exist or is unreadable.
+    std::optional<Entry> Load(std::string_view key) const;
+
+    // Returns false if the entry could not be written. Failing to store an entry is not fatal.
+    bool Store(std::string_view key, const Entry& entry) const;
+
+    // Removes all entries.
+    void Clear() const;
+
+    // Describes the contents of a shader source file and every file it #includes (recursively, resolved like DXC's
+    // default include handler), for use in a key. Returns std::nullopt if an include is computed by a macro or any
+    // of the files can't be found or read, in which case the key has to come from the preprocessed source instead.
+    static std::optional<std::string> DescribeSourceFiles(
+        const std::filesystem::path& sourcePath, 
+        gsl::span<const std::filesystem::path> includeDirectories);
+
+    const std::filesystem::path& GetDirectory() const { return m_directory; }
+
+    // 64-bit FNV-1a hash. Data can be hashed in chunks by passing the hash of the previous chunk as the seed.
+    static uint64_t Hash(gsl::span<const std::byte> data, uint64_t seed = 14695981039346656037ull);
+
+private:
+    std::filesystem::path GetEntryPath(std::string_view key) const;
+
+private:
+    std::filesystem::path m_directory;
+};
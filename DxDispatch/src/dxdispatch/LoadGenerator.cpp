@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "LoadGenerator.h"
+#include <atomic>
+
+ArrivalSchedule::ArrivalSchedule(Process process, double ratePerSecond, uint32_t seed) :
+    m_process(process), m_ratePerSecond(ratePerSecond), m_seed(seed), m_random(seed)
+{
+}
+
+ArrivalSchedule ArrivalSchedule::FixedRate(double ratePerSecond)
+{
+    if (!(ratePerSecond > 0))
+    {
+        throw std::invalid_argument("The arrival rate must be greater than 0");
+    }
+    return ArrivalSchedule(Process::Fixed, ratePerSecond, 0);
+}
+
+ArrivalSchedule ArrivalSchedule::Poisson(double ratePerSecond, uint32_t seed)
+{
+    if (!(ratePerSecond > 0))
+    {
+        throw std::invalid_argument("The arrival rate must be greater than 0");
+    }
+    return ArrivalSchedule(Process::Poisson, ratePerSecond, seed);
+}
+
+ArrivalSchedule ArrivalSchedule::FromTrace(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::invalid_argument(fmt::format("Could not open arrival trace '{}'", path.string()));
+    }
+
+    ArrivalSchedule schedule(Process::Trace, 0, 0);
+    std::string line;
+    for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+
+        double arrival = 0;
+        try
+        {
+            arrival = std::stod(line);
+        }
+        catch (const std::exception&)
+        {
+            throw std::invalid_argument(fmt::format("Arrival trace '{}' line {} is not a number", path.string(), lineNumber));
+        }
+
+        if (arrival < 0 || (!schedule.m_arrivals.empty() && arrival < schedule.m_arrivals.back()))
+        {
+            throw std::invalid_argument(fmt::format("Arrival trace '{}' line {}: arrival times must be non-negative and non-decreasing", path.string(), lineNumber));
+        }
+        schedule.m_arrivals.push_back(arrival);
+    }
+
+    if (schedule.m_arrivals.empty())
+    {
+        throw std::invalid_argument(fmt::format("Arrival trace '{}' has no arrivals", path.string()));
+    }
+
+    // The average rate is reported alongside the achieved rate.
+    if (schedule.m_arrivals.back() > 0)
+    {
+        schedule.m_ratePerSecond = (schedule.m_arrivals.size() - 1) * 1000.0 / schedule.m_arrivals.back();
+    }
+
+    return schedule;
+}
+
+uint32_t ArrivalSchedule::Count() const
+{
+    if (m_process == Process::Trace)
+    {
+        return static_cast<uint32_t>(std::min<size_t>(m_arrivals.size(), std::numeric_limits<uint32_t>::max()));
+    }
+    return std::numeric_limits<uint32_t>::max();
+}
+
+double ArrivalSchedule::ArrivalTimeInMilliseconds(uint32_t index)
+{
+    double meanIntervalInMilliseconds = 1000.0 / m_ratePerSecond;
+
+    switch (m_process)
+    {
+    case Process::Fixed:
+        return index * meanIntervalInMilliseconds;
+
+    case Process::Poisson:
+    {
+        // The first request arrives at time 0, like the other processes.
+        std::exponential_distribution<double> interval(1.0 / meanIntervalInMilliseconds);
+        while (m_arrivals.size() <= index)
+        {
+            m_arrivals.push_back(m_arrivals.empty() ? 0.0 : m_arrivals.back() + interval(m_random));
+        }
+        return m_arrivals[index];
+    }
+
+    case Process::Trace:
+        return m_arrivals.at(index);
+    }
+
+    throw std::invalid_argument("Unknown arrival process");
+}
+
+void ArrivalSchedule::Reset()
+{
+    if (m_process == Process::Poisson)
+    {
+        m_arrivals.clear();
+        m_random.seed(m_seed);
+    }
+}
+
+void Pacer::WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+
+    auto now = steady_clock::now();
+    while (duration<double, std::milli>(deadline - now).count() > m_sleepEstimate)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+        auto afterSleep = steady_clock::now();
+
+        double observed = duration<double, std::milli>(afterSleep - now).count();
+        m_sleepCount++;
+        double delta = observed - m_sleepMean;
+        m_sleepMean += delta / m_sleepCount;
+        m_sleepM2 += delta * (observed - m_sleepMean);
+        if (m_sleepCount > 1)
+        {
+            // Two standard deviations above the mean covers almost all oversleeps without spinning for long.
+            m_sleepEstimate = m_sleepMean + 2 * std::sqrt(m_sleepM2 / (m_sleepCount - 1));
+        }
+
+        now = afterSleep;
+    }
+
+    while (steady_clock::now() < deadline)
+    {
+    }
+}
+
+ConcurrentStreamTimings RunStreamsConcurrently(
+    uint32_t streamCount,
+    uint32_t iterationsPerStream,
+    std::optional<uint32_t> timeToRunInMilliseconds,
+    const std::function<void(uint32_t stream)>& warmUp,
+    const std::function<void(uint32_t stream)>& runIteration)
+{
+    using namespace std::chrono;
+
+    ConcurrentStreamTimings timings;
+    timings.latencies.resize(streamCount);
+    std::vector<std::exception_ptr> errors(streamCount);
+    std::atomic<uint32_t> readyStreams = 0;
+    std::atomic<uint32_t> finishedStreams = 0;
+    std::atomic<bool> started = false;
+    std::atomic<bool> stopped = false;
+    steady_clock::time_point startTime;
+    std::vector<steady_clock::time_point> endTimes(streamCount);
+
+    auto RunStream = [&](uint32_t stream)
+    {
+        try
+        {
+            if (!stopped)
+            {
+                warmUp(stream);
+            }
+        }
+        catch (...)
+        {
+            errors[stream] = std::current_exception();
+            stopped = true;
+        }
+
+        readyStreams++;
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+
+        try
+        {
+            auto& latencies = timings.latencies[stream];
+            for (uint32_t iteration = 0; !stopped && iteration < iterationsPerStream; iteration++)
+            {
+                auto runStart = steady_clock::now();
+                runIteration(stream);
+                latencies.push_back(duration<double, std::milli>(steady_clock::now() - runStart).count());
+            }
+        }
+        catch (...)
+        {
+            errors[stream] = std::current_exception();
+            stopped = true;
+        }
+        endTimes[stream] = steady_clock::now();
+        finishedStreams++;
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        for (uint32_t stream = 0; stream < streamCount; stream++)
+        {
+            threads.emplace_back(RunStream, stream);
+        }
+    }
+    catch (...)
+    {
+        // Streams that already started would wait at the start barrier forever, and destroying a joinable thread
+        // terminates the process, so they are released with nothing left to run and joined first.
+        stopped = true;
+        started = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        throw;
+    }
+
+    while (readyStreams < streamCount)
+    {
+        std::this_thread::yield();
+    }
+    startTime = steady_clock::now();
+    started = true;
+
+    if (timeToRunInMilliseconds)
+    {
+        // Streams that finish their iterations early end the wait early as well.
+        auto deadline = startTime + milliseconds(*timeToRunInMilliseconds);
+        while (!stopped && finishedStreams < streamCount && steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        stopped = true;
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    timings.durationInMilliseconds = streamCount == 0 ? 0.0 : 
+        duration<double, std::milli>(*std::max_element(endTimes.begin(), endTimes.end()) - startTime).count();
+    return timings;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <random>
+
+// Arrival times of requests for open-loop dispatching, in milliseconds relative to the start of a dispatch loop.
+// Arrivals don't depend on when earlier requests complete, so a dispatch that runs long delays the requests
+// behind it (queueing) instead of lowering the offered load.
+class ArrivalSchedule
+{
+public:
+    enum class Process
+    {
+        Fixed,      // Requests arrive at a constant rate.
+        Poisson,    // Exponentially distributed gaps between requests with a mean given by the rate.
+        Trace,      // Arrival times are replayed from a file.
+    };
+
+    static ArrivalSchedule FixedRate(double ratePerSecond);
+    static ArrivalSchedule Poisson(double ratePerSecond, uint32_t seed);
+
+    // Reads a text file with one arrival time (milliseconds) per line. Times must be non-decreasing.
+    static ArrivalSchedule FromTrace(const std::filesystem::path& path);
+
+    Process GetProcess() const { return m_process; }
+    double RatePerSecond() const { return m_ratePerSecond; }
+
+    // Number of arrivals in the schedule: unbounded unless arrivals are replayed from a trace.
+    uint32_t Count() const;
+
+    // Returns the arrival time of a request. Generated arrivals are produced on demand, in order.
+    double ArrivalTimeInMilliseconds(uint32_t index);
+
+    // Restarts the schedule so that every dispatch loop sees the same arrivals.
+    void Reset();
+
+private:
+    ArrivalSchedule(Process process, double ratePerSecond, uint32_t seed);
+
+private:
+    Process m_process;
+    double m_ratePerSecond;
+    uint32_t m_seed;
+    std::mt19937 m_random;
+    std::vector<double> m_arrivals;
+};
+
+// Waits until a deadline more precisely than sleeping alone. The OS may oversleep by a full scheduler period
+// (often 1-16 ms), so the pacer only sleeps while the remaining time exceeds an estimate of the longest
+// sleep, and spins for the rest. The estimate is learned from the sleeps actually observed.
+class Pacer
+{
+public:
+    void WaitUntil(std::chrono::steady_clock::time_point deadline);
+
+private:
+    // Running mean and variance (Welford) of the observed duration of a 1 ms sleep, in milliseconds.
+    double m_sleepEstimate = 16.0;
+    double m_sleepMean = 0;
+    double m_sleepM2 = 0;
+    uint64_t m_sleepCount = 0;
+};
+
+struct ConcurrentStreamTimings
+{
+    std::vector<std::vector<double>> latencies; // Milliseconds per iteration, indexed by stream.
+    double durationInMilliseconds = 0;          // Time from the first stream starting to the last stream finishing.
+};
+
+// Runs streamCount streams of work on threads of their own, passing each callback its stream index. Every stream
+// warms up once before the clock starts, so first-run costs aren't counted, and then runs iterationsPerStream timed
+// iterations. All streams stop early once timeToRunInMilliseconds has elapsed or any stream throws. Every thread is
+// joined before returning, and the first error (in stream order) is rethrown.
+ConcurrentStreamTimings RunStreamsConcurrently(
+    uint32_t streamCount,
+    uint32_t iterationsPerStream,
+    std::optional<uint32_t> timeToRunInMilliseconds,
+    const std::function<void(uint32_t stream)>& warmUp,
+    const std::function<void(uint32_t stream)>& runIteration);
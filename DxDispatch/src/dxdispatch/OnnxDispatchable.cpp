@@ -4,6 +4,10 @@
 #include "Model.h"
 #include "Dispatchable.h"
 #include "OnnxDispatchable.h"
+#include "HlslShaderCache.h"
+#include "OnnxModelCache.h"
+#include "ModuleInfo.h"
+#include "config.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -254,12 +258,142 @@ void OnnxDispatchable::Initialize()
         }
     }
 
+    std::filesystem::path modelPath = m_desc.sourcePath;
+    if (m_args.OnnxModelCachePath())
+    {
+        if (auto cachedModelPath = GetOptimizedModel(sessionOptions, graphOptimizationLevel))
+        {
+            // The cached model is already optimized, so only the execution provider's partitioning remains.
+            modelPath = *cachedModelPath;
+            sessionOptions.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+        }
+    }
+
     const OrtDmlApi* ortDmlApi;
     Ort::ThrowOnError(ortApi.GetExecutionProviderApi("DML", ORT_API_VERSION, reinterpret_cast<const void**>(&ortDmlApi)));
     Ort::ThrowOnError(ortDmlApi->SessionOptionsAppendExecutionProvider_DML1(sessionOptions, m_device->DML(), m_device->GetCommandQueue()));
 
-    m_session = Ort::Session(*m_environment, m_desc.sourcePath.wstring().c_str(), sessionOptions);
+    {
+        TraceScope traceScope("Create session");
+        m_session = Ort::Session(*m_environment, modelPath.wstring().c_str(), sessionOptions);
+    }
     m_ioBindings = Ort::IoBinding::IoBinding(*m_session);
+
+    // Kept so that concurrent streams can create sessions of their own.
+    m_sessionModelPath = modelPath;
+    m_sessionOptions = std::move(sessionOptions);
+}
+
+// The cache key identifies everything that affects the optimized model: the ONNX Runtime and DirectML versions, the
+// contents of the source model and its external data files, and the session options that shape the graph. Options
+// that only affect execution are left out.
+std::string OnnxDispatchable::ComputeModelCacheKey(GraphOptimizationLevel graphOptimizationLevel)
+{
+    auto sourceFiles = OnnxModelCache::DescribeSourceFiles(m_desc.sourcePath);
+    if (!sourceFiles)
+    {
+        return {};
+    }
+
+    // The loaded module versions are only available on Windows, so the configured versions are included too.
+    auto GetModuleVersion = [](gsl::czstring<> moduleName) -> std::string
+    {
+        auto moduleInfo = moduleName ? GetModuleInfo(moduleName) : std::nullopt;
+        return moduleInfo ? std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(moduleInfo->version) : std::string();
+    };
+
+    std::string key = fmt::format("ort {} {} {}\n", OrtGetApiBase()->GetVersionString(), c_ortConfig, GetModuleVersion(c_ortModuleName));
+    key += fmt::format("directml {} {}\n", c_directmlConfig, GetModuleVersion(c_directmlModuleName));
+    key += *sourceFiles;
+    key += fmt::format("graphOptimizationLevel {}\n", static_cast<int>(graphOptimizationLevel));
+    key += fmt::format("ortExtensions {}\n", m_args.OrtExtensionsEnabled());
+
+    // Later entries override earlier ones (command-line values follow JSON values), so the order is part of the key.
+    using DimOverridesList = std::initializer_list<gsl::span<const std::pair<std::string, uint32_t>>>;
+    for (auto& overrides : DimOverridesList{ m_desc.freeDimNameOverrides, m_args.GetOnnxFreeDimensionNameOverrides() })
+    {
+        for (auto& override : overrides)
+        {
+            key += fmt::format("freeDimName {} {}\n", override.first, override.second);
+        }
+    }
+    for (auto& overrides : DimOverridesList{ m_desc.freeDimDenotationOverrides, m_args.GetOnnxFreeDimensionDenotationOverrides() })
+    {
+        for (auto& override : overrides)
+        {
+            key += fmt::format("freeDimDenotation {} {}\n", override.first, override.second);
+        }
+    }
+
+    using ConfigEntriesList = std::initializer_list<gsl::span<const std::pair<std::string, std::string>>>;
+    for (auto& configEntries : ConfigEntriesList{ m_desc.sessionOptionsConfigEntries, m_args.GetOnnxSessionOptionConfigEntries() })
+    {
+        for (auto& configEntry : configEntries)
+        {
+            key += fmt::format("config {} {}\n", configEntry.first, configEntry.second);
+        }
+    }
+
+    return key;
+}
+
+// Returns the path of an optimized copy of the source model, creating it if it isn't cached yet. Returns std::nullopt
+// if the model could not be optimized offline, in which case the session is created from the source model.
+std::optional<std::filesystem::path> OnnxDispatchable::GetOptimizedModel(const Ort::SessionOptions& sessionOptions, GraphOptimizationLevel graphOptimizationLevel)
+{
+    OnnxModelCache cache(*m_args.OnnxModelCachePath());
+
+    std::string cacheKey = ComputeModelCacheKey(graphOptimizationLevel);
+    if (cacheKey.empty())
+    {
+        m_logger->LogWarning(fmt::format("Not caching '{}': the model or an external data file it references could not be read", m_desc.sourcePath.filename().string()).c_str());
+        return std::nullopt;
+    }
+
+    if (auto cachedModelPath = cache.Find(cacheKey))
+    {
+        m_logger->LogInfo(fmt::format("Loaded '{}' from the ONNX model cache", m_desc.sourcePath.filename().string()).c_str());
+        return cachedModelPath;
+    }
+
+    std::filesystem::path stagedModelPath;
+    try
+    {
+        TraceScope traceScope("Optimize model");
+        stagedModelPath = cache.BeginStore(cacheKey);
+
+        // The optimized model is written while creating a throwaway session. The DML execution provider is appended
+        // so that optimizations target it, but its fused partitions can't be serialized, so graph fusion is disabled
+        // here and happens again when the real session is created. Weights go to a separate file so models larger
+        // than the 2 GB protobuf limit can be cached.
+        Ort::SessionOptions optimizeOptions = sessionOptions.Clone();
+        optimizeOptions.DisableProfiling();
+        optimizeOptions.SetOptimizedModelFilePath(stagedModelPath.wstring().c_str());
+        optimizeOptions.AddConfigEntry("ep.dml.disable_graph_fusion", "1");
+        optimizeOptions.AddConfigEntry("session.optimized_model_external_initializers_file_name", OnnxModelCache::ExternalDataFileName());
+        optimizeOptions.AddConfigEntry("session.optimized_model_external_initializers_min_size_in_bytes", "1024");
+
+        Ort::ThrowOnError(m_ortDmlApi->SessionOptionsAppendExecutionProvider_DML1(optimizeOptions, m_device->DML(), m_device->GetCommandQueue()));
+
+        Ort::Session optimizeSession(*m_environment, m_desc.sourcePath.wstring().c_str(), optimizeOptions);
+    }
+    catch (const std::exception& e)
+    {
+        m_logger->LogWarning(fmt::format("Failed to optimize '{}' for the ONNX model cache: {}", m_desc.sourcePath.filename().string(), e.what()).c_str());
+        if (!stagedModelPath.empty())
+        {
+            std::error_code error;
+            std::filesystem::remove_all(stagedModelPath.parent_path(), error);
+        }
+        return std::nullopt;
+    }
+
+    auto cachedModelPath = cache.EndStore(cacheKey, stagedModelPath);
+    if (!cachedModelPath)
+    {
+        m_logger->LogInfo(fmt::format("Failed to write to the ONNX model cache '{}'", cache.GetDirectory().string()).c_str());
+    }
+    return cachedModelPath;
 }
 
 void OnnxDispatchable::Bind(const Bindings& jsonBindings, uint32_t iteration)
@@ -609,4 +743,130 @@ void OnnxDispatchable::Dispatch(const Model::DispatchCommand& args, uint32_t ite
             throw std::invalid_argument(fmt::format("Could not find deferred binding {}", deferredBinding->name));
         }
     }
-}
\ No newline at end of file
+}
+std::vector<OnnxDispatchable::TensorBinding> OnnxDispatchable::CreateStreamBindings(Ort::IoBinding& ioBinding)
+{
+    Ort::MemoryInfo cpuMemoryInformation = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::MemoryInfo dmlMemoryInformation("DML", OrtAllocatorType::OrtDeviceAllocator, 0, OrtMemType::OrtMemTypeDefault);
+
+    std::vector<TensorBinding> streamBindings;
+    for (auto& binding : m_mergedBindings)
+    {
+        TensorBinding streamBinding = {};
+        streamBinding.name = binding.name;
+        streamBinding.resourceType = binding.resourceType;
+        streamBinding.shape = binding.shape;
+        streamBinding.dataType = binding.dataType;
+        streamBinding.isInput = binding.isInput;
+
+        if (binding.resource)
+        {
+            // Inputs keep their contents so every stream computes the same thing. The copies are recorded into the
+            // device's command list and executed before the streams start.
+            uint64_t sizeInBytes = binding.resource->GetDesc().Width;
+            streamBinding.resource = binding.isInput ? 
+                m_device->Upload(sizeInBytes, m_device->Download(binding.resource)) : 
+                m_device->CreatePreferredDeviceMemoryBuffer(sizeInBytes);
+
+            streamBinding.ortValue = CreateTensorFromResource(
+                m_ortDmlApi,
+                dmlMemoryInformation,
+                streamBinding.resource.Get(),
+                streamBinding.shape,
+                GetDataTypeInfo(streamBinding.dataType).onnxDataType,
+                &streamBinding.wrapper
+            );
+        }
+        else if (binding.ortValue && !binding.isInput)
+        {
+            streamBinding.ortValue = Ort::Value::CreateTensor(
+                static_cast<OrtAllocator*>(Ort::AllocatorWithDefaultOptions()), 
+                streamBinding.shape.data(),
+                streamBinding.shape.size(), 
+                streamBinding.dataType
+            );
+        }
+
+        if (binding.isInput)
+        {
+            // CPU inputs (data types DML doesn't support) are only read, so the streams share them.
+            auto& value = streamBinding.ortValue ? streamBinding.ortValue : binding.ortValue;
+            if (value)
+            {
+                ioBinding.BindInput(binding.name.c_str(), *value);
+            }
+        }
+        else if (streamBinding.ortValue)
+        {
+            ioBinding.BindOutput(binding.name.c_str(), *streamBinding.ortValue);
+        }
+        else
+        {
+            bool isDmlSupportedType = GetDataTypeInfo(binding.dataType).dmlDataType != DML_TENSOR_DATA_TYPE_UNKNOWN;
+            ioBinding.BindOutput(binding.name.c_str(), isDmlSupportedType ? dmlMemoryInformation : cpuMemoryInformation);
+        }
+
+        streamBindings.emplace_back(std::move(streamBinding));
+    }
+
+    return streamBindings;
+}
+
+OnnxDispatchable::StreamTimings OnnxDispatchable::RunConcurrentStreams(
+    uint32_t streamCount, 
+    uint32_t iterationsPerStream, 
+    std::optional<uint32_t> timeToRunInMilliseconds)
+{
+    // The DirectML execution provider doesn't support concurrent Run() calls on a single session, so each stream
+    // has a session of its own. Sessions beyond the first are created before any stream starts and kept for later
+    // stream counts.
+    while (m_streamSessions.size() + 1 < streamCount)
+    {
+        TraceScope traceScope("Create stream session");
+        m_streamSessions.emplace_back(*m_environment, m_sessionModelPath.wstring().c_str(), *m_sessionOptions);
+    }
+
+    std::vector<Ort::Session*> sessions = { &*m_session };
+    for (uint32_t stream = 1; stream < streamCount; stream++)
+    {
+        sessions.push_back(&m_streamSessions[stream - 1]);
+    }
+
+    std::vector<Ort::IoBinding> ioBindings;
+    std::vector<std::vector<TensorBinding>> streamBindings;
+    for (uint32_t stream = 0; stream < streamCount; stream++)
+    {
+        ioBindings.emplace_back(*sessions[stream]);
+        streamBindings.push_back(CreateStreamBindings(ioBindings.back()));
+    }
+    m_device->ExecuteCommandListAndWait();
+
+    // The first run of each stream pays for allocations and shader compilation, so it isn't timed.
+    auto WarmUp = [&](uint32_t stream)
+    {
+        Ort::RunOptions runOptions;
+        sessions[stream]->Run(runOptions, ioBindings[stream]);
+        ioBindings[stream].SynchronizeOutputs();
+    };
+
+    auto RunIteration = [&](uint32_t stream)
+    {
+        Ort::RunOptions runOptions;
+        for (uint32_t i = 0; i < m_args.DispatchRepeat(); i++)
+        {
+            sessions[stream]->Run(runOptions, ioBindings[stream]);
+        }
+        ioBindings[stream].SynchronizeOutputs();
+    };
+
+    // Each timed iteration runs DispatchRepeat inferences, so its latency is averaged over them.
+    auto timings = RunStreamsConcurrently(streamCount, iterationsPerStream, timeToRunInMilliseconds, WarmUp, RunIteration);
+    for (auto& latencies : timings.latencies)
+    {
+        for (auto& latency : latencies)
+        {
+            latency /= m_args.DispatchRepeat();
+        }
+    }
+    return timings;
+}
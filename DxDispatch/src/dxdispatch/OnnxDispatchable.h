@@ -3,6 +3,7 @@
 #include <onnxruntime_cxx_api.h>
 #include "dml_provider_factory.h"
 #include "CommandLineArgs.h"
+#include "LoadGenerator.h"
 
 class OnnxDispatchable : public Dispatchable
 {
@@ -17,11 +18,26 @@ public:
     void Bind(const Bindings& bindings, uint32_t iteration) final;
     void Dispatch(const Model::DispatchCommand& args, uint32_t iteration, DeferredBindings& defferedBindings) final;
 
+    using StreamTimings = ConcurrentStreamTimings; // Latencies are milliseconds per inference.
+
+    // Runs the model from streamCount threads at once. Each stream has its own session and IO binding with private
+    // copies of the bound DirectX resources, so streams share only the device. Each stream runs iterationsPerStream
+    // inferences, or stops early once timeToRunInMilliseconds has elapsed. Bind() must have been called to resolve 
+    // the tensor bindings first.
+    StreamTimings RunConcurrentStreams(uint32_t streamCount, uint32_t iterationsPerStream, std::optional<uint32_t> timeToRunInMilliseconds);
+
+private:
+    std::string ComputeModelCacheKey(GraphOptimizationLevel graphOptimizationLevel);
+    std::optional<std::filesystem::path> GetOptimizedModel(const Ort::SessionOptions& sessionOptions, GraphOptimizationLevel graphOptimizationLevel);
+
 private:
     std::shared_ptr<Device> m_device;
     const Model::OnnxDispatchableDesc& m_desc;
     std::optional<Ort::Env> m_environment;
     std::optional<Ort::Session> m_session;
+    std::optional<Ort::SessionOptions> m_sessionOptions;
+    std::filesystem::path m_sessionModelPath;
+    std::vector<Ort::Session> m_streamSessions; // Sessions for concurrent streams after the first.
     const OrtDmlApi* m_ortDmlApi = nullptr;
     const CommandLineArgs& m_args;
 
@@ -41,6 +57,9 @@ private:
     // are the union of JSON bindings and bindings to lazily-allocated resources from the first Bind().
     std::vector<TensorBinding> m_mergedBindings;
 
+    // Creates a copy of the merged bindings for one concurrent stream and binds them to ioBinding.
+    std::vector<TensorBinding> CreateStreamBindings(Ort::IoBinding& ioBinding);
+
     std::optional<Ort::IoBinding> m_ioBindings;
     Microsoft::WRL::ComPtr<IDxDispatchLogger> m_logger;
 };
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "HlslShaderCache.h"
+#include "OnnxModelCache.h"
+#include <set>
+
+constexpr const char* c_modelFileName = "model.onnx";
+constexpr const char* c_keyFileName = "key.txt";
+
+OnnxModelCache::OnnxModelCache(std::filesystem::path directory) : m_directory(std::move(directory))
+{
+}
+
+std::filesystem::path OnnxModelCache::GetEntryDirectory(std::string_view key) const
+{
+    auto keyBytes = gsl::make_span(reinterpret_cast<const std::byte*>(key.data()), key.size());
+    return m_directory / fmt::format("{:016x}", HlslShaderCache::Hash(keyBytes));
+}
+
+std::optional<std::filesystem::path> OnnxModelCache::Find(std::string_view key) const
+{
+    auto entryDirectory = GetEntryDirectory(key);
+
+    std::ifstream keyFile(entryDirectory / c_keyFileName, std::ios::binary);
+    if (!keyFile.is_open())
+    {
+        return std::nullopt;
+    }
+
+    std::string storedKey((std::istreambuf_iterator<char>(keyFile)), std::istreambuf_iterator<char>());
+    std::error_code error;
+    if (storedKey != key || !std::filesystem::exists(entryDirectory / c_modelFileName, error))
+    {
+        return std::nullopt;
+    }
+
+    return entryDirectory / c_modelFileName;
+}
+
+std::filesystem::path OnnxModelCache::BeginStore(std::string_view key) const
+{
+    auto stagingDirectory = GetEntryDirectory(key);
+    stagingDirectory += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+        static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    std::filesystem::create_directories(stagingDirectory);
+    return stagingDirectory / c_modelFileName;
+}
+
+std::optional<std::filesystem::path> OnnxModelCache::EndStore(std::string_view key, const std::filesystem::path& stagedModelPath) const
+{
+    auto stagingDirectory = stagedModelPath.parent_path();
+    std::error_code error;
+
+    {
+        std::ofstream keyFile(stagingDirectory / c_keyFileName, std::ios::binary | std::ios::trunc);
+        keyFile.write(key.data(), key.size());
+        if (!keyFile)
+        {
+            keyFile.close();
+            std::filesystem::remove_all(stagingDirectory, error);
+            return std::nullopt;
+        }
+    }
+
+    // An existing directory for the key is either the same entry stored by another process or a stale/corrupt
+    // entry (e.g. a hash collision). Only the latter is replaced.
+    if (auto existingModel = Find(key))
+    {
+        std::filesystem::remove_all(stagingDirectory, error);
+        return existingModel;
+    }
+
+    auto entryDirectory = GetEntryDirectory(key);
+    std::filesystem::remove_all(entryDirectory, error);
+    std::filesystem::rename(stagingDirectory, entryDirectory, error);
+    if (error)
+    {
+        std::filesystem::remove_all(stagingDirectory, error);
+        return Find(key);
+    }
+
+    return entryDirectory / c_modelFileName;
+}
+
+void OnnxModelCache::Clear() const
+{
+    std::error_code error;
+    std::filesystem::remove_all(m_directory, error);
+    if (error)
+    {
+        throw std::runtime_error(fmt::format("Failed to clear ONNX model cache '{}': {}", m_directory.string(), error.message()));
+    }
+}
+
+// Hashes a file in chunks, calling a visitor on each chunk so the caller can scan it without reading the file twice.
+template <typename ChunkVisitor>
+static bool HashFile(const std::filesystem::path& path, uint64_t& hash, uint64_t& size, ChunkVisitor&& visitChunk)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    hash = HlslShaderCache::Hash({});
+    size = 0;
+    std::vector<char> chunk(1 << 20);
+    while (file.read(chunk.data(), chunk.size()) || file.gcount() > 0)
+    {
+        auto chunkSize = static_cast<size_t>(file.gcount());
+        hash = HlslShaderCache::Hash(gsl::make_span(reinterpret_cast<const std::byte*>(chunk.data()), chunkSize), hash);
+        size += chunkSize;
+        visitChunk(std::string_view(chunk.data(), chunkSize));
+    }
+    return !file.bad();
+}
+
+std::optional<std::string> OnnxModelCache::DescribeSourceFiles(const std::filesystem::path& modelPath)
+{
+    // Tensors with external data list StringStringEntryProto messages, and the file is named by the one with the key
+    // "location": field 1 (tag 0x0A) holds the 8-byte key, and field 2 (tag 0x12) holds the varint-prefixed value. 
+    // Chunks are scanned with the tail of the previous chunk prepended, so entries that span chunks are found.
+    constexpr std::string_view locationPrefix("\x0A\x08location\x12", 11);
+    constexpr size_t maxEntrySize = 1024;
+    std::set<std::string> locations;
+    std::string window;
+
+    auto scanChunk = [&](std::string_view chunk)
+    {
+        window += chunk;
+        for (size_t match = window.find(locationPrefix); match != std::string::npos; match = window.find(locationPrefix, match + 1))
+        {
+            size_t offset = match + locationPrefix.size();
+            uint64_t length = 0;
+            for (uint32_t shift = 0; offset < window.size() && shift < 64; shift += 7)
+            {
+                auto byte = static_cast<uint8_t>(window[offset++]);
+                length |= uint64_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    if (length <= window.size() - offset)
+                    {
+                        locations.emplace(window.substr(offset, length));
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (window.size() > maxEntrySize)
+        {
+            window.erase(0, window.size() - maxEntrySize);
+        }
+    };
+
+    uint64_t hash, size;
+    if (!HashFile(modelPath, hash, size, scanChunk))
+    {
+        return std::nullopt;
+    }
+    std::string description = fmt::format("source {:016x} {}\n", hash, size);
+
+    for (auto& location : locations)
+    {
+        if (!HashFile(modelPath.parent_path() / location, hash, size, [](std::string_view) {}))
+        {
+            return std::nullopt;
+        }
+        description += fmt::format("externalData {} {:016x} {}\n", location, hash, size);
+    }
+
+    return description;
+}
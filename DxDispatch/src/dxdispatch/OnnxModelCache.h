@@ -0,0 +1,40 @@
+#pragma once
+
+// Persistent cache of ONNX models that ONNX Runtime has already optimized. Each entry is a directory named after a
+// hash of its key, holding the optimized model, its external initializers, and the full key (compared on lookup so
+// hash collisions are treated as misses). Entries are written to a staging directory and renamed into place, so
+// concurrent processes can share a cache and never see a partially written model.
+class OnnxModelCache
+{
+public:
+    explicit OnnxModelCache(std::filesystem::path directory);
+
+    // Returns the path of the cached model, or std::nullopt if there is no complete entry for the key.
+    std::optional<std::filesystem::path> Find(std::string_view key) const;
+
+    // Creates an empty staging directory for a new entry and returns the path the optimized model should be
+    // written to. External initializers must be written next to it using ExternalDataFileName().
+    std::filesystem::path BeginStore(std::string_view key) const;
+
+    // Moves a staged entry into the cache and returns the path of its model. Returns std::nullopt if the entry
+    // could not be stored; the staged files are removed either way. If another process stored the same entry
+    // first, its model is returned instead.
+    std::optional<std::filesystem::path> EndStore(std::string_view key, const std::filesystem::path& stagedModelPath) const;
+
+    // Removes all entries.
+    void Clear() const;
+
+    // Describes the contents of a source model and the external data files it references (ONNX "location" entries,
+    // resolved next to the model), for use in a key. Returns std::nullopt if any of the files can't be read.
+    static std::optional<std::string> DescribeSourceFiles(const std::filesystem::path& modelPath);
+
+    const std::filesystem::path& GetDirectory() const { return m_directory; }
+
+    static constexpr const char* ExternalDataFileName() { return "model.onnx.data"; }
+
+private:
+    std::filesystem::path GetEntryDirectory(std::string_view key) const;
+
+private:
+    std::filesystem::path m_directory;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+
+// Build with -DDXD_PERF_COUNTERS=OFF to compile out all counter updates.
+#ifndef DXD_PERF_COUNTERS
+#define DXD_PERF_COUNTERS 0
+#endif
+
+// Counts work that is easy to miss in timing results: resource allocations, descriptor heap and binding table
+// creation, command list submissions, and CPU waits on the GPU. Counters are process-wide and only increase;
+// take a snapshot before and after a region of interest and subtract them to attribute work to the region.
+struct PerfCounters
+{
+    uint64_t resourcesCreated = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t descriptorHeapsCreated = 0;
+    uint64_t bindingTablesCreated = 0;
+    uint64_t commandListSubmissions = 0;
+    uint64_t fenceWaits = 0;
+    double fenceWaitMilliseconds = 0;
+
+    // Returns a snapshot of the process-wide counters.
+    static PerfCounters Global();
+
+    PerfCounters operator-(const PerfCounters& other) const
+    {
+        PerfCounters delta;
+        delta.resourcesCreated = resourcesCreated - other.resourcesCreated;
+        delta.bytesAllocated = bytesAllocated - other.bytesAllocated;
+        delta.descriptorHeapsCreated = descriptorHeapsCreated - other.descriptorHeapsCreated;
+        delta.bindingTablesCreated = bindingTablesCreated - other.bindingTablesCreated;
+        delta.commandListSubmissions = commandListSubmissions - other.commandListSubmissions;
+        delta.fenceWaits = fenceWaits - other.fenceWaits;
+        delta.fenceWaitMilliseconds = fenceWaitMilliseconds - other.fenceWaitMilliseconds;
+        return delta;
+    }
+};
+
+// The process-wide counters behind PerfCounters::Global(). Concurrent ONNX streams and the readback thread reach
+// device paths that update them, so every counter is atomic. Relaxed increments are enough: a snapshot needs each
+// value, not an order between them.
+struct PerfCounterStorage
+{
+    std::atomic<uint64_t> resourcesCreated = 0;
+    std::atomic<uint64_t> bytesAllocated = 0;
+    std::atomic<uint64_t> descriptorHeapsCreated = 0;
+    std::atomic<uint64_t> bindingTablesCreated = 0;
+    std::atomic<uint64_t> commandListSubmissions = 0;
+    std::atomic<uint64_t> fenceWaits = 0;
+    std::atomic<uint64_t> fenceWaitNanoseconds = 0;
+
+    static PerfCounterStorage& Get()
+    {
+        static PerfCounterStorage storage;
+        return storage;
+    }
+};
+
+inline PerfCounters PerfCounters::Global()
+{
+    auto& storage = PerfCounterStorage::Get();
+    PerfCounters counters;
+    counters.resourcesCreated = storage.resourcesCreated.load(std::memory_order_relaxed);
+    counters.bytesAllocated = storage.bytesAllocated.load(std::memory_order_relaxed);
+    counters.descriptorHeapsCreated = storage.descriptorHeapsCreated.load(std::memory_order_relaxed);
+    counters.bindingTablesCreated = storage.bindingTablesCreated.load(std::memory_order_relaxed);
+    counters.commandListSubmissions = storage.commandListSubmissions.load(std::memory_order_relaxed);
+    counters.fenceWaits = storage.fenceWaits.load(std::memory_order_relaxed);
+    counters.fenceWaitMilliseconds = storage.fenceWaitNanoseconds.load(std::memory_order_relaxed) / 1e6;
+    return counters;
+}
+
+#if DXD_PERF_COUNTERS
+#define DXD_PERF_COUNTER_ADD(counter, value) (PerfCounterStorage::Get().counter.fetch_add((value), std::memory_order_relaxed))
+#else
+#define DXD_PERF_COUNTER_ADD(counter, value) ((void)0)
+#endif
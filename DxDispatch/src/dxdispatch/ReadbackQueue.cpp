@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "Device.h"
+#include "ReadbackQueue.h"
+
+using Microsoft::WRL::ComPtr;
+
+ReadbackQueue::ReadbackQueue(std::shared_ptr<Device> device, IDxDispatchLogger* logger, uint32_t bufferCount) :
+    m_device(device),
+    m_logger(logger),
+    m_buffers(bufferCount)
+{
+    // The device's own fence is signaled with values relative to its last completed value, so readbacks track
+    // their copies with a separate, strictly increasing fence.
+    THROW_IF_FAILED(m_device->D3D()->CreateFence(
+        0,
+        D3D12_FENCE_FLAG_NONE,
+        IID_GRAPHICS_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+
+    m_thread = std::thread([this] { ProcessRequests(); });
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+    try
+    {
+        Flush();
+    }
+    catch (...)
+    {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_requestAvailable.notify_all();
+    m_thread.join();
+}
+
+void ReadbackQueue::Enqueue(ComPtr<ID3D12Resource> buffer, Callback callback)
+{
+    // CPU-visible buffers are copied immediately, since later dispatches may overwrite them at any time.
+    if (Device::IsCpuReadable(buffer.Get()))
+    {
+        Enqueue(m_device->Download(buffer), std::move(callback));
+        return;
+    }
+
+    TraceScope traceScope("Enqueue readback");
+
+    uint32_t bufferIndex = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_requestCompleted.wait(lock, [&]
+        {
+            auto freeBuffer = std::find_if(m_buffers.begin(), m_buffers.end(), [](auto& b) { return !b.inUse; });
+            bufferIndex = static_cast<uint32_t>(freeBuffer - m_buffers.begin());
+            return freeBuffer != m_buffers.end();
+        });
+        m_buffers[bufferIndex].inUse = true;
+    }
+
+    // The buffer is moved into the request once the copy is submitted; until then, a failure frees the slot.
+    auto releaseBuffer = gsl::finally([&]
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_buffers[bufferIndex].inUse = false;
+        }
+    });
+
+    // Readback buffers only grow, so after the first few requests no new allocations are made.
+    auto sizeInBytes = buffer->GetDesc().Width;
+    auto& readbackBuffer = m_buffers[bufferIndex].resource;
+    if (!readbackBuffer || readbackBuffer->GetDesc().Width < sizeInBytes)
+    {
+        readbackBuffer = m_device->CreateReadbackBuffer(sizeInBytes);
+        readbackBuffer->SetName(L"ReadbackQueue");
+    }
+
+    auto commandList = m_device->GetCommandList();
+    D3D12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            buffer.Get(),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_COPY_SOURCE)
+    };
+    commandList->ResourceBarrier(_countof(barriers), barriers);
+    commandList->CopyBufferRegion(readbackBuffer.Get(), 0, buffer.Get(), 0, sizeInBytes);
+    std::swap(barriers[0].Transition.StateBefore, barriers[0].Transition.StateAfter);
+    commandList->ResourceBarrier(_countof(barriers), barriers);
+
+    m_device->ExecuteCommandList();
+    THROW_IF_FAILED(m_device->GetCommandQueue()->Signal(m_fence.Get(), ++m_lastFenceValue));
+
+    Request request = {};
+    request.callback = std::move(callback);
+    request.bufferIndex = bufferIndex;
+    request.fenceValue = m_lastFenceValue;
+    request.sizeInBytes = sizeInBytes;
+    request.source = std::move(buffer);
+    Push(std::move(request));
+}
+
+void ReadbackQueue::Enqueue(std::vector<std::byte> data, Callback callback)
+{
+    Request request = {};
+    request.callback = std::move(callback);
+    request.sizeInBytes = data.size();
+    request.data = std::move(data);
+    Push(std::move(request));
+}
+
+void ReadbackQueue::Push(Request&& request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back(std::move(request));
+        m_pendingCount++;
+    }
+    m_requestAvailable.notify_one();
+}
+
+void ReadbackQueue::Flush()
+{
+    TraceScope traceScope("Flush readbacks");
+
+    std::vector<Message> messages;
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_requestCompleted.wait(lock, [this] { return m_pendingCount == 0; });
+        messages = std::exchange(m_messages, {});
+        error = std::exchange(m_error, nullptr);
+    }
+
+    for (auto& message : messages)
+    {
+        if (message.level == Message::Level::Error)
+        {
+            m_logger->LogError(message.text.c_str());
+        }
+        else
+        {
+            m_logger->LogInfo(message.text.c_str());
+        }
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ReadbackQueue::ProcessRequests()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_requestAvailable.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+            if (m_requests.empty())
+            {
+                return;
+            }
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+
+        std::vector<Message> messages;
+        std::exception_ptr error;
+        try
+        {
+            TraceScope traceScope("Readback");
+            if (request.bufferIndex)
+            {
+                // With a null event handle this blocks until the fence reaches the value.
+                THROW_IF_FAILED(m_fence->SetEventOnCompletion(request.fenceValue, nullptr));
+                request.source = nullptr;
+
+                auto resource = m_buffers[*request.bufferIndex].resource.Get();
+                size_t dataSize = gsl::narrow<size_t>(request.sizeInBytes);
+                CD3DX12_RANGE readRange(0, dataSize);
+                void* mappedBufferData = nullptr;
+                THROW_IF_FAILED(resource->Map(0, &readRange, &mappedBufferData));
+                auto unmap = gsl::finally([&] { resource->Unmap(0, nullptr); });
+                TraceRecorder::Get().IncrementCounter("Bytes downloaded", dataSize);
+
+                request.callback(gsl::make_span(static_cast<const std::byte*>(mappedBufferData), dataSize), messages);
+            }
+            else
+            {
+                request.callback(request.data, messages);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (request.bufferIndex)
+            {
+                m_buffers[*request.bufferIndex].inUse = false;
+            }
+            if (error && !m_error)
+            {
+                m_error = error;
+            }
+            m_messages.insert(m_messages.end(), std::make_move_iterator(messages.begin()), std::make_move_iterator(messages.end()));
+            m_pendingCount--;
+        }
+        m_requestCompleted.notify_all();
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+
+// Reads buffers back to the CPU without blocking the thread that requests them. Copies are recorded into the device
+// command list and land in a small ring of persistent readback buffers, each guarded by a fence value. A background
+// thread waits for each copy and passes the mapped bytes to the request's callback (e.g. formatting or writing a
+// file) before returning the buffer to the ring. Callbacks run one at a time, in the order they were enqueued. Loggers
+// may not be thread-safe, so callbacks return their messages and Flush logs them on the calling thread.
+class ReadbackQueue
+{
+public:
+    struct Message
+    {
+        enum class Level { Info, Error };
+        Level level;
+        std::string text;
+    };
+
+    // Appends any messages to log; messages added before a callback throws are still logged.
+    using Callback = std::function<void(gsl::span<const std::byte> data, std::vector<Message>& messages)>;
+
+    ReadbackQueue(std::shared_ptr<Device> device, IDxDispatchLogger* logger, uint32_t bufferCount = 2);
+    ~ReadbackQueue();
+
+    // Submits a copy of the buffer and queues the callback to run with its contents. The copy executes after any
+    // work already recorded into the device command list. Blocks only while every readback buffer is still in use.
+    void Enqueue(Microsoft::WRL::ComPtr<ID3D12Resource> buffer, Callback callback);
+
+    // Queues the callback to run with data that is already on the CPU, in order with other callbacks.
+    void Enqueue(std::vector<std::byte> data, Callback callback);
+
+    // Blocks until every queued callback has run, then logs their messages in order. Rethrows the first exception
+    // thrown by a callback since the last flush.
+    void Flush();
+
+private:
+    struct Request
+    {
+        Callback callback;
+        std::optional<uint32_t> bufferIndex; // Index into m_buffers; not set for CPU data.
+        uint64_t fenceValue = 0;
+        uint64_t sizeInBytes = 0;
+        Microsoft::WRL::ComPtr<ID3D12Resource> source; // Kept alive until the copy completes.
+        std::vector<std::byte> data;
+    };
+
+    struct ReadbackBuffer
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        bool inUse = false;
+    };
+
+    void Push(Request&& request);
+    void ProcessRequests();
+
+private:
+    std::shared_ptr<Device> m_device;
+    IDxDispatchLogger* m_logger;
+    Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+    uint64_t m_lastFenceValue = 0;
+    std::vector<ReadbackBuffer> m_buffers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_requestAvailable;
+    std::condition_variable m_requestCompleted;
+    std::deque<Request> m_requests;
+    uint32_t m_pendingCount = 0; // Queued requests plus the request being processed.
+    std::vector<Message> m_messages; // Messages from completed callbacks, not yet logged.
+    std::exception_ptr m_error;
+    bool m_stop = false;
+    std::thread m_thread;
+};
@@ -0,0 +1,671 @@
+#include "pch.h"
+#include "Device.h"
+#include "Model.h"
+#include "Dispatchable.h"
+#include "JsonParsers.h"
+#include "CommandLineArgs.h"
+#include "Executor.h"
+#include "Server.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <utility>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static void CloseNativeSocket(LocalSocket::NativeHandle handle) { closesocket(static_cast<SOCKET>(handle)); }
+static bool IsValidNativeSocket(LocalSocket::NativeHandle handle) { return static_cast<SOCKET>(handle) != INVALID_SOCKET; }
+constexpr int c_sendFlags = 0;
+
+// Winsock must be initialized once per process before any socket is created.
+static void EnsureWinsockInitialized()
+{
+    static int result = []
+    {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data);
+    }();
+
+    if (result != 0)
+    {
+        throw std::runtime_error(fmt::format("WSAStartup failed with error {}", result));
+    }
+}
+#else
+static void CloseNativeSocket(LocalSocket::NativeHandle handle) { close(handle); }
+static bool IsValidNativeSocket(LocalSocket::NativeHandle handle) { return handle >= 0; }
+static void EnsureWinsockInitialized() {}
+
+// A client that disconnects mid-stream must not terminate the server with SIGPIPE.
+constexpr int c_sendFlags = MSG_NOSIGNAL;
+#endif
+
+static sockaddr_un GetSocketAddress(const std::filesystem::path& path)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+
+    auto pathString = path.string();
+    if (pathString.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument(fmt::format("Socket path '{}' is too long", pathString));
+    }
+    std::copy(pathString.begin(), pathString.end(), address.sun_path);
+    return address;
+}
+
+static LocalSocket::NativeHandle CreateNativeSocket()
+{
+    EnsureWinsockInitialized();
+    auto handle = static_cast<LocalSocket::NativeHandle>(socket(AF_UNIX, SOCK_STREAM, 0));
+    if (!IsValidNativeSocket(handle))
+    {
+        throw std::runtime_error("Failed to create a local socket");
+    }
+    return handle;
+}
+
+LocalSocket LocalSocket::Listen(const std::filesystem::path& path)
+{
+    auto address = GetSocketAddress(path);
+    LocalSocket listener(CreateNativeSocket());
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    if (bind(*listener.m_handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(*listener.m_handle, SOMAXCONN) != 0)
+    {
+        throw std::runtime_error(fmt::format("Failed to listen on '{}'", path.string()));
+    }
+    return listener;
+}
+
+LocalSocket LocalSocket::Connect(const std::filesystem::path& path)
+{
+    auto address = GetSocketAddress(path);
+    LocalSocket client(CreateNativeSocket());
+    if (connect(*client.m_handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        throw std::runtime_error(fmt::format("Failed to connect to '{}'", path.string()));
+    }
+    return client;
+}
+
+LocalSocket::LocalSocket(LocalSocket&& other) noexcept :
+    m_handle(std::exchange(other.m_handle, std::nullopt)), m_receiveBuffer(std::move(other.m_receiveBuffer))
+{
+}
+
+LocalSocket& LocalSocket::operator=(LocalSocket&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_handle = std::exchange(other.m_handle, std::nullopt);
+        m_receiveBuffer = std::move(other.m_receiveBuffer);
+    }
+    return *this;
+}
+
+LocalSocket::~LocalSocket()
+{
+    Close();
+}
+
+void LocalSocket::Close()
+{
+    if (m_handle)
+    {
+        CloseNativeSocket(*m_handle);
+        m_handle.reset();
+    }
+}
+
+LocalSocket LocalSocket::Accept()
+{
+    auto handle = static_cast<NativeHandle>(accept(*m_handle, nullptr, nullptr));
+    if (!IsValidNativeSocket(handle))
+    {
+        throw std::runtime_error("Failed to accept a connection");
+    }
+    return LocalSocket(handle);
+}
+
+bool LocalSocket::SendLine(std::string_view line)
+{
+    std::string message(line);
+    message += '\n';
+
+    size_t bytesSent = 0;
+    while (bytesSent < message.size())
+    {
+        auto result = send(*m_handle, message.data() + bytesSent, static_cast<int>(message.size() - bytesSent), c_sendFlags);
+        if (result <= 0)
+        {
+            return false;
+        }
+        bytesSent += result;
+    }
+    return true;
+}
+
+bool LocalSocket::ReceiveLine(std::string& line)
+{
+    while (true)
+    {
+        auto newline = m_receiveBuffer.find('\n');
+        if (newline != std::string::npos)
+        {
+            line = m_receiveBuffer.substr(0, newline);
+            m_receiveBuffer.erase(0, newline + 1);
+            return true;
+        }
+
+        char chunk[4096];
+        auto result = recv(*m_handle, chunk, sizeof(chunk), 0);
+        if (result <= 0)
+        {
+            return false;
+        }
+        m_receiveBuffer.append(chunk, result);
+    }
+}
+
+// Builds a single-line JSON message with a "type" and any number of string/number fields.
+class MessageWriter
+{
+public:
+    explicit MessageWriter(std::string_view type) : m_writer(m_buffer)
+    {
+        m_writer.StartObject();
+        Add("type", type);
+    }
+
+    MessageWriter& Add(std::string_view key, std::string_view value)
+    {
+        m_writer.Key(key.data(), static_cast<rapidjson::SizeType>(key.size()));
+        m_writer.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+        return *this;
+    }
+
+    MessageWriter& Add(std::string_view key, const char* value)
+    {
+        return Add(key, std::string_view(value));
+    }
+
+    MessageWriter& Add(std::string_view key, double value)
+    {
+        m_writer.Key(key.data(), static_cast<rapidjson::SizeType>(key.size()));
+        m_writer.Double(value);
+        return *this;
+    }
+
+    MessageWriter& Add(std::string_view key, bool value)
+    {
+        m_writer.Key(key.data(), static_cast<rapidjson::SizeType>(key.size()));
+        m_writer.Bool(value);
+        return *this;
+    }
+
+    std::string_view Finish()
+    {
+        m_writer.EndObject();
+        return std::string_view(m_buffer.GetString(), m_buffer.GetSize());
+    }
+
+private:
+    rapidjson::StringBuffer m_buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> m_writer;
+};
+
+// Streams log messages to the client whose request is being handled, or to the server's own logger between requests.
+class ClientLogger : public Microsoft::WRL::Base<IDxDispatchLogger>
+{
+public:
+    ClientLogger(IDxDispatchLogger* serverLogger) : m_serverLogger(serverLogger) {}
+
+    void SetClient(LocalSocket* client) { m_client = client; }
+
+    void STDMETHODCALLTYPE LogInfo(_In_ PCSTR message) final { Log("info", message); }
+    void STDMETHODCALLTYPE LogWarning(_In_ PCSTR message) final { Log("warning", message); }
+    void STDMETHODCALLTYPE LogError(_In_ PCSTR message) final { Log("error", message); }
+
+    void STDMETHODCALLTYPE LogCommandStarted(UINT32 index, _In_ PCSTR jsonString) final
+    {
+        Log("info", fmt::format("[StartCmd][{:>04}]\t: {}", index, jsonString).c_str());
+    }
+
+    void STDMETHODCALLTYPE LogCommandCompleted(UINT32 index, HRESULT hr, _In_opt_ PCSTR statusString) final
+    {
+        Log("info", fmt::format("[EndCmd][{:>04}]\t: hr={:<#010x} {}", index, hr, statusString ? statusString : "").c_str());
+    }
+
+private:
+    void Log(std::string_view level, PCSTR message)
+    {
+        if (m_client)
+        {
+            m_client->SendLine(MessageWriter("log").Add("level", level).Add("message", message).Finish());
+        }
+        else if (level == "error")
+        {
+            m_serverLogger->LogError(message);
+        }
+        else if (level == "warning")
+        {
+            m_serverLogger->LogWarning(message);
+        }
+        else
+        {
+            m_serverLogger->LogInfo(message);
+        }
+    }
+
+private:
+    Microsoft::WRL::ComPtr<IDxDispatchLogger> m_serverLogger;
+    LocalSocket* m_client = nullptr;
+};
+
+Server::Server(std::shared_ptr<Device> device, const CommandLineArgs& args, IDxDispatchLogger* logger) :
+    m_device(std::move(device)), m_commandLineArgs(args), m_logger(logger)
+{
+    m_clientLogger = Microsoft::WRL::Make<ClientLogger>(logger);
+}
+
+Server::~Server()
+{
+    // Executors reference their models, so they're released first.
+    for (auto& [path, loadedModel] : m_models)
+    {
+        loadedModel.executor.reset();
+    }
+}
+
+void Server::Run(const std::filesystem::path& socketPath)
+{
+    auto listener = LocalSocket::Listen(socketPath);
+    m_logger->LogInfo(fmt::format("Serving on '{}'", socketPath.string()).c_str());
+
+    bool running = true;
+    while (running)
+    {
+        auto client = listener.Accept();
+        std::string requestLine;
+        while (running && client.ReceiveLine(requestLine))
+        {
+            m_clientLogger->SetClient(&client);
+            running = HandleRequest(client, requestLine);
+            m_clientLogger->SetClient(nullptr);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::remove(socketPath, error);
+}
+
+// The model file and every file it reads, which must all be unchanged for a cached model to be reused.
+static std::vector<std::filesystem::path> GetSourceFiles(const Model& model, const std::filesystem::path& modelPath, const CommandLineArgs& args)
+{
+    std::vector<std::filesystem::path> paths = { modelPath };
+    if (args.OverlayPath())
+    {
+        paths.push_back(*args.OverlayPath());
+    }
+
+    for (auto& desc : model.GetResourceDescs())
+    {
+        auto& sourcePath = std::get<Model::BufferDesc>(desc.value).sourcePath;
+        if (!sourcePath.empty())
+        {
+            paths.push_back(sourcePath);
+        }
+    }
+
+    for (auto& desc : model.GetDispatchableDescs())
+    {
+        std::visit([&](auto& dispatchableDesc)
+        {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(dispatchableDesc)>, Model::DmlDispatchableDesc>)
+            {
+                paths.push_back(dispatchableDesc.sourcePath);
+            }
+        }, desc.value);
+    }
+
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    return paths;
+}
+
+static bool SourceFilesUnchanged(gsl::span<const std::pair<std::filesystem::path, std::filesystem::file_time_type>> sourceFiles)
+{
+    for (auto& [path, lastWriteTime] : sourceFiles)
+    {
+        std::error_code error;
+        if (std::filesystem::last_write_time(path, error) != lastWriteTime || error)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Server::LoadedModel& Server::Load(
+    const std::filesystem::path& modelPath,
+    const std::filesystem::path& inputPath,
+    const std::filesystem::path& outputPath,
+    bool& cacheHit)
+{
+    ModelKey key = { modelPath.string(), inputPath.string(), outputPath.string() };
+    auto& loadedModel = m_models[key];
+
+    // A model whose initial values were released (--lean_host_memory) can't restore its buffers, so it's reloaded.
+    cacheHit = loadedModel.executor && 
+        SourceFilesUnchanged(loadedModel.sourceFiles) && 
+        !(loadedModel.ran && loadedModel.model->InitialValuesReleased());
+
+    if (cacheHit)
+    {
+        return loadedModel;
+    }
+
+    loadedModel.executor.reset();
+    loadedModel.model.reset();
+    loadedModel.ran = false;
+
+    try
+    {
+        if (!std::filesystem::is_regular_file(modelPath))
+        {
+            throw std::invalid_argument(fmt::format("Model '{}' does not exist", modelPath.string()));
+        }
+
+        // Write times are read before parsing, so a file that changes while the model loads is reloaded next time.
+        auto modelWriteTime = std::filesystem::last_write_time(modelPath);
+
+        if (modelPath.extension() == ".json")
+        {
+            loadedModel.model = std::make_unique<Model>(JsonParsers::ParseModel(modelPath, inputPath, outputPath));
+        }
+        else if (modelPath.extension() == ".onnx")
+        {
+#ifdef ONNXRUNTIME_NONE
+            throw std::invalid_argument("ONNX dispatchables require ONNX Runtime");
+#else
+            auto name = modelPath.filename().string();
+            loadedModel.model = std::make_unique<Model>(
+                std::vector<Model::ResourceDesc>{},
+                std::vector<Model::DispatchableDesc>{ {name, Model::OnnxDispatchableDesc{modelPath}} },
+                std::vector<Model::CommandDesc>{ {"dispatch", name, Model::DispatchCommand{name, {}, {}} } },
+                BucketAllocator{});
+#endif
+        }
+        else
+        {
+            throw std::invalid_argument("Expected a .json or .onnx file");
+        }
+
+        if (m_commandLineArgs.OverlayPath())
+        {
+            JsonParsers::ApplyModelOverlay(*loadedModel.model, *m_commandLineArgs.OverlayPath());
+        }
+
+        loadedModel.sourceFiles.clear();
+        for (auto& path : GetSourceFiles(*loadedModel.model, modelPath, m_commandLineArgs))
+        {
+            loadedModel.sourceFiles.emplace_back(path, path == modelPath ? modelWriteTime : std::filesystem::last_write_time(path));
+        }
+
+        loadedModel.executor = std::make_unique<Executor>(*loadedModel.model, m_device, m_commandLineArgs, m_clientLogger.Get());
+    }
+    catch (const std::exception&)
+    {
+        m_models.erase(key);
+        throw;
+    }
+
+    return loadedModel;
+}
+
+bool Server::HandleRequest(LocalSocket& client, std::string_view requestLine)
+{
+    auto MillisecondsSince = [](std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::string type;
+    std::filesystem::path modelPath;
+    try
+    {
+        rapidjson::Document request;
+        request.Parse(requestLine.data(), requestLine.size());
+        if (request.HasParseError() || !request.IsObject())
+        {
+            throw std::invalid_argument("Requests must be a single-line JSON object");
+        }
+
+        auto GetString = [&](const char* name, std::string_view defaultValue = {}) -> std::string
+        {
+            auto member = request.FindMember(name);
+            if (member == request.MemberEnd())
+            {
+                return std::string(defaultValue);
+            }
+            if (!member->value.IsString())
+            {
+                throw std::invalid_argument(fmt::format("The request's '{}' field must be a string", name));
+            }
+            return member->value.GetString();
+        };
+
+        type = GetString("type");
+        if (type == "shutdown")
+        {
+            client.SendLine(MessageWriter("done").Add("status", "ok").Finish());
+            return false;
+        }
+
+        modelPath = std::filesystem::absolute(GetString("model"));
+        if (type == "unload")
+        {
+            // Unloads the model for every input and output path it was loaded with.
+            for (auto loadedModel = m_models.begin(); loadedModel != m_models.end();)
+            {
+                if (std::get<0>(loadedModel->first) == modelPath.string())
+                {
+                    loadedModel->second.executor.reset();
+                    loadedModel = m_models.erase(loadedModel);
+                }
+                else
+                {
+                    loadedModel++;
+                }
+            }
+            client.SendLine(MessageWriter("done").Add("status", "ok").Finish());
+            return true;
+        }
+
+        if (type != "load" && type != "run")
+        {
+            throw std::invalid_argument(fmt::format("Unknown request type '{}'", type));
+        }
+
+        auto inputPath = GetString("inputPath", modelPath.parent_path().string());
+        auto outputPath = GetString("outputPath", m_commandLineArgs.OutputPath().value_or(std::filesystem::current_path()).string());
+
+        bool cacheHit = false;
+        auto loadStart = std::chrono::steady_clock::now();
+        auto& loadedModel = Load(modelPath, inputPath, outputPath, cacheHit);
+        double loadMilliseconds = MillisecondsSince(loadStart);
+
+        double runMilliseconds = 0;
+        if (type == "run")
+        {
+            auto runStart = std::chrono::steady_clock::now();
+            try
+            {
+                // Earlier runs may have written to any buffer (e.g. an output that's also an input), so each run 
+                // starts from the initial values, as a fresh process would.
+                if (loadedModel.ran)
+                {
+                    loadedModel.executor->ResetResources();
+                }
+                loadedModel.ran = true;
+                loadedModel.executor->Run();
+            }
+            catch (const std::exception&)
+            {
+                // The executor may have stopped part way through the commands, so it isn't reused.
+                loadedModel.executor.reset();
+                m_models.erase(ModelKey{ modelPath.string(), inputPath, outputPath });
+                throw;
+            }
+            runMilliseconds = MillisecondsSince(runStart);
+
+            for (auto& desc : loadedModel.model->GetDispatchableDescs())
+            {
+                auto& result = loadedModel.executor->GetDispatchResult(loadedModel.model->GetDispatchableId(desc.name));
+                if (result.iterations == 0)
+                {
+                    continue;
+                }
+
+                MessageWriter message("result");
+                message.Add("dispatchable", desc.name);
+                message.Add("iterations", static_cast<double>(result.iterations));
+                message.Add("cpuMedianMs", result.cpuMedianInMilliseconds);
+                if (result.gpuMedianInMilliseconds)
+                {
+                    message.Add("gpuMedianMs", *result.gpuMedianInMilliseconds);
+                }
+                client.SendLine(message.Finish());
+            }
+        }
+
+        client.SendLine(MessageWriter("done")
+            .Add("status", "ok")
+            .Add("cached", cacheHit)
+            .Add("loadMs", loadMilliseconds)
+            .Add("runMs", runMilliseconds)
+            .Finish());
+    }
+    catch (const std::exception& e)
+    {
+        client.SendLine(MessageWriter("done").Add("status", "error").Add("message", e.what()).Finish());
+    }
+
+    return true;
+}
+
+std::optional<bool> HandleServerMessage(std::string_view messageLine, IDxDispatchLogger* logger)
+{
+    rapidjson::Document message;
+    message.Parse(messageLine.data(), messageLine.size());
+    if (message.HasParseError() || !message.IsObject())
+    {
+        throw std::invalid_argument("Messages must be a single-line JSON object");
+    }
+
+    auto GetMember = [&](const char* name, bool (rapidjson::Value::*isType)() const, std::string_view typeName) -> const rapidjson::Value&
+    {
+        auto member = message.FindMember(name);
+        if (member == message.MemberEnd() || !(member->value.*isType)())
+        {
+            throw std::invalid_argument(fmt::format("Expected a {} '{}' field in {}", typeName, name, messageLine));
+        }
+        return member->value;
+    };
+    auto GetString = [&](const char* name) { return std::string_view(GetMember(name, &rapidjson::Value::IsString, "string").GetString()); };
+    auto GetDouble = [&](const char* name) { return GetMember(name, &rapidjson::Value::IsNumber, "number").GetDouble(); };
+    auto GetBool = [&](const char* name) { return GetMember(name, &rapidjson::Value::IsBool, "bool").GetBool(); };
+
+    auto type = GetString("type");
+    if (type == "log")
+    {
+        auto level = GetString("level");
+        auto text = std::string(GetString("message"));
+        if (level == "error")
+        {
+            logger->LogError(text.c_str());
+        }
+        else if (level == "warning")
+        {
+            logger->LogWarning(text.c_str());
+        }
+        else
+        {
+            logger->LogInfo(text.c_str());
+        }
+    }
+    else if (type == "done")
+    {
+        if (GetString("status") != "ok")
+        {
+            logger->LogError(fmt::format("Server request failed: {}", GetString("message")).c_str());
+            return false;
+        }
+
+        if (message.HasMember("loadMs"))
+        {
+            logger->LogInfo(fmt::format("Server: model {} in {:.4f} ms, run in {:.4f} ms",
+                GetBool("cached") ? "cached" : "loaded",
+                GetDouble("loadMs"),
+                GetDouble("runMs")
+            ).c_str());
+        }
+        return true;
+    }
+
+    return std::nullopt;
+}
+
+bool RunServerClient(const CommandLineArgs& args, IDxDispatchLogger* logger)
+{
+    auto client = LocalSocket::Connect(*args.ConnectPath());
+
+    MessageWriter request(args.ServerRequest());
+    if (args.ModelPath())
+    {
+        // The server may run from a different directory, so paths are made absolute.
+        request.Add("model", std::filesystem::absolute(*args.ModelPath()).string());
+        request.Add("outputPath", std::filesystem::absolute(args.OutputPath().value_or(std::filesystem::current_path())).string());
+        if (args.InputPath())
+        {
+            request.Add("inputPath", std::filesystem::absolute(*args.InputPath()).string());
+        }
+    }
+
+    if (!client.SendLine(request.Finish()))
+    {
+        throw std::runtime_error("The server closed the connection");
+    }
+
+    std::string line;
+    while (client.ReceiveLine(line))
+    {
+        try
+        {
+            if (auto succeeded = HandleServerMessage(line, logger))
+            {
+                return *succeeded;
+            }
+        }
+        catch (const std::invalid_argument& e)
+        {
+            logger->LogError(fmt::format("Invalid message from the server: {}", e.what()).c_str());
+            return false;
+        }
+    }
+
+    throw std::runtime_error("The server closed the connection before completing the request");
+}
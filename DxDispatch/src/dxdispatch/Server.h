@@ -0,0 +1,105 @@
+#pragma once
+
+#include <tuple>
+
+class Device;
+class Model;
+class Executor;
+class CommandLineArgs;
+class ClientLogger;
+
+// A connected local (AF_UNIX) stream socket that exchanges newline-delimited messages.
+class LocalSocket
+{
+public:
+#ifdef _WIN32
+    using NativeHandle = uintptr_t;
+#else
+    using NativeHandle = int;
+#endif
+
+    // Creates a socket bound to the given path that listens for connections. A stale socket file is replaced.
+    static LocalSocket Listen(const std::filesystem::path& path);
+
+    // Connects to a socket that another process is listening on.
+    static LocalSocket Connect(const std::filesystem::path& path);
+
+    LocalSocket() = default;
+    LocalSocket(LocalSocket&& other) noexcept;
+    LocalSocket& operator=(LocalSocket&& other) noexcept;
+    LocalSocket(const LocalSocket&) = delete;
+    LocalSocket& operator=(const LocalSocket&) = delete;
+    ~LocalSocket();
+
+    // Blocks until a client connects to a listening socket.
+    LocalSocket Accept();
+
+    // Sends a message followed by a newline. Returns false if the peer has disconnected.
+    bool SendLine(std::string_view line);
+
+    // Receives the next message (without the newline). Returns false once the peer has disconnected.
+    bool ReceiveLine(std::string& line);
+
+private:
+    explicit LocalSocket(NativeHandle handle) : m_handle(handle) {}
+    void Close();
+
+private:
+    std::optional<NativeHandle> m_handle;
+    std::string m_receiveBuffer;
+};
+
+// Serves requests from a local socket with the device, models, and compiled dispatchables kept resident between
+// requests. Each request and response is one line of JSON:
+//
+//   { "type": "run", "model": "<path>", "inputPath": "<path>", "outputPath": "<path>" }
+//   { "type": "load", "model": "<path>", ... }
+//   { "type": "unload", "model": "<path>" }
+//   { "type": "shutdown" }
+//
+// While a request is handled, the server streams "log" messages and (for run requests) one "result" message per
+// dispatchable. Every request ends with a "done" message. Models are cached by their absolute, input, and output
+// paths, and reloaded when the last write time of the model or a file it reads (e.g. .npy, .hlsl, .onnx) changes.
+// Buffers are restored to their initial values before each run of a cached model.
+class Server
+{
+public:
+    Server(std::shared_ptr<Device> device, const CommandLineArgs& args, IDxDispatchLogger* logger);
+    ~Server();
+
+    // Accepts clients one at a time until a shutdown request is received.
+    void Run(const std::filesystem::path& socketPath);
+
+    // Handles a single request, streaming the response to the client. Returns false if the request asks the server
+    // to shut down.
+    bool HandleRequest(LocalSocket& client, std::string_view requestLine);
+
+private:
+    // Model, input, and output paths.
+    using ModelKey = std::tuple<std::string, std::string, std::string>;
+
+    struct LoadedModel
+    {
+        std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> sourceFiles;
+        std::unique_ptr<Model> model;
+        std::unique_ptr<Executor> executor;
+        bool ran = false; // True once the executor has run, so its buffers no longer hold their initial values.
+    };
+
+    LoadedModel& Load(const std::filesystem::path& modelPath, const std::filesystem::path& inputPath, const std::filesystem::path& outputPath, bool& cacheHit);
+
+private:
+    std::shared_ptr<Device> m_device;
+    const CommandLineArgs& m_commandLineArgs;
+    Microsoft::WRL::ComPtr<IDxDispatchLogger> m_logger;
+    Microsoft::WRL::ComPtr<ClientLogger> m_clientLogger;
+    std::map<ModelKey, LoadedModel> m_models;
+};
+
+// Logs a message streamed by the server. Returns whether the request succeeded once its "done" message is received,
+// or std::nullopt for other messages. Throws std::invalid_argument if the message is malformed.
+std::optional<bool> HandleServerMessage(std::string_view messageLine, IDxDispatchLogger* logger);
+
+// Sends a single request to a server and logs the streamed messages. Returns false if the request failed or the
+// server sent a malformed message.
+bool RunServerClient(const CommandLineArgs& args, IDxDispatchLogger* logger);
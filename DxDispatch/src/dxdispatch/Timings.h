@@ -0,0 +1,151 @@
+#pragma once
+
+// Timing samples of a dispatch loop, and the statistics reported for them.
+struct Timings
+{
+    std::vector<double> rawSamples;
+
+    struct Stats
+    {
+        size_t count;
+        double sum;
+        double average;
+        double median;
+        double min;
+        double max;
+        double p90;
+        double p99;
+        double p999;
+
+        // Bounds of the 95% confidence interval of the median.
+        double medianLow;
+        double medianHigh;
+
+        // Width of the median's confidence interval relative to the median.
+        double MedianIntervalWidth() const 
+        { 
+            return median > 0 ? (medianHigh - medianLow) / median : std::numeric_limits<double>::infinity(); 
+        }
+    };
+
+    struct SampleStats
+    {
+        Stats cold;
+        Stats hot;
+    };
+
+    Stats ComputeStats(gsl::span<const double> sampleSpan) const
+    {
+        Stats stats = {};
+
+        if (!sampleSpan.empty())
+        {
+            std::vector<double> samples(sampleSpan.size());
+            std::copy(sampleSpan.begin(), sampleSpan.end(), samples.begin());
+            std::sort(samples.begin(), samples.end());
+
+            stats.count = sampleSpan.size();
+            stats.sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+            stats.average = stats.sum / samples.size();
+            stats.median = samples[samples.size() / 2];
+            stats.min = samples[0];
+            stats.max = samples[samples.size() - 1];
+
+            // Nearest-rank percentiles.
+            auto Percentile = [&](double p) { return samples[static_cast<size_t>(std::ceil(p * samples.size())) - 1]; };
+            stats.p90 = Percentile(0.9);
+            stats.p99 = Percentile(0.99);
+            stats.p999 = Percentile(0.999);
+
+            // The confidence interval of the median is distribution-free: its bounds are the order statistics whose 
+            // ranks are +/- 1.96 standard deviations of a Binomial(n, 0.5) away from the middle rank. There are too 
+            // few samples for these ranks to exist when n < 8, in which case the full sample range is used.
+            double rankOffset = 1.96 * std::sqrt(static_cast<double>(samples.size())) / 2;
+            auto lowRank = static_cast<int64_t>(std::floor(samples.size() / 2.0 - rankOffset));
+            auto highRank = static_cast<int64_t>(std::ceil(samples.size() / 2.0 + rankOffset)) + 1;
+            if (lowRank >= 1 && highRank <= static_cast<int64_t>(samples.size()))
+            {
+                stats.medianLow = samples[lowRank - 1];
+                stats.medianHigh = samples[highRank - 1];
+            }
+            else
+            {
+                stats.medianLow = stats.min;
+                stats.medianHigh = stats.max;
+            }
+        }
+
+        return stats;
+    }
+
+    SampleStats ComputeStats(size_t maxWarmupSampleCount) const
+    {
+        SampleStats stats = {};
+        if (rawSamples.empty())
+        {
+            return stats;
+        }
+
+        // The first samples may be from "warmup" runs that skew the results because of cold caches.
+        // We call the first few samples "cold" and the later samples "hot". We always want at least 
+        // 1 hot sample. Example:
+        //
+        // Raw Samples | maxWarmup | cold | hot
+        // ------------|-----------|------|----
+        //           0 |         2 |    0 |   0
+        //           1 |         2 |    0 |   1
+        //           2 |         2 |    1 |   1
+        //           3 |         2 |    2 |   1
+        //           4 |         2 |    2 |   2
+        //           5 |         2 |    2 |   3
+
+        size_t coldSampleCount = std::min(std::max<size_t>(rawSamples.size(), 1) - 1, maxWarmupSampleCount);
+        size_t hotSampleCount = rawSamples.size() - coldSampleCount;
+        assert(coldSampleCount + hotSampleCount == rawSamples.size());
+
+        stats.cold = ComputeStats(gsl::make_span<const double>(rawSamples.data(), coldSampleCount));
+        stats.hot = ComputeStats(gsl::make_span<const double>(rawSamples.data() + coldSampleCount, hotSampleCount));
+
+        return stats;
+    }
+
+    // Estimates how many of the first samples were recorded before the timings reached a steady state. This uses
+    // MSER-5: samples are averaged in batches of 5, and the leading batches are truncated at the point that minimizes
+    // the standard error of the remaining batch means. At most half of the samples are considered warmup.
+    size_t DetectWarmupSampleCount() const
+    {
+        constexpr size_t batchSize = 5;
+        size_t batchCount = rawSamples.size() / batchSize;
+        if (batchCount < 2)
+        {
+            return 0;
+        }
+
+        // Suffix sums of the batch means (and their squares) give the variance of every truncation in one pass.
+        std::vector<double> sums(batchCount + 1);
+        std::vector<double> squares(batchCount + 1);
+        for (size_t i = batchCount; i-- > 0;)
+        {
+            auto batchBegin = rawSamples.begin() + i * batchSize;
+            double mean = std::accumulate(batchBegin, batchBegin + batchSize, 0.0) / batchSize;
+            sums[i] = sums[i + 1] + mean;
+            squares[i] = squares[i + 1] + mean * mean;
+        }
+
+        size_t bestTruncation = 0;
+        double bestStatistic = std::numeric_limits<double>::infinity();
+        for (size_t truncation = 0; truncation <= batchCount / 2; truncation++)
+        {
+            double remaining = static_cast<double>(batchCount - truncation);
+            double sumOfSquaredDeviations = squares[truncation] - sums[truncation] * sums[truncation] / remaining;
+            double statistic = sumOfSquaredDeviations / (remaining * remaining);
+            if (statistic < bestStatistic)
+            {
+                bestStatistic = statistic;
+                bestTruncation = truncation;
+            }
+        }
+
+        return bestTruncation * batchSize;
+    }
+};
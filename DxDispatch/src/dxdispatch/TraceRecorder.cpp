@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "TraceRecorder.h"
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+
+// Thread ID 0 is reserved for the GPU track; CPU threads are numbered from 1 in order of first use.
+constexpr uint32_t c_gpuThreadId = 0;
+
+TraceRecorder& TraceRecorder::Get()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::TraceRecorder() : m_startTime(std::chrono::steady_clock::now())
+{
+}
+
+void TraceRecorder::Enable(const std::filesystem::path& outputPath)
+{
+    std::scoped_lock lock(m_mutex);
+    m_outputPath = outputPath;
+    m_enabled = true;
+}
+
+double TraceRecorder::NowInMicroseconds() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+uint32_t TraceRecorder::GetThreadId()
+{
+    auto [it, inserted] = m_threadIds.try_emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_threadIds.size() + 1));
+    return it->second;
+}
+
+void TraceRecorder::BeginSpan(std::string_view name)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    m_openSpansByThread[std::this_thread::get_id()].push_back(m_events.size());
+    m_events.push_back({'X', std::string(name), GetThreadId(), NowInMicroseconds(), 0.0, 0});
+}
+
+void TraceRecorder::EndSpan()
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    auto& openSpans = m_openSpansByThread[std::this_thread::get_id()];
+    if (!openSpans.empty())
+    {
+        auto& event = m_events[openSpans.back()];
+        event.duration = NowInMicroseconds() - event.timestamp;
+        openSpans.pop_back();
+    }
+}
+
+void TraceRecorder::AddGpuSpan(std::string_view name, double startMicroseconds, double durationMicroseconds)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    m_events.push_back({'X', std::string(name), c_gpuThreadId, startMicroseconds, durationMicroseconds, 0});
+}
+
+void TraceRecorder::IncrementCounter(std::string_view name, uint64_t delta)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    auto counter = m_counters.find(name);
+    if (counter == m_counters.end())
+    {
+        counter = m_counters.emplace(std::string(name), 0).first;
+    }
+    counter->second += delta;
+    m_events.push_back({'C', counter->first, GetThreadId(), NowInMicroseconds(), 0.0, counter->second});
+}
+
+void TraceRecorder::Write()
+{
+    std::scoped_lock lock(m_mutex);
+    if (!m_enabled)
+    {
+        return;
+    }
+    m_enabled = false;
+
+    // Spans that were never closed (e.g. an exception unwound past EndSpan) are closed at the current time.
+    auto now = NowInMicroseconds();
+    for (auto& [threadId, openSpans] : m_openSpansByThread)
+    {
+        for (auto eventIndex : openSpans)
+        {
+            m_events[eventIndex].duration = now - m_events[eventIndex].timestamp;
+        }
+    }
+
+    if (m_outputPath.has_parent_path() && !std::filesystem::exists(m_outputPath.parent_path()))
+    {
+        std::filesystem::create_directories(m_outputPath.parent_path());
+    }
+
+    std::ofstream file(m_outputPath, std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::ios::failure(fmt::format("Could not open trace file '{}'", m_outputPath.string()));
+    }
+
+    rapidjson::OStreamWrapper stream(file);
+    rapidjson::Writer<rapidjson::OStreamWrapper> writer(stream);
+
+    auto WriteThreadName = [&](uint32_t threadId, const std::string& name)
+    {
+        writer.StartObject();
+        writer.Key("ph"); writer.String("M");
+        writer.Key("name"); writer.String("thread_name");
+        writer.Key("pid"); writer.Uint(1);
+        writer.Key("tid"); writer.Uint(threadId);
+        writer.Key("args"); writer.StartObject(); writer.Key("name"); writer.String(name.c_str()); writer.EndObject();
+        writer.EndObject();
+    };
+
+    writer.StartObject();
+    writer.Key("displayTimeUnit"); writer.String("ms");
+    writer.Key("traceEvents");
+    writer.StartArray();
+
+    WriteThreadName(c_gpuThreadId, "GPU");
+    for (auto& [threadId, id] : m_threadIds)
+    {
+        WriteThreadName(id, id == 1 ? "CPU" : fmt::format("CPU {}", id));
+    }
+
+    for (auto& event : m_events)
+    {
+        writer.StartObject();
+        writer.Key("ph"); writer.String(&event.phase, 1);
+        writer.Key("name"); writer.String(event.name.c_str(), static_cast<rapidjson::SizeType>(event.name.size()));
+        writer.Key("cat"); writer.String(event.threadId == c_gpuThreadId ? "gpu" : "cpu");
+        writer.Key("pid"); writer.Uint(1);
+        writer.Key("tid"); writer.Uint(event.threadId);
+        writer.Key("ts"); writer.Double(event.timestamp);
+        if (event.phase == 'X')
+        {
+            writer.Key("dur"); writer.Double(event.duration);
+        }
+        else if (event.phase == 'C')
+        {
+            writer.Key("args"); writer.StartObject(); writer.Key("value"); writer.Uint64(event.counterValue); writer.EndObject();
+        }
+        writer.EndObject();
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+
+    m_events.clear();
+    m_openSpansByThread.clear();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+
+// Records a timeline of CPU spans, GPU work, and counters that can be saved as a Chrome Trace Event
+// file (viewable in chrome://tracing or https://ui.perfetto.dev). Unlike PIX events, the trace works on
+// every platform. The recorder is process-wide so that it can be driven from the same call sites that
+// emit PIX events; all methods are no-ops until Enable() is called.
+class TraceRecorder
+{
+public:
+    static TraceRecorder& Get();
+
+    void Enable(const std::filesystem::path& outputPath);
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // CPU spans nest per thread: each EndSpan() closes the most recent BeginSpan() on the calling thread.
+    void BeginSpan(std::string_view name);
+    void EndSpan();
+
+    // Adds a span to the GPU track. Timestamps are in microseconds relative to the trace start.
+    void AddGpuSpan(std::string_view name, double startMicroseconds, double durationMicroseconds);
+
+    // Adds a value to a cumulative counter (e.g. bytes uploaded).
+    void IncrementCounter(std::string_view name, uint64_t delta);
+
+    // Microseconds elapsed since the recorder was created.
+    double NowInMicroseconds() const;
+
+    // Writes all recorded events to the output path and disables further recording.
+    void Write();
+
+private:
+    TraceRecorder();
+
+    struct Event
+    {
+        char phase;
+        std::string name;
+        uint32_t threadId;
+        double timestamp;
+        double duration;
+        uint64_t counterValue;
+    };
+
+    uint32_t GetThreadId();
+
+private:
+    std::mutex m_mutex;
+    std::atomic<bool> m_enabled = false;
+    std::filesystem::path m_outputPath;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::vector<Event> m_events;
+    std::map<std::thread::id, std::vector<size_t>> m_openSpansByThread;
+    std::map<std::thread::id, uint32_t> m_threadIds;
+    std::map<std::string, uint64_t, std::less<>> m_counters;
+};
+
+// Records a CPU span for the lifetime of the object.
+class TraceScope
+{
+public:
+    TraceScope(std::string_view name) { TraceRecorder::Get().BeginSpan(name); }
+    ~TraceScope() { TraceRecorder::Get().EndSpan(); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
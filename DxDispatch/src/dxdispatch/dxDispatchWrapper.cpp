@@ -6,7 +6,10 @@
 #include "JsonParsers.h"
 #include "Executor.h"
 #include "CommandLineArgs.h"
+#include "HlslShaderCache.h"
+#include "OnnxModelCache.h"
 #include "ModuleInfo.h"
+#include "Server.h"
 #include "dxDispatchWrapper.h"
 
 using namespace Microsoft::WRL;
@@ -95,6 +98,27 @@ HRESULT DxDispatch::RuntimeClassInitialize(
         throw;
     }
 
+    if (m_options->TracePath())
+    {
+        TraceRecorder::Get().Enable(*m_options->TracePath());
+    }
+
+    if (m_options->ClearShaderCaches() && !m_options->HlslShaderCachePath().empty())
+    {
+        HlslShaderCache(m_options->HlslShaderCachePath()).Clear();
+    }
+
+    if (m_options->ClearShaderCaches() && m_options->OnnxModelCachePath())
+    {
+        OnnxModelCache(*m_options->OnnxModelCachePath()).Clear();
+    }
+
+    // Clients send the model to a server, so they skip loading DirectX components and creating a device.
+    if (m_options->ConnectPath() && !m_options->PrintHelp())
+    {
+        return S_OK;
+    }
+
     // Needs to be constructed *before* D3D12 device. A warning is printed if DXCore.dll is loaded first,
     // even though the D3D12Device isn't created yet, so we create the capture helper first to avoid this
     // message.
@@ -130,7 +154,8 @@ HRESULT DxDispatch::RuntimeClassInitialize(
     }
     auto model = m_options->ModelPath();
     if (!model.has_value() &&
-        nullptr == jsonConfig)
+        nullptr == jsonConfig &&
+        !m_options->ServePath())
     {
         return S_FALSE;
     }
@@ -157,6 +182,7 @@ HRESULT DxDispatch::RuntimeClassInitialize(
     
     try
     {
+            TraceScope traceScope("Create device");
             m_options->SetAdapter(dxDispatchAdapter->GetAdapter());
             m_device = std::make_shared<Device>(
                 dxDispatchAdapter->GetAdapter(),
@@ -189,11 +215,18 @@ HRESULT DxDispatch::RuntimeClassInitialize(
 
     m_logger->LogInfo(fmt::format("Running on '{}'", dxDispatchAdapter->GetDescription()).c_str());
 
+    // Servers load models when requested.
+    if (m_options->ServePath())
+    {
+        return S_OK;
+    }
+
     auto inputPath = m_options->InputPath();
     auto outputPath = m_options->OutputPath();
 
     try
     {
+        TraceScope traceScope("Parse model");
         if (!inputPath.has_value())
         {
             if (model.has_value())
@@ -260,6 +293,11 @@ HRESULT DxDispatch::RuntimeClassInitialize(
             m_logger->LogError("Expected a .json or .onnx file");
             return E_NOTIMPL;
         }
+
+        if (m_options->OverlayPath())
+        {
+            JsonParsers::ApplyModelOverlay(m_modelWrapper->Value(), *m_options->OverlayPath());
+        }
     }
     catch(const std::exception& e) 
     {
@@ -271,6 +309,33 @@ HRESULT DxDispatch::RuntimeClassInitialize(
 HRESULT DxDispatch::RunAll() try
 {
     auto lock = std::scoped_lock(m_lock);
+    if (m_options && m_options->ConnectPath())
+    {
+        try
+        {
+            return RunServerClient(*m_options, m_logger.Get()) ? S_OK : E_FAIL;
+        }
+        catch (const std::exception& e)
+        {
+            m_logger->LogError(fmt::format("Failed to send the request to the server: {}", e.what()).c_str());
+            throw;
+        }
+    }
+
+    if (m_options && m_options->ServePath())
+    {
+        try
+        {
+            Server(m_device, *m_options, m_logger.Get()).Run(*m_options->ServePath());
+        }
+        catch (const std::exception& e)
+        {
+            m_logger->LogError(fmt::format("Server failed: {}", e.what()).c_str());
+            throw;
+        }
+        return S_OK;
+    }
+
     if (nullptr == m_modelWrapper) // Should only initialize once
     {
         m_logger->LogError(fmt::format("{} called before initialize", __FUNCTION__).c_str());
@@ -280,8 +345,30 @@ HRESULT DxDispatch::RunAll() try
     try
     {
         RETURN_IF_FAILED(m_pixCaptureHelper->BeginCapturableWork());
-        m_executor = std::make_unique<Executor>(m_modelWrapper->Value(), m_device, *m_options, m_logger.Get());
-        m_executor->Run();
+
+        // The executor is kept across calls: a model whose initial values were released (--lean_host_memory) can't
+        // be uploaded to a new one. Its buffers are restored instead, unless those values are gone.
+        if (m_executor == nullptr)
+        {
+            m_executor = std::make_unique<Executor>(m_modelWrapper->Value(), m_device, *m_options, m_logger.Get());
+        }
+        else if (!m_modelWrapper->Value().InitialValuesReleased())
+        {
+            m_executor->ResetResources();
+        }
+        else
+        {
+            m_logger->LogWarning("Buffers may keep values written by an earlier run, since their initial values were released (--lean_host_memory)");
+        }
+
+        if (m_options->AutotunePath())
+        {
+            m_executor->Autotune(*m_options->AutotunePath());
+        }
+        else
+        {
+            m_executor->Run();
+        }
         RETURN_IF_FAILED(m_pixCaptureHelper->EndCapturableWork());
     }
     catch(const std::exception& e)
@@ -361,6 +448,18 @@ DxDispatch::~DxDispatch()
     m_options.reset();
     m_pixCaptureHelper.reset();
     m_device.reset();
+
+    try
+    {
+        TraceRecorder::Get().Write();
+    }
+    catch (const std::exception& e)
+    {
+        if (m_logger)
+        {
+            m_logger->LogError(fmt::format("Failed to write trace: {}", e.what()).c_str());
+        }
+    }
 #ifdef WIN32
     ReleaseDllRef();
 #endif
@@ -86,7 +86,6 @@ using IAdapter = IDXCoreAdapter;
 #endif
 
 #include <DirectML.h>
-#include "DirectMLX.h"
 #include "BucketAllocator.h"
 #include "DirectMLHelpers/ApiTraits.h"
 #include "DirectMLHelpers/ApiHelpers.h"
@@ -97,5 +96,10 @@ using IAdapter = IDXCoreAdapter;
 #include "DirectMLHelpers/GeneratedSchemaHelpers.h"
 #include "DirectMLHelpers/AbstractOperatorDescImpl.h"
 
+// After the helpers, which DirectMLX uses when DMLX_USE_GRAPH_SERIALIZATION is defined.
+#include "DirectMLX.h"
+
 #include "DxDispatchInterface.h"
-#include "Logging.h"
\ No newline at end of file
+#include "Logging.h"
+#include "TraceRecorder.h"
+#include "PerfCounters.h"
\ No newline at end of file
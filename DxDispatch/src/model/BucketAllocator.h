@@ -54,6 +54,13 @@ public:
         return reinterpret_cast<T*>(memory);
     }
 
+    // Frees all buckets, invalidating every pointer returned by Allocate.
+    void Reset()
+    {
+        m_buckets.clear();
+        m_buckets.emplace_back(1);
+    }
+
 private:
     struct Bucket
     {
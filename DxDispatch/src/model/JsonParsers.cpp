@@ -2,6 +2,7 @@
 #include "JsonParsers.h"
 #include "StdSupport.h"
 #include "NpyReaderWriter.h"
+#include "NpzReader.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
 #ifndef WIN32
@@ -971,6 +972,35 @@ uint64_t GetTensorSize(const DML_TENSOR_DESC& desc)
 
 #include "JsonParsersGenerated.cpp"
 
+// Parses a 4-bit integer, which is held in an int32_t until packed.
+int32_t ParseInt4(const rapidjson::Value& value, DML_TENSOR_DATA_TYPE dataType)
+{
+    if (!value.IsInt64())
+    {
+        throw std::invalid_argument("Expected an integer.");
+    }
+
+    int64_t minValue = (dataType == DML_TENSOR_DATA_TYPE_INT4) ? -8 : 0;
+    int64_t maxValue = (dataType == DML_TENSOR_DATA_TYPE_INT4) ? 7 : 15;
+    if (value.GetInt64() < minValue || value.GetInt64() > maxValue)
+    {
+        throw std::invalid_argument(fmt::format("Value {} is outside the range [{}, {}].", value.GetInt64(), minValue, maxValue));
+    }
+    return static_cast<int32_t>(value.GetInt64());
+}
+
+// Packs 4-bit values two per byte, with even elements in the low nibble (the DML tensor layout). When the element
+// count is odd, the high nibble of the last byte is zero.
+std::vector<std::byte> PackInt4(gsl::span<const int32_t> values)
+{
+    std::vector<std::byte> packedBytes((values.size() + 1) / 2);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        packedBytes[i / 2] |= static_cast<std::byte>((values[i] & 0xF) << ((i % 2) * 4));
+    }
+    return packedBytes;
+}
+
 std::vector<std::byte> GenerateInitialValuesFromList(DML_TENSOR_DATA_TYPE dataType, const rapidjson::Value& object)
 {
     switch (dataType)
@@ -986,6 +1016,8 @@ std::vector<std::byte> GenerateInitialValuesFromList(DML_TENSOR_DATA_TYPE dataTy
     case DML_TENSOR_DATA_TYPE_INT16: return ParseArrayAsBytes<int16_t>(object, ParseInt16);
     case DML_TENSOR_DATA_TYPE_INT32: return ParseArrayAsBytes<int32_t>(object, ParseInt32);
     case DML_TENSOR_DATA_TYPE_INT64: return ParseArrayAsBytes<int64_t>(object, ParseInt64);
+    case DML_TENSOR_DATA_TYPE_UINT4:
+    case DML_TENSOR_DATA_TYPE_INT4: return PackInt4(ParseArrayAsVector<int32_t>(object, [=](auto& field){ return ParseInt4(field, dataType); }));
     default: throw std::invalid_argument(fmt::format("Invalid tensor data type."));
     }
 }
@@ -1023,6 +1055,12 @@ std::vector<std::byte> GenerateInitialValuesFromConstant(DML_TENSOR_DATA_TYPE da
     case DML_TENSOR_DATA_TYPE_INT16: return AsBytes(ParseInt16Field(object, "value"));
     case DML_TENSOR_DATA_TYPE_INT32: return AsBytes(ParseInt32Field(object, "value"));
     case DML_TENSOR_DATA_TYPE_INT64: return AsBytes(ParseInt64Field(object, "value"));
+    case DML_TENSOR_DATA_TYPE_UINT4:
+    case DML_TENSOR_DATA_TYPE_INT4:
+        {
+            auto value = ParseFieldHelper<int32_t>(object, "value", true, 0, [=](auto& field){ return ParseInt4(field, dataType); });
+            return PackInt4(std::vector<int32_t>(valueCount, value));
+        }
     default: throw std::invalid_argument(fmt::format("Invalid tensor data type."));
     }
 }
@@ -1062,6 +1100,20 @@ std::vector<std::byte> GenerateInitialValuesFromSequence(DML_TENSOR_DATA_TYPE da
     case DML_TENSOR_DATA_TYPE_INT16: return AsBytes(ParseInt16Field, static_cast<int16_t>(0));
     case DML_TENSOR_DATA_TYPE_INT32: return AsBytes(ParseInt32Field, static_cast<int32_t>(0));
     case DML_TENSOR_DATA_TYPE_INT64: return AsBytes(ParseInt64Field, static_cast<int64_t>(0));
+    case DML_TENSOR_DATA_TYPE_UINT4:
+    case DML_TENSOR_DATA_TYPE_INT4:
+        {
+            // Like the other integer types, values that step past the end of the range wrap around.
+            uint32_t value = ParseFieldHelper<int32_t>(object, "valueStart", true, 0, [=](auto& field){ return ParseInt4(field, dataType); });
+            uint32_t valueDelta = ParseInt32Field(object, "valueDelta");
+            std::vector<int32_t> values(valueCount);
+            for (auto& element : values)
+            {
+                element = static_cast<int32_t>(value & 0xF);
+                value += valueDelta;
+            }
+            return PackInt4(values);
+        }
     default: throw std::invalid_argument(fmt::format("Invalid tensor data type."));
     }
 }
@@ -1102,17 +1154,43 @@ std::vector<std::byte> ReadFileContent(const std::string& fileName)
 
 std::tuple<std::vector<std::byte>, DML_TENSOR_DATA_TYPE, std::filesystem::path> GenerateInitialValuesFromFile(
     const std::filesystem::path& parentPath,
-    const rapidjson::Value& object)
+    const rapidjson::Value& object,
+    NpzArchiveCache* archiveCache)
 {
     auto sourcePath = ParseStringField(object, "sourcePath");
-    auto filePath = ResolveInputFilePath(parentPath, sourcePath);
 
-    std::vector<std::byte> allBytes = ReadFileContent(filePath.string());
+    // An array in a NumPy archive is named after the archive path (e.g. "weights.npz#conv1_filter").
+    std::string_view archivePath = sourcePath;
+    std::string_view arrayName;
+    if (auto separator = archivePath.rfind('#'); separator != std::string_view::npos && IsNpzFilenameExtension(archivePath.substr(0, separator)))
+    {
+        arrayName = archivePath.substr(separator + 1);
+        archivePath = archivePath.substr(0, separator);
+    }
+    else if (IsNpzFilenameExtension(sourcePath))
+    {
+        throw std::invalid_argument(fmt::format("Source path '{}' must name an array in the archive (e.g. '{}#arrayName').", sourcePath, sourcePath));
+    }
+
+    auto filePath = ResolveInputFilePath(parentPath, archivePath);
+
+    std::vector<std::byte> allBytes;
+    if (!arrayName.empty())
+    {
+        // Without a cache (e.g. parsing a single resource), the archive is indexed just for this array.
+        std::optional<NpzArchive> localArchive;
+        const NpzArchive& archive = archiveCache ? archiveCache->GetArchive(filePath) : localArchive.emplace(filePath);
+        allBytes = archive.ReadArrayFile(arrayName);
+    }
+    else
+    {
+        allBytes = ReadFileContent(filePath.string());
+    }
 
     DML_TENSOR_DATA_TYPE tensorDataType = DML_TENSOR_DATA_TYPE_UNKNOWN;
 
     // Check for NumPy array files. Otherwise read it as raw file data, such as a .dat/.bin file.
-    if (IsNpyFilenameExtension(sourcePath))
+    if (IsNpyFilenameExtension(sourcePath) || !arrayName.empty())
     {
         std::vector<uint32_t> dimensions;
         std::vector<std::byte> arrayByteData;
@@ -1123,7 +1201,7 @@ std::tuple<std::vector<std::byte>, DML_TENSOR_DATA_TYPE, std::filesystem::path>
     return {std::move(allBytes), tensorDataType, filePath};
 }
 
-Model::BufferDesc ParseModelBufferDesc(const std::filesystem::path& parentPath, const rapidjson::Value& object)
+Model::BufferDesc ParseModelBufferDesc(const std::filesystem::path& parentPath, const rapidjson::Value& object, NpzArchiveCache* archiveCache)
 {
     if (!object.IsObject())
     {
@@ -1194,7 +1272,7 @@ Model::BufferDesc ParseModelBufferDesc(const std::filesystem::path& parentPath,
         // e.g. "initialValues": { "sourcePath": "inputFile.npy" }
         else if (initialValuesField->value.HasMember("sourcePath"))
         {
-            auto [initialValues, fileBufferDataType, fileName] = GenerateInitialValuesFromFile(parentPath, initialValuesField->value);
+            auto [initialValues, fileBufferDataType, fileName] = GenerateInitialValuesFromFile(parentPath, initialValuesField->value, archiveCache);
 
             // Depending on the file type (.npy vs .dat), the file may have an explict data type.
             // Use the data type if present, else require initialValuesDataType if not.
@@ -1210,6 +1288,7 @@ Model::BufferDesc ParseModelBufferDesc(const std::filesystem::path& parentPath,
 
             ensureInitialValuesDataType(); // Raw data requires 'initialValuesDataType'. Typed data (e.g. .npy) already had a type.
             buffer.initialValues = std::move(initialValues);
+            buffer.sourcePath = std::move(fileName);
         }
         else
         {
@@ -1250,11 +1329,12 @@ Model::BufferDesc ParseModelBufferDesc(const std::filesystem::path& parentPath,
 Model::ResourceDesc ParseModelResourceDesc(
     std::string_view name,
     const std::filesystem::path& parentPath,
-    const rapidjson::Value& object)
+    const rapidjson::Value& object,
+    NpzArchiveCache* archiveCache)
 {
     Model::ResourceDesc desc;
     desc.name = name;
-    desc.value = ParseModelBufferDesc(parentPath, object);
+    desc.value = ParseModelBufferDesc(parentPath, object, archiveCache);
     return desc;
 }
 
@@ -1286,6 +1366,38 @@ Model::HlslDispatchableDesc ParseModelHlslDispatchableDesc(const std::filesystem
         desc.compilerArgs.push_back(compilerArg.GetString());
     }
 
+    auto bindingModeStr = ParseStringField(object, "bindingMode", false, "descriptorTable");
+    if (!_stricmp(bindingModeStr.data(), "descriptorTable"))
+    {
+        desc.bindingMode = Model::HlslDispatchableDesc::BindingMode::DescriptorTable;
+    }
+    else if (!_stricmp(bindingModeStr.data(), "rootDescriptors"))
+    {
+        desc.bindingMode = Model::HlslDispatchableDesc::BindingMode::RootDescriptors;
+    }
+    else
+    {
+        throw std::invalid_argument(fmt::format("Unrecognized binding mode '{}'", bindingModeStr));
+    }
+
+    desc.rootConstants = ParseFieldHelper<std::unordered_map<std::string, std::vector<std::byte>>>(
+        object, "rootConstants", false, {}, [](auto& value)
+    {
+        std::unordered_map<std::string, std::vector<std::byte>> rootConstants;
+
+        if (!value.IsObject())
+        {
+            throw std::invalid_argument("Expected a non-null JSON object.");
+        }
+
+        for (auto member = value.MemberBegin(); member != value.MemberEnd(); member++)
+        {
+            rootConstants[member->name.GetString()] = ParseMixedPrimitiveArray(member->value);
+        }
+
+        return rootConstants;
+    });
+
     return desc;
 }
 
@@ -1611,6 +1723,332 @@ Model::CommandDesc ParseModelCommandDesc(const rapidjson::Value& object, const s
     return commandDesc;
 }
 
+// ----------------------------------------------------------------------------
+// SWEEPS
+// ----------------------------------------------------------------------------
+
+// Parses the values of a sweep parameter: either an array of values, or an integer range given by
+// 'start', 'stop' (inclusive), and either 'step' (arithmetic) or 'multiplier' (geometric).
+rapidjson::Value ParseSweepParameterValues(const rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator)
+{
+    if (value.IsArray())
+    {
+        if (value.Empty())
+        {
+            throw std::invalid_argument("Expected at least one value.");
+        }
+        return rapidjson::Value(value, allocator);
+    }
+
+    if (!value.IsObject())
+    {
+        throw std::invalid_argument("Expected an array of values or a range object.");
+    }
+
+    auto start = ParseUInt64Field(value, "start");
+    auto stop = ParseUInt64Field(value, "stop");
+    auto step = ParseUInt64Field(value, "step", false, 0);
+    auto multiplier = ParseUInt64Field(value, "multiplier", false, 0);
+    if ((step == 0) == (multiplier == 0))
+    {
+        throw std::invalid_argument("A range must have either a nonzero 'step' or a 'multiplier' larger than 1.");
+    }
+    if (multiplier == 1 || (start == 0 && multiplier != 0))
+    {
+        throw std::invalid_argument("A geometric range must have a nonzero 'start' and a 'multiplier' larger than 1.");
+    }
+    if (start > stop)
+    {
+        throw std::invalid_argument("A range must have 'start' <= 'stop'.");
+    }
+
+    rapidjson::Value values(rapidjson::kArrayType);
+    for (uint64_t i = start; i <= stop; )
+    {
+        values.PushBack(rapidjson::Value(i), allocator);
+
+        uint64_t next = step ? i + step : i * multiplier;
+        if (next <= i)
+        {
+            break; // Overflow
+        }
+        i = next;
+    }
+    return values;
+}
+
+std::string SweepParameterValueToString(const rapidjson::Value& value)
+{
+    return value.IsString() ? std::string(value.GetString(), value.GetStringLength()) : RapidJsonToString(value);
+}
+
+// Copies a sweep's dispatchable template, replacing each string that is exactly "$name" with the value of that 
+// parameter, and each "${name}" within other strings with the parameter's value as text.
+rapidjson::Value SubstituteSweepParameters(
+    const rapidjson::Value& value,
+    gsl::span<const std::string> parameterNames,
+    gsl::span<const rapidjson::Value*> parameterValues,
+    rapidjson::Document::AllocatorType& allocator)
+{
+    auto FindParameter = [&](std::string_view name) -> const rapidjson::Value&
+    {
+        for (size_t i = 0; i < parameterNames.size(); i++)
+        {
+            if (parameterNames[i] == name)
+            {
+                return *parameterValues[i];
+            }
+        }
+        throw std::invalid_argument(fmt::format("'{}' is not a parameter of the sweep.", name));
+    };
+
+    if (value.IsString())
+    {
+        std::string_view text(value.GetString(), value.GetStringLength());
+        if (text.size() > 1 && text[0] == '$' && text[1] != '{')
+        {
+            return rapidjson::Value(FindParameter(text.substr(1)), allocator);
+        }
+
+        if (text.find("${") == std::string_view::npos)
+        {
+            return rapidjson::Value(value, allocator);
+        }
+
+        std::string substituted;
+        size_t position = 0;
+        for (size_t start; (start = text.find("${", position)) != std::string_view::npos; )
+        {
+            size_t end = text.find('}', start);
+            if (end == std::string_view::npos)
+            {
+                throw std::invalid_argument(fmt::format("Unterminated parameter reference in '{}'.", text));
+            }
+            substituted += text.substr(position, start - position);
+            substituted += SweepParameterValueToString(FindParameter(text.substr(start + 2, end - start - 2)));
+            position = end + 1;
+        }
+        substituted += text.substr(position);
+
+        return rapidjson::Value(substituted.c_str(), static_cast<rapidjson::SizeType>(substituted.size()), allocator);
+    }
+
+    if (value.IsArray())
+    {
+        rapidjson::Value array(rapidjson::kArrayType);
+        array.Reserve(value.Size(), allocator);
+        for (auto& element : value.GetArray())
+        {
+            array.PushBack(SubstituteSweepParameters(element, parameterNames, parameterValues, allocator), allocator);
+        }
+        return array;
+    }
+
+    if (value.IsObject())
+    {
+        rapidjson::Value object(rapidjson::kObjectType);
+        for (auto& member : value.GetObject())
+        {
+            object.AddMember(
+                rapidjson::Value(member.name, allocator), 
+                SubstituteSweepParameters(member.value, parameterNames, parameterValues, allocator), 
+                allocator);
+        }
+        return object;
+    }
+
+    return rapidjson::Value(value, allocator);
+}
+
+Model::SweepDesc ParseModelSweep(
+    std::string_view name,
+    const std::filesystem::path& parentPath,
+    const rapidjson::Value& object,
+    BucketAllocator& allocator,
+    std::vector<Model::ResourceDesc>& resources,
+    std::vector<Model::DispatchableDesc>& dispatchables,
+    std::vector<Model::CommandDesc>& commands)
+{
+    if (!object.IsObject())
+    {
+        throw std::invalid_argument("Expected a non-null JSON object.");
+    }
+
+    auto parametersField = object.FindMember("parameters");
+    if (parametersField == object.MemberEnd() || !parametersField->value.IsObject())
+    {
+        throw std::invalid_argument("Expected an object field named 'parameters'.");
+    }
+
+    auto templateField = object.FindMember("dispatchable");
+    if (templateField == object.MemberEnd() || !templateField->value.IsObject())
+    {
+        throw std::invalid_argument("Expected an object field named 'dispatchable'.");
+    }
+
+    // Holds the parameter values and the dispatchables produced from the template.
+    rapidjson::Document scratch;
+    auto& scratchAllocator = scratch.GetAllocator();
+
+    Model::SweepDesc sweep;
+    sweep.name = name;
+
+    if (parametersField->value.ObjectEmpty())
+    {
+        throw std::invalid_argument("Expected at least one parameter.");
+    }
+
+    std::vector<rapidjson::Value> parameterValueLists;
+    uint64_t pointCount = 1;
+    for (auto& parameter : parametersField->value.GetObject())
+    {
+        try
+        {
+            sweep.parameterNames.emplace_back(parameter.name.GetString(), parameter.name.GetStringLength());
+            parameterValueLists.push_back(ParseSweepParameterValues(parameter.value, scratchAllocator));
+            pointCount *= parameterValueLists.back().Size();
+        }
+        catch (std::exception& e)
+        {
+            throw std::invalid_argument(fmt::format("Failed to parse parameter '{}': {}", parameter.name.GetString(), e.what()));
+        }
+
+        if (pointCount > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::invalid_argument("The sweep has too many points.");
+        }
+    }
+
+    // Every point binds the same buffer to a given bind point, sized for the largest tensor across the sweep. The 
+    // points run one after another, so they don't need buffers of their own.
+    std::vector<std::pair<std::string, uint64_t>> sharedBuffers;
+    auto BindSharedBuffer = [&](std::string resourceName, uint64_t sizeInBytes)
+    {
+        auto buffer = std::find_if(sharedBuffers.begin(), sharedBuffers.end(), [&](auto& b) { return b.first == resourceName; });
+        if (buffer == sharedBuffers.end())
+        {
+            sharedBuffers.emplace_back(resourceName, sizeInBytes);
+        }
+        else
+        {
+            buffer->second = std::max(buffer->second, sizeInBytes);
+        }
+
+        Model::BufferBindingSource source = {};
+        source.name = std::move(resourceName);
+        return source;
+    };
+
+    // The first parameter varies slowest, so points are ordered like nested loops in declaration order.
+    std::vector<size_t> valueIndices(parameterValueLists.size());
+    std::vector<const rapidjson::Value*> pointValues(parameterValueLists.size());
+    for (uint64_t pointIndex = 0; pointIndex < pointCount; pointIndex++)
+    {
+        Model::SweepDesc::Point point;
+        std::string pointLabel;
+        for (size_t i = 0; i < parameterValueLists.size(); i++)
+        {
+            pointValues[i] = &parameterValueLists[i][static_cast<rapidjson::SizeType>(valueIndices[i])];
+            point.parameterValues.push_back(SweepParameterValueToString(*pointValues[i]));
+            pointLabel += fmt::format("{}{}={}", i ? "," : "", sweep.parameterNames[i], point.parameterValues.back());
+        }
+        point.dispatchableName = fmt::format("{}({})", name, pointLabel);
+
+        try
+        {
+            auto dispatchableValue = SubstituteSweepParameters(templateField->value, sweep.parameterNames, pointValues, scratchAllocator);
+            auto dispatchable = ParseModelDispatchableDesc(point.dispatchableName, parentPath, dispatchableValue, allocator);
+            if (!std::holds_alternative<Model::DmlDispatchableDesc>(dispatchable.value))
+            {
+                throw std::invalid_argument("Sweeps only support DirectML operator dispatchables.");
+            }
+            auto& dmlDispatchable = std::get<Model::DmlDispatchableDesc>(dispatchable.value);
+
+            auto descMember = dispatchableValue.FindMember("Desc");
+            if (descMember == dispatchableValue.MemberEnd())
+            {
+                descMember = dispatchableValue.FindMember("desc");
+            }
+            const rapidjson::Value& descValue = descMember != dispatchableValue.MemberEnd() ? descMember->value : dispatchableValue;
+
+            // The bind points come from the operator's schema; the tensor descs they bind are sized from the JSON. 
+            // Tensors owned by DML are bound when the operator is initialized instead of each dispatch.
+            Model::DispatchCommand command = {};
+            command.dispatchableName = point.dispatchableName;
+            command.threadGroupCount = {1, 1, 1};
+            auto BindTensors = [&](const std::vector<Model::DmlDispatchableDesc::BindPoint>& bindPoints)
+            {
+                BucketAllocator tensorAllocator;
+                for (auto& bindPoint : bindPoints)
+                {
+                    if (!bindPoint.requiredBinding)
+                    {
+                        continue;
+                    }
+
+                    gsl::span<DML_TENSOR_DESC> tensors = bindPoint.resourceCount == 1 ?
+                        gsl::make_span(ParseDmlTensorDescField(descValue, bindPoint.name, tensorAllocator), 1) :
+                        ParseDmlTensorDescArrayField(descValue, bindPoint.name, tensorAllocator);
+
+                    for (size_t i = 0; i < tensors.size(); i++)
+                    {
+                        auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensors[i].Desc);
+                        auto resourceName = tensors.size() == 1 ? 
+                            fmt::format("{}.{}", name, bindPoint.name) : 
+                            fmt::format("{}.{}[{}]", name, bindPoint.name, i);
+
+                        auto& bindings = (bufferDesc.Flags & DML_TENSOR_FLAG_OWNED_BY_DML) ? dmlDispatchable.initBindings : command.bindings;
+                        bindings[bindPoint.name].push_back(BindSharedBuffer(std::move(resourceName), bufferDesc.TotalTensorSizeInBytes));
+                    }
+                }
+            };
+            BindTensors(dmlDispatchable.bindPoints.inputs);
+            BindTensors(dmlDispatchable.bindPoints.outputs);
+
+            auto IsDispatchableName = [&](auto& d) { return d.name == point.dispatchableName; };
+            if (std::any_of(dispatchables.begin(), dispatchables.end(), IsDispatchableName))
+            {
+                throw std::invalid_argument(fmt::format("The model already has a dispatchable named '{}'.", point.dispatchableName));
+            }
+
+            dispatchables.push_back(std::move(dispatchable));
+            commands.push_back({"dispatch", point.dispatchableName, std::move(command)});
+        }
+        catch (std::exception& e)
+        {
+            throw std::invalid_argument(fmt::format("Failed to expand point '{}': {}", point.dispatchableName, e.what()));
+        }
+
+        sweep.points.push_back(std::move(point));
+
+        for (size_t i = valueIndices.size(); i-- > 0; )
+        {
+            if (++valueIndices[i] < parameterValueLists[i].Size())
+            {
+                break;
+            }
+            valueIndices[i] = 0;
+        }
+    }
+
+    // The buffers aren't initialized with data, so D3D12 zero-fills them.
+    for (auto& [resourceName, sizeInBytes] : sharedBuffers)
+    {
+        auto IsResourceName = [&](auto& r) { return r.name == resourceName; };
+        if (std::any_of(resources.begin(), resources.end(), IsResourceName))
+        {
+            throw std::invalid_argument(fmt::format("The model already has a resource named '{}'.", resourceName));
+        }
+
+        Model::BufferDesc bufferDesc = {};
+        bufferDesc.sizeInBytes = (sizeInBytes + 3) & ~3ull; // DML requires 4-byte alignment
+        bufferDesc.initialValuesDataType = DML_TENSOR_DATA_TYPE_UNKNOWN;
+        resources.push_back({resourceName, bufferDesc});
+    }
+
+    return sweep;
+}
+
 // Determine the line and column in text by counting the line breaking characters
 // up to the given offset. Note the line and column counts are zero-based, and so the
 // caller may want to add 1 when displaying it, as most text editors show one-based
@@ -1709,17 +2147,32 @@ Model ParseModel(
 
     BucketAllocator allocator;
 
+    // Sweeps produce their own resources, dispatchables, and commands, so a model with sweeps may omit those.
+    auto sweepsField = doc.FindMember("sweeps");
+    const bool hasSweeps = sweepsField != doc.MemberEnd();
+    if (hasSweeps && !sweepsField->value.IsObject())
+    {
+        throw std::invalid_argument("Expected 'sweeps' to be an object");
+    }
+
+    rapidjson::Value emptyObject(rapidjson::kObjectType);
+    rapidjson::Value emptyArray(rapidjson::kArrayType);
+
+    // Resources initialized from the same NumPy archive share its index, which is dropped once parsing is done.
+    NpzArchiveCache archiveCache;
+
     std::vector<Model::ResourceDesc> resources;
     auto resourcesField = doc.FindMember("resources");
-    if (resourcesField == doc.MemberEnd() || !resourcesField->value.IsObject())
+    const rapidjson::Value* resourcesValue = resourcesField != doc.MemberEnd() ? &resourcesField->value : hasSweeps ? &emptyObject : nullptr;
+    if (!resourcesValue || !resourcesValue->IsObject())
     {
         throw std::invalid_argument("Expected an object named 'resources'");
     }
-    for (auto field = resourcesField->value.MemberBegin(); field != resourcesField->value.MemberEnd(); field++)
+    for (auto field = resourcesValue->MemberBegin(); field != resourcesValue->MemberEnd(); field++)
     {
         try
         {
-            resources.emplace_back(std::move(ParseModelResourceDesc(field->name.GetString(), inputPath, field->value)));
+            resources.emplace_back(std::move(ParseModelResourceDesc(field->name.GetString(), inputPath, field->value, &archiveCache)));
         }
         catch (std::exception& e)
         {
@@ -1729,11 +2182,12 @@ Model ParseModel(
 
     std::vector<Model::DispatchableDesc> operators;
     auto dispatchablesField = doc.FindMember("dispatchables");
-    if (dispatchablesField == doc.MemberEnd() || !dispatchablesField->value.IsObject())
+    const rapidjson::Value* dispatchablesValue = dispatchablesField != doc.MemberEnd() ? &dispatchablesField->value : hasSweeps ? &emptyObject : nullptr;
+    if (!dispatchablesValue || !dispatchablesValue->IsObject())
     {
         throw std::invalid_argument("Expected an object named 'dispatchables'");
     }
-    for (auto field = dispatchablesField->value.MemberBegin(); field != dispatchablesField->value.MemberEnd(); field++)
+    for (auto field = dispatchablesValue->MemberBegin(); field != dispatchablesValue->MemberEnd(); field++)
     {
         try
         {
@@ -1747,11 +2201,12 @@ Model ParseModel(
 
     std::vector<Model::CommandDesc> commands;
     auto commandsField = doc.FindMember("commands");
-    if (commandsField == doc.MemberEnd() || !commandsField->value.IsArray())
+    const rapidjson::Value* commandsValue = commandsField != doc.MemberEnd() ? &commandsField->value : hasSweeps ? &emptyArray : nullptr;
+    if (!commandsValue || !commandsValue->IsArray())
     {
         throw std::invalid_argument("Expected an array field named 'commands'");
     }
-    auto commandsArray = commandsField->value.GetArray();
+    auto commandsArray = commandsValue->GetArray();
     for (uint32_t i = 0; i < commandsArray.Size(); i++)
     {
         try
@@ -1764,7 +2219,24 @@ Model ParseModel(
         }
     }
 
-    return {std::move(resources), std::move(operators), std::move(commands), std::move(allocator)};
+    // Sweep points are dispatched after the model's own commands.
+    std::vector<Model::SweepDesc> sweeps;
+    if (hasSweeps)
+    {
+        for (auto field = sweepsField->value.MemberBegin(); field != sweepsField->value.MemberEnd(); field++)
+        {
+            try
+            {
+                sweeps.push_back(ParseModelSweep(field->name.GetString(), inputPath, field->value, allocator, resources, operators, commands));
+            }
+            catch (std::exception& e)
+            {
+                throw std::invalid_argument(fmt::format("Failed to parse sweep {}: {}", field->name.GetString(), e.what()));
+            }
+        }
+    }
+
+    return {std::move(resources), std::move(operators), std::move(commands), std::move(allocator), std::move(sweeps)};
 }
 
 Model ParseModel(
@@ -1805,4 +2277,72 @@ Model ParseModel(
     return ParseModel(doc, fileContent, inputPath, outputPath);
 }
 
+void ApplyModelOverlay(Model& model, const rapidjson::Value& overlay)
+{
+    if (!overlay.IsObject())
+    {
+        throw std::invalid_argument("Expected the overlay to be an object");
+    }
+
+    auto dispatchablesField = overlay.FindMember("dispatchables");
+    if (dispatchablesField == overlay.MemberEnd())
+    {
+        return;
+    }
+    if (!dispatchablesField->value.IsObject())
+    {
+        throw std::invalid_argument("Expected 'dispatchables' to be an object");
+    }
+
+    for (auto field = dispatchablesField->value.MemberBegin(); field != dispatchablesField->value.MemberEnd(); field++)
+    {
+        std::string_view name(field->name.GetString(), field->name.GetStringLength());
+        auto dispatchableId = model.GetDispatchableId(name);
+        if (dispatchableId == Model::InvalidId)
+        {
+            throw std::invalid_argument(fmt::format("The overlay references dispatchable '{}', which is not in the model", name));
+        }
+
+        auto dmlDesc = std::get_if<Model::DmlDispatchableDesc>(&model.GetDispatchable(dispatchableId).value);
+        if (!dmlDesc)
+        {
+            throw std::invalid_argument(fmt::format("The overlay for dispatchable '{}' only applies to DirectML operators", name));
+        }
+
+        try
+        {
+            dmlDesc->executionFlags = ParseDmlExecutionFlagsField(field->value, "executionFlags", false, dmlDesc->executionFlags);
+            dmlDesc->compileType = ParseDmlCompileTypeField(field->value, "dmlCompileType", false, dmlDesc->compileType);
+        }
+        catch (std::exception& e)
+        {
+            throw std::invalid_argument(fmt::format("Failed to parse the overlay for dispatchable '{}': {}", name, e.what()));
+        }
+    }
+}
+
+void ApplyModelOverlay(Model& model, const std::filesystem::path& overlayPath)
+{
+    std::vector<std::byte> allBytes = ReadFileContent(overlayPath.string());
+    allBytes.push_back(std::byte(0)); // Ensure null terminated for parser.
+    char* fileContentBegin = reinterpret_cast<char*>(allBytes.data());
+    std::string_view fileContent{fileContentBegin, allBytes.size()};
+
+    rapidjson::Document doc;
+
+    constexpr rapidjson::ParseFlag parseFlags = rapidjson::ParseFlag(
+        rapidjson::kParseFullPrecisionFlag | 
+        rapidjson::kParseCommentsFlag |
+        rapidjson::kParseTrailingCommasFlag |
+        rapidjson::kParseStopWhenDoneFlag);
+
+    doc.ParseInsitu<parseFlags>(fileContentBegin);
+    if (doc.HasParseError())
+    {
+        throw std::invalid_argument(GetJsonParseErrorMessage(doc, fileContent));
+    }
+
+    ApplyModelOverlay(model, doc);
+}
+
 } // namespace JsonParsers
\ No newline at end of file
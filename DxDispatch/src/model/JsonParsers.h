@@ -5,6 +5,8 @@
 #include <half.hpp>
 #include "Model.h"
 
+class NpzArchiveCache;
+
 namespace JsonParsers
 {
     // ------------------------------------------------------------------------
@@ -131,11 +133,22 @@ namespace JsonParsers
     // MODEL STRUCTS
     // ------------------------------------------------------------------------
 
-    Model::ResourceDesc ParseModelResourceDesc(std::string_view name, const std::filesystem::path& parentPath, const rapidjson::Value& object);
+    Model::ResourceDesc ParseModelResourceDesc(std::string_view name, const std::filesystem::path& parentPath, const rapidjson::Value& object, NpzArchiveCache* archiveCache = nullptr);
     Model::DispatchableDesc ParseModelDispatchableDesc(std::string_view name, const std::filesystem::path& parentPath, const rapidjson::Value& object, BucketAllocator& allocator);
     Model::Command ParseModelCommand(const rapidjson::Value& object, const std::filesystem::path& outputPath);
     Model::CommandDesc ParseModelCommandDesc(const rapidjson::Value& object, const std::filesystem::path& outputPath);
 
+    // Expands a sweep into a DML dispatchable and dispatch command per point, appending them and the buffers they 
+    // bind to the given lists.
+    Model::SweepDesc ParseModelSweep(
+        std::string_view name,
+        const std::filesystem::path& parentPath,
+        const rapidjson::Value& object,
+        BucketAllocator& allocator,
+        std::vector<Model::ResourceDesc>& resources,
+        std::vector<Model::DispatchableDesc>& dispatchables,
+        std::vector<Model::CommandDesc>& commands);
+
     Model ParseModel(
         const rapidjson::Document& doc,
         const std::string_view &jsonDocumentText,
@@ -146,4 +159,9 @@ namespace JsonParsers
         const std::filesystem::path& filePath, 
         std::filesystem::path inputPath,
         std::filesystem::path outputPath);
+
+    // Overrides the execution options of DML dispatchables with those in an overlay (e.g. written by --autotune):
+    // { "dispatchables": { "<name>": { "executionFlags": ..., "dmlCompileType": ... } } }
+    void ApplyModelOverlay(Model& model, const rapidjson::Value& overlay);
+    void ApplyModelOverlay(Model& model, const std::filesystem::path& overlayPath);
 }
\ No newline at end of file
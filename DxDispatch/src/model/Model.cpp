@@ -4,13 +4,13 @@
 static void VerifyBindings(
     const std::string& dispatchableType,
     const std::unordered_map<std::string, std::vector<Model::BufferBindingSource>>& initBindings,
-    std::unordered_map<std::string, Model::ResourceDesc*>& resourceDescsByName)
+    const std::unordered_map<std::string_view, Model::ResourceId>& resourceIdsByName)
 {
     for (const auto& [bindingName, sourceResources] : initBindings)
     {
         for (const auto& sourceResource : sourceResources)
         {
-            if (resourceDescsByName.find(sourceResource.name) == resourceDescsByName.end())
+            if (resourceIdsByName.find(sourceResource.name) == resourceIdsByName.end())
             {
                 throw std::invalid_argument(fmt::format(
                     "{} dispatchable attempts to bind resource '{}' for initialization, which does not exist in the model", 
@@ -24,28 +24,35 @@ Model::Model(
     std::vector<ResourceDesc>&& resourceDescs,
     std::vector<DispatchableDesc>&& dispatchableDescs,
     std::vector<CommandDesc>&& commands,
-    BucketAllocator&& allocator) : 
+    BucketAllocator&& allocator,
+    std::vector<SweepDesc>&& sweeps) : 
         m_resourceDescs(std::move(resourceDescs)),
         m_dispatchableDescs(std::move(dispatchableDescs)),
         m_commands(std::move(commands)),
+        m_sweeps(std::move(sweeps)),
         m_allocator(std::move(allocator))
 {
-    for (auto& resourceDesc : m_resourceDescs) 
+    m_resourceIdsByName.reserve(m_resourceDescs.size());
+    for (size_t i = 0; i < m_resourceDescs.size(); i++)
     {
-        m_resourceDescsByName[resourceDesc.name] = &resourceDesc;
+        m_resourceIdsByName[m_resourceDescs[i].name] = static_cast<ResourceId>(i);
     }
 
-    for (auto& dispatchableDesc : m_dispatchableDescs) 
-    { 
-        m_dispatchableDescsByName[dispatchableDesc.name] = &dispatchableDesc;
+    m_dispatchableIdsByName.reserve(m_dispatchableDescs.size());
+    for (size_t i = 0; i < m_dispatchableDescs.size(); i++)
+    {
+        auto& dispatchableDesc = m_dispatchableDescs[i];
+        m_dispatchableIdsByName[dispatchableDesc.name] = static_cast<DispatchableId>(i);
         
         if (std::holds_alternative<DmlDispatchableDesc>(dispatchableDesc.value))
         {
-            VerifyBindings("DML", std::get<DmlDispatchableDesc>(dispatchableDesc.value).initBindings, m_resourceDescsByName);
+            auto& dmlDispatchableDesc = std::get<DmlDispatchableDesc>(dispatchableDesc.value);
+            VerifyBindings("DML", dmlDispatchableDesc.initBindings, m_resourceIdsByName);
+            dmlDispatchableDesc.initBindingPlanId = CompileBindingPlan(dmlDispatchableDesc.initBindings);
         }
         else if (std::holds_alternative<DmlSerializedGraphDispatchableDesc>(dispatchableDesc.value))
         {
-            VerifyBindings("DmlSerializedGraph", std::get<DmlSerializedGraphDispatchableDesc>(dispatchableDesc.value).initBindings, m_resourceDescsByName);
+            VerifyBindings("DmlSerializedGraph", std::get<DmlSerializedGraphDispatchableDesc>(dispatchableDesc.value).initBindings, m_resourceIdsByName);
         }
 
     }
@@ -58,8 +65,8 @@ Model::Model(
             overload{
                 [&](DispatchCommand& command)
                 {
-                    auto dispatchable = m_dispatchableDescsByName.find(command.dispatchableName);
-                    if (dispatchable == m_dispatchableDescsByName.end())
+                    command.dispatchableId = GetDispatchableId(command.dispatchableName);
+                    if (command.dispatchableId == InvalidId)
                     {
                         throw std::invalid_argument(fmt::format(
                             "Command attempts to dispatch '{}', which does not exist in the model", 
@@ -70,14 +77,14 @@ Model::Model(
                     {
                         for (auto& sourceResource : binding.second)
                         {
-                            if (m_resourceDescsByName.find(sourceResource.name) == m_resourceDescsByName.end())
+                            if (GetResourceId(sourceResource.name) == InvalidId)
                             {
                                 throw std::invalid_argument(fmt::format(
                                     "Command attempts to bind resource '{}', which does not exist in the model", 
                                     sourceResource.name));
                             }
 
-                            if (sourceResource.counterName && m_resourceDescsByName.find(*sourceResource.counterName) == m_resourceDescsByName.end())
+                            if (sourceResource.counterName && GetResourceId(*sourceResource.counterName) == InvalidId)
                             {
                                 throw std::invalid_argument(fmt::format(
                                     "Command attempts to bind resource '{}' as a counter, which does not exist in the model", 
@@ -85,10 +92,13 @@ Model::Model(
                             }
                         }
                     }
+
+                    command.bindingPlanId = CompileBindingPlan(command.bindings);
                 },
                 [&](PrintCommand& printCommand)
                 {
-                    if (m_resourceDescsByName.find(printCommand.resourceName) == m_resourceDescsByName.end())
+                    printCommand.resourceId = GetResourceId(printCommand.resourceName);
+                    if (printCommand.resourceId == InvalidId)
                     {
                         throw std::invalid_argument(fmt::format(
                             "Command attempts to print resource '{}', which does not exist in the model", 
@@ -97,7 +107,8 @@ Model::Model(
                 },
                 [&](WriteFileCommand& writeFileCommand)
                 {
-                    if (m_resourceDescsByName.find(writeFileCommand.resourceName) == m_resourceDescsByName.end())
+                    writeFileCommand.resourceId = GetResourceId(writeFileCommand.resourceName);
+                    if (writeFileCommand.resourceId == InvalidId)
                     {
                         throw std::invalid_argument(fmt::format(
                             "Command attempts to write to a file the resource '{}', which does not exist in the model", 
@@ -107,4 +118,99 @@ Model::Model(
             },
             command);
     }
-}
\ No newline at end of file
+
+    for (auto& sweep : m_sweeps)
+    {
+        for (auto& point : sweep.points)
+        {
+            point.dispatchableId = GetDispatchableId(point.dispatchableName);
+            if (point.dispatchableId == InvalidId)
+            {
+                throw std::invalid_argument(fmt::format(
+                    "Sweep '{}' refers to dispatchable '{}', which does not exist in the model", 
+                    sweep.name, point.dispatchableName));
+            }
+        }
+    }
+}
+
+Model::ResourceId Model::GetResourceId(std::string_view name) const
+{
+    auto it = m_resourceIdsByName.find(name);
+    return it == m_resourceIdsByName.end() ? InvalidId : it->second;
+}
+
+Model::DispatchableId Model::GetDispatchableId(std::string_view name) const
+{
+    auto it = m_dispatchableIdsByName.find(name);
+    return it == m_dispatchableIdsByName.end() ? InvalidId : it->second;
+}
+
+void Model::ReleaseInitialValues()
+{
+    for (auto& resourceDesc : m_resourceDescs)
+    {
+        if (auto bufferDesc = std::get_if<BufferDesc>(&resourceDesc.value))
+        {
+            bufferDesc->releasedInitialValuesSizeInBytes = bufferDesc->InitialValuesSizeInBytes();
+            std::vector<std::byte>().swap(bufferDesc->initialValues);
+        }
+    }
+    m_initialValuesReleased = true;
+}
+
+void Model::ReleaseOperatorDescs()
+{
+    for (auto& dispatchableDesc : m_dispatchableDescs)
+    {
+        if (auto dmlDispatchableDesc = std::get_if<DmlDispatchableDesc>(&dispatchableDesc.value))
+        {
+            dmlDispatchableDesc->desc = nullptr;
+        }
+    }
+    m_allocator.Reset();
+}
+
+// Flattens a set of bindings into a plan that refers to resources by ID. All resource names 
+// must have been validated before calling this.
+Model::BindingPlanId Model::CompileBindingPlan(const Bindings& bindings)
+{
+    BindingPlan plan;
+    plan.targets.reserve(bindings.size());
+
+    for (auto& [targetName, sourceResources] : bindings)
+    {
+        BindingPlan::Target target = {};
+        target.name = targetName;
+        target.firstSourceIndex = static_cast<uint32_t>(plan.sources.size());
+        target.sourceCount = static_cast<uint32_t>(sourceResources.size());
+
+        for (auto& sourceResource : sourceResources)
+        {
+            BindingPlan::Source source = {};
+            source.resourceId = GetResourceId(sourceResource.name);
+            source.counterResourceId = sourceResource.counterName ? GetResourceId(*sourceResource.counterName) : InvalidId;
+            source.targetIndex = static_cast<uint32_t>(plan.targets.size());
+            source.elementCount = sourceResource.elementCount;
+            source.elementSizeInBytes = sourceResource.elementSizeInBytes;
+            source.elementOffset = sourceResource.elementOffset;
+            source.counterOffsetBytes = sourceResource.counterOffsetBytes;
+            source.format = sourceResource.format;
+            source.shape = sourceResource.shape;
+            assert(source.resourceId != InvalidId);
+
+            auto& resourceDesc = m_resourceDescs[source.resourceId];
+            if (std::holds_alternative<BufferDesc>(resourceDesc.value) && std::get<BufferDesc>(resourceDesc.value).useDeferredBinding)
+            {
+                plan.deferredSources.push_back(static_cast<uint32_t>(plan.sources.size()));
+            }
+
+            plan.sources.push_back(source);
+        }
+
+        plan.targets.push_back(target);
+    }
+
+    m_bindingPlans.push_back(std::move(plan));
+    return static_cast<BindingPlanId>(m_bindingPlans.size() - 1);
+}
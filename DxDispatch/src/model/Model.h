@@ -5,6 +5,8 @@
 #include <optional>
 #include <variant>
 #include <string>
+#include <string_view>
+#include <limits>
 #include <vector>
 #include <gsl/gsl>
 #include <DirectML.h>
@@ -13,6 +15,13 @@
 class Model
 {
 public:
+    // Resources and dispatchables are interned to dense integer IDs when the model is constructed. An ID
+    // is the index of the respective desc in GetResourceDescs() or GetDispatchableDescs().
+    using ResourceId = uint32_t;
+    using DispatchableId = uint32_t;
+    using BindingPlanId = uint32_t;
+    static constexpr uint32_t InvalidId = std::numeric_limits<uint32_t>::max();
+
     // When binding a buffer to an operator it is possible to use a subregion of
     // the buffer by specifying an elementOffset, elementCount, and elementSizeInBytes.
     // Additionally, an optional format specifier dictates how to interpret the buffer
@@ -35,6 +44,38 @@ public:
 
     using Bindings = std::unordered_map<std::string, std::vector<BufferBindingSource>>;
 
+    // A Bindings map compiled into flat arrays that reference resources by ID instead of by name. Each
+    // target (bind point) owns a contiguous range of sources. Plans are built once when the model is
+    // constructed so that executing a command doesn't hash resource names or rebuild binding vectors.
+    struct BindingPlan
+    {
+        struct Target
+        {
+            std::string_view name;
+            uint32_t firstSourceIndex;
+            uint32_t sourceCount;
+        };
+
+        struct Source
+        {
+            ResourceId resourceId;
+            ResourceId counterResourceId; // InvalidId if the source has no counter.
+            uint32_t targetIndex;
+            uint64_t elementCount;
+            uint64_t elementSizeInBytes;
+            uint64_t elementOffset;
+            uint64_t counterOffsetBytes;
+            std::optional<DXGI_FORMAT> format;
+            gsl::span<const int64_t> shape;
+        };
+
+        std::vector<Target> targets;
+        std::vector<Source> sources;
+
+        // Indices into 'sources' that refer to resources with deferred binding.
+        std::vector<uint32_t> deferredSources;
+    };
+
     // RESOURCES
     // ------------------------------------------------------------------------
 
@@ -45,6 +86,14 @@ public:
         DML_TENSOR_DATA_TYPE initialValuesDataType;
         uint64_t initialValuesOffsetInBytes;
         bool useDeferredBinding;
+        uint64_t releasedInitialValuesSizeInBytes = 0; // Size of initialValues before Model::ReleaseInitialValues().
+        std::filesystem::path sourcePath; // File the initial values were read from (e.g. an .npy or .npz), if any.
+
+        // Remains valid after the initial values are released.
+        uint64_t InitialValuesSizeInBytes() const 
+        { 
+            return initialValues.empty() ? releasedInitialValuesSizeInBytes : initialValues.size(); 
+        }
     };
 
     struct ResourceDesc
@@ -82,6 +131,7 @@ public:
         DML_EXECUTION_FLAGS executionFlags;
         DmlCompileType compileType;
         Bindings initBindings;
+        BindingPlanId initBindingPlanId = InvalidId;
     };
 
     struct HlslDispatchableDesc
@@ -91,9 +141,23 @@ public:
             DXC
         };
 
+        enum class BindingMode
+        {
+            // All shader inputs are bound with views in a single descriptor table.
+            DescriptorTable,
+
+            // Raw buffers, structured buffers, and cbuffers are bound as root descriptors; 
+            // remaining inputs (typed buffers, counters, arrays) use a descriptor table.
+            RootDescriptors
+        };
+
         std::filesystem::path sourcePath;
         Compiler compiler;
         std::vector<std::string> compilerArgs;
+        BindingMode bindingMode = BindingMode::DescriptorTable;
+
+        // Maps cbuffer names to values that are set as root constants instead of binding a resource.
+        std::unordered_map<std::string, std::vector<std::byte>> rootConstants;
     };
 
     struct OnnxDispatchableDesc
@@ -133,11 +197,16 @@ public:
         std::string dispatchableName;
         Bindings bindings;
         std::array<uint32_t, 3> threadGroupCount;
+
+        // Resolved when the model is constructed.
+        DispatchableId dispatchableId = InvalidId;
+        BindingPlanId bindingPlanId = InvalidId;
     };
 
     struct PrintCommand
     {
         std::string resourceName;
+        ResourceId resourceId = InvalidId; // Resolved when the model is constructed.
     };
 
     struct WriteFileCommand
@@ -145,6 +214,7 @@ public:
         std::string resourceName;
         std::string targetPath;
         std::vector<uint32_t> dimensions; // The resources don't store their dimensions. So repeat them here.
+        ResourceId resourceId = InvalidId; // Resolved when the model is constructed.
     };
 
     using Command = std::variant<DispatchCommand, PrintCommand, WriteFileCommand>;
@@ -156,13 +226,33 @@ public:
         Command command;
     };
 
+    // SWEEPS
+    // ------------------------------------------------------------------------
+
+    // A sweep is expanded into one DML dispatchable and dispatch command per combination of its parameter
+    // values when the model is parsed. The points are kept so the results can be reported together.
+    struct SweepDesc
+    {
+        struct Point
+        {
+            std::string dispatchableName;
+            std::vector<std::string> parameterValues; // Parallel to parameterNames.
+            DispatchableId dispatchableId = InvalidId; // Resolved when the model is constructed.
+        };
+
+        std::string name;
+        std::vector<std::string> parameterNames;
+        std::vector<Point> points;
+    };
+
     Model() = default;
 
     Model(
         std::vector<ResourceDesc>&& resourceDescs,
         std::vector<DispatchableDesc>&& dispatchableDescs,
         std::vector<CommandDesc>&& commands,
-        BucketAllocator&& allocator);
+        BucketAllocator&& allocator,
+        std::vector<SweepDesc>&& sweeps = {});
 
     Model(const Model&) = delete;
     Model& operator=(const Model&) = delete;
@@ -172,15 +262,44 @@ public:
     gsl::span<const ResourceDesc> GetResourceDescs() const { return m_resourceDescs; }
     gsl::span<const DispatchableDesc> GetDispatchableDescs() const { return m_dispatchableDescs; }
     gsl::span<const CommandDesc> GetCommands() const { return m_commands; }
+    gsl::span<const SweepDesc> GetSweeps() const { return m_sweeps; }
 
-    const ResourceDesc& GetResource(std::string_view name) const { return *m_resourceDescsByName.find(name.data())->second; }
-    const DispatchableDesc& GetDispatchable(std::string_view name) const { return *m_dispatchableDescsByName.find(name.data())->second; }
+    gsl::span<const BindingPlan> GetBindingPlans() const { return m_bindingPlans; }
+
+    // Returns InvalidId if the name doesn't exist in the model.
+    ResourceId GetResourceId(std::string_view name) const;
+    DispatchableId GetDispatchableId(std::string_view name) const;
+
+    const ResourceDesc& GetResource(ResourceId id) const { return m_resourceDescs[id]; }
+    const DispatchableDesc& GetDispatchable(DispatchableId id) const { return m_dispatchableDescs[id]; }
+    DispatchableDesc& GetDispatchable(DispatchableId id) { return m_dispatchableDescs[id]; }
+    const BindingPlan& GetBindingPlan(BindingPlanId id) const { return m_bindingPlans[id]; }
+
+    const ResourceDesc& GetResource(std::string_view name) const { return m_resourceDescs[m_resourceIdsByName.find(name)->second]; }
+    const DispatchableDesc& GetDispatchable(std::string_view name) const { return m_dispatchableDescs[m_dispatchableIdsByName.find(name)->second]; }
+
+    // Frees the host copy of every buffer's initial values, keeping only their sizes. Used once the values have 
+    // been uploaded; the model can't be uploaded again afterward.
+    void ReleaseInitialValues();
+    bool InitialValuesReleased() const { return m_initialValuesReleased; }
+
+    // Frees the memory behind DML operator descs, which is only needed to create operators. Each 
+    // DmlDispatchableDesc::desc is set to nullptr.
+    void ReleaseOperatorDescs();
+
+private:
+    BindingPlanId CompileBindingPlan(const Bindings& bindings);
 
 private:
     std::vector<ResourceDesc> m_resourceDescs;
     std::vector<DispatchableDesc> m_dispatchableDescs;
     std::vector<CommandDesc> m_commands;
+    std::vector<SweepDesc> m_sweeps;
     BucketAllocator m_allocator;
-    std::unordered_map<std::string, ResourceDesc*> m_resourceDescsByName;
-    std::unordered_map<std::string, DispatchableDesc*> m_dispatchableDescsByName;
+    std::vector<BindingPlan> m_bindingPlans;
+    bool m_initialValuesReleased = false;
+
+    // Keys view the names stored in m_resourceDescs/m_dispatchableDescs, which don't move after construction.
+    std::unordered_map<std::string_view, ResourceId> m_resourceIdsByName;
+    std::unordered_map<std::string_view, DispatchableId> m_dispatchableIdsByName;
 };
\ No newline at end of file
@@ -82,26 +82,41 @@ bool IsNpyFilenameExtension(std::string_view filename)
 ////////////////////////////////////////
 // Tensor specific
 
-constexpr uint32_t g_elementDataTypeByteSizes[] =
+constexpr uint32_t g_elementDataTypeBitSizes[] =
 {
-    0, // DML_TENSOR_DATA_TYPE_UNKNOWN,
-    4, // DML_TENSOR_DATA_TYPE_FLOAT32,
-    2, // DML_TENSOR_DATA_TYPE_FLOAT16,
-    4, // DML_TENSOR_DATA_TYPE_UINT32,
-    2, // DML_TENSOR_DATA_TYPE_UINT16,
-    1, // DML_TENSOR_DATA_TYPE_UINT8,
-    4, // DML_TENSOR_DATA_TYPE_INT32,
-    2, // DML_TENSOR_DATA_TYPE_INT16,
-    1, // DML_TENSOR_DATA_TYPE_INT8,
-    8, // DML_TENSOR_DATA_TYPE_FLOAT64,
-    8, // DML_TENSOR_DATA_TYPE_UINT64,
-    8, // DML_TENSOR_DATA_TYPE_INT64,
+     0, // DML_TENSOR_DATA_TYPE_UNKNOWN,
+    32, // DML_TENSOR_DATA_TYPE_FLOAT32,
+    16, // DML_TENSOR_DATA_TYPE_FLOAT16,
+    32, // DML_TENSOR_DATA_TYPE_UINT32,
+    16, // DML_TENSOR_DATA_TYPE_UINT16,
+     8, // DML_TENSOR_DATA_TYPE_UINT8,
+    32, // DML_TENSOR_DATA_TYPE_INT32,
+    16, // DML_TENSOR_DATA_TYPE_INT16,
+     8, // DML_TENSOR_DATA_TYPE_INT8,
+    64, // DML_TENSOR_DATA_TYPE_FLOAT64,
+    64, // DML_TENSOR_DATA_TYPE_UINT64,
+    64, // DML_TENSOR_DATA_TYPE_INT64,
+     4, // DML_TENSOR_DATA_TYPE_UINT4,
+     4, // DML_TENSOR_DATA_TYPE_INT4,
 };
 
-uint32_t GetByteSizeFromDataType(DML_TENSOR_DATA_TYPE dataType) noexcept
+uint32_t GetBitSizeFromDataType(DML_TENSOR_DATA_TYPE dataType) noexcept
 {
     size_t index = static_cast<size_t>(dataType);
-    return g_elementDataTypeByteSizes[index < std::size(g_elementDataTypeByteSizes) ? index : 0];
+    return g_elementDataTypeBitSizes[index < std::size(g_elementDataTypeBitSizes) ? index : 0];
+}
+
+// Packed types smaller than a byte (e.g. INT4) have no whole-byte element size and return 0.
+uint32_t GetByteSizeFromDataType(DML_TENSOR_DATA_TYPE dataType) noexcept
+{
+    uint32_t bitSize = GetBitSizeFromDataType(dataType);
+    return (bitSize % 8 == 0) ? bitSize / 8 : 0;
+}
+
+bool IsPackedDataType(DML_TENSOR_DATA_TYPE dataType) noexcept
+{
+    uint32_t bitSize = GetBitSizeFromDataType(dataType);
+    return bitSize > 0 && bitSize < 8;
 }
 
 uint32_t ComputeElementCount(std::span<const uint32_t> dimensions)
@@ -657,10 +672,38 @@ void ReadNpy(
         }
     }
 
+    // NumPy has no 4-bit types, so packed tensors are stored as a flat uint8 array. The packed data type and the
+    // logical shape follow the dictionary as a Python comment, which NumPy ignores when loading the file.
+    std::u8string_view headerText(reinterpret_cast<const char8_t*>(fileData.data() + dictionaryOffset), dictionaryLength);
+    size_t annotationOffset = headerText.find('#');
+    if (annotationOffset != std::u8string_view::npos)
+    {
+        PythonDictionaryLexer annotationLexer(headerText.substr(annotationOffset + 1));
+        std::map<std::u8string_view, std::u8string_view> annotation = annotationLexer.ReadDictionary();
+
+        auto packedDataType = annotation.find(U8("dml_data_type"));
+        auto packedShape = annotation.find(U8("shape"));
+        if (packedDataType != annotation.end() && packedShape != annotation.end())
+        {
+            if (dataType != DML_TENSOR_DATA_TYPE_UINT8)
+            {
+                throw std::ios::failure("Packed NumPy arrays must be stored as uint8.");
+            }
+
+            if (packedDataType->second == std::u8string_view(U8("INT4"))) { dataType = DML_TENSOR_DATA_TYPE_INT4; }
+            else if (packedDataType->second == std::u8string_view(U8("UINT4"))) { dataType = DML_TENSOR_DATA_TYPE_UINT4; }
+            else { throw std::ios::failure("Unsupported packed data type in NumPy array header."); }
+
+            dimensions.clear();
+            PythonDictionaryLexer shapeLexer(packedShape->second);
+            shapeLexer.ParseIntegers(dimensions);
+        }
+    }
+
     arrayByteData.assign(fileData.data() + dataByteOffset, fileData.end());
     const uint32_t elementByteSize = GetByteSizeFromDataType(dataType);
     const uint32_t totalElementCount = ComputeElementCount(dimensions);
-    const uint32_t totalByteSize = elementByteSize * totalElementCount;
+    const uint32_t totalByteSize = static_cast<uint32_t>((uint64_t(GetBitSizeFromDataType(dataType)) * totalElementCount + 7) / 8);
     if (arrayByteData.size() < totalByteSize)
     {
         arrayByteData.resize(totalByteSize);
@@ -670,7 +713,7 @@ void ReadNpy(
     // If not, lots of other places would break too anyway.
     if (isBackwardsEndian)
     {
-        SwapBytes(/*inout*/ reinterpret_span<uint8_t>(arrayByteData), totalByteSize);
+        SwapBytes(/*inout*/ reinterpret_span<uint8_t>(arrayByteData), elementByteSize);
     }
     if (hasIncreasingStrides)
     {
@@ -691,10 +734,15 @@ void WriteNpy(
     PythonDictionaryWriter dictionaryWriter;
     PythonDictionaryWriter numberWriter;
 
+    // Packed types are written as a flat uint8 array, followed by an annotation with the packed data type and
+    // logical shape (see ReadNpy).
+    const bool isPacked = IsPackedDataType(dataType);
+    const uint32_t packedByteCount = static_cast<uint32_t>((uint64_t(GetBitSizeFromDataType(dataType)) * ComputeElementCount(dimensions) + 7) / 8);
+
     // Format dictionary fields.
     std::u8string numPyElementType;
-    AppendOnnxDataTypeToNumPyArray(dataType, /*isBackwardsEndian*/ false, /*inout*/ numPyElementType);
-    numberWriter.WriteIntegers(dimensions, U8("()"));
+    AppendOnnxDataTypeToNumPyArray(isPacked ? DML_TENSOR_DATA_TYPE_UINT8 : dataType, /*isBackwardsEndian*/ false, /*inout*/ numPyElementType);
+    numberWriter.WriteIntegers(isPacked ? std::span<const uint32_t>(&packedByteCount, &packedByteCount + 1) : dimensions, U8("()"));
 
     dictionaryWriter.Append(U8("{"));
     dictionaryWriter.WriteKeyValue(U8("descr"), numPyElementType);
@@ -702,6 +750,17 @@ void WriteNpy(
     dictionaryWriter.WriteKeyValueUnquoted(U8("'shape'"), numberWriter.GetText());
     dictionaryWriter.Append(U8("}"));
 
+    if (isPacked)
+    {
+        PythonDictionaryWriter shapeWriter;
+        shapeWriter.WriteIntegers(dimensions, U8("()"));
+
+        dictionaryWriter.Append(U8(" #{"));
+        dictionaryWriter.WriteKeyValue(U8("dml_data_type"), dataType == DML_TENSOR_DATA_TYPE_INT4 ? U8("INT4") : U8("UINT4"));
+        dictionaryWriter.WriteKeyValueUnquoted(U8("'shape'"), shapeWriter.GetText());
+        dictionaryWriter.Append(U8("}"));
+    }
+
     // Compute header length for alignment.
     uint32_t headerLength = sizeof(headerFixedPart);
     headerLength += static_cast<uint32_t>(dictionaryWriter.GetText().size());
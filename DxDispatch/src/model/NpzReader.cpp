@@ -0,0 +1,669 @@
+#include "pch.h"
+#include "StdSupport.h"
+#include "NpzReader.h"
+
+////////////////////////////////////////
+// Zip specific
+// https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+
+constexpr uint32_t c_endOfCentralDirectorySignature = 0x06054b50;
+constexpr uint32_t c_zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+constexpr uint32_t c_zip64EndOfCentralDirectorySignature = 0x06064b50;
+constexpr uint32_t c_centralDirectoryHeaderSignature = 0x02014b50;
+constexpr uint32_t c_localFileHeaderSignature = 0x04034b50;
+
+constexpr size_t c_endOfCentralDirectorySize = 22;
+constexpr size_t c_zip64EndOfCentralDirectoryLocatorSize = 20;
+constexpr size_t c_zip64EndOfCentralDirectorySize = 56;
+constexpr size_t c_centralDirectoryHeaderSize = 46;
+constexpr size_t c_localFileHeaderSize = 30;
+constexpr size_t c_maxCommentSize = 0xFFFF;
+
+constexpr uint16_t c_zip64ExtraFieldId = 0x0001;
+constexpr uint16_t c_compressionMethodStored = 0;
+constexpr uint16_t c_compressionMethodDeflated = 8;
+
+// Zip fields are little endian and unaligned.
+template <typename T>
+T ReadField(gsl::span<const std::byte> data, size_t offset)
+{
+    if (offset + sizeof(T) > data.size())
+    {
+        throw std::ios::failure("Zip record is truncated.");
+    }
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+// Sizes and offsets come from the archive itself, so they're checked against the file size before anything is
+// allocated for them.
+void CheckFileRange(std::ifstream& file, uint64_t offset, uint64_t sizeInBytes)
+{
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    if (!file || offset > fileSize || sizeInBytes > fileSize - offset)
+    {
+        throw std::ios::failure("Zip record extends past the end of the file.");
+    }
+}
+
+std::vector<std::byte> ReadFileRange(std::ifstream& file, uint64_t offset, uint64_t sizeInBytes)
+{
+    CheckFileRange(file, offset, sizeInBytes);
+    std::vector<std::byte> data(gsl::narrow<size_t>(sizeInBytes));
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (!file || static_cast<uint64_t>(file.gcount()) != sizeInBytes)
+    {
+        throw std::ios::failure("Unexpected end of zip file.");
+    }
+    return data;
+}
+
+// CRC-32 as used by zip (reflected, polynomial 0xEDB88320).
+uint32_t ComputeCrc32(gsl::span<const std::byte> data)
+{
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < table.size(); i++)
+        {
+            uint32_t value = i;
+            for (uint32_t bit = 0; bit < 8; bit++)
+            {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (auto byte : data)
+    {
+        crc = table[(crc ^ std::to_integer<uint32_t>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+////////////////////////////////////////
+// Deflate specific
+// https://www.rfc-editor.org/rfc/rfc1951
+
+// Reads bits least significant first from a file, refilling a small buffer as it goes so that a compressed member
+// is never held in memory at once.
+class BitReader
+{
+public:
+    BitReader(std::ifstream& file, uint64_t sizeInBytes) : file_(file), remainingFileBytes_(sizeInBytes), buffer_(65536)
+    {
+    }
+
+    // Makes up to count bits available to PeekBits. Fewer are available at the end of the stream.
+    uint32_t EnsureBits(uint32_t count)
+    {
+        while (bitCount_ < count && HasMoreBytes())
+        {
+            bitBuffer_ |= uint64_t(NextByte()) << bitCount_;
+            bitCount_ += 8;
+        }
+        return bitCount_;
+    }
+
+    uint32_t PeekBits(uint32_t count) const
+    {
+        return static_cast<uint32_t>(bitBuffer_ & ((1ull << count) - 1));
+    }
+
+    void SkipBits(uint32_t count)
+    {
+        assert(count <= bitCount_);
+        bitBuffer_ >>= count;
+        bitCount_ -= count;
+    }
+
+    uint32_t ReadBits(uint32_t count)
+    {
+        if (EnsureBits(count) < count)
+        {
+            throw std::ios::failure("Unexpected end of deflate stream.");
+        }
+        uint32_t value = PeekBits(count);
+        SkipBits(count);
+        return value;
+    }
+
+    // Discards the remaining bits of the current byte.
+    void AlignToByte()
+    {
+        SkipBits(bitCount_ % 8);
+    }
+
+    void ReadAlignedBytes(gsl::span<std::byte> bytes)
+    {
+        assert(bitCount_ % 8 == 0);
+        size_t index = 0;
+        for (; index < bytes.size() && bitCount_ > 0; index++)
+        {
+            bytes[index] = static_cast<std::byte>(ReadBits(8));
+        }
+        while (index < bytes.size())
+        {
+            if (!HasMoreBytes())
+            {
+                throw std::ios::failure("Unexpected end of deflate stream.");
+            }
+            size_t copySize = std::min(bytes.size() - index, bufferEnd_ - bufferPosition_);
+            memcpy(bytes.data() + index, buffer_.data() + bufferPosition_, copySize);
+            bufferPosition_ += copySize;
+            index += copySize;
+        }
+    }
+
+private:
+    bool HasMoreBytes()
+    {
+        if (bufferPosition_ == bufferEnd_ && remainingFileBytes_ > 0)
+        {
+            size_t readSize = static_cast<size_t>(std::min<uint64_t>(remainingFileBytes_, buffer_.size()));
+            file_.read(reinterpret_cast<char*>(buffer_.data()), readSize);
+            if (!file_)
+            {
+                throw std::ios::failure("Unexpected end of zip file.");
+            }
+            remainingFileBytes_ -= readSize;
+            bufferPosition_ = 0;
+            bufferEnd_ = readSize;
+        }
+        return bufferPosition_ < bufferEnd_;
+    }
+
+    uint8_t NextByte()
+    {
+        return buffer_[bufferPosition_++];
+    }
+
+    std::ifstream& file_;
+    uint64_t remainingFileBytes_;
+    std::vector<uint8_t> buffer_;
+    size_t bufferPosition_ = 0;
+    size_t bufferEnd_ = 0;
+    uint64_t bitBuffer_ = 0;
+    uint32_t bitCount_ = 0;
+};
+
+// Canonical Huffman code. Codes up to c_fastBits long are decoded with a single table lookup, and longer codes
+// fall back to walking the code lengths one bit at a time.
+class HuffmanDecoder
+{
+public:
+    static constexpr uint32_t c_maxBits = 15;
+    static constexpr uint32_t c_fastBits = 9;
+
+    HuffmanDecoder() = default;
+
+    HuffmanDecoder(gsl::span<const uint8_t> codeLengths)
+    {
+        for (auto length : codeLengths)
+        {
+            counts_[length]++;
+        }
+        counts_[0] = 0;
+
+        std::array<uint16_t, c_maxBits + 2> offsets = {};
+        for (uint32_t length = 1; length <= c_maxBits; length++)
+        {
+            offsets[length + 1] = offsets[length] + counts_[length];
+        }
+
+        // Symbols are sorted by code length, then by value, which is the order of their canonical codes.
+        symbols_.resize(codeLengths.size());
+        for (uint32_t symbol = 0; symbol < codeLengths.size(); symbol++)
+        {
+            if (codeLengths[symbol] != 0)
+            {
+                symbols_[offsets[codeLengths[symbol]]++] = static_cast<uint16_t>(symbol);
+            }
+        }
+
+        // Deflate packs codes starting with their most significant bit, so the table is indexed by reversed codes.
+        uint32_t code = 0;
+        uint32_t symbolIndex = 0;
+        for (uint32_t length = 1; length <= c_fastBits; length++)
+        {
+            for (uint32_t i = 0; i < counts_[length]; i++, code++, symbolIndex++)
+            {
+                uint32_t reversedCode = 0;
+                for (uint32_t bit = 0; bit < length; bit++)
+                {
+                    reversedCode |= ((code >> bit) & 1) << (length - 1 - bit);
+                }
+                for (uint32_t entry = reversedCode; entry < fastTable_.size(); entry += (1u << length))
+                {
+                    fastTable_[entry] = static_cast<uint16_t>((symbols_[symbolIndex] << 4) | length);
+                }
+            }
+            code <<= 1;
+        }
+    }
+
+    uint32_t Decode(BitReader& reader) const
+    {
+        uint32_t availableBits = reader.EnsureBits(c_fastBits);
+        uint16_t entry = fastTable_[reader.PeekBits(c_fastBits)];
+        uint32_t length = entry & 0xF;
+        if (length != 0 && length <= availableBits)
+        {
+            reader.SkipBits(length);
+            return entry >> 4;
+        }
+
+        int32_t code = 0;
+        int32_t first = 0;
+        int32_t index = 0;
+        for (uint32_t bits = 1; bits <= c_maxBits; bits++)
+        {
+            code |= reader.ReadBits(1);
+            int32_t count = counts_[bits];
+            if (code - count < first)
+            {
+                return symbols_[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        throw std::ios::failure("Invalid deflate Huffman code.");
+    }
+
+private:
+    std::array<uint16_t, c_maxBits + 1> counts_ = {};
+    std::vector<uint16_t> symbols_;
+    std::array<uint16_t, 1 << c_fastBits> fastTable_ = {}; // Symbol << 4 | code length, or 0 for longer codes.
+};
+
+constexpr uint16_t c_lengthBases[] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+constexpr uint8_t c_lengthExtraBits[] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+constexpr uint16_t c_distanceBases[] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+constexpr uint8_t c_distanceExtraBits[] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+void InflateCodes(BitReader& reader, const HuffmanDecoder& literalLengths, const HuffmanDecoder& distances, gsl::span<std::byte> output, size_t& outputPosition)
+{
+    while (true)
+    {
+        uint32_t symbol = literalLengths.Decode(reader);
+        if (symbol < 256)
+        {
+            if (outputPosition >= output.size())
+            {
+                throw std::ios::failure("Deflate stream is larger than its declared size.");
+            }
+            output[outputPosition++] = static_cast<std::byte>(symbol);
+        }
+        else if (symbol == 256)
+        {
+            return;
+        }
+        else
+        {
+            symbol -= 257;
+            if (symbol >= std::size(c_lengthBases))
+            {
+                throw std::ios::failure("Invalid deflate length code.");
+            }
+            size_t length = c_lengthBases[symbol] + reader.ReadBits(c_lengthExtraBits[symbol]);
+
+            uint32_t distanceSymbol = distances.Decode(reader);
+            if (distanceSymbol >= std::size(c_distanceBases))
+            {
+                throw std::ios::failure("Invalid deflate distance code.");
+            }
+            size_t distance = c_distanceBases[distanceSymbol] + reader.ReadBits(c_distanceExtraBits[distanceSymbol]);
+
+            if (distance > outputPosition || length > output.size() - outputPosition)
+            {
+                throw std::ios::failure("Invalid deflate back reference.");
+            }
+
+            // The source may overlap the destination (e.g. a run of one repeated byte), so copy forward bytewise.
+            std::byte* destination = output.data() + outputPosition;
+            const std::byte* source = destination - distance;
+            for (size_t i = 0; i < length; i++)
+            {
+                destination[i] = source[i];
+            }
+            outputPosition += length;
+        }
+    }
+}
+
+const std::pair<HuffmanDecoder, HuffmanDecoder>& GetFixedDecoders()
+{
+    static const std::pair<HuffmanDecoder, HuffmanDecoder> decoders = []
+    {
+        std::array<uint8_t, 288> literalLengthCodeLengths;
+        std::fill(literalLengthCodeLengths.begin() + 0, literalLengthCodeLengths.begin() + 144, uint8_t(8));
+        std::fill(literalLengthCodeLengths.begin() + 144, literalLengthCodeLengths.begin() + 256, uint8_t(9));
+        std::fill(literalLengthCodeLengths.begin() + 256, literalLengthCodeLengths.begin() + 280, uint8_t(7));
+        std::fill(literalLengthCodeLengths.begin() + 280, literalLengthCodeLengths.end(), uint8_t(8));
+
+        std::array<uint8_t, 30> distanceCodeLengths;
+        distanceCodeLengths.fill(5);
+
+        return std::make_pair(HuffmanDecoder(literalLengthCodeLengths), HuffmanDecoder(distanceCodeLengths));
+    }();
+    return decoders;
+}
+
+std::pair<HuffmanDecoder, HuffmanDecoder> ReadDynamicDecoders(BitReader& reader)
+{
+    uint32_t literalLengthCount = reader.ReadBits(5) + 257;
+    uint32_t distanceCount = reader.ReadBits(5) + 1;
+    uint32_t codeLengthCount = reader.ReadBits(4) + 4;
+    if (literalLengthCount > 286 || distanceCount > 30)
+    {
+        throw std::ios::failure("Invalid deflate code counts.");
+    }
+
+    constexpr uint8_t codeLengthOrder[] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+    std::array<uint8_t, 19> codeLengthCodeLengths = {};
+    for (uint32_t i = 0; i < codeLengthCount; i++)
+    {
+        codeLengthCodeLengths[codeLengthOrder[i]] = static_cast<uint8_t>(reader.ReadBits(3));
+    }
+    HuffmanDecoder codeLengthDecoder(codeLengthCodeLengths);
+
+    // Literal/length and distance code lengths are a single sequence, and repeats may cross between them.
+    std::vector<uint8_t> codeLengths;
+    codeLengths.reserve(literalLengthCount + distanceCount);
+    while (codeLengths.size() < literalLengthCount + distanceCount)
+    {
+        uint32_t symbol = codeLengthDecoder.Decode(reader);
+        uint8_t repeatedLength = 0;
+        uint32_t repeatCount = 0;
+        switch (symbol)
+        {
+        case 16:
+            if (codeLengths.empty())
+            {
+                throw std::ios::failure("Invalid deflate code length repeat.");
+            }
+            repeatedLength = codeLengths.back();
+            repeatCount = 3 + reader.ReadBits(2);
+            break;
+        case 17: repeatCount = 3 + reader.ReadBits(3); break;
+        case 18: repeatCount = 11 + reader.ReadBits(7); break;
+        default: repeatCount = 1; repeatedLength = static_cast<uint8_t>(symbol); break;
+        }
+
+        if (codeLengths.size() + repeatCount > literalLengthCount + distanceCount)
+        {
+            throw std::ios::failure("Invalid deflate code length repeat.");
+        }
+        codeLengths.insert(codeLengths.end(), repeatCount, repeatedLength);
+    }
+
+    if (codeLengths[256] == 0)
+    {
+        throw std::ios::failure("Deflate block has no end-of-block code.");
+    }
+
+    gsl::span<const uint8_t> allCodeLengths(codeLengths.data(), codeLengths.data() + codeLengths.size());
+    return std::make_pair(
+        HuffmanDecoder(allCodeLengths.subspan(0, literalLengthCount)),
+        HuffmanDecoder(allCodeLengths.subspan(literalLengthCount, distanceCount)));
+}
+
+// Decompresses a raw deflate stream from the file's current position into output, which must be exactly the
+// uncompressed size.
+void Inflate(std::ifstream& file, uint64_t compressedSizeInBytes, gsl::span<std::byte> output)
+{
+    BitReader reader(file, compressedSizeInBytes);
+    size_t outputPosition = 0;
+
+    bool isFinalBlock = false;
+    while (!isFinalBlock)
+    {
+        isFinalBlock = reader.ReadBits(1);
+        uint32_t blockType = reader.ReadBits(2);
+        switch (blockType)
+        {
+        case 0: // Stored
+            {
+                reader.AlignToByte();
+                uint32_t length = reader.ReadBits(16);
+                uint32_t lengthComplement = reader.ReadBits(16);
+                if (length != (~lengthComplement & 0xFFFF) || length > output.size() - outputPosition)
+                {
+                    throw std::ios::failure("Invalid deflate stored block.");
+                }
+                reader.ReadAlignedBytes(output.subspan(outputPosition, length));
+                outputPosition += length;
+            }
+            break;
+
+        case 1: // Fixed Huffman codes
+            {
+                auto& [literalLengths, distances] = GetFixedDecoders();
+                InflateCodes(reader, literalLengths, distances, output, outputPosition);
+            }
+            break;
+
+        case 2: // Dynamic Huffman codes
+            {
+                auto [literalLengths, distances] = ReadDynamicDecoders(reader);
+                InflateCodes(reader, literalLengths, distances, output, outputPosition);
+            }
+            break;
+
+        default:
+            throw std::ios::failure("Invalid deflate block type.");
+        }
+    }
+
+    if (outputPosition != output.size())
+    {
+        throw std::ios::failure("Deflate stream is smaller than its declared size.");
+    }
+}
+
+////////////////////////////////////////
+// NumPy specific
+
+bool IsNpzFilenameExtension(std::string_view filename)
+{
+    return ends_with(filename, std::string_view(".npz")) || ends_with(filename, std::string_view(".NPZ"));
+}
+
+NpzArchive::NpzArchive(std::filesystem::path path) : m_path(std::move(path)), m_file(m_path, std::ifstream::ate | std::ifstream::binary)
+{
+    if (!m_file.is_open())
+    {
+        throw std::ios::failure(fmt::format("Given filename '{}' could not be opened.", m_path.string()));
+    }
+    uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+
+    // The end of central directory record is at the end of the file, followed only by a variable length comment.
+    uint64_t tailSize = std::min<uint64_t>(fileSize, c_endOfCentralDirectorySize + c_maxCommentSize + c_zip64EndOfCentralDirectoryLocatorSize);
+    uint64_t tailOffset = fileSize - tailSize;
+    std::vector<std::byte> tail = ReadFileRange(m_file, tailOffset, tailSize);
+
+    std::optional<size_t> endRecordOffset;
+    for (size_t offset = tail.size() >= c_endOfCentralDirectorySize ? tail.size() - c_endOfCentralDirectorySize + 1 : 0; offset-- > 0;)
+    {
+        if (ReadField<uint32_t>(tail, offset) == c_endOfCentralDirectorySignature)
+        {
+            endRecordOffset = offset;
+            break;
+        }
+    }
+    if (!endRecordOffset)
+    {
+        throw std::ios::failure(fmt::format("'{}' is not a zip archive.", m_path.string()));
+    }
+
+    uint64_t memberCount = ReadField<uint16_t>(tail, *endRecordOffset + 10);
+    uint64_t centralDirectorySize = ReadField<uint32_t>(tail, *endRecordOffset + 12);
+    uint64_t centralDirectoryOffset = ReadField<uint32_t>(tail, *endRecordOffset + 16);
+
+    // Archives with more than 65535 members or larger than 4GB (not unusual for weights) use zip64 records.
+    if (*endRecordOffset >= c_zip64EndOfCentralDirectoryLocatorSize)
+    {
+        size_t locatorOffset = *endRecordOffset - c_zip64EndOfCentralDirectoryLocatorSize;
+        if (ReadField<uint32_t>(tail, locatorOffset) == c_zip64EndOfCentralDirectoryLocatorSignature)
+        {
+            uint64_t zip64EndRecordOffset = ReadField<uint64_t>(tail, locatorOffset + 8);
+            std::vector<std::byte> zip64EndRecord = ReadFileRange(m_file, zip64EndRecordOffset, c_zip64EndOfCentralDirectorySize);
+            if (ReadField<uint32_t>(zip64EndRecord, 0) != c_zip64EndOfCentralDirectorySignature)
+            {
+                throw std::ios::failure(fmt::format("'{}' has an invalid zip64 end of central directory record.", m_path.string()));
+            }
+            memberCount = ReadField<uint64_t>(zip64EndRecord, 32);
+            centralDirectorySize = ReadField<uint64_t>(zip64EndRecord, 40);
+            centralDirectoryOffset = ReadField<uint64_t>(zip64EndRecord, 48);
+        }
+    }
+
+    std::vector<std::byte> centralDirectory = ReadFileRange(m_file, centralDirectoryOffset, centralDirectorySize);
+    gsl::span<const std::byte> records(centralDirectory.data(), centralDirectory.data() + centralDirectory.size());
+
+    size_t recordOffset = 0;
+    for (uint64_t memberIndex = 0; memberIndex < memberCount; memberIndex++)
+    {
+        if (ReadField<uint32_t>(records, recordOffset) != c_centralDirectoryHeaderSignature)
+        {
+            throw std::ios::failure(fmt::format("'{}' has an invalid zip central directory.", m_path.string()));
+        }
+
+        uint16_t flags = ReadField<uint16_t>(records, recordOffset + 8);
+        Member member = {};
+        member.compressionMethod = ReadField<uint16_t>(records, recordOffset + 10);
+        member.crc32 = ReadField<uint32_t>(records, recordOffset + 16);
+        member.compressedSizeInBytes = ReadField<uint32_t>(records, recordOffset + 20);
+        member.uncompressedSizeInBytes = ReadField<uint32_t>(records, recordOffset + 24);
+        uint16_t nameSize = ReadField<uint16_t>(records, recordOffset + 28);
+        uint16_t extraFieldSize = ReadField<uint16_t>(records, recordOffset + 30);
+        uint16_t commentSize = ReadField<uint16_t>(records, recordOffset + 32);
+        member.localHeaderOffset = ReadField<uint32_t>(records, recordOffset + 42);
+
+        size_t nameOffset = recordOffset + c_centralDirectoryHeaderSize;
+        size_t extraFieldOffset = nameOffset + nameSize;
+        if (extraFieldOffset + extraFieldSize > records.size())
+        {
+            throw std::ios::failure(fmt::format("'{}' has an invalid zip central directory.", m_path.string()));
+        }
+        std::string name(reinterpret_cast<const char*>(records.data() + nameOffset), nameSize);
+
+        // Sizes and offsets that don't fit in 32 bits are 0xFFFFFFFF, with the real values in the zip64 extra field
+        // (in this order, and only the ones that overflowed).
+        for (size_t fieldOffset = extraFieldOffset; fieldOffset + 4 <= extraFieldOffset + extraFieldSize;)
+        {
+            uint16_t fieldId = ReadField<uint16_t>(records, fieldOffset);
+            uint16_t fieldSize = ReadField<uint16_t>(records, fieldOffset + 2);
+            if (fieldId == c_zip64ExtraFieldId)
+            {
+                size_t valueOffset = fieldOffset + 4;
+                for (uint64_t* value : { &member.uncompressedSizeInBytes, &member.compressedSizeInBytes, &member.localHeaderOffset })
+                {
+                    if (*value == 0xFFFFFFFF)
+                    {
+                        *value = ReadField<uint64_t>(records, valueOffset);
+                        valueOffset += sizeof(uint64_t);
+                    }
+                }
+            }
+            fieldOffset += 4 + fieldSize;
+        }
+
+        // Only arrays are indexed; members that can't be read are rejected when requested rather than up front, so
+        // an archive with other content can still be used.
+        if ((flags & 0x1) != 0)
+        {
+            member.compressionMethod = std::numeric_limits<uint16_t>::max(); // Encrypted.
+        }
+        if (ends_with(std::string_view(name), std::string_view(".npy")))
+        {
+            name.resize(name.size() - 4);
+            m_members[std::move(name)] = member;
+        }
+
+        recordOffset = extraFieldOffset + extraFieldSize + commentSize;
+    }
+}
+
+bool NpzArchive::Contains(std::string_view arrayName) const
+{
+    return m_members.find(arrayName) != m_members.end();
+}
+
+std::vector<std::byte> NpzArchive::ReadArrayFile(std::string_view arrayName) const
+{
+    auto memberIterator = m_members.find(arrayName);
+    if (memberIterator == m_members.end())
+    {
+        throw std::invalid_argument(fmt::format("Archive '{}' has no array named '{}'.", m_path.string(), arrayName));
+    }
+    auto& member = memberIterator->second;
+
+    // Every read seeks to its member in the stream opened with the archive. A failed read leaves the stream in a
+    // failed state, so it is cleared first.
+    m_file.clear();
+
+    // The local header repeats the name and may have a different extra field than the central directory.
+    std::vector<std::byte> localHeader = ReadFileRange(m_file, member.localHeaderOffset, c_localFileHeaderSize);
+    if (ReadField<uint32_t>(localHeader, 0) != c_localFileHeaderSignature)
+    {
+        throw std::ios::failure(fmt::format("Archive '{}' has an invalid local header for '{}'.", m_path.string(), arrayName));
+    }
+    uint64_t dataOffset = member.localHeaderOffset + c_localFileHeaderSize +
+        ReadField<uint16_t>(localHeader, 26) +
+        ReadField<uint16_t>(localHeader, 28);
+
+    std::vector<std::byte> data;
+    switch (member.compressionMethod)
+    {
+    case c_compressionMethodStored:
+        if (member.compressedSizeInBytes != member.uncompressedSizeInBytes)
+        {
+            throw std::ios::failure(fmt::format("Archive '{}' has an invalid size for '{}'.", m_path.string(), arrayName));
+        }
+        data = ReadFileRange(m_file, dataOffset, member.uncompressedSizeInBytes);
+        break;
+
+    case c_compressionMethodDeflated:
+        // Deflate can't expand data by more than about 1032:1, so a larger declared size is corrupt.
+        CheckFileRange(m_file, dataOffset, member.compressedSizeInBytes);
+        if (member.uncompressedSizeInBytes / 1032 > member.compressedSizeInBytes)
+        {
+            throw std::ios::failure(fmt::format("Archive '{}' has an invalid size for '{}'.", m_path.string(), arrayName));
+        }
+        data.resize(gsl::narrow<size_t>(member.uncompressedSizeInBytes));
+        m_file.seekg(dataOffset);
+        Inflate(m_file, member.compressedSizeInBytes, gsl::span<std::byte>(data.data(), data.data() + data.size()));
+        break;
+
+    default:
+        throw std::invalid_argument(fmt::format(
+            "Array '{}' in archive '{}' must be stored or deflated (numpy.savez or numpy.savez_compressed).",
+            arrayName,
+            m_path.string()));
+    }
+
+    if (ComputeCrc32(data) != member.crc32)
+    {
+        throw std::ios::failure(fmt::format("Archive '{}' has a CRC-32 mismatch for '{}'.", m_path.string(), arrayName));
+    }
+    return data;
+}
+
+const NpzArchive& NpzArchiveCache::GetArchive(const std::filesystem::path& path)
+{
+    auto& archive = m_archives[path];
+    if (!archive)
+    {
+        archive = std::make_unique<NpzArchive>(path);
+    }
+    return *archive;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+bool IsNpzFilenameExtension(std::string_view filename);
+
+// Index of the arrays in a NumPy .npz archive (a zip file of .npy members, as written by numpy.savez or
+// numpy.savez_compressed). Only the zip central directory is read when the archive is opened; each array is read
+// from the file when it is requested, so a model only pays for the arrays it uses. The file stays open for the
+// lifetime of the archive and every read seeks within it, so an archive must not be read from several threads.
+class NpzArchive
+{
+public:
+    explicit NpzArchive(std::filesystem::path path);
+
+    const std::filesystem::path& GetPath() const { return m_path; }
+    bool Contains(std::string_view arrayName) const;
+
+    // Returns the .npy file data of an array (the member name without its ".npy" extension). Stored members are read
+    // directly from their offset in the archive, and deflated members are decompressed as they are read. Throws if
+    // the data doesn't match the CRC-32 in the central directory.
+    std::vector<std::byte> ReadArrayFile(std::string_view arrayName) const;
+
+private:
+    struct Member
+    {
+        uint16_t compressionMethod;
+        uint64_t compressedSizeInBytes;
+        uint64_t uncompressedSizeInBytes;
+        uint64_t localHeaderOffset;
+        uint32_t crc32; // Of the uncompressed data.
+    };
+
+    std::filesystem::path m_path;
+    mutable std::ifstream m_file;
+    std::map<std::string, Member, std::less<>> m_members;
+};
+
+// Opens each archive once, so that every resource initialized from the same archive shares its index.
+class NpzArchiveCache
+{
+public:
+    const NpzArchive& GetArchive(const std::filesystem::path& path);
+
+private:
+    std::map<std::filesystem::path, std::unique_ptr<NpzArchive>> m_archives;
+};
@@ -0,0 +1,102 @@
+#define NOMINMAX
+#ifndef WIN32
+#include <wsl/winadapter.h>
+#include "directml_guids.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <wrl/client.h>
+#include <directx/d3d12.h>
+#include "DirectMLX.h"
+
+using Microsoft::WRL::ComPtr;
+using Clock = std::chrono::steady_clock;
+
+// Measures how long DirectMLX takes to build a large graph and produce its graph desc, which is the CPU cost paid
+// before DirectML compiles anything. The graph is a chain of small transformer-like layers (GEMM, bias add, ReLU), each
+// in its own name scope, so the numbers mostly reflect per-node overhead rather than tensor sizes.
+//
+// Without DMLX_USE_GRAPH_SERIALIZATION, DirectMLX creates each operator as it is added, so this needs a D3D12 and DML
+// device and the build time includes operator creation. With it (the dmlxbenchmark_serialized target), operator
+// creation is deferred, so the graph is built without a device and serialized instead; that variant runs anywhere and
+// measures only DirectMLX's own overhead.
+//
+// Usage: dmlxbenchmark [node count] (default 100000)
+int main(int argc, char** argv)
+{
+    const uint32_t requestedNodeCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    constexpr uint32_t nodesPerLayer = 3;
+    const uint32_t layerCount = std::max(1u, requestedNodeCount / nodesPerLayer);
+    const uint32_t nodeCount = layerCount * nodesPerLayer;
+
+#if !DMLX_USE_GRAPH_SERIALIZATION
+    ComPtr<ID3D12Device> d3d12Device;
+    if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3d12Device))))
+    {
+        std::fprintf(stderr, "Failed to create a D3D12 device.\n");
+        return 1;
+    }
+
+    ComPtr<IDMLDevice> dmlDevice;
+    if (FAILED(DMLCreateDevice(d3d12Device.Get(), DML_CREATE_DEVICE_FLAG_NONE, IID_PPV_ARGS(&dmlDevice))))
+    {
+        std::fprintf(stderr, "Failed to create a DML device.\n");
+        return 1;
+    }
+#endif
+
+    auto buildStart = Clock::now();
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+    dml::Graph graph(nullptr);
+#else
+    dml::Graph graph(dmlDevice.Get());
+#endif
+    const dml::TensorDimensions activationSizes = { 1, 1, 16, 64 };
+    const dml::TensorDimensions weightSizes = { 1, 1, 64, 64 };
+    dml::Expression x = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, activationSizes));
+    dml::Expression weights = dml::InputTensor(graph, 1, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, weightSizes));
+    dml::Expression bias = dml::InputTensor(graph, 2, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, activationSizes));
+
+    for (uint32_t layer = 0; layer < layerCount; ++layer)
+    {
+        auto scope = graph.CreateNameScope("layer" + std::to_string(layer));
+        x = dml::ActivationRelu(dml::Gemm(x, weights) + bias);
+    }
+
+    auto buildEnd = Clock::now();
+
+    const dml::Expression outputs[] = { x };
+    dml::detail::GraphDescOptions graphDescOptions;
+#if DMLX_USE_GRAPH_SERIALIZATION
+    graphDescOptions.createOperators = false;
+#endif
+    size_t graphNodeCount = graph.Impl()->GetGraphDesc(outputs, graphDescOptions).operatorNodes.size();
+
+    auto graphDescEnd = Clock::now();
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+    size_t serializedSize = graph.Serialize(outputs).size();
+
+    auto serializeEnd = Clock::now();
+#endif
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const double buildMs = Milliseconds(buildEnd - buildStart).count();
+    const double graphDescMs = Milliseconds(graphDescEnd - buildEnd).count();
+    const double per100k = 100000.0 / nodeCount;
+
+    std::printf("Nodes: %u (graph desc: %zu)\n", nodeCount, graphNodeCount);
+    std::printf("Build: %.1f ms (%.1f ms per 100k nodes)\n", buildMs, buildMs * per100k);
+    std::printf("Graph desc: %.1f ms (%.1f ms per 100k nodes)\n", graphDescMs, graphDescMs * per100k);
+#if DMLX_USE_GRAPH_SERIALIZATION
+    const double serializeMs = Milliseconds(serializeEnd - graphDescEnd).count();
+    std::printf("Serialize: %.1f ms (%.1f ms per 100k nodes, %zu bytes)\n", serializeMs, serializeMs * per100k, serializedSize);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,531 @@
+#include "pch.h"
+#include <gtest/gtest.h>
+#include "DirectMLHelpers/DmlGraphDeserialization.h"
+
+// These tests build graphs without a device (DMLX_USE_GRAPH_SERIALIZATION defers operator creation), so they inspect
+// the graph desc that Compile would give DirectML rather than compiling it.
+
+static dml::TensorDesc FloatTensor(dml::TensorDimensions sizes)
+{
+    return dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, std::move(sizes));
+}
+
+static DML_OPERATOR_TYPE GetOperatorType(const DmlSerializedGraphNode& node)
+{
+    return std::get<AbstractOperatorDesc>(node.Desc).schema->OperatorType;
+}
+
+// Returns the graph desc that Graph::Compile would pass to DirectML, without creating any operators.
+static dml::detail::GraphDesc GetGraphDesc(
+    dml::Graph& graph, 
+    dml::Span<const dml::Expression> outputs, 
+    dml::detail::GraphDescOptions options = {})
+{
+    options.createOperators = false;
+    return graph.Impl()->GetGraphDesc(outputs, options);
+}
+
+// Returns the number of intermediate edges from one operator node to another.
+static size_t CountIntermediateEdges(const dml::detail::GraphDesc& desc, uint32_t fromNodeIndex, uint32_t toNodeIndex)
+{
+    return std::count_if(desc.intermediateEdges.begin(), desc.intermediateEdges.end(), [&](auto& edge)
+    {
+        return edge.FromNodeIndex == fromNodeIndex && edge.ToNodeIndex == toNodeIndex;
+    });
+}
+
+// ----------------------------------------------------------------------------
+// SERIALIZATION
+// ----------------------------------------------------------------------------
+
+#if DML_TARGET_VERSION >= 0x6200
+TEST(DirectMLXGraphTest, SerializeRoundTrip)
+{
+    const float constantValues[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    auto constantBytes = gsl::as_bytes(gsl::make_span(constantValues));
+
+    dml::Graph graph(nullptr);
+    auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    auto b = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 2, 2 }));
+    auto c = dml::ConstantData(graph, dml::Span<const dml::Byte>(constantBytes.data(), constantBytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+    auto sum = dml::Add(a, b);
+    auto product = dml::Multiply(sum, c);
+    dml::Expression outputs[] = { sum, product };
+
+    std::vector<uint8_t> serialized = graph.Serialize(outputs);
+    std::vector<std::unique_ptr<std::byte[]>> rawData;
+    DmlSerializedGraphDesc desc = DeserializeDmlGraph(serialized.data(), rawData);
+
+    EXPECT_EQ(desc.InputCount, 2u);
+    EXPECT_EQ(desc.OutputCount, 2u);
+
+    // Constants come first, then operators in creation order.
+    ASSERT_EQ(desc.Nodes.size(), 3u);
+    auto& constantNode = std::get<DmlSerializedGraphNodeConstantVariant>(desc.Nodes[0].Desc);
+    auto& constantData = std::get<ConstantData>(constantNode);
+    ASSERT_EQ(constantData.dataSize, sizeof(constantValues));
+    EXPECT_EQ(memcmp(constantData.data, constantValues, sizeof(constantValues)), 0);
+    EXPECT_EQ(GetOperatorType(desc.Nodes[1]), DML_OPERATOR_ELEMENT_WISE_ADD);
+    EXPECT_EQ(GetOperatorType(desc.Nodes[2]), DML_OPERATOR_ELEMENT_WISE_MULTIPLY);
+
+    // Each input of the add is bound to the matching graph input.
+    ASSERT_EQ(desc.InputEdges.size(), 2u);
+    for (auto& edge : desc.InputEdges)
+    {
+        EXPECT_EQ(edge.ToNodeIndex, 1u);
+        EXPECT_EQ(edge.ToNodeInputIndex, edge.GraphInputIndex);
+    }
+
+    // The multiply reads the add and the constant.
+    ASSERT_EQ(desc.IntermediateEdges.size(), 2u);
+    for (auto& edge : desc.IntermediateEdges)
+    {
+        EXPECT_EQ(edge.ToNodeIndex, 2u);
+        EXPECT_EQ(edge.FromNodeOutputIndex, 0u);
+        EXPECT_EQ(edge.FromNodeIndex, edge.ToNodeInputIndex == 0 ? 1u : 0u);
+    }
+
+    ASSERT_EQ(desc.OutputEdges.size(), 2u);
+    for (auto& edge : desc.OutputEdges)
+    {
+        EXPECT_EQ(edge.FromNodeIndex, edge.GraphOutputIndex == 0 ? 1u : 2u);
+        EXPECT_EQ(edge.FromNodeOutputIndex, 0u);
+    }
+
+    // The operator descs survive the round trip.
+    auto& addDesc = std::get<AbstractOperatorDesc>(desc.Nodes[1].Desc);
+    auto addInputs = addDesc.GetInputTensors();
+    ASSERT_EQ(addInputs.size(), 2u);
+    EXPECT_EQ(addInputs[0]->dataType, DML_TENSOR_DATA_TYPE_FLOAT32);
+    EXPECT_EQ(addInputs[0]->sizes, std::vector<uint32_t>({ 1, 1, 2, 2 }));
+}
+
+TEST(DirectMLXGraphTest, SerializeExternalConstants)
+{
+    const float constantValues[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    auto constantBytes = gsl::as_bytes(gsl::make_span(constantValues));
+
+    dml::Graph graph(nullptr);
+    auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    dml::Expression c;
+    {
+        auto scope = graph.CreateNameScope("weights");
+        c = dml::ConstantData(graph, dml::Span<const dml::Byte>(constantBytes.data(), constantBytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+    }
+    dml::Expression outputs[] = { dml::Add(a, c) };
+
+    std::vector<dml::SerializedConstant> externalConstants;
+    std::vector<uint8_t> serialized = graph.Serialize(outputs, &externalConstants);
+    std::vector<std::unique_ptr<std::byte[]>> rawData;
+    DmlSerializedGraphDesc desc = DeserializeDmlGraph(serialized.data(), rawData);
+
+    // The constant is referenced by name, and its data is returned rather than embedded.
+    ASSERT_EQ(externalConstants.size(), 1u);
+    EXPECT_EQ(externalConstants[0].name, "weights");
+    ASSERT_EQ(externalConstants[0].data.size(), sizeof(constantValues));
+    EXPECT_EQ(externalConstants[0].data.data(), constantBytes.data());
+    EXPECT_TRUE(rawData.empty());
+
+    ASSERT_EQ(desc.Nodes.size(), 2u);
+    auto& constantNode = std::get<DmlSerializedGraphNodeConstantVariant>(desc.Nodes[0].Desc);
+    EXPECT_EQ(std::get<ConstantName>(constantNode).name, "weights");
+    EXPECT_EQ(GetOperatorType(desc.Nodes[1]), DML_OPERATOR_ELEMENT_WISE_ADD);
+}
+#endif // DML_TARGET_VERSION >= 0x6200
+
+// ----------------------------------------------------------------------------
+// ACTIVATION FUSION
+// ----------------------------------------------------------------------------
+
+TEST(DirectMLXGraphTest, ActivationFusionIsOptIn)
+{
+    dml::Graph graph(nullptr);
+    EXPECT_FALSE(graph.GetActivationFusion());
+    graph.SetActivationFusion(true);
+    EXPECT_TRUE(graph.GetActivationFusion());
+}
+
+TEST(DirectMLXGraphTest, FusedAndUnfusedActivation)
+{
+    dml::Graph graph(nullptr);
+    auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    auto b = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 2, 2 }));
+    dml::Expression outputs[] = { dml::ActivationRelu(dml::Add(a, b)) };
+
+    auto unfused = GetGraphDesc(graph, outputs);
+    EXPECT_EQ(unfused.fusedActivationCount, 0u);
+    ASSERT_EQ(unfused.operatorNodes.size(), 2u);
+    ASSERT_EQ(unfused.intermediateEdges.size(), 1u);
+    EXPECT_EQ(CountIntermediateEdges(unfused, 0, 1), 1u);
+    ASSERT_EQ(unfused.outputEdges.size(), 1u);
+    EXPECT_EQ(unfused.outputEdges[0].FromNodeIndex, 1u);
+
+    // The activation is removed, and the graph output comes from the add instead.
+    dml::detail::GraphDescOptions options;
+    options.fuseActivations = true;
+    auto fused = GetGraphDesc(graph, outputs, options);
+    EXPECT_EQ(fused.fusedActivationCount, 1u);
+    ASSERT_EQ(fused.operatorNodes.size(), 1u);
+    EXPECT_EQ(fused.builderOperatorIndices[0], unfused.builderOperatorIndices[0]);
+    EXPECT_TRUE(fused.intermediateEdges.empty());
+    ASSERT_EQ(fused.outputEdges.size(), 1u);
+    EXPECT_EQ(fused.outputEdges[0].FromNodeIndex, 0u);
+    ASSERT_EQ(fused.inputEdges.size(), unfused.inputEdges.size());
+    for (size_t i = 0; i < fused.inputEdges.size(); i++)
+    {
+        EXPECT_EQ(fused.inputEdges[i].GraphInputIndex, unfused.inputEdges[i].GraphInputIndex);
+        EXPECT_EQ(fused.inputEdges[i].ToNodeIndex, 0u);
+        EXPECT_EQ(fused.inputEdges[i].ToNodeInputIndex, unfused.inputEdges[i].ToNodeInputIndex);
+    }
+}
+
+TEST(DirectMLXGraphTest, ActivationOfSharedOutputIsNotFused)
+{
+    // The add's output feeds both the activation and another operator, which must still see the value before the
+    // activation, so fusing would change the result.
+    {
+        dml::Graph graph(nullptr);
+        auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+        auto b = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 2, 2 }));
+        auto sum = dml::Add(a, b);
+        dml::Expression outputs[] = { dml::Multiply(dml::ActivationRelu(sum), sum) };
+
+        dml::detail::GraphDescOptions options;
+        options.fuseActivations = true;
+        auto desc = GetGraphDesc(graph, outputs, options);
+        EXPECT_EQ(desc.fusedActivationCount, 0u);
+        EXPECT_EQ(desc.operatorNodes.size(), 3u);
+        EXPECT_EQ(CountIntermediateEdges(desc, 0, 1), 1u);
+        EXPECT_EQ(CountIntermediateEdges(desc, 0, 2), 1u);
+    }
+
+    // The same applies when the add's output is also a graph output.
+    {
+        dml::Graph graph(nullptr);
+        auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+        auto b = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 2, 2 }));
+        auto sum = dml::Add(a, b);
+        dml::Expression outputs[] = { sum, dml::ActivationRelu(sum) };
+
+        dml::detail::GraphDescOptions options;
+        options.fuseActivations = true;
+        auto desc = GetGraphDesc(graph, outputs, options);
+        EXPECT_EQ(desc.fusedActivationCount, 0u);
+        EXPECT_EQ(desc.operatorNodes.size(), 2u);
+    }
+}
+
+TEST(DirectMLXGraphTest, FusedActivationWithTwoConsumers)
+{
+    // Consumers of the activation read the fused operator instead.
+    dml::Graph graph(nullptr);
+    auto a = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    auto b = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 2, 2 }));
+    auto relu = dml::ActivationRelu(dml::Add(a, b));
+    dml::Expression outputs[] = { dml::Multiply(relu, a), dml::Add(relu, b) };
+
+    dml::detail::GraphDescOptions options;
+    options.fuseActivations = true;
+    auto desc = GetGraphDesc(graph, outputs, options);
+    EXPECT_EQ(desc.fusedActivationCount, 1u);
+    ASSERT_EQ(desc.operatorNodes.size(), 3u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 0, 1), 1u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 0, 2), 1u);
+    EXPECT_EQ(desc.intermediateEdges.size(), 2u);
+}
+
+// ----------------------------------------------------------------------------
+// CONSTANT FOLDING
+// ----------------------------------------------------------------------------
+
+#if DML_TARGET_VERSION >= 0x6200
+TEST(DirectMLXGraphTest, FoldConstantOnlySubgraph)
+{
+    const float aValues[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    const float bValues[] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    auto aBytes = gsl::as_bytes(gsl::make_span(aValues));
+    auto bBytes = gsl::as_bytes(gsl::make_span(bValues));
+
+    dml::Graph graph(nullptr);
+    auto input = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    auto a = dml::ConstantData(graph, dml::Span<const dml::Byte>(aBytes.data(), aBytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+    auto b = dml::ConstantData(graph, dml::Span<const dml::Byte>(bBytes.data(), bBytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+
+    // (a + b) + a only reads constants, so both adds fold into one constant that the last add reads.
+    auto folded = dml::Add(dml::Add(a, b), a);
+    dml::Expression outputs[] = { dml::Add(input, folded) };
+
+    auto unfoldedDesc = GetGraphDesc(graph, outputs);
+    EXPECT_EQ(unfoldedDesc.operatorNodes.size(), 3u);
+    EXPECT_EQ(unfoldedDesc.constantNodes.size(), 2u);
+    EXPECT_EQ(unfoldedDesc.constantFoldingStats.foldedOperatorCount, 0u);
+
+    dml::detail::GraphDescOptions options;
+    options.foldConstants = true;
+    auto desc = GetGraphDesc(graph, outputs, options);
+    ASSERT_EQ(desc.operatorNodes.size(), 1u);
+    ASSERT_EQ(desc.constantNodes.size(), 1u);
+    EXPECT_EQ(desc.constantFoldingStats.foldedOperatorCount, 2u);
+    EXPECT_EQ(desc.constantFoldingStats.foldedConstantCount, 1u);
+    EXPECT_EQ(desc.constantFoldingStats.foldedConstantBytes, sizeof(aValues));
+    EXPECT_EQ(desc.constantFoldingStats.removedConstantBytes, sizeof(aValues) + sizeof(bValues));
+
+    const float expectedValues[] = { 12.0f, 24.0f, 36.0f, 48.0f };
+    ASSERT_EQ(desc.constantNodes[0].DataSize, sizeof(expectedValues));
+    EXPECT_EQ(memcmp(desc.constantNodes[0].Data, expectedValues, sizeof(expectedValues)), 0);
+
+    // The remaining add reads the graph input and the folded constant (node 1, after the operator).
+    ASSERT_EQ(desc.inputEdges.size(), 1u);
+    EXPECT_EQ(desc.inputEdges[0].ToNodeInputIndex, 0u);
+    ASSERT_EQ(desc.intermediateEdges.size(), 1u);
+    EXPECT_EQ(desc.intermediateEdges[0].FromNodeIndex, 1u);
+    EXPECT_EQ(desc.intermediateEdges[0].ToNodeIndex, 0u);
+    EXPECT_EQ(desc.intermediateEdges[0].ToNodeInputIndex, 1u);
+}
+
+TEST(DirectMLXGraphTest, GraphOutputsAreNotFolded)
+{
+    const float values[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    auto bytes = gsl::as_bytes(gsl::make_span(values));
+
+    // Graph outputs can't be connected to constant nodes.
+    dml::Graph graph(nullptr);
+    auto a = dml::ConstantData(graph, dml::Span<const dml::Byte>(bytes.data(), bytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+    dml::Expression outputs[] = { dml::Add(a, a) };
+
+    dml::detail::GraphDescOptions options;
+    options.foldConstants = true;
+    auto desc = GetGraphDesc(graph, outputs, options);
+    EXPECT_EQ(desc.operatorNodes.size(), 1u);
+    EXPECT_EQ(desc.constantNodes.size(), 1u);
+    EXPECT_EQ(desc.constantFoldingStats.foldedOperatorCount, 0u);
+}
+#endif // DML_TARGET_VERSION >= 0x6200
+
+// ----------------------------------------------------------------------------
+// DEAD OPERATOR PRUNING
+// ----------------------------------------------------------------------------
+
+#if DML_TARGET_VERSION >= 0x6200
+TEST(DirectMLXGraphTest, UnusedOperatorsAndConstantsArePruned)
+{
+    const float values[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    auto bytes = gsl::as_bytes(gsl::make_span(values));
+
+    dml::Graph graph(nullptr);
+    auto input = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 2, 2 }));
+    auto weights = dml::ConstantData(graph, dml::Span<const dml::Byte>(bytes.data(), bytes.size()), FloatTensor({ 1, 1, 2, 2 }));
+
+    // Neither the multiply (the only reader of the constant) nor the identity reading the live add contributes to
+    // the output.
+    auto unused = dml::Multiply(input, weights);
+    auto sum = dml::Add(input, input);
+    auto unusedConsumer = dml::Identity(sum);
+    dml::Expression outputs[] = { sum };
+
+    auto desc = GetGraphDesc(graph, outputs);
+    ASSERT_EQ(desc.operatorNodes.size(), 1u);
+    EXPECT_EQ(desc.builderOperatorIndices[0], 1u);
+    EXPECT_TRUE(desc.constantNodes.empty());
+    EXPECT_TRUE(desc.intermediateEdges.empty());
+    ASSERT_EQ(desc.inputEdges.size(), 2u);
+    ASSERT_EQ(desc.outputEdges.size(), 1u);
+    EXPECT_EQ(desc.outputEdges[0].FromNodeIndex, 0u);
+
+    // Serialization and memory analysis see the same pruned graph.
+    std::vector<uint8_t> serialized = graph.Serialize(outputs);
+    std::vector<std::unique_ptr<std::byte[]>> rawData;
+    DmlSerializedGraphDesc serializedDesc = DeserializeDmlGraph(serialized.data(), rawData);
+    ASSERT_EQ(serializedDesc.Nodes.size(), 1u);
+    EXPECT_EQ(GetOperatorType(serializedDesc.Nodes[0]), DML_OPERATOR_ELEMENT_WISE_ADD);
+
+    auto analysis = graph.AnalyzeMemory(outputs);
+    EXPECT_EQ(analysis.nodes.size(), 1u);
+    EXPECT_EQ(analysis.constantBytes, 0u);
+
+    // Once the multiply is an output, it and its constant are kept.
+    dml::Expression bothOutputs[] = { sum, unused };
+    auto bothDesc = GetGraphDesc(graph, bothOutputs);
+    EXPECT_EQ(bothDesc.operatorNodes.size(), 2u);
+    EXPECT_EQ(bothDesc.constantNodes.size(), 1u);
+    (void)unusedConsumer;
+}
+#endif // DML_TARGET_VERSION >= 0x6200
+
+// ----------------------------------------------------------------------------
+// LAYOUT ASSIGNMENT
+// ----------------------------------------------------------------------------
+
+TEST(DirectMLXGraphTest, LayoutAssignmentWithoutTransposes)
+{
+    // Both convolutions prefer the interleaved layout with the default costs, so the tensor between them is written
+    // interleaved and no transpose is needed. The graph output keeps the default layout.
+    dml::Graph graph(nullptr);
+    auto input = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 4, 4 }));
+    auto filter = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 1, 1 }));
+    dml::Expression outputs[] = { dml::Convolution(dml::Convolution(input, filter), filter) };
+
+    auto unassigned = GetGraphDesc(graph, outputs);
+    EXPECT_EQ(unassigned.layoutAssignmentReport.interleavedOperatorCount, 0u);
+
+    dml::LayoutCostFn defaultCost;
+    dml::detail::GraphDescOptions options;
+    options.layoutCost = &defaultCost;
+    auto desc = GetGraphDesc(graph, outputs, options);
+    EXPECT_EQ(desc.layoutAssignmentReport.interleavedOperatorCount, 2u);
+    EXPECT_TRUE(desc.layoutAssignmentReport.transposes.empty());
+    EXPECT_EQ(desc.operatorNodes.size(), 2u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 0, 1), 1u);
+}
+
+TEST(DirectMLXGraphTest, LayoutAssignmentInsertsTransposes)
+{
+    // The identity between the convolutions strongly prefers the default layout and the convolutions the interleaved
+    // one, so each tensor between them is transposed.
+    dml::LayoutCostFn cost = [](DML_OPERATOR_TYPE type, dml::TensorLayout layout)
+    {
+        const bool interleaved = layout == dml::TensorLayout::InterleavedChannel;
+        if (type == DML_OPERATOR_CONVOLUTION)
+        {
+            return interleaved ? 0.01f : 10.0f;
+        }
+        return interleaved ? 100.0f : 1.0f;
+    };
+
+    dml::Graph graph(nullptr);
+    auto input = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 4, 4 }));
+    auto filter = dml::InputTensor(graph, 1, FloatTensor({ 1, 1, 1, 1 }));
+    auto first = dml::Convolution(input, filter);
+    auto identity = dml::Identity(first);
+    dml::Expression outputs[] = { dml::Convolution(identity, filter) };
+
+    dml::detail::GraphDescOptions options;
+    options.layoutCost = &cost;
+    auto desc = GetGraphDesc(graph, outputs, options);
+
+    auto& report = desc.layoutAssignmentReport;
+    EXPECT_EQ(report.interleavedOperatorCount, 2u);
+    ASSERT_EQ(report.transposes.size(), 2u);
+    EXPECT_EQ(report.transposes[0].from, dml::TensorLayout::InterleavedChannel);
+    EXPECT_EQ(report.transposes[0].to, dml::TensorLayout::Default);
+    EXPECT_EQ(report.transposes[0].sizeInBytes, 64u);
+    EXPECT_EQ(report.transposes[1].from, dml::TensorLayout::Default);
+    EXPECT_EQ(report.transposes[1].to, dml::TensorLayout::InterleavedChannel);
+
+    // The transposes follow the three operators, and each consumer reads the transposed copy.
+    ASSERT_EQ(desc.operatorNodes.size(), 5u);
+    EXPECT_EQ(desc.builderOperatorIndices[3], UINT32_MAX);
+    EXPECT_EQ(desc.builderOperatorIndices[4], UINT32_MAX);
+    EXPECT_EQ(CountIntermediateEdges(desc, 0, 3), 1u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 3, 1), 1u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 1, 4), 1u);
+    EXPECT_EQ(CountIntermediateEdges(desc, 4, 2), 1u);
+    EXPECT_EQ(desc.intermediateEdges.size(), 4u);
+
+    // With the identity indifferent to layout, it follows the convolutions and the transposes are elided.
+    dml::LayoutCostFn indifferentCost = [&](DML_OPERATOR_TYPE type, dml::TensorLayout layout)
+    {
+        return type == DML_OPERATOR_CONVOLUTION ? cost(type, layout) : 1.0f;
+    };
+    options.layoutCost = &indifferentCost;
+    auto elided = GetGraphDesc(graph, outputs, options);
+    EXPECT_EQ(elided.layoutAssignmentReport.interleavedOperatorCount, 3u);
+    EXPECT_TRUE(elided.layoutAssignmentReport.transposes.empty());
+    EXPECT_EQ(elided.operatorNodes.size(), 3u);
+}
+
+// ----------------------------------------------------------------------------
+// MEMORY ANALYSIS
+// ----------------------------------------------------------------------------
+
+// Returns whether two tensors are live at the same time and overlap in the arena.
+static bool Collide(const dml::MemoryAnalysis::Tensor& a, const dml::MemoryAnalysis::Tensor& b)
+{
+    bool overlapInTime = a.firstStep <= b.lastStep && b.firstStep <= a.lastStep;
+    bool overlapInMemory = a.arenaOffset < b.arenaOffset + b.sizeInBytes && b.arenaOffset < a.arenaOffset + a.sizeInBytes;
+    return overlapInTime && overlapInMemory;
+}
+
+TEST(DirectMLXGraphTest, AnalyzeMemoryDiamond)
+{
+    // input -> a -> { b, c } -> d, with 16-byte tensors.
+    dml::Graph graph(nullptr);
+    auto input = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 1, 4 }));
+    auto a = dml::Identity(input);
+    auto b = dml::Identity(a);
+    auto c = dml::Identity(a, DML_SCALE_BIAS{ 2.0f, 0.0f });
+    auto d = dml::Add(b, c);
+    dml::Expression outputs[] = { d };
+
+    auto analysis = graph.AnalyzeMemory(outputs);
+    ASSERT_EQ(analysis.nodes.size(), 4u);
+    ASSERT_EQ(analysis.tensors.size(), 4u);
+    EXPECT_EQ(analysis.inputBytes, 16u);
+    EXPECT_EQ(analysis.outputBytes, 16u);
+
+    // a is live from step 0 until c reads it at step 2; b and c until d reads them at step 3.
+    auto& aTensor = analysis.tensors[0];
+    auto& bTensor = analysis.tensors[1];
+    auto& cTensor = analysis.tensors[2];
+    auto& dTensor = analysis.tensors[3];
+    EXPECT_EQ(aTensor.firstStep, 0u);
+    EXPECT_EQ(aTensor.lastStep, 2u);
+    EXPECT_EQ(bTensor.firstStep, 1u);
+    EXPECT_EQ(bTensor.lastStep, 3u);
+    EXPECT_EQ(cTensor.firstStep, 2u);
+    EXPECT_EQ(cTensor.lastStep, 3u);
+    EXPECT_TRUE(dTensor.isGraphOutput);
+
+    EXPECT_EQ(analysis.nodes[0].liveIntermediateBytes, 16u);
+    EXPECT_EQ(analysis.nodes[1].liveIntermediateBytes, 32u);
+    EXPECT_EQ(analysis.nodes[2].liveIntermediateBytes, 48u);
+    EXPECT_EQ(analysis.nodes[3].liveIntermediateBytes, 32u);
+    EXPECT_EQ(analysis.peakIntermediateBytes, 48u);
+    EXPECT_EQ(analysis.peakStep, 2u);
+
+    // All three intermediates are live at step 2, so they need separate, aligned offsets.
+    EXPECT_EQ(aTensor.arenaOffset, 0u);
+    EXPECT_EQ(bTensor.arenaOffset, 16u);
+    EXPECT_EQ(cTensor.arenaOffset, 32u);
+    EXPECT_EQ(analysis.arenaSizeInBytes, 48u);
+}
+
+TEST(DirectMLXGraphTest, AnalyzeMemoryReusesArena)
+{
+    // A chain of identities: each intermediate is only live while the next node reads it, so the arena alternates
+    // between two offsets however long the chain is. Larger tensors are placed first.
+    dml::Graph graph(nullptr);
+    auto x = dml::InputTensor(graph, 0, FloatTensor({ 1, 1, 1, 4 }));
+    x = dml::Identity(x);
+    auto wide = dml::Join(std::vector<dml::Expression>{ x, x }, 3);
+    x = dml::Identity(wide);
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        x = dml::Identity(x);
+    }
+    dml::Expression outputs[] = { x };
+
+    auto analysis = graph.AnalyzeMemory(outputs);
+    ASSERT_EQ(analysis.tensors.size(), 19u);
+    EXPECT_EQ(analysis.peakIntermediateBytes, 64u);
+    EXPECT_EQ(analysis.arenaSizeInBytes, 64u);
+
+    for (size_t i = 0; i < analysis.tensors.size(); ++i)
+    {
+        auto& tensor = analysis.tensors[i];
+        EXPECT_EQ(tensor.arenaOffset % DML_MINIMUM_BUFFER_TENSOR_ALIGNMENT, 0u);
+        if (tensor.isGraphOutput)
+        {
+            continue;
+        }
+
+        EXPECT_LE(tensor.arenaOffset + tensor.sizeInBytes, analysis.arenaSizeInBytes);
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (!analysis.tensors[j].isGraphOutput)
+            {
+                EXPECT_FALSE(Collide(tensor, analysis.tensors[j])) << "tensors " << j << " and " << i;
+            }
+        }
+    }
+}
@@ -0,0 +1,1251 @@
+#include "pch.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include "HlslShaderCache.h"
+#include "LoadGenerator.h"
+#include "Timings.h"
+#include "OnnxModelCache.h"
+#include "JsonParsers.h"
+#include "DmlDispatchFusion.h"
+#include "CommandLineArgs.h"
+#include "Logging.h"
+#include "Server.h"
+#include "Adapter.h"
+#include "Device.h"
+#include "Dispatchable.h"
+#ifndef DXCOMPILER_NONE
+#include "HlslDispatchable.h"
+#endif
+#include <rapidjson/istreamwrapper.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+// Returns a path under the temp directory that no other test (or concurrent test process) uses.
+static std::filesystem::path GetUniqueTempPath(std::string_view prefix)
+{
+    static std::mt19937_64 generator{ std::random_device{}() };
+    return std::filesystem::temp_directory_path() / fmt::format("{}_{:016x}", prefix, generator());
+}
+
+// Removes a temporary file or directory when the test ends, even if an assertion fails.
+class TempPath
+{
+public:
+    explicit TempPath(std::string_view prefix) : m_path(GetUniqueTempPath(prefix)) {}
+    ~TempPath() { std::error_code error; std::filesystem::remove_all(m_path, error); }
+    const std::filesystem::path& Get() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+};
+
+static std::vector<std::byte> MakeBytes(std::string_view text)
+{
+    auto data = reinterpret_cast<const std::byte*>(text.data());
+    return std::vector<std::byte>(data, data + text.size());
+}
+
+// ----------------------------------------------------------------------------
+// HLSL SHADER CACHE
+// ----------------------------------------------------------------------------
+
+TEST(HlslShaderCacheTest, Hash)
+{
+    // Reference values for 64-bit FNV-1a.
+    EXPECT_EQ(HlslShaderCache::Hash({}), 14695981039346656037ull);
+    EXPECT_EQ(HlslShaderCache::Hash(MakeBytes("a")), 0xaf63dc4c8601ec8cull);
+    EXPECT_EQ(HlslShaderCache::Hash(MakeBytes("foobar")), 0x85944171f73967e8ull);
+
+    // Hashing in chunks matches hashing all at once.
+    auto prefix = MakeBytes("foo");
+    auto suffix = MakeBytes("bar");
+    EXPECT_EQ(HlslShaderCache::Hash(suffix, HlslShaderCache::Hash(prefix)), HlslShaderCache::Hash(MakeBytes("foobar")));
+}
+
+TEST(HlslShaderCacheTest, StoreAndLoad)
+{
+    TempPath directory("DxDispatchHlslCache");
+    HlslShaderCache cache(directory.Get() / "nested");
+
+    EXPECT_FALSE(cache.Load("key").has_value());
+
+    HlslShaderCache::Entry entry;
+    entry.shader = MakeBytes("shader");
+    entry.reflection = MakeBytes("reflection");
+    entry.rootSignature = {};
+    ASSERT_TRUE(cache.Store("key", entry));
+
+    auto loaded = cache.Load("key");
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->shader, entry.shader);
+    EXPECT_EQ(loaded->reflection, entry.reflection);
+    EXPECT_TRUE(loaded->rootSignature.empty());
+    EXPECT_FALSE(cache.Load("other key").has_value());
+
+    // Storing under the same key replaces the entry.
+    entry.shader = MakeBytes("new shader");
+    ASSERT_TRUE(cache.Store("key", entry));
+    EXPECT_EQ(cache.Load("key")->shader, entry.shader);
+
+    // No temporary files are left behind.
+    size_t fileCount = 0;
+    for (auto& file : std::filesystem::directory_iterator(cache.GetDirectory()))
+    {
+        EXPECT_EQ(file.path().extension(), ".bin");
+        fileCount++;
+    }
+    EXPECT_EQ(fileCount, 1u);
+
+    cache.Clear();
+    EXPECT_FALSE(std::filesystem::exists(cache.GetDirectory()));
+    EXPECT_FALSE(cache.Load("key").has_value());
+}
+
+TEST(HlslShaderCacheTest, CorruptEntriesAreMisses)
+{
+    TempPath directory("DxDispatchHlslCache");
+    HlslShaderCache cache(directory.Get());
+
+    HlslShaderCache::Entry entry;
+    entry.shader = MakeBytes("shader");
+    entry.reflection = MakeBytes("reflection");
+    entry.rootSignature = MakeBytes("root signature");
+    ASSERT_TRUE(cache.Store("key", entry));
+
+    auto entryPath = std::filesystem::directory_iterator(cache.GetDirectory())->path();
+    auto fileSize = std::filesystem::file_size(entryPath);
+
+    // Truncate the entry so the last section is incomplete.
+    std::filesystem::resize_file(entryPath, fileSize - 1);
+    EXPECT_FALSE(cache.Load("key").has_value());
+
+    // Replace the first section size (the key) with a huge value.
+    ASSERT_TRUE(cache.Store("key", entry));
+    {
+        std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t hugeSize = ~0ull;
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&hugeSize), sizeof(hugeSize));
+    }
+    EXPECT_FALSE(cache.Load("key").has_value());
+
+    // Corrupt the magic.
+    ASSERT_TRUE(cache.Store("key", entry));
+    {
+        std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+        file.write("XXXX", 4);
+    }
+    EXPECT_FALSE(cache.Load("key").has_value());
+}
+
+TEST(HlslShaderCacheTest, StoreFailsWhenDirectoryIsAFile)
+{
+    TempPath path("DxDispatchHlslCache");
+    std::ofstream(path.Get()) << "not a directory";
+
+    HlslShaderCache cache(path.Get());
+    EXPECT_FALSE(cache.Store("key", {}));
+    EXPECT_FALSE(cache.Load("key").has_value());
+}
+
+TEST(HlslShaderCacheTest, DescribeSourceFiles)
+{
+    TempPath directory("DxDispatchHlslSource");
+    std::filesystem::create_directories(directory.Get() / "include");
+    auto sourcePath = directory.Get() / "shader.hlsl";
+    auto localPath = directory.Get() / "local.hlsli";
+    auto sharedPath = directory.Get() / "include" / "shared.hlsli";
+
+    std::ofstream(sourcePath) << "#include \"local.hlsli\"\n  #  include <shared.hlsli>\n// #include \"commented.hlsli\"\n";
+    std::ofstream(localPath) << "#include \"shared.hlsli\"\n#define LOCAL 1\n";
+    std::ofstream(sharedPath) << "#pragma once\n#define SHARED 1\n";
+    std::vector<std::filesystem::path> includeDirectories = { directory.Get() / "include" };
+
+    auto description = HlslShaderCache::DescribeSourceFiles(sourcePath, includeDirectories);
+    ASSERT_TRUE(description);
+    EXPECT_NE(description->find(sourcePath.lexically_normal().string()), std::string::npos) << *description;
+    EXPECT_NE(description->find(localPath.lexically_normal().string()), std::string::npos) << *description;
+    EXPECT_NE(description->find(sharedPath.lexically_normal().string()), std::string::npos) << *description;
+    EXPECT_EQ(description->find("commented.hlsli"), std::string::npos) << *description;
+
+    // Files included more than once are described once.
+    size_t sharedOffset = description->find(sharedPath.lexically_normal().string());
+    EXPECT_EQ(description->find(sharedPath.lexically_normal().string(), sharedOffset + 1), std::string::npos) << *description;
+
+    // Changing only an included file changes the description.
+    std::ofstream(sharedPath, std::ios::trunc) << "#pragma once\n#define SHARED 2\n";
+    auto changedDescription = HlslShaderCache::DescribeSourceFiles(sourcePath, includeDirectories);
+    ASSERT_TRUE(changedDescription);
+    EXPECT_NE(*description, *changedDescription);
+
+    // Bracketed includes are only found in the include directories.
+    EXPECT_FALSE(HlslShaderCache::DescribeSourceFiles(sourcePath, {}));
+
+    // Includes that need the preprocessor and missing files can't be described.
+    std::ofstream(sourcePath, std::ios::trunc) << "#define HEADER \"local.hlsli\"\n#include HEADER\n";
+    EXPECT_FALSE(HlslShaderCache::DescribeSourceFiles(sourcePath, includeDirectories));
+    std::ofstream(sourcePath, std::ios::trunc) << "#include \"missing.hlsli\"\n";
+    EXPECT_FALSE(HlslShaderCache::DescribeSourceFiles(sourcePath, includeDirectories));
+    EXPECT_FALSE(HlslShaderCache::DescribeSourceFiles(directory.Get() / "missing.hlsl", includeDirectories));
+}
+
+// ----------------------------------------------------------------------------
+// HLSL BINDINGS
+// ----------------------------------------------------------------------------
+
+#ifndef DXCOMPILER_NONE
+
+using BindingMode = Model::HlslDispatchableDesc::BindingMode;
+using RootParameterType = HlslDispatchable::RootParameterType;
+
+static D3D12_SHADER_INPUT_BIND_DESC MakeShaderInput(const char* name, D3D_SHADER_INPUT_TYPE type, uint32_t bindPoint)
+{
+    D3D12_SHADER_INPUT_BIND_DESC desc = {};
+    desc.Name = name;
+    desc.Type = type;
+    desc.BindPoint = bindPoint;
+    desc.BindCount = 1;
+    desc.Dimension = type == D3D_SIT_CBUFFER ? D3D_SRV_DIMENSION_UNKNOWN : D3D_SRV_DIMENSION_BUFFER;
+    desc.NumSamples = (type == D3D_SIT_STRUCTURED || type == D3D_SIT_UAV_RWSTRUCTURED) ? 16 : 0;
+    return desc;
+}
+
+static std::vector<D3D12_SHADER_INPUT_BIND_DESC> MakeMixedShaderInputs()
+{
+    return {
+        MakeShaderInput("constants", D3D_SIT_CBUFFER, 0),
+        MakeShaderInput("params", D3D_SIT_CBUFFER, 1),
+        MakeShaderInput("input", D3D_SIT_STRUCTURED, 0),
+        MakeShaderInput("output", D3D_SIT_UAV_RWBYTEADDRESS, 0),
+        MakeShaderInput("typed", D3D_SIT_UAV_RWTYPED, 1),
+    };
+}
+
+TEST(HlslBindingTest, RootDescriptors)
+{
+    auto shaderInputs = MakeMixedShaderInputs();
+    auto data = HlslDispatchable::ReflectBindingData(shaderInputs, BindingMode::RootDescriptors, { { "constants", 4 } });
+
+    ASSERT_EQ(data.rootParameters.size(), 4u);
+    EXPECT_EQ(data.rootParameters[0].ParameterType, D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+    EXPECT_EQ(data.rootParameters[0].Constants.Num32BitValues, 4u);
+    EXPECT_EQ(data.rootParameters[0].Constants.ShaderRegister, 0u);
+    EXPECT_EQ(data.rootParameters[1].ParameterType, D3D12_ROOT_PARAMETER_TYPE_CBV);
+    EXPECT_EQ(data.rootParameters[1].Descriptor.ShaderRegister, 1u);
+    EXPECT_EQ(data.rootParameters[2].ParameterType, D3D12_ROOT_PARAMETER_TYPE_SRV);
+    EXPECT_EQ(data.rootParameters[3].ParameterType, D3D12_ROOT_PARAMETER_TYPE_UAV);
+
+    EXPECT_EQ(data.bindPoints["constants"].rootParameterType, RootParameterType::RootConstants);
+    EXPECT_EQ(data.bindPoints["constants"].rootParameterIndex, 0u);
+    EXPECT_EQ(data.bindPoints["params"].rootParameterType, RootParameterType::RootDescriptor);
+    EXPECT_EQ(data.bindPoints["params"].rootParameterIndex, 1u);
+    EXPECT_EQ(data.bindPoints["input"].rootParameterType, RootParameterType::RootDescriptor);
+    EXPECT_EQ(data.bindPoints["input"].structureByteStride, 16u);
+    EXPECT_EQ(data.bindPoints["output"].rootParameterIndex, 3u);
+
+    // Typed buffers have no root descriptor form, so they go in the descriptor table after the root parameters.
+    EXPECT_EQ(data.bindPoints["typed"].rootParameterType, RootParameterType::DescriptorTable);
+    EXPECT_EQ(data.bindPoints["typed"].rootParameterIndex, 4u);
+    ASSERT_EQ(data.descriptorRanges.size(), 1u);
+    EXPECT_EQ(data.descriptorRanges[0].RangeType, D3D12_DESCRIPTOR_RANGE_TYPE_UAV);
+    EXPECT_EQ(data.descriptorRanges[0].BaseShaderRegister, 1u);
+    EXPECT_EQ(data.descriptorTableSize, 1u);
+}
+
+TEST(HlslBindingTest, DescriptorTable)
+{
+    auto shaderInputs = MakeMixedShaderInputs();
+    auto data = HlslDispatchable::ReflectBindingData(shaderInputs, BindingMode::DescriptorTable, { { "constants", 4 } });
+
+    // Root constants are used in either mode; everything else is a view in the table.
+    ASSERT_EQ(data.rootParameters.size(), 1u);
+    EXPECT_EQ(data.rootParameters[0].ParameterType, D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+    EXPECT_EQ(data.bindPoints["constants"].rootParameterType, RootParameterType::RootConstants);
+    for (auto name : { "params", "input", "output", "typed" })
+    {
+        EXPECT_EQ(data.bindPoints[name].rootParameterType, RootParameterType::DescriptorTable) << name;
+        EXPECT_EQ(data.bindPoints[name].rootParameterIndex, 1u) << name;
+    }
+
+    // Consecutive UAV registers share a range.
+    ASSERT_EQ(data.descriptorRanges.size(), 3u);
+    EXPECT_EQ(data.descriptorRanges[0].RangeType, D3D12_DESCRIPTOR_RANGE_TYPE_CBV);
+    EXPECT_EQ(data.descriptorRanges[1].RangeType, D3D12_DESCRIPTOR_RANGE_TYPE_SRV);
+    EXPECT_EQ(data.descriptorRanges[2].RangeType, D3D12_DESCRIPTOR_RANGE_TYPE_UAV);
+    EXPECT_EQ(data.descriptorRanges[2].NumDescriptors, 2u);
+    EXPECT_EQ(data.descriptorTableSize, 4u);
+}
+
+TEST(HlslBindingTest, RootSignatureBudget)
+{
+    // 63 DWORDs of root constants plus the descriptor table fill the 64-DWORD root signature exactly.
+    auto shaderInputs = MakeMixedShaderInputs();
+    EXPECT_NO_THROW(HlslDispatchable::ReflectBindingData(shaderInputs, BindingMode::DescriptorTable, { { "constants", 63 } }));
+    EXPECT_THROW(HlslDispatchable::ReflectBindingData(shaderInputs, BindingMode::DescriptorTable, { { "constants", 64 } }), std::invalid_argument);
+
+    // Root descriptors cost two DWORDs each: 32 fit, 33 don't.
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < 33; i++)
+    {
+        names.push_back(fmt::format("output{}", i));
+    }
+    std::vector<D3D12_SHADER_INPUT_BIND_DESC> uavs;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        uavs.push_back(MakeShaderInput(names[i].c_str(), D3D_SIT_UAV_RWSTRUCTURED, i));
+    }
+    EXPECT_NO_THROW(HlslDispatchable::ReflectBindingData(uavs, BindingMode::RootDescriptors, {}));
+    EXPECT_NO_THROW(HlslDispatchable::ReflectBindingData(uavs, BindingMode::DescriptorTable, {}));
+
+    uavs.push_back(MakeShaderInput(names[32].c_str(), D3D_SIT_UAV_RWSTRUCTURED, 32));
+    EXPECT_NO_THROW(HlslDispatchable::ReflectBindingData(uavs, BindingMode::DescriptorTable, {}));
+    try
+    {
+        HlslDispatchable::ReflectBindingData(uavs, BindingMode::RootDescriptors, {});
+        FAIL() << "Expected the root signature to exceed the DWORD limit";
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("66 DWORDs"), std::string::npos) << e.what();
+        EXPECT_NE(std::string(e.what()).find("for 33 root descriptors"), std::string::npos) << e.what();
+    }
+}
+#endif // !DXCOMPILER_NONE
+
+// ----------------------------------------------------------------------------
+// TIMINGS
+// ----------------------------------------------------------------------------
+
+TEST(TimingsTest, ConstantSamples)
+{
+    Timings timings;
+    timings.rawSamples.assign(100, 2.0);
+
+    EXPECT_EQ(timings.DetectWarmupSampleCount(), 0u);
+
+    auto stats = timings.ComputeStats(0).hot;
+    EXPECT_EQ(stats.count, 100u);
+    EXPECT_EQ(stats.median, 2.0);
+    EXPECT_EQ(stats.medianLow, 2.0);
+    EXPECT_EQ(stats.medianHigh, 2.0);
+    EXPECT_EQ(stats.MedianIntervalWidth(), 0.0);
+}
+
+TEST(TimingsTest, StepWarmup)
+{
+    // Four batches of slow samples followed by a steady state.
+    Timings timings;
+    timings.rawSamples.assign(20, 10.0);
+    timings.rawSamples.insert(timings.rawSamples.end(), 80, 1.0);
+    EXPECT_EQ(timings.DetectWarmupSampleCount(), 20u);
+
+    // At most half of the samples are treated as warmup.
+    timings.rawSamples.assign(60, 10.0);
+    timings.rawSamples.insert(timings.rawSamples.end(), 40, 1.0);
+    EXPECT_LE(timings.DetectWarmupSampleCount(), 50u);
+
+    // Too few samples for two batches.
+    timings.rawSamples = { 10.0, 10.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+    EXPECT_EQ(timings.DetectWarmupSampleCount(), 0u);
+}
+
+TEST(TimingsTest, MedianConfidenceInterval)
+{
+    // For n = 100 the interval spans the 40th to 61st order statistics, and the median is the 51st.
+    Timings timings;
+    for (int i = 100; i >= 1; i--)
+    {
+        timings.rawSamples.push_back(static_cast<double>(i));
+    }
+
+    auto stats = timings.ComputeStats(0).hot;
+    EXPECT_EQ(stats.median, 51.0);
+    EXPECT_EQ(stats.medianLow, 40.0);
+    EXPECT_EQ(stats.medianHigh, 61.0);
+    EXPECT_DOUBLE_EQ(stats.MedianIntervalWidth(), 21.0 / 51.0);
+    EXPECT_EQ(stats.p90, 90.0);
+    EXPECT_EQ(stats.p99, 99.0);
+
+    // With fewer than 8 samples the interval is the full range.
+    timings.rawSamples = { 3.0, 1.0, 2.0 };
+    stats = timings.ComputeStats(0).hot;
+    EXPECT_EQ(stats.medianLow, 1.0);
+    EXPECT_EQ(stats.medianHigh, 3.0);
+    EXPECT_DOUBLE_EQ(stats.MedianIntervalWidth(), 1.0);
+
+    // A zero median has no relative width.
+    timings.rawSamples = { 0.0, 0.0, 0.0 };
+    EXPECT_EQ(timings.ComputeStats(0).hot.MedianIntervalWidth(), std::numeric_limits<double>::infinity());
+}
+
+TEST(TimingsTest, ColdAndHotSamples)
+{
+    Timings timings;
+    timings.rawSamples = { 5.0, 4.0, 1.0, 1.0, 1.0 };
+
+    auto stats = timings.ComputeStats(2);
+    EXPECT_EQ(stats.cold.count, 2u);
+    EXPECT_EQ(stats.cold.average, 4.5);
+    EXPECT_EQ(stats.hot.count, 3u);
+    EXPECT_EQ(stats.hot.median, 1.0);
+
+    // At least one sample is always hot.
+    timings.rawSamples = { 5.0 };
+    stats = timings.ComputeStats(2);
+    EXPECT_EQ(stats.cold.count, 0u);
+    EXPECT_EQ(stats.hot.count, 1u);
+}
+
+// ----------------------------------------------------------------------------
+// PERF COUNTERS
+// ----------------------------------------------------------------------------
+
+TEST(PerfCountersTest, SnapshotDelta)
+{
+    PerfCounters before;
+    before.resourcesCreated = 2;
+    before.bytesAllocated = 1024;
+    before.fenceWaits = 1;
+    before.fenceWaitMilliseconds = 0.5;
+
+    PerfCounters after = before;
+    after.resourcesCreated += 3;
+    after.bytesAllocated += 4096;
+    after.descriptorHeapsCreated += 1;
+    after.bindingTablesCreated += 2;
+    after.commandListSubmissions += 5;
+    after.fenceWaits += 4;
+    after.fenceWaitMilliseconds += 1.25;
+
+    auto delta = after - before;
+    EXPECT_EQ(delta.resourcesCreated, 3);
+    EXPECT_EQ(delta.bytesAllocated, 4096);
+    EXPECT_EQ(delta.descriptorHeapsCreated, 1);
+    EXPECT_EQ(delta.bindingTablesCreated, 2);
+    EXPECT_EQ(delta.commandListSubmissions, 5);
+    EXPECT_EQ(delta.fenceWaits, 4);
+    EXPECT_DOUBLE_EQ(delta.fenceWaitMilliseconds, 1.25);
+}
+
+TEST(PerfCountersTest, ConcurrentUpdates)
+{
+    constexpr uint32_t threadCount = 4;
+    constexpr uint32_t incrementsPerThread = 10000;
+
+    auto before = PerfCounters::Global();
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([]
+        {
+            for (uint32_t j = 0; j < incrementsPerThread; j++)
+            {
+                DXD_PERF_COUNTER_ADD(resourcesCreated, 1);
+                DXD_PERF_COUNTER_ADD(bytesAllocated, 256);
+                DXD_PERF_COUNTER_ADD(fenceWaitNanoseconds, 1000);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto delta = PerfCounters::Global() - before;
+
+#if DXD_PERF_COUNTERS
+    // No increment is lost when several threads update the same counter.
+    EXPECT_EQ(delta.resourcesCreated, threadCount * incrementsPerThread);
+    EXPECT_EQ(delta.bytesAllocated, threadCount * incrementsPerThread * 256ull);
+    EXPECT_DOUBLE_EQ(delta.fenceWaitMilliseconds, threadCount * incrementsPerThread * 0.001);
+#else
+    // Updates are compiled out (DXD_PERF_COUNTERS=0).
+    EXPECT_EQ(delta.resourcesCreated, 0);
+    EXPECT_EQ(delta.bytesAllocated, 0);
+    EXPECT_EQ(delta.fenceWaitMilliseconds, 0);
+#endif
+    EXPECT_EQ(delta.commandListSubmissions, 0);
+}
+
+// ----------------------------------------------------------------------------
+// TRACE RECORDER
+// ----------------------------------------------------------------------------
+
+// Writes the process-wide trace (which disables the recorder) and parses the file.
+static void WriteTrace(const std::filesystem::path& path, rapidjson::Document& trace)
+{
+    TraceRecorder::Get().Write();
+    std::ifstream file(path);
+    rapidjson::IStreamWrapper stream(file);
+    trace.ParseStream(stream);
+    ASSERT_FALSE(trace.HasParseError());
+}
+
+// Returns the complete ('X') events on CPU threads by name.
+static std::map<std::string, const rapidjson::Value*> GetCpuSpans(const rapidjson::Document& trace)
+{
+    std::map<std::string, const rapidjson::Value*> spans;
+    for (auto& event : trace["traceEvents"].GetArray())
+    {
+        if (std::string_view(event["ph"].GetString()) == "X" && std::string_view(event["cat"].GetString()) == "cpu")
+        {
+            spans[event["name"].GetString()] = &event;
+        }
+    }
+    return spans;
+}
+
+static double SpanStart(const rapidjson::Value* span) { return span->FindMember("ts")->value.GetDouble(); }
+static double SpanEnd(const rapidjson::Value* span) { return SpanStart(span) + span->FindMember("dur")->value.GetDouble(); }
+
+TEST(TraceRecorderTest, NestedSpans)
+{
+    TempPath tracePath("DxDispatchTrace");
+    TraceRecorder::Get().Enable(tracePath.Get());
+    {
+        TraceScope outer("Outer");
+        {
+            TraceScope inner("Inner");
+        }
+        TraceScope second("Second");
+    }
+
+    rapidjson::Document trace;
+    WriteTrace(tracePath.Get(), trace);
+    auto spans = GetCpuSpans(trace);
+    ASSERT_EQ(spans.size(), 3);
+    auto outer = spans["Outer"], inner = spans["Inner"], second = spans["Second"];
+
+    EXPECT_EQ((*inner)["tid"].GetUint(), (*outer)["tid"].GetUint());
+    EXPECT_LE(SpanStart(outer), SpanStart(inner));
+    EXPECT_LE(SpanEnd(inner), SpanStart(second));
+    EXPECT_LE(SpanEnd(second), SpanEnd(outer));
+}
+
+TEST(TraceRecorderTest, ExceptionClosesSpans)
+{
+    TempPath tracePath("DxDispatchTrace");
+    TraceRecorder::Get().Enable(tracePath.Get());
+    {
+        TraceScope outer("Outer");
+        try
+        {
+            TraceScope inner("Inner");
+            throw std::runtime_error("Compile failed");
+        }
+        catch (const std::exception&)
+        {
+        }
+
+        // A span left open by the exception would be closed here instead of 'After'.
+        TraceScope after("After");
+    }
+
+    rapidjson::Document trace;
+    WriteTrace(tracePath.Get(), trace);
+    auto spans = GetCpuSpans(trace);
+    ASSERT_EQ(spans.size(), 3);
+    auto outer = spans["Outer"], inner = spans["Inner"], after = spans["After"];
+
+    EXPECT_LE(SpanEnd(inner), SpanStart(after));
+    EXPECT_LE(SpanStart(outer), SpanStart(inner));
+    EXPECT_LE(SpanEnd(after), SpanEnd(outer));
+}
+
+TEST(TraceRecorderTest, JsonShape)
+{
+    // Nothing is recorded while the recorder is disabled.
+    TraceRecorder::Get().IncrementCounter("TraceRecorderTest bytes", 100);
+    {
+        TraceScope ignored("Ignored");
+    }
+
+    TempPath tracePath("DxDispatchTrace");
+    TraceRecorder::Get().Enable(tracePath.Get());
+    EXPECT_TRUE(TraceRecorder::Get().IsEnabled());
+    {
+        TraceScope span("Span");
+        TraceRecorder::Get().IncrementCounter("TraceRecorderTest bytes", 3);
+        TraceRecorder::Get().IncrementCounter("TraceRecorderTest bytes", 4);
+    }
+    TraceRecorder::Get().AddGpuSpan("Gpu", 10, 5);
+
+    rapidjson::Document trace;
+    WriteTrace(tracePath.Get(), trace);
+    EXPECT_FALSE(TraceRecorder::Get().IsEnabled());
+
+    ASSERT_TRUE(trace.IsObject());
+    EXPECT_STREQ(trace["displayTimeUnit"].GetString(), "ms");
+    ASSERT_TRUE(trace["traceEvents"].IsArray());
+
+    bool hasGpuThreadName = false;
+    std::vector<uint64_t> counterValues;
+    std::vector<std::string> spanNames;
+    for (auto& event : trace["traceEvents"].GetArray())
+    {
+        ASSERT_TRUE(event.IsObject());
+        ASSERT_TRUE(event.HasMember("ph") && event["ph"].IsString());
+        ASSERT_TRUE(event.HasMember("name") && event["name"].IsString());
+        EXPECT_EQ(event["pid"].GetUint(), 1);
+        std::string_view phase = event["ph"].GetString();
+        std::string_view name = event["name"].GetString();
+
+        if (phase == "M")
+        {
+            EXPECT_EQ(name, "thread_name");
+            if (event["tid"].GetUint() == 0)
+            {
+                hasGpuThreadName = std::string_view(event["args"]["name"].GetString()) == "GPU";
+            }
+        }
+        else if (phase == "X")
+        {
+            ASSERT_TRUE(event["ts"].IsNumber() && event["dur"].IsNumber());
+            spanNames.emplace_back(name);
+            if (name == "Gpu")
+            {
+                EXPECT_STREQ(event["cat"].GetString(), "gpu");
+                EXPECT_EQ(event["tid"].GetUint(), 0);
+                EXPECT_EQ(event["ts"].GetDouble(), 10);
+                EXPECT_EQ(event["dur"].GetDouble(), 5);
+            }
+            else
+            {
+                EXPECT_STREQ(event["cat"].GetString(), "cpu");
+                EXPECT_GE(event["tid"].GetUint(), 1);
+            }
+        }
+        else
+        {
+            ASSERT_EQ(phase, "C");
+            EXPECT_EQ(name, "TraceRecorderTest bytes");
+            ASSERT_TRUE(event["ts"].IsNumber());
+            counterValues.push_back(event["args"]["value"].GetUint64());
+        }
+    }
+
+    EXPECT_TRUE(hasGpuThreadName);
+    EXPECT_EQ(spanNames, (std::vector<std::string>{ "Span", "Gpu" }));
+    EXPECT_EQ(counterValues, (std::vector<uint64_t>{ 3, 7 }));
+}
+
+// ----------------------------------------------------------------------------
+// ARRIVAL SCHEDULES
+// ----------------------------------------------------------------------------
+
+TEST(ArrivalScheduleTest, FixedRate)
+{
+    auto schedule = ArrivalSchedule::FixedRate(200);
+    EXPECT_EQ(schedule.GetProcess(), ArrivalSchedule::Process::Fixed);
+    EXPECT_EQ(schedule.Count(), std::numeric_limits<uint32_t>::max());
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(0), 0.0);
+    EXPECT_DOUBLE_EQ(schedule.ArrivalTimeInMilliseconds(3), 15.0);
+
+    EXPECT_THROW(ArrivalSchedule::FixedRate(0), std::invalid_argument);
+    EXPECT_THROW(ArrivalSchedule::FixedRate(-1), std::invalid_argument);
+    EXPECT_THROW(ArrivalSchedule::FixedRate(std::numeric_limits<double>::quiet_NaN()), std::invalid_argument);
+}
+
+TEST(ArrivalScheduleTest, PoissonIsDeterministic)
+{
+    constexpr uint32_t count = 10000;
+    auto GetArrivals = [&](ArrivalSchedule& schedule)
+    {
+        std::vector<double> arrivals;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            arrivals.push_back(schedule.ArrivalTimeInMilliseconds(i));
+        }
+        return arrivals;
+    };
+
+    auto schedule = ArrivalSchedule::Poisson(100, 7);
+    auto arrivals = GetArrivals(schedule);
+    EXPECT_EQ(arrivals[0], 0.0);
+    EXPECT_TRUE(std::is_sorted(arrivals.begin(), arrivals.end()));
+
+    // The mean gap is 1 / rate. Its standard error over 10000 gaps is 1%.
+    double meanInterval = arrivals.back() / (count - 1);
+    EXPECT_NEAR(meanInterval, 10.0, 0.5);
+
+    // The same seed gives the same arrivals, as does restarting the schedule, whatever was generated before.
+    auto sameSeed = ArrivalSchedule::Poisson(100, 7);
+    EXPECT_EQ(GetArrivals(sameSeed), arrivals);
+    schedule.Reset();
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(count - 1), arrivals.back());
+    schedule.Reset();
+    EXPECT_EQ(GetArrivals(schedule), arrivals);
+
+    // Arrivals can be requested out of order.
+    auto outOfOrder = ArrivalSchedule::Poisson(100, 7);
+    EXPECT_EQ(outOfOrder.ArrivalTimeInMilliseconds(50), arrivals[50]);
+    EXPECT_EQ(outOfOrder.ArrivalTimeInMilliseconds(10), arrivals[10]);
+
+    auto otherSeed = ArrivalSchedule::Poisson(100, 8);
+    EXPECT_NE(GetArrivals(otherSeed), arrivals);
+
+    EXPECT_THROW(ArrivalSchedule::Poisson(0, 7), std::invalid_argument);
+}
+
+TEST(ArrivalScheduleTest, FromTrace)
+{
+    TempPath path("DxDispatchArrivals");
+    std::ofstream(path.Get()) << "0\n\n  2.5\r\n2.5\n10\n";
+
+    auto schedule = ArrivalSchedule::FromTrace(path.Get());
+    EXPECT_EQ(schedule.GetProcess(), ArrivalSchedule::Process::Trace);
+    ASSERT_EQ(schedule.Count(), 4u);
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(0), 0.0);
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(1), 2.5);
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(2), 2.5);
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(3), 10.0);
+    EXPECT_THROW(schedule.ArrivalTimeInMilliseconds(4), std::out_of_range);
+
+    // Three gaps over 10 ms.
+    EXPECT_DOUBLE_EQ(schedule.RatePerSecond(), 300.0);
+
+    // Replaying doesn't change the trace.
+    schedule.Reset();
+    EXPECT_EQ(schedule.Count(), 4u);
+    EXPECT_EQ(schedule.ArrivalTimeInMilliseconds(3), 10.0);
+}
+
+TEST(ArrivalScheduleTest, FromTraceErrors)
+{
+    auto ParseTrace = [](std::string_view contents)
+    {
+        TempPath path("DxDispatchArrivals");
+        std::ofstream(path.Get()) << contents;
+        return ArrivalSchedule::FromTrace(path.Get());
+    };
+
+    EXPECT_THROW(ParseTrace("1\nsoon\n"), std::invalid_argument);
+    EXPECT_THROW(ParseTrace("1\n3\n2\n"), std::invalid_argument);
+    EXPECT_THROW(ParseTrace("-1\n"), std::invalid_argument);
+    EXPECT_THROW(ParseTrace(""), std::invalid_argument);
+    EXPECT_THROW(ParseTrace(" \n\t\n"), std::invalid_argument);
+    EXPECT_THROW(ArrivalSchedule::FromTrace(GetUniqueTempPath("DxDispatchMissing")), std::invalid_argument);
+
+    // The error names the offending line.
+    try
+    {
+        ParseTrace("1\n2\n\nsoon\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("line 4"), std::string::npos) << e.what();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// CONCURRENT STREAMS
+// ----------------------------------------------------------------------------
+
+TEST(ConcurrentStreamsTest, StreamsStartAfterEveryWarmup)
+{
+    constexpr uint32_t streamCount = 4;
+    constexpr uint32_t iterationsPerStream = 5;
+    std::atomic<uint32_t> warmups = 0;
+    std::atomic<bool> iterationBeforeAllWarmups = false;
+    std::mutex mutex;
+    std::vector<std::set<std::thread::id>> streamThreads(streamCount);
+    std::vector<uint32_t> streamIterations(streamCount);
+
+    auto RecordThread = [&](uint32_t stream)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        streamThreads[stream].insert(std::this_thread::get_id());
+    };
+
+    auto timings = RunStreamsConcurrently(streamCount, iterationsPerStream, std::nullopt, 
+        [&](uint32_t stream)
+        {
+            RecordThread(stream);
+            std::this_thread::sleep_for(std::chrono::milliseconds(stream * 5));
+            warmups++;
+        },
+        [&](uint32_t stream)
+        {
+            RecordThread(stream);
+            if (warmups < streamCount)
+            {
+                iterationBeforeAllWarmups = true;
+            }
+            streamIterations[stream]++;
+        });
+
+    EXPECT_FALSE(iterationBeforeAllWarmups);
+    ASSERT_EQ(timings.latencies.size(), streamCount);
+    std::set<std::thread::id> threads;
+    for (uint32_t stream = 0; stream < streamCount; stream++)
+    {
+        EXPECT_EQ(timings.latencies[stream].size(), iterationsPerStream);
+        EXPECT_EQ(streamIterations[stream], iterationsPerStream);
+
+        // Each stream's warmup and iterations run on one thread of its own.
+        ASSERT_EQ(streamThreads[stream].size(), 1u);
+        threads.insert(*streamThreads[stream].begin());
+    }
+    EXPECT_EQ(threads.size(), streamCount);
+    EXPECT_GE(timings.durationInMilliseconds, 0.0);
+}
+
+TEST(ConcurrentStreamsTest, TimeToRunStopsStreams)
+{
+    auto timings = RunStreamsConcurrently(2, std::numeric_limits<uint32_t>::max(), 20, 
+        [](uint32_t) {},
+        [](uint32_t) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+
+    for (auto& latencies : timings.latencies)
+    {
+        EXPECT_FALSE(latencies.empty());
+        EXPECT_LT(latencies.size(), 10000u);
+    }
+    EXPECT_GE(timings.durationInMilliseconds, 20.0);
+}
+
+TEST(ConcurrentStreamsTest, ErrorsStopEveryStream)
+{
+    // A failing iteration stops the other streams and is rethrown once every thread has finished.
+    std::atomic<uint32_t> iterations = 0;
+    EXPECT_THROW(RunStreamsConcurrently(3, std::numeric_limits<uint32_t>::max(), std::nullopt, 
+        [](uint32_t) {},
+        [&](uint32_t stream)
+        {
+            if (stream == 1 && ++iterations > 10)
+            {
+                throw std::runtime_error("stream failed");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }), std::runtime_error);
+
+    // A failing warmup stops the streams before any timed iteration runs.
+    std::atomic<bool> ranIteration = false;
+    try
+    {
+        RunStreamsConcurrently(3, 10, std::nullopt, 
+            [](uint32_t stream) { if (stream == 2) { throw std::invalid_argument("warmup failed"); } },
+            [&](uint32_t) { ranIteration = true; });
+        ADD_FAILURE() << "Expected the warmup error to be rethrown";
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_STREQ(e.what(), "warmup failed");
+    }
+    EXPECT_FALSE(ranIteration);
+}
+
+// ----------------------------------------------------------------------------
+// ONNX MODEL CACHE
+// ----------------------------------------------------------------------------
+
+static std::string ReadText(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Stages an entry whose model file holds the given contents, as ONNX Runtime would write it.
+static std::filesystem::path StageModel(const OnnxModelCache& cache, std::string_view key, std::string_view contents)
+{
+    auto stagedModelPath = cache.BeginStore(key);
+    std::ofstream(stagedModelPath, std::ios::binary) << contents;
+    std::ofstream(stagedModelPath.parent_path() / OnnxModelCache::ExternalDataFileName(), std::ios::binary) << "weights";
+    return stagedModelPath;
+}
+
+TEST(OnnxModelCacheTest, StoreAndFind)
+{
+    TempPath directory("DxDispatchOnnxCache");
+    OnnxModelCache cache(directory.Get());
+
+    EXPECT_FALSE(cache.Find("key"));
+
+    auto stagedModelPath = StageModel(cache, "key", "optimized");
+    EXPECT_FALSE(cache.Find("key")); // Staged entries aren't visible.
+
+    auto storedModelPath = cache.EndStore("key", stagedModelPath);
+    ASSERT_TRUE(storedModelPath);
+    EXPECT_FALSE(std::filesystem::exists(stagedModelPath.parent_path()));
+    EXPECT_EQ(ReadText(*storedModelPath), "optimized");
+    EXPECT_EQ(ReadText(storedModelPath->parent_path() / OnnxModelCache::ExternalDataFileName()), "weights");
+
+    auto foundModelPath = cache.Find("key");
+    ASSERT_TRUE(foundModelPath);
+    EXPECT_EQ(*foundModelPath, *storedModelPath);
+    EXPECT_FALSE(cache.Find("other key"));
+
+    // An entry without its model is a miss.
+    std::filesystem::remove(*storedModelPath);
+    EXPECT_FALSE(cache.Find("key"));
+
+    cache.Clear();
+    EXPECT_FALSE(std::filesystem::exists(directory.Get()));
+}
+
+TEST(OnnxModelCacheTest, EndStoreKeepsExistingEntry)
+{
+    TempPath directory("DxDispatchOnnxCache");
+    OnnxModelCache cache(directory.Get());
+
+    // Two processes optimize the same model; the entry stored first wins and the other's staged files are removed.
+    auto firstStagedModelPath = StageModel(cache, "key", "first");
+    auto secondStagedModelPath = StageModel(cache, "key", "second");
+    ASSERT_NE(firstStagedModelPath, secondStagedModelPath);
+
+    auto firstModelPath = cache.EndStore("key", firstStagedModelPath);
+    auto secondModelPath = cache.EndStore("key", secondStagedModelPath);
+    ASSERT_TRUE(firstModelPath && secondModelPath);
+    EXPECT_EQ(*firstModelPath, *secondModelPath);
+    EXPECT_EQ(ReadText(*secondModelPath), "first");
+    EXPECT_FALSE(std::filesystem::exists(secondStagedModelPath.parent_path()));
+}
+
+TEST(OnnxModelCacheTest, CollidingEntryIsReplaced)
+{
+    TempPath directory("DxDispatchOnnxCache");
+    OnnxModelCache cache(directory.Get());
+
+    auto modelPath = cache.EndStore("key", StageModel(cache, "key", "original"));
+    ASSERT_TRUE(modelPath);
+
+    // A different key with the same hash: the stored key doesn't match, so the entry is a miss and is replaced.
+    std::ofstream(modelPath->parent_path() / "key.txt", std::ios::binary | std::ios::trunc) << "colliding key";
+    EXPECT_FALSE(cache.Find("key"));
+
+    auto replacedModelPath = cache.EndStore("key", StageModel(cache, "key", "replacement"));
+    ASSERT_TRUE(replacedModelPath);
+    EXPECT_EQ(*replacedModelPath, *modelPath);
+    EXPECT_EQ(ReadText(*replacedModelPath), "replacement");
+    EXPECT_EQ(ReadText(replacedModelPath->parent_path() / "key.txt"), "key");
+    EXPECT_TRUE(cache.Find("key"));
+}
+
+TEST(OnnxModelCacheTest, DescribeSourceFiles)
+{
+    TempPath directory("DxDispatchOnnxSource");
+    std::filesystem::create_directories(directory.Get());
+    auto modelPath = directory.Get() / "model.onnx";
+    auto dataPath = directory.Get() / "model.onnx.data";
+
+    // A tensor's external_data entries as serialized by protobuf: { key: "location", value: "model.onnx.data" }.
+    std::string locationEntry = std::string("\x0A\x08location\x12\x0F", 12) + "model.onnx.data";
+    std::ofstream(modelPath, std::ios::binary) << "graph" << locationEntry << "more graph";
+    std::ofstream(dataPath, std::ios::binary) << "weights";
+
+    auto description = OnnxModelCache::DescribeSourceFiles(modelPath);
+    ASSERT_TRUE(description);
+    EXPECT_NE(description->find("externalData model.onnx.data "), std::string::npos) << *description;
+
+    // Changing only the external data changes the description.
+    std::ofstream(dataPath, std::ios::binary | std::ios::trunc) << "new weights";
+    auto changedDescription = OnnxModelCache::DescribeSourceFiles(modelPath);
+    ASSERT_TRUE(changedDescription);
+    EXPECT_NE(*description, *changedDescription);
+
+    // A model without external data only describes itself.
+    auto plainModelPath = directory.Get() / "plain.onnx";
+    std::ofstream(plainModelPath, std::ios::binary) << "graph";
+    auto plainDescription = OnnxModelCache::DescribeSourceFiles(plainModelPath);
+    ASSERT_TRUE(plainDescription);
+    EXPECT_EQ(plainDescription->find("externalData"), std::string::npos);
+
+    // Missing files can't be described.
+    std::filesystem::remove(dataPath);
+    EXPECT_FALSE(OnnxModelCache::DescribeSourceFiles(modelPath));
+    EXPECT_FALSE(OnnxModelCache::DescribeSourceFiles(directory.Get() / "missing.onnx"));
+}
+
+// ----------------------------------------------------------------------------
+// DML DISPATCH FUSION
+// ----------------------------------------------------------------------------
+
+// Parses a model with FLOAT32 resources A, B, and C, identity operators 'copy' ([3] to [3]) and 'reshape' ([1,3] to
+// [1,3]), and the given commands.
+static Model ParseFusionModel(std::string_view commands)
+{
+    auto json = fmt::format(R"({{
+        "resources": 
+        {{
+            "A": {{ "initialValuesDataType": "FLOAT32", "initialValues": [1, 2, 3] }},
+            "B": {{ "initialValuesDataType": "FLOAT32", "initialValues": {{ "value": 0, "valueCount": 3 }} }},
+            "C": {{ "initialValuesDataType": "FLOAT32", "initialValues": {{ "value": 0, "valueCount": 3 }} }}
+        }},
+        "dispatchables": 
+        {{
+            "copy": {{ "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "desc": {{ "InputTensor": {{ "DataType": "FLOAT32", "Sizes": [3] }}, "OutputTensor": {{ "DataType": "FLOAT32", "Sizes": [3] }} }} }},
+            "reshape": {{ "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "desc": {{ "InputTensor": {{ "DataType": "FLOAT32", "Sizes": [1, 3] }}, "OutputTensor": {{ "DataType": "FLOAT32", "Sizes": [1, 3] }} }} }}
+        }},
+        "commands": [ {} ]
+    }})", commands);
+
+    rapidjson::Document d;
+    d.Parse(json.c_str());
+    return JsonParsers::ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+}
+
+TEST(DmlDispatchFusionTest, ChainWithElidedIntermediate)
+{
+    auto model = ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "C" } },
+        { "type": "print", "resource": "C" }
+    )");
+
+    auto groups = FindDmlDispatchGroups(model);
+    ASSERT_EQ(groups.size(), 1u);
+    auto& group = groups[0];
+    EXPECT_EQ(group.name, "copy+copy");
+    EXPECT_EQ(group.commandIds, (std::vector<uint32_t>{ 0, 1 }));
+
+    auto& graph = group.graph;
+    ASSERT_EQ(graph.nodes.size(), 2u);
+    EXPECT_EQ(graph.nodeNames, (std::vector<std::string>{ "copy_0", "copy_1" }));
+
+    // B is only read by the second operator, so it becomes an intermediate edge instead of a graph output.
+    ASSERT_EQ(graph.intermediates.size(), 1u);
+    EXPECT_EQ(graph.intermediates[0].fromNodeIndex, 0u);
+    EXPECT_EQ(graph.intermediates[0].fromNodeOutputIndex, 0u);
+    EXPECT_EQ(graph.intermediates[0].toNodeIndex, 1u);
+    EXPECT_EQ(graph.intermediates[0].toNodeInputIndex, 0u);
+
+    ASSERT_EQ(graph.inputs.size(), 1u);
+    EXPECT_EQ(graph.inputs[0].name, "0:copy.InputTensor");
+    EXPECT_EQ(graph.inputs[0].toNodeIndex, 0u);
+    ASSERT_EQ(group.inputBindings.size(), 1u);
+    EXPECT_EQ(group.inputBindings[0].bindPointName, "InputTensor");
+    EXPECT_EQ(group.inputBindings[0].resourceIndex, 0u);
+
+    ASSERT_EQ(graph.outputs.size(), 1u);
+    EXPECT_EQ(graph.outputs[0].name, "1:copy.OutputTensor");
+    EXPECT_EQ(graph.outputs[0].fromNodeIndex, 1u);
+    ASSERT_EQ(group.outputBindings.size(), 1u);
+    EXPECT_EQ(group.outputBindings[0].bindPointName, "OutputTensor");
+}
+
+TEST(DmlDispatchFusionTest, IntermediateReadElsewhereIsKept)
+{
+    // B is printed after the group, so the fused graph must still write it.
+    auto model = ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "C" } },
+        { "type": "print", "resource": "B" }
+    )");
+
+    auto groups = FindDmlDispatchGroups(model);
+    ASSERT_EQ(groups.size(), 1u);
+    auto& graph = groups[0].graph;
+    EXPECT_EQ(graph.intermediates.size(), 1u);
+    ASSERT_EQ(graph.outputs.size(), 2u);
+    EXPECT_EQ(graph.outputs[0].fromNodeIndex, 0u);
+    EXPECT_EQ(graph.outputs[1].fromNodeIndex, 1u);
+}
+
+TEST(DmlDispatchFusionTest, IneligibleCommandsAreNotGrouped)
+{
+    // The consumer's tensor desc differs from the producer's.
+    EXPECT_TRUE(FindDmlDispatchGroups(ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "reshape", "bindings": { "InputTensor": "B", "OutputTensor": "C" } }
+    )")).empty());
+
+    // Another command observes the resource between the operators.
+    EXPECT_TRUE(FindDmlDispatchGroups(ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "print", "resource": "B" },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "C" } }
+    )")).empty());
+
+    // The second operator rewrites a resource that the group already read.
+    EXPECT_TRUE(FindDmlDispatchGroups(ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "A" } }
+    )")).empty());
+
+    // Independent operators don't share a resource, so there's nothing to fuse.
+    EXPECT_TRUE(FindDmlDispatchGroups(ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "C" } }
+    )")).empty());
+}
+
+TEST(DmlDispatchFusionTest, HazardSplitsGroups)
+{
+    // The third operator rewrites B, which the first group wrote, so it starts a new group with the fourth.
+    auto model = ParseFusionModel(R"(
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "C" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "C", "OutputTensor": "B" } },
+        { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "B", "OutputTensor": "A" } }
+    )");
+
+    auto groups = FindDmlDispatchGroups(model);
+    ASSERT_EQ(groups.size(), 2u);
+    EXPECT_EQ(groups[0].commandIds, (std::vector<uint32_t>{ 0, 1 }));
+    EXPECT_EQ(groups[1].commandIds, (std::vector<uint32_t>{ 2, 3 }));
+}
+
+// ----------------------------------------------------------------------------
+// SERVER
+// ----------------------------------------------------------------------------
+
+// Returns a connected client and server-side socket.
+static std::pair<LocalSocket, LocalSocket> ConnectLocalSockets(const std::filesystem::path& path)
+{
+    auto listener = LocalSocket::Listen(path);
+    auto client = LocalSocket::Connect(path);
+    return { std::move(client), listener.Accept() };
+}
+
+TEST(LocalSocketTest, RoundTrip)
+{
+    TempPath path("DxDispatchSocket");
+    auto sockets = ConnectLocalSockets(path.Get());
+    auto& client = sockets.first;
+    auto& server = sockets.second;
+
+    // Several lines in a single send are buffered and received one at a time.
+    ASSERT_TRUE(client.SendLine("first\nsecond"));
+    ASSERT_TRUE(client.SendLine(""));
+    std::string line;
+    ASSERT_TRUE(server.ReceiveLine(line));
+    EXPECT_EQ(line, "first");
+    ASSERT_TRUE(server.ReceiveLine(line));
+    EXPECT_EQ(line, "second");
+    ASSERT_TRUE(server.ReceiveLine(line));
+    EXPECT_EQ(line, "");
+
+    // A line longer than the receive chunk is reassembled.
+    std::string longLine(10000, 'x');
+    std::thread sender([&] { server.SendLine(longLine); });
+    ASSERT_TRUE(client.ReceiveLine(line));
+    sender.join();
+    EXPECT_EQ(line, longLine);
+
+    // The peer disconnecting ends the stream.
+    client = LocalSocket();
+    EXPECT_FALSE(server.ReceiveLine(line));
+}
+
+// Requests that fail before a model is loaded don't need a device.
+TEST(ServerTest, HandleRequest)
+{
+    TempPath directory("DxDispatchServer");
+    std::filesystem::create_directories(directory.Get());
+    auto sockets = ConnectLocalSockets(directory.Get() / "socket");
+    auto& client = sockets.first;
+    auto& serverSocket = sockets.second;
+
+    CommandLineArgs args;
+    auto logger = Microsoft::WRL::Make<DxDispatchConsoleLogger>();
+    Server server(nullptr, args, logger.Get());
+
+    // Handles the request and returns the final message sent to the client.
+    bool keepRunning = true;
+    auto HandleRequest = [&](std::string_view request)
+    {
+        keepRunning = server.HandleRequest(serverSocket, request);
+        std::string line;
+        EXPECT_TRUE(client.ReceiveLine(line));
+        rapidjson::Document response;
+        response.Parse(line.c_str());
+        EXPECT_TRUE(response.IsObject() && response.HasMember("type") && response.HasMember("status")) << line;
+        EXPECT_STREQ(response["type"].GetString(), "done");
+        return response;
+    };
+
+    auto ExpectError = [&](std::string_view request, std::string_view expectedMessage)
+    {
+        auto response = HandleRequest(request);
+        EXPECT_STREQ(response["status"].GetString(), "error");
+        std::string message = response.HasMember("message") ? response["message"].GetString() : "";
+        EXPECT_NE(message.find(expectedMessage), std::string::npos) << message;
+        EXPECT_TRUE(keepRunning);
+    };
+
+    auto ToJsonString = [](const std::filesystem::path& path)
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.String(path.string().c_str());
+        return std::string(buffer.GetString(), buffer.GetSize());
+    };
+
+    ExpectError("not json", "single-line JSON object");
+    ExpectError("[1, 2]", "single-line JSON object");
+    ExpectError(R"({ "type": "compile", "model": "model.json" })", "Unknown request type 'compile'");
+    ExpectError(R"({ "type": "load", "model": 1 })", "'model' field must be a string");
+
+    auto missingPath = directory.Get() / "missing.json";
+    ExpectError(fmt::format(R"({{ "type": "load", "model": {} }})", ToJsonString(missingPath)), "does not exist");
+
+    auto textPath = directory.Get() / "model.txt";
+    std::ofstream(textPath) << "{}";
+    ExpectError(fmt::format(R"({{ "type": "run", "model": {} }})", ToJsonString(textPath)), "Expected a .json or .onnx file");
+
+    auto invalidModelPath = directory.Get() / "invalid.json";
+    std::ofstream(invalidModelPath) << R"({ "resources": {}, "dispatchables": {} })";
+    ExpectError(fmt::format(R"({{ "type": "load", "model": {} }})", ToJsonString(invalidModelPath)), "commands");
+
+    // Unloading a model that isn't loaded (e.g. after a failed load) succeeds.
+    auto response = HandleRequest(fmt::format(R"({{ "type": "unload", "model": {} }})", ToJsonString(invalidModelPath)));
+    EXPECT_STREQ(response["status"].GetString(), "ok");
+    EXPECT_TRUE(keepRunning);
+
+    response = HandleRequest(R"({ "type": "shutdown" })");
+    EXPECT_STREQ(response["status"].GetString(), "ok");
+    EXPECT_FALSE(keepRunning);
+}
+
+// Records logged messages as "<level>: <message>".
+class RecordingLogger : public Microsoft::WRL::Base<IDxDispatchLogger>
+{
+public:
+    void STDMETHODCALLTYPE LogInfo(_In_ PCSTR message) final { messages.push_back(fmt::format("info: {}", message)); }
+    void STDMETHODCALLTYPE LogWarning(_In_ PCSTR message) final { messages.push_back(fmt::format("warning: {}", message)); }
+    void STDMETHODCALLTYPE LogError(_In_ PCSTR message) final { messages.push_back(fmt::format("error: {}", message)); }
+    void STDMETHODCALLTYPE LogCommandStarted(UINT32, _In_ PCSTR) final {}
+    void STDMETHODCALLTYPE LogCommandCompleted(UINT32, HRESULT, _In_opt_ PCSTR) final {}
+
+    std::vector<std::string> messages;
+};
+
+TEST(ServerTest, HandleServerMessage)
+{
+    auto logger = Microsoft::WRL::Make<RecordingLogger>();
+
+    EXPECT_EQ(HandleServerMessage(R"({ "type": "log", "level": "warning", "message": "careful" })", logger.Get()), std::nullopt);
+    EXPECT_EQ(HandleServerMessage(R"({ "type": "result", "dispatchable": "add", "iterations": 1 })", logger.Get()), std::nullopt);
+    EXPECT_EQ(HandleServerMessage(R"({ "type": "done", "status": "error", "message": "no model" })", logger.Get()), false);
+    EXPECT_EQ(HandleServerMessage(R"({ "type": "done", "status": "ok", "cached": true, "loadMs": 1, "runMs": 2.5 })", logger.Get()), true);
+    EXPECT_EQ(logger->messages, std::vector<std::string>({
+        "warning: careful",
+        "error: Server request failed: no model",
+        "info: Server: model cached in 1.0000 ms, run in 2.5000 ms" }));
+
+    // Malformed messages are protocol errors rather than crashes.
+    auto ExpectError = [&](std::string_view message, std::string_view expectedError)
+    {
+        try
+        {
+            HandleServerMessage(message, logger.Get());
+            ADD_FAILURE() << "Expected an error for " << message;
+        }
+        catch (const std::invalid_argument& e)
+        {
+            EXPECT_NE(std::string(e.what()).find(expectedError), std::string::npos) << e.what();
+        }
+    };
+
+    ExpectError("not json", "single-line JSON object");
+    ExpectError("[]", "single-line JSON object");
+    ExpectError(R"({ "level": "info" })", "Expected a string 'type' field");
+    ExpectError(R"({ "type": 1 })", "Expected a string 'type' field");
+    ExpectError(R"({ "type": "log", "level": "info" })", "Expected a string 'message' field");
+    ExpectError(R"({ "type": "log", "level": null, "message": "text" })", "Expected a string 'level' field");
+    ExpectError(R"({ "type": "done" })", "Expected a string 'status' field");
+    ExpectError(R"({ "type": "done", "status": "error" })", "Expected a string 'message' field");
+    ExpectError(R"({ "type": "done", "status": "ok", "cached": 1, "loadMs": 1, "runMs": 2 })", "Expected a bool 'cached' field");
+    ExpectError(R"({ "type": "done", "status": "ok", "cached": false, "loadMs": 1 })", "Expected a number 'runMs' field");
+}
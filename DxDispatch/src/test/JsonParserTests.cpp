@@ -6,9 +6,13 @@
 #endif
 
 #include <gtest/gtest.h>
+#include <fstream>
+#include <random>
 #include <fmt/format.h>
 #include <wrl/client.h>
 #include "JsonParsers.h"
+#include "NpyReaderWriter.h"
+#include "NpzReader.h"
 #include "DirectMLX.h"
 
 using namespace rapidjson;
@@ -1748,6 +1752,360 @@ TEST(ParseModelResourceDesc, BufferSequenceInitializer)
     }
 }
 
+TEST(ParseModelResourceDesc, BufferPackedInt4Initializers) 
+{
+    Document d;
+    d.Parse(R"({
+        "initialValuesDataType": "DML_TENSOR_DATA_TYPE_INT4", 
+        "initialValues": [1, -2, 7, -8, 3]
+    })");
+    ASSERT_FALSE(d.HasParseError());
+
+    auto result = ParseModelResourceDesc("testInt4List", "", d);
+    ASSERT_TRUE(std::holds_alternative<Model::BufferDesc>(result.value));
+    auto& desc = std::get<Model::BufferDesc>(result.value);
+    EXPECT_EQ(desc.initialValuesDataType, DML_TENSOR_DATA_TYPE_INT4);
+    EXPECT_EQ(desc.sizeInBytes, 4);
+
+    // Two elements per byte, with the first element in the low nibble.
+    constexpr uint8_t expectedBytes[] = {0xE1, 0x87, 0x03};
+    ASSERT_EQ(desc.initialValues.size(), sizeof(expectedBytes));
+    for (size_t i = 0; i < _countof(expectedBytes); i++)
+    {
+        EXPECT_EQ(static_cast<uint8_t>(desc.initialValues[i]), expectedBytes[i]);
+    }
+
+    d.Parse(R"({
+        "initialValuesDataType": "DML_TENSOR_DATA_TYPE_UINT4", 
+        "initialValues": { "valueCount": 4, "valueStart": 14, "valueDelta": 1 }
+    })");
+    ASSERT_FALSE(d.HasParseError());
+
+    result = ParseModelResourceDesc("testUInt4Sequence", "", d);
+    auto& sequenceDesc = std::get<Model::BufferDesc>(result.value);
+    ASSERT_EQ(sequenceDesc.initialValues.size(), 2);
+    EXPECT_EQ(static_cast<uint8_t>(sequenceDesc.initialValues[0]), 0xFE);
+    EXPECT_EQ(static_cast<uint8_t>(sequenceDesc.initialValues[1]), 0x10);
+
+    d.Parse(R"({
+        "initialValuesDataType": "DML_TENSOR_DATA_TYPE_UINT4", 
+        "initialValues": [16]
+    })");
+    ASSERT_FALSE(d.HasParseError());
+    EXPECT_THROW(ParseModelResourceDesc("testUInt4OutOfRange", "", d), std::invalid_argument);
+}
+
+TEST(NpyReaderWriterTest, PackedInt4RoundTrip) 
+{
+    // An odd element count leaves the last byte half used; the logical shape and data type are kept in the
+    // header's '#{'dml_data_type': ...}' annotation rather than the uint8 shape NumPy sees.
+    for (auto dataType : { DML_TENSOR_DATA_TYPE_INT4, DML_TENSOR_DATA_TYPE_UINT4 })
+    {
+        const std::vector<uint32_t> dimensions = { 3, 5 };
+        std::vector<std::byte> packedValues(8);
+        for (size_t i = 0; i < packedValues.size(); i++)
+        {
+            packedValues[i] = static_cast<std::byte>(i * 0x11 + 0x10);
+        }
+        packedValues.back() &= std::byte{0x0F};
+
+        std::vector<std::byte> fileData;
+        WriteNpy(packedValues, dataType, dimensions, fileData);
+
+        auto headerEnd = std::find(fileData.begin(), fileData.end(), std::byte{'\n'});
+        std::string header(reinterpret_cast<const char*>(fileData.data()), headerEnd - fileData.begin());
+        EXPECT_NE(header.find("'descr':'<u1'"), std::string::npos);
+        EXPECT_NE(header.find("'shape':(8,)"), std::string::npos);
+        EXPECT_NE(header.find(dataType == DML_TENSOR_DATA_TYPE_INT4 ? "'dml_data_type':'INT4'" : "'dml_data_type':'UINT4'"), std::string::npos);
+
+        DML_TENSOR_DATA_TYPE readDataType = DML_TENSOR_DATA_TYPE_UNKNOWN;
+        std::vector<uint32_t> readDimensions;
+        std::vector<std::byte> readValues;
+        ReadNpy(fileData, readDataType, readDimensions, readValues);
+        EXPECT_EQ(readDataType, dataType);
+        EXPECT_EQ(readDimensions, dimensions);
+        EXPECT_EQ(readValues, packedValues);
+    }
+}
+
+// A .npy file holding a 1D float32 array, padded so the header is 128 bytes (as NumPy writes it).
+static std::string MakeFloat32NpyFile(const std::vector<float>& values)
+{
+    std::string dictionary = fmt::format("{{'descr': '<f4', 'fortran_order': False, 'shape': ({},), }}", values.size());
+    dictionary.resize(128 - 10 - 1, ' ');
+    dictionary += '\n';
+    std::string npyFile = std::string("\x93NUMPY\x01\x00", 8) + char(dictionary.size()) + '\0' + dictionary;
+    npyFile.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+    return npyFile;
+}
+
+struct ZipMember
+{
+    std::string name;
+    uint16_t compressionMethod;
+    std::string data;
+    uint64_t uncompressedSize;
+    uint32_t crc32;
+};
+
+// A zip archive laid out as numpy.savez (stored) and numpy.savez_compressed (deflated) write it.
+static std::string MakeZipFile(const std::vector<ZipMember>& members)
+{
+    std::string zipFile;
+    auto append = [&](uint64_t value, size_t size) { zipFile.append(reinterpret_cast<const char*>(&value), size); };
+    std::vector<size_t> localHeaderOffsets;
+    for (auto& member : members)
+    {
+        localHeaderOffsets.push_back(zipFile.size());
+        append(0x04034b50, 4); append(20, 2); append(0, 2); append(member.compressionMethod, 2); append(0, 4); append(member.crc32, 4);
+        append(member.data.size(), 4); append(member.uncompressedSize, 4); append(member.name.size(), 2); append(0, 2);
+        zipFile += member.name;
+        zipFile += member.data;
+    }
+    size_t centralDirectoryOffset = zipFile.size();
+    for (size_t i = 0; i < members.size(); i++)
+    {
+        auto& member = members[i];
+        append(0x02014b50, 4); append(20, 2); append(20, 2); append(0, 2); append(member.compressionMethod, 2); append(0, 4); append(member.crc32, 4);
+        append(member.data.size(), 4); append(member.uncompressedSize, 4); append(member.name.size(), 2); append(0, 2); append(0, 2);
+        append(0, 2); append(0, 2); append(0, 4); append(localHeaderOffsets[i], 4);
+        zipFile += member.name;
+    }
+    size_t centralDirectorySize = zipFile.size() - centralDirectoryOffset;
+    append(0x06054b50, 4); append(0, 2); append(0, 2); append(members.size(), 2); append(members.size(), 2);
+    append(centralDirectorySize, 4); append(centralDirectoryOffset, 4); append(0, 2);
+    return zipFile;
+}
+
+// A zip archive with one member.
+static std::string MakeZipFile(
+    const std::string& memberName, 
+    uint16_t compressionMethod, 
+    std::string_view memberData, 
+    uint64_t uncompressedSize, 
+    uint32_t crc32)
+{
+    return MakeZipFile({ { memberName, compressionMethod, std::string(memberData), uncompressedSize, crc32 } });
+}
+
+// A unique file in the temp directory, removed when the test ends (even if an assertion fails).
+class TempFile
+{
+public:
+    explicit TempFile(std::string_view prefix, std::string_view extension)
+    {
+        static std::mt19937_64 generator{ std::random_device{}() };
+        m_path = std::filesystem::temp_directory_path() / fmt::format("{}_{:016x}{}", prefix, generator(), extension);
+    }
+    ~TempFile() { std::error_code error; std::filesystem::remove(m_path, error); }
+    const std::filesystem::path& Get() const { return m_path; }
+
+    void Write(std::string_view data) const
+    {
+        std::ofstream(m_path, std::ios::binary).write(data.data(), data.size());
+    }
+
+private:
+    std::filesystem::path m_path;
+};
+
+constexpr uint16_t c_zipStored = 0;
+constexpr uint16_t c_zipDeflated = 8;
+
+// Raw deflate streams of MakeFloat32NpyFile outputs, as written by numpy.savez_compressed (zlib level 6).
+
+// [1, 2, 3]: a single block with fixed Huffman codes.
+constexpr uint32_t c_fixedHuffmanCrc32 = 0xd140a677;
+constexpr uint8_t c_fixedHuffmanStream[] =
+{
+    0x9b,0xec,0x17,0xea,0x1b,0x10,0xc9,0xc8,0x50,0xc6,0x50,0xad,0x9e,0x92,0x5a,0x9c,
+    0x5c,0xa4,0x6e,0xa5,0xa0,0x6e,0x93,0x66,0xa2,0xae,0xa3,0xa0,0x9e,0x96,0x5f,0x54,
+    0x52,0x94,0x98,0x17,0x9f,0x5f,0x94,0x92,0x0a,0x12,0x77,0x4b,0xcc,0x29,0x4e,0x05,
+    0x8a,0x17,0x67,0x24,0x16,0xa4,0x02,0xf9,0x1a,0xc6,0x3a,0x9a,0x3a,0x0a,0xb5,0x0a,
+    0x14,0x00,0x2e,0x06,0x86,0x06,0x7b,0x06,0x06,0x06,0x07,0x20,0x72,0x00,0x00,
+};
+
+// (i * 7) % 85 for i in [0, 36): a single block with dynamic Huffman codes.
+constexpr uint32_t c_dynamicHuffmanCrc32 = 0x82429e8d;
+constexpr uint8_t c_dynamicHuffmanStream[] =
+{
+    0x9d,0xca,0x41,0x0b,0xc1,0x70,0x18,0xc7,0xf1,0x47,0x39,0x48,0x5e,0xc4,0xff,0xa0,
+    0xfe,0x53,0xbb,0x91,0x83,0x76,0x98,0x25,0x37,0xda,0x45,0x51,0x8a,0xc5,0x96,0x83,
+    0x4c,0xdb,0x92,0xc2,0x5d,0x72,0x53,0x5a,0x4e,0x3b,0x69,0x2f,0xc3,0x4b,0x70,0x74,
+    0xf4,0x52,0x7c,0x79,0x09,0x9e,0xfa,0x1c,0x9e,0x5f,0xdf,0x4b,0x7f,0xd0,0x73,0x47,
+    0x05,0xd9,0xc8,0x4e,0xcf,0xfd,0x78,0x16,0xe9,0x96,0xd2,0x56,0xd0,0xd0,0xa6,0xd2,
+    0x41,0x18,0x25,0x91,0xb7,0x9a,0x84,0xd1,0xdc,0xff,0xee,0x5d,0x6f,0x19,0xfb,0xec,
+    0xf1,0xc2,0x5b,0xfb,0xfc,0x46,0xbd,0x69,0xd6,0x4c,0x75,0x50,0xff,0x5f,0x59,0x7e,
+    0xf7,0xb6,0x45,0xa6,0x6d,0x91,0x1c,0x6f,0x54,0x1c,0x11,0x03,0x1d,0x4c,0xb1,0xc7,
+    0x19,0x37,0xe4,0x78,0xd0,0xbb,0x74,0x19,0x5e,0x28,0xb1,0x55,0x61,0x63,0x8c,0x2d,
+    0x4e,0x48,0x71,0x47,0x46,0x6f,0xd3,0xa5,0x78,0xa2,0xc8,0xa6,0x60,0x61,0x88,0x04,
+    0x47,0x5c,0x9d,0x0f,
+};
+
+static std::string_view AsString(gsl::span<const uint8_t> bytes)
+{
+    return std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+TEST(ParseModelResourceDesc, BufferNpzArchiveInitializer) 
+{
+    const std::vector<float> arrayValues = {1,2,3};
+    std::string npyFile = MakeFloat32NpyFile(arrayValues);
+    TempFile archive("DxDispatchTestArchive", ".npz");
+    archive.Write(MakeZipFile("weights.npy", c_zipStored, npyFile, npyFile.size(), c_fixedHuffmanCrc32));
+    auto& archivePath = archive.Get();
+
+    Document d;
+    d.Parse(fmt::format(R"({{ "initialValues": {{ "sourcePath": "{}#weights" }} }})", archivePath.filename().string()).c_str());
+    ASSERT_FALSE(d.HasParseError());
+
+    auto result = ParseModelResourceDesc("testNpz", archivePath.parent_path(), d);
+    auto& desc = std::get<Model::BufferDesc>(result.value);
+    EXPECT_EQ(desc.initialValuesDataType, DML_TENSOR_DATA_TYPE_FLOAT32);
+    ASSERT_EQ(desc.initialValues.size(), arrayValues.size() * sizeof(float));
+    EXPECT_EQ(memcmp(desc.initialValues.data(), arrayValues.data(), desc.initialValues.size()), 0);
+    EXPECT_EQ(desc.sourcePath, archivePath);
+
+    d.Parse(fmt::format(R"({{ "initialValues": {{ "sourcePath": "{}#missing" }} }})", archivePath.filename().string()).c_str());
+    EXPECT_THROW(ParseModelResourceDesc("testNpzMissing", archivePath.parent_path(), d), std::invalid_argument);
+}
+
+TEST(NpzArchiveTest, DeflatedMembers) 
+{
+    std::vector<float> dynamicValues;
+    for (int i = 0; i < 36; i++)
+    {
+        dynamicValues.push_back(static_cast<float>((i * 7) % 85));
+    }
+
+    // Level 0 deflate writes the data in stored blocks: a final block header, then the length and its complement.
+    std::string fixedNpyFile = MakeFloat32NpyFile({1,2,3});
+    std::string storedStream = "\x01";
+    uint16_t storedLength = static_cast<uint16_t>(fixedNpyFile.size());
+    uint16_t storedLengthComplement = ~storedLength;
+    storedStream.append(reinterpret_cast<const char*>(&storedLength), 2);
+    storedStream.append(reinterpret_cast<const char*>(&storedLengthComplement), 2);
+    storedStream += fixedNpyFile;
+
+    struct Case
+    {
+        std::string name;
+        std::string stream;
+        uint32_t crc32;
+        std::string expectedNpyFile;
+    };
+    const Case cases[] =
+    {
+        { "fixed", std::string(AsString(c_fixedHuffmanStream)), c_fixedHuffmanCrc32, fixedNpyFile },
+        { "dynamic", std::string(AsString(c_dynamicHuffmanStream)), c_dynamicHuffmanCrc32, MakeFloat32NpyFile(dynamicValues) },
+        { "stored", storedStream, c_fixedHuffmanCrc32, fixedNpyFile },
+    };
+
+    for (auto& testCase : cases)
+    {
+        SCOPED_TRACE(testCase.name);
+        TempFile archive("DxDispatchTestArchive", ".npz");
+        archive.Write(MakeZipFile("weights.npy", c_zipDeflated, testCase.stream, testCase.expectedNpyFile.size(), testCase.crc32));
+
+        NpzArchive npz(archive.Get());
+        EXPECT_TRUE(npz.Contains("weights"));
+        auto npyFile = npz.ReadArrayFile("weights");
+        EXPECT_EQ(std::string(reinterpret_cast<const char*>(npyFile.data()), npyFile.size()), testCase.expectedNpyFile);
+    }
+}
+
+TEST(NpzArchiveTest, InvalidMembers) 
+{
+    auto npyFileSize = MakeFloat32NpyFile({1,2,3}).size();
+    auto stream = std::string(AsString(c_dynamicHuffmanStream));
+    auto dynamicNpyFileSize = 128 + 36 * sizeof(float);
+
+    auto ExpectReadFailure = [](const std::string& zipFile)
+    {
+        TempFile archive("DxDispatchTestArchive", ".npz");
+        archive.Write(zipFile);
+        NpzArchive npz(archive.Get());
+        EXPECT_THROW(npz.ReadArrayFile("weights"), std::ios::failure);
+    };
+
+    {
+        SCOPED_TRACE("truncated stream");
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, stream.substr(0, stream.size() / 2), dynamicNpyFileSize, c_dynamicHuffmanCrc32));
+    }
+    {
+        SCOPED_TRACE("corrupt stream");
+        std::string corruptStream = stream;
+        corruptStream[corruptStream.size() / 2] ^= 0x10;
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, corruptStream, dynamicNpyFileSize, c_dynamicHuffmanCrc32));
+    }
+    {
+        SCOPED_TRACE("invalid block type");
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, "\x07", npyFileSize, c_fixedHuffmanCrc32));
+    }
+    {
+        SCOPED_TRACE("wrong declared size");
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, AsString(c_fixedHuffmanStream), npyFileSize + 1, c_fixedHuffmanCrc32));
+    }
+    {
+        SCOPED_TRACE("CRC mismatch");
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, AsString(c_fixedHuffmanStream), npyFileSize, c_fixedHuffmanCrc32 ^ 1));
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipStored, MakeFloat32NpyFile({1,2,4}), npyFileSize, c_fixedHuffmanCrc32));
+    }
+    {
+        SCOPED_TRACE("implausible compression ratio");
+        ExpectReadFailure(MakeZipFile("weights.npy", c_zipDeflated, AsString(c_fixedHuffmanStream), 0xFFFFFFF0, c_fixedHuffmanCrc32));
+    }
+}
+
+TEST(NpzArchiveTest, MembersShareTheArchiveFile) 
+{
+    std::string fixedNpyFile = MakeFloat32NpyFile({1,2,3});
+    std::string corruptNpyFile = MakeFloat32NpyFile({1,2,4});
+    TempFile archive("DxDispatchTestArchive", ".npz");
+    archive.Write(MakeZipFile({
+        { "stored.npy", c_zipStored, fixedNpyFile, fixedNpyFile.size(), c_fixedHuffmanCrc32 },
+        { "corrupt.npy", c_zipStored, corruptNpyFile, corruptNpyFile.size(), c_fixedHuffmanCrc32 },
+        { "deflated.npy", c_zipDeflated, std::string(AsString(c_fixedHuffmanStream)), fixedNpyFile.size(), c_fixedHuffmanCrc32 },
+    }));
+
+    // Members are read in any order and more than once, and a failed read doesn't affect later reads.
+    NpzArchive npz(archive.Get());
+    auto ExpectArray = [&](std::string_view arrayName)
+    {
+        SCOPED_TRACE(arrayName);
+        auto npyFile = npz.ReadArrayFile(arrayName);
+        EXPECT_EQ(std::string(reinterpret_cast<const char*>(npyFile.data()), npyFile.size()), fixedNpyFile);
+    };
+
+    ExpectArray("deflated");
+    ExpectArray("stored");
+    EXPECT_THROW(npz.ReadArrayFile("corrupt"), std::ios::failure);
+    ExpectArray("deflated");
+    EXPECT_THROW(npz.ReadArrayFile("missing"), std::invalid_argument);
+    ExpectArray("stored");
+}
+
+TEST(NpzArchiveTest, CentralDirectoryPastEndOfFile) 
+{
+    // Sizes and offsets in the end of central directory record are checked against the file size before reading.
+    std::string zipFile = MakeZipFile("weights.npy", c_zipStored, "", 0, 0);
+    std::string endRecord = zipFile.substr(zipFile.size() - 22);
+    zipFile.resize(zipFile.size() - 22);
+
+    uint32_t hugeSize = 0xFFFFFF00;
+    std::string oversizedEndRecord = endRecord;
+    oversizedEndRecord.replace(12, 4, reinterpret_cast<const char*>(&hugeSize), 4);
+    std::string misplacedEndRecord = endRecord;
+    misplacedEndRecord.replace(16, 4, reinterpret_cast<const char*>(&hugeSize), 4);
+
+    for (auto& record : { oversizedEndRecord, misplacedEndRecord })
+    {
+        TempFile archive("DxDispatchTestArchive", ".npz");
+        archive.Write(zipFile + record);
+        EXPECT_THROW(NpzArchive npz(archive.Get()), std::ios::failure);
+    }
+}
+
 // ----------------------------------------------------------------------------
 // Model::DmlDispatchableDesc
 // ----------------------------------------------------------------------------
@@ -1842,6 +2200,38 @@ TEST(ParseModelDispatchableDesc, HlslAdd)
     EXPECT_EQ(modelHlslOpDesc.compilerArgs[5], "NUM_THREADS=4");
 }
 
+TEST(ParseModelDispatchableDesc, HlslRootBindings) 
+{
+    Document d;
+    d.Parse(R"({
+        "type": "hlsl",
+        "sourcePath": "c:/foo/bar/test.hlsl",
+        "compilerArgs": [ "-T", "cs_6_0", "-E", "CSMain" ],
+        "bindingMode": "rootDescriptors",
+        "rootConstants": 
+        {
+            "constants": 
+            [
+                { "name": "elementCount", "type": "UINT32", "value": 6 },
+                { "name": "alpha", "type": "FLOAT32", "value": 0.5 }
+            ]
+        }
+    })");
+    ASSERT_FALSE(d.HasParseError());
+
+    BucketAllocator allocator;
+    auto result = ParseModelDispatchableDesc("my test operator", "", d, allocator);
+    ASSERT_TRUE(std::holds_alternative<Model::HlslDispatchableDesc>(result.value));
+    auto modelHlslOpDesc = std::get<Model::HlslDispatchableDesc>(result.value);
+
+    EXPECT_EQ(modelHlslOpDesc.bindingMode, Model::HlslDispatchableDesc::BindingMode::RootDescriptors);
+    ASSERT_EQ(modelHlslOpDesc.rootConstants.size(), 1);
+    auto& values = modelHlslOpDesc.rootConstants["constants"];
+    ASSERT_EQ(values.size(), 8);
+    EXPECT_EQ(*reinterpret_cast<const uint32_t*>(values.data() + 0), 6);
+    EXPECT_EQ(*reinterpret_cast<const float*>(values.data() + 4), 0.5f);
+}
+
 // ----------------------------------------------------------------------------
 // ParseModelCommand
 // ----------------------------------------------------------------------------
@@ -2005,4 +2395,259 @@ TEST(ParseExecuteCommandTest, ArrayBindings)
         EXPECT_EQ(binding->second[0].elementSizeInBytes, 0);
         EXPECT_EQ(binding->second[0].format, std::nullopt);
     }
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------------------------------
+// MODEL
+// ----------------------------------------------------------------------------
+
+TEST(ModelTest, InternedIdsAndBindingPlans) 
+{
+    std::string json = R"({
+        "resources": 
+        {
+            "A": { "initialValuesDataType": "FLOAT32", "initialValues": [1, 2, 3] },
+            "B": { "initialValuesDataType": "FLOAT32", "initialValues": { "value": 0, "valueCount": 3 } }
+        },
+        "dispatchables": 
+        {
+            "copy": { "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "desc": { "InputTensor": { "DataType": "FLOAT32", "Sizes": [3] }, "OutputTensor": { "DataType": "FLOAT32", "Sizes": [3] } } }
+        },
+        "commands": 
+        [
+            { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } },
+            { "type": "print", "resource": "B" }
+        ]
+    })";
+
+    Document d;
+    d.Parse(json.c_str());
+    ASSERT_FALSE(d.HasParseError());
+
+    auto model = ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+
+    EXPECT_EQ(model.GetResourceId("A"), 0);
+    EXPECT_EQ(model.GetResourceId("B"), 1);
+    EXPECT_EQ(model.GetResourceId("C"), Model::InvalidId);
+    EXPECT_EQ(model.GetDispatchableId("copy"), 0);
+    EXPECT_EQ(model.GetResource(model.GetResourceId("B")).name, "B");
+
+    auto commands = model.GetCommands();
+    ASSERT_EQ(commands.size(), 2);
+
+    auto& dispatchCommand = std::get<Model::DispatchCommand>(commands[0].command);
+    EXPECT_EQ(dispatchCommand.dispatchableId, 0);
+    ASSERT_NE(dispatchCommand.bindingPlanId, Model::InvalidId);
+
+    auto& plan = model.GetBindingPlan(dispatchCommand.bindingPlanId);
+    ASSERT_EQ(plan.targets.size(), 2);
+    ASSERT_EQ(plan.sources.size(), 2);
+    EXPECT_TRUE(plan.deferredSources.empty());
+    for (auto& target : plan.targets)
+    {
+        ASSERT_EQ(target.sourceCount, 1);
+        auto& source = plan.sources[target.firstSourceIndex];
+        EXPECT_EQ(source.resourceId, target.name == "InputTensor" ? 0 : 1);
+        EXPECT_EQ(source.counterResourceId, Model::InvalidId);
+    }
+
+    auto& printCommand = std::get<Model::PrintCommand>(commands[1].command);
+    EXPECT_EQ(printCommand.resourceId, 1);
+}
+
+TEST(ModelTest, ReleaseHostData) 
+{
+    std::string json = R"({
+        "resources": 
+        {
+            "A": { "initialValuesDataType": "FLOAT16", "initialValues": [1, 2, 3] },
+            "B": { "initialValuesDataType": "FLOAT16", "initialValues": { "value": 0, "valueCount": 3 } }
+        },
+        "dispatchables": 
+        {
+            "copy": { "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "desc": { "InputTensor": { "DataType": "FLOAT16", "Sizes": [3] }, "OutputTensor": { "DataType": "FLOAT16", "Sizes": [3] } } }
+        },
+        "commands": 
+        [
+            { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "B" } }
+        ]
+    })";
+
+    Document d;
+    d.Parse(json.c_str());
+    ASSERT_FALSE(d.HasParseError());
+
+    auto model = ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+    auto& bufferDesc = std::get<Model::BufferDesc>(model.GetResource("A").value);
+    EXPECT_EQ(bufferDesc.InitialValuesSizeInBytes(), 6);
+    EXPECT_FALSE(model.InitialValuesReleased());
+
+    model.ReleaseInitialValues();
+    EXPECT_TRUE(model.InitialValuesReleased());
+    EXPECT_TRUE(bufferDesc.initialValues.empty());
+    EXPECT_EQ(bufferDesc.InitialValuesSizeInBytes(), 6);
+    EXPECT_EQ(bufferDesc.initialValuesDataType, DML_TENSOR_DATA_TYPE_FLOAT16);
+
+    // Releasing again keeps the recorded sizes.
+    model.ReleaseInitialValues();
+    EXPECT_EQ(bufferDesc.InitialValuesSizeInBytes(), 6);
+
+    auto& dmlDesc = std::get<Model::DmlDispatchableDesc>(model.GetDispatchable("copy").value);
+    EXPECT_NE(dmlDesc.desc, nullptr);
+    model.ReleaseOperatorDescs();
+    EXPECT_EQ(dmlDesc.desc, nullptr);
+    EXPECT_EQ(dmlDesc.bindPoints.inputs.size(), 1);
+}
+
+TEST(ModelTest, SweepExpansion) 
+{
+    std::string json = R"({
+        "sweeps": 
+        {
+            "copy": 
+            {
+                "parameters": 
+                {
+                    "M": { "start": 2, "stop": 6, "step": 4 },
+                    "dataType": [ "FLOAT16", "FLOAT32" ]
+                },
+                "dispatchable": 
+                {
+                    "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY",
+                    "desc": 
+                    {
+                        "InputTensor": { "DataType": "$dataType", "Sizes": [ "$M" ] },
+                        "OutputTensor": { "DataType": "${dataType}", "Sizes": [ "$M" ] }
+                    }
+                }
+            }
+        }
+    })";
+
+    Document d;
+    d.Parse(json.c_str());
+    ASSERT_FALSE(d.HasParseError());
+
+    auto model = ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+
+    ASSERT_EQ(model.GetSweeps().size(), 1);
+    auto& sweep = model.GetSweeps()[0];
+    EXPECT_EQ(sweep.name, "copy");
+    ASSERT_EQ(sweep.parameterNames.size(), 2);
+    EXPECT_EQ(sweep.parameterNames[0], "M");
+    EXPECT_EQ(sweep.parameterNames[1], "dataType");
+
+    // The first parameter varies slowest.
+    ASSERT_EQ(sweep.points.size(), 4);
+    EXPECT_EQ(sweep.points[0].dispatchableName, "copy(M=2,dataType=FLOAT16)");
+    EXPECT_EQ(sweep.points[1].dispatchableName, "copy(M=2,dataType=FLOAT32)");
+    EXPECT_EQ(sweep.points[2].dispatchableName, "copy(M=6,dataType=FLOAT16)");
+    EXPECT_EQ(sweep.points[3].dispatchableName, "copy(M=6,dataType=FLOAT32)");
+    EXPECT_EQ(sweep.points[3].parameterValues, (std::vector<std::string>{ "6", "FLOAT32" }));
+    for (uint32_t i = 0; i < sweep.points.size(); i++)
+    {
+        EXPECT_EQ(sweep.points[i].dispatchableId, i);
+    }
+
+    // All points share one buffer per bind point, sized for the largest point.
+    for (auto resourceName : { "copy.InputTensor", "copy.OutputTensor" })
+    {
+        auto resourceId = model.GetResourceId(resourceName);
+        ASSERT_NE(resourceId, Model::InvalidId);
+        EXPECT_EQ(std::get<Model::BufferDesc>(model.GetResource(resourceId).value).sizeInBytes, 24);
+    }
+
+    auto commands = model.GetCommands();
+    ASSERT_EQ(commands.size(), 4);
+    for (uint32_t i = 0; i < commands.size(); i++)
+    {
+        auto& dispatchCommand = std::get<Model::DispatchCommand>(commands[i].command);
+        EXPECT_EQ(dispatchCommand.dispatchableId, i);
+        EXPECT_EQ(dispatchCommand.bindings.at("InputTensor")[0].name, "copy.InputTensor");
+        EXPECT_EQ(dispatchCommand.bindings.at("OutputTensor")[0].name, "copy.OutputTensor");
+    }
+}
+
+TEST(ModelTest, SweepNameCollisions) 
+{
+    // Returns a model with a single-point sweep named 'copy', along with the given resources and dispatchables.
+    auto ParseSweepModel = [](std::string_view resources, std::string_view dispatchables)
+    {
+        std::string json = fmt::format(R"({{
+            "resources": {{ {} }},
+            "dispatchables": {{ {} }},
+            "commands": [],
+            "sweeps": 
+            {{
+                "copy": 
+                {{
+                    "parameters": {{ "M": [ 4 ] }},
+                    "dispatchable": 
+                    {{
+                        "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY",
+                        "desc": 
+                        {{
+                            "InputTensor": {{ "DataType": "FLOAT32", "Sizes": [ "$M" ] }},
+                            "OutputTensor": {{ "DataType": "FLOAT32", "Sizes": [ "$M" ] }}
+                        }}
+                    }}
+                }}
+            }}
+        }})", resources, dispatchables);
+
+        Document d;
+        d.Parse(json.c_str());
+        EXPECT_FALSE(d.HasParseError());
+        return ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+    };
+
+    constexpr std::string_view identity = R"({ "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "desc": { "InputTensor": { "DataType": "FLOAT32", "Sizes": [4] }, "OutputTensor": { "DataType": "FLOAT32", "Sizes": [4] } } })";
+    constexpr std::string_view buffer = R"({ "initialValuesDataType": "FLOAT32", "initialValues": [1, 2, 3, 4] })";
+
+    EXPECT_NO_THROW(ParseSweepModel(fmt::format(R"("copy": {})", buffer), fmt::format(R"("copy": {})", identity)));
+    EXPECT_THROW(ParseSweepModel(fmt::format(R"("copy.InputTensor": {})", buffer), ""), std::invalid_argument);
+    EXPECT_THROW(ParseSweepModel(fmt::format(R"("copy.OutputTensor": {})", buffer), ""), std::invalid_argument);
+    EXPECT_THROW(ParseSweepModel("", fmt::format(R"("copy(M=4)": {})", identity)), std::invalid_argument);
+}
+
+TEST(ModelTest, ApplyOverlay) 
+{
+    std::string json = R"({
+        "resources": 
+        {
+            "A": { "initialValuesDataType": "FLOAT32", "initialValues": [1, 2, 3] }
+        },
+        "dispatchables": 
+        {
+            "copy": { "type": "DML_OPERATOR_ELEMENT_WISE_IDENTITY", "executionFlags": "DML_EXECUTION_FLAG_DESCRIPTORS_VOLATILE", "desc": { "InputTensor": { "DataType": "FLOAT32", "Sizes": [3] }, "OutputTensor": { "DataType": "FLOAT32", "Sizes": [3] } } }
+        },
+        "commands": 
+        [
+            { "type": "dispatch", "dispatchable": "copy", "bindings": { "InputTensor": "A", "OutputTensor": "A" } }
+        ]
+    })";
+
+    Document d;
+    d.Parse(json.c_str());
+    ASSERT_FALSE(d.HasParseError());
+    auto model = ParseModel(d, json, std::filesystem::current_path(), std::filesystem::current_path());
+
+    Document overlay;
+    overlay.Parse(R"({
+        "dispatchables": 
+        {
+            "copy": { "executionFlags": [ "DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION" ], "dmlCompileType": "DmlCompileGraph" }
+        }
+    })");
+    ASSERT_FALSE(overlay.HasParseError());
+    ApplyModelOverlay(model, overlay);
+
+    auto& desc = std::get<Model::DmlDispatchableDesc>(model.GetDispatchable(model.GetDispatchableId("copy")).value);
+    EXPECT_EQ(desc.executionFlags, DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION);
+    EXPECT_EQ(desc.compileType, Model::DmlDispatchableDesc::DmlCompileType::DmlCompileGraph);
+
+    Document badOverlay;
+    badOverlay.Parse(R"({ "dispatchables": { "missing": { "dmlCompileType": "DmlCompileOp" } } })");
+    ASSERT_FALSE(badOverlay.HasParseError());
+    EXPECT_THROW(ApplyModelOverlay(model, badOverlay), std::invalid_argument);
+}
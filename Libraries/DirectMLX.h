@@ -15,6 +15,9 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <vector>
 #include <array>
 #include <deque>
@@ -23,6 +26,7 @@
 #include <type_traits>
 #include <functional>
 #include <stack>
+#include <string>
 
 #include <wrl/client.h> // For Microsoft::WRL::ComPtr
 
@@ -46,6 +50,16 @@
     #include <string_view>
 #endif
 
+// Graph::Serialize reuses the DxDispatch DirectMLHelpers (DxDispatch/src/dxdispatch/DirectMLHelpers) and FlatBuffers.
+// The helpers' schema headers (DirectMLSchema.h, GeneratedSchemaTypes.h, SchemaHelpers.h, GeneratedSchemaHelpers.h,
+// and AbstractOperatorDescImpl.h) must be included before this header. The same helpers let the graph keep a copy of
+// each operator desc, so operators are only created when the graph is compiled (see the Graph constructor).
+#if DMLX_USE_GRAPH_SERIALIZATION
+    #include <string>
+    #include <unordered_set>
+    #include "DmlGraphSerialization.h"
+#endif
+
 /** Calculates the minimum number of bytes required to store a buffer tensor with the specified type, sizes, and
     strides. The formula can be expressed as the following:
 
@@ -526,26 +540,355 @@ namespace dml
         }
     };
 
+    // Represents an activation to be fused with an existing operator. The meaning of param1 and param2 depend on the
+    // activation to be fused.
+    // 
+    // For HARD_SIGMOID, LINEAR, PARAMETRIC_SOFTPLUS, and SCALED_TANH: param1 = Alpha and param2 = Beta
+    // For ELU, LEAKY_RELU, THRESHOLDED_RELU, and CELU: param1 = Alpha. param2 is unused.
+    // For SCALED_ELU, param1 = Alpha and param2 = Gamma.
+    // For SHRINK, param1 = Bias and param2 = Threshold
+    // For SOFTPLUS, param1 = Steepness.
+    // For all other activations, both param1 and param2 are unused.
+    struct FusedActivation
+    {
+        DML_OPERATOR_TYPE activation = DML_OPERATOR_INVALID;
+        float param1 = 0.0f;
+        float param2 = 0.0f;
+
+        FusedActivation() = default;
+
+        explicit FusedActivation(DML_OPERATOR_TYPE activation, float param1 = 0.0f, float param2 = 0.0f)
+            : activation(activation), param1(param1), param2(param2)
+        {}
+
+        static FusedActivation None()
+        {
+            return FusedActivation();
+        }
+
+        static FusedActivation Elu(float alpha = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_ELU, alpha);
+        }
+
+        static FusedActivation HardSigmoid(float alpha = 0.2f, float beta = 0.5f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_HARD_SIGMOID, alpha, beta);
+        }
+
+        static FusedActivation Identity()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_IDENTITY);
+        }
+
+        static FusedActivation LeakyRelu(float alpha = 0.01f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_LEAKY_RELU, alpha);
+        }
+
+        static FusedActivation Linear(float alpha, float beta)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_LINEAR, alpha, beta);
+        }
+
+        static FusedActivation ParametricSoftplus(float alpha, float beta)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS, alpha, beta);
+        }
+
+        static FusedActivation Relu()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_RELU);
+        }
+
+        static FusedActivation ScaledElu(float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_ELU, alpha, gamma);
+        }
+
+        static FusedActivation ScaledTanh(float alpha = 1.0f, float beta = 0.5f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_TANH, alpha, beta);
+        }
+
+        static FusedActivation Sigmoid()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SIGMOID);
+        }
+
+        static FusedActivation Softplus(float steepness = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTPLUS, steepness);
+        }
+
+        static FusedActivation Softsign()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTSIGN);
+        }
+
+        static FusedActivation Tanh()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_TANH);
+        }
+
+        static FusedActivation ThresholdedRelu(float alpha = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU, alpha);
+        }
+
+        static FusedActivation Shrink(float bias = 0.0f, float threshold = 0.5f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SHRINK, bias, threshold);
+        }
+
+        static FusedActivation Celu(float alpha = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_CELU, alpha);
+        }
+
+#if DML_TARGET_VERSION >= 0x5100
+        static FusedActivation Gelu()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_GELU);
+        }
+#endif // DML_TARGET_VERSION >= 0x5100
+    };
+
+    // Results of the constant folding pass in Graph::Compile; see Graph::SetConstantFolding.
+    struct ConstantFoldingStats
+    {
+        uint32_t foldedOperatorCount = 0; // Operators evaluated on the CPU instead of in the compiled graph
+        uint32_t foldedConstantCount = 0; // Constant nodes added to the graph to hold their results
+        uint64_t foldedConstantBytes = 0; // Size of the constant data added
+        uint64_t removedConstantBytes = 0; // Size of the ConstantData no longer referenced by the graph
+    };
+
+    // Static memory footprint of a graph, computed by Graph::AnalyzeMemory from the tensor descs alone.
+    struct MemoryAnalysis
+    {
+        // An output of an operator node.
+        struct Tensor
+        {
+            uint32_t node; // Index in `nodes` of the producer
+            uint32_t outputIndex;
+            uint64_t sizeInBytes;
+
+            // The tensor is live from the step its producer executes through the step of its last consumer,
+            // inclusive. Steps are indices into `nodes`. Graph outputs are live until the end of the graph.
+            uint32_t firstStep;
+            uint32_t lastStep;
+
+            bool isGraphOutput;
+
+            // Offset of an intermediate tensor in a single arena shared by all intermediates (see arenaSizeInBytes).
+            uint64_t arenaOffset;
+        };
+
+        // An operator node, in execution (topological) order.
+        struct Node
+        {
+            std::string name;
+            DML_OPERATOR_TYPE type;
+            uint64_t estimatedOps; // Rough count of arithmetic operations (a multiply-add counts as two)
+            uint64_t bytesRead;
+            uint64_t bytesWritten;
+            uint64_t liveIntermediateBytes; // Total size of the intermediate tensors live while this node executes
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Tensor> tensors;
+
+        uint64_t inputBytes = 0;
+        uint64_t outputBytes = 0;
+        uint64_t constantBytes = 0;
+        uint64_t estimatedOps = 0;
+
+        // The largest liveIntermediateBytes of any node: the intermediate memory needed with perfect reuse.
+        uint64_t peakIntermediateBytes = 0;
+        uint32_t peakStep = 0;
+
+        // Size of an arena holding every intermediate at a fixed offset, assigned greedily largest first so that
+        // tensors with overlapping lifetimes don't overlap in memory. At least peakIntermediateBytes.
+        uint64_t arenaSizeInBytes = 0;
+
+        // Returns the indices in `tensors` of the largest tensors, largest first.
+        std::vector<uint32_t> GetLargestTensors(size_t count) const
+        {
+            std::vector<uint32_t> indices(tensors.size());
+            for (uint32_t i = 0; i < indices.size(); ++i)
+            {
+                indices[i] = i;
+            }
+
+            count = std::min(count, indices.size());
+            std::partial_sort(indices.begin(), indices.begin() + count, indices.end(), [this](uint32_t a, uint32_t b)
+            {
+                return tensors[a].sizeInBytes > tensors[b].sizeInBytes;
+            });
+            indices.resize(count);
+            return indices;
+        }
+
+        // Returns a human-readable summary followed by the largest tensors.
+        std::string ToString(size_t largestTensorCount = 10) const
+        {
+            std::string text;
+            text += "Nodes: " + std::to_string(nodes.size()) + "\n";
+            text += "Estimated ops: " + std::to_string(estimatedOps) + "\n";
+            text += "Input bytes: " + std::to_string(inputBytes) + "\n";
+            text += "Output bytes: " + std::to_string(outputBytes) + "\n";
+            text += "Constant bytes: " + std::to_string(constantBytes) + "\n";
+            text += "Peak intermediate bytes: " + std::to_string(peakIntermediateBytes);
+            if (!nodes.empty())
+            {
+                text += " (step " + std::to_string(peakStep) + ", '" + nodes[peakStep].name + "')";
+            }
+            text += "\n";
+            text += "Arena bytes: " + std::to_string(arenaSizeInBytes) + "\n";
+            text += "Largest tensors:\n";
+            for (uint32_t tensorIndex : GetLargestTensors(largestTensorCount))
+            {
+                const Tensor& tensor = tensors[tensorIndex];
+                text += "  " + nodes[tensor.node].name + ":" + std::to_string(tensor.outputIndex) + " " +
+                    std::to_string(tensor.sizeInBytes) + " bytes, steps " + std::to_string(tensor.firstStep) + "-" +
+                    std::to_string(tensor.lastStep) + (tensor.isGraphOutput ? ", graph output" : "") + "\n";
+            }
+            return text;
+        }
+    };
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+    // The data of a constant node that Graph::Serialize references by name instead of embedding in the graph.
+    struct SerializedConstant
+    {
+        std::string name;
+        Span<const Byte> data; // Not owned; valid as long as the data given to the constant node.
+    };
+
+    // Memory layouts that layout assignment (Graph::SetLayoutAssignment) chooses between. InterleavedChannel is the
+    // layout produced by TensorPolicy::InterleavedChannel, e.g. NHWC for 4D tensors.
+    enum class TensorLayout
+    {
+        Default,
+        InterleavedChannel,
+    };
+
+    // Returns the relative cost, per byte read or written, of executing an operator with its tensors in a layout; lower
+    // is better. Layout assignment weighs this against the cost of a transpose, which reads and writes the tensor once.
+    using LayoutCostFn = std::function<float(DML_OPERATOR_TYPE type, TensorLayout layout)>;
+
+    // A copy of an intermediate tensor into another layout, added by layout assignment.
+    struct LayoutTranspose
+    {
+        std::string producer; // Name of the operator producing the tensor
+        uint32_t outputIndex;
+        TensorLayout from;
+        TensorLayout to;
+        uint64_t sizeInBytes;
+    };
+
+    // Results of layout assignment in Graph::Compile.
+    struct LayoutAssignmentReport
+    {
+        uint32_t interleavedOperatorCount = 0; // Operators executed with TensorLayout::InterleavedChannel
+        std::vector<LayoutTranspose> transposes;
+    };
+#endif
+
     namespace detail
     {
         class GraphBuilder;
         class NodeOutput;
 
+        // A bump allocator for data that lives as long as the GraphBuilder, such as operator input lists and node
+        // names. Building a graph allocates many small arrays that are never freed individually; carving them out of
+        // large blocks avoids a heap allocation per array. Memory is released only when the arena is destroyed, so it
+        // only holds trivially destructible types.
+        class Arena
+        {
+        public:
+            template <typename T>
+            T* Copy(const T* values, size_t count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without destroying its contents");
+
+                T* copy = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+                std::uninitialized_copy(values, values + count, copy);
+                return copy;
+            }
+
+        private:
+            static constexpr size_t c_blockSize = 64 * 1024;
+
+            void* Allocate(size_t size, size_t alignment)
+            {
+                size_t offset = (m_offset + alignment - 1) / alignment * alignment;
+                if (m_blocks.empty() || offset + size > m_blockSize)
+                {
+                    // Blocks from new[] are aligned for any fundamental type. Allocations larger than a block get a
+                    // block of their own.
+                    m_blockSize = std::max(c_blockSize, size);
+                    m_blocks.emplace_back(new Byte[m_blockSize]);
+                    offset = 0;
+                }
+
+                m_offset = offset + size;
+                return m_blocks.back().get() + offset;
+            }
+
+            std::vector<std::unique_ptr<Byte[]>> m_blocks;
+            size_t m_blockSize = 0;
+            size_t m_offset = 0;
+        };
+
         // A node in the graph which represents a graph input.
         struct InputNode
         {
             uint32_t inputIndex;
         };
 
+        // Fills out an operator desc with the given fused activation and passes it to the callback. The desc is only
+        // valid for the duration of the callback.
+        using FusibleOperatorDescFn = std::function<void(FusedActivation, const std::function<void(const DML_OPERATOR_DESC&)>&)>;
+
+        // Evaluates an operator on the CPU for constant folding, given the data of each of its inputs (empty for absent
+        // optional inputs), and writes the data of its output. Returns false if it can't evaluate these inputs, which
+        // leaves the operator in the graph.
+        using ConstantEvaluatorFn = std::function<bool(const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)>;
+
         // A node in the graph which represents a DML operator.
         struct OperatorNode
         {
-            Microsoft::WRL::ComPtr<IDMLOperator> op;
+            // Created with the node, or, when the builder keeps operator descs (DMLX_USE_GRAPH_SERIALIZATION), on first
+            // use by GetGraphDesc.
+            mutable Microsoft::WRL::ComPtr<IDMLOperator> op;
 
-            // The inputs to this node
-            std::vector<NodeOutput*> inputs;
+            // The inputs to this node, allocated in the GraphBuilder's arena
+            Span<NodeOutput* const> inputs;
 
-            std::string name;
+            // Interned in the GraphBuilder's arena; null if the node was created outside of a name scope.
+            const char* name = nullptr;
+
+            // Set for operators that support a fused activation and were created without one, so that Graph::Compile
+            // can recreate them with a standalone activation folded in.
+            FusibleOperatorDescFn makeDescWithFusedActivation;
+
+            // Set for standalone activations that DML can also execute as a fused activation of the operator
+            // producing their input.
+            FusedActivation equivalentFusedActivation;
+
+            // Set for single-output operators that constant folding can evaluate on the CPU.
+            ConstantEvaluatorFn evaluateConstant;
+
+            DML_OPERATOR_TYPE type;
+
+            // Estimated arithmetic operations per element of the first output, for Graph::AnalyzeMemory.
+            uint64_t opsPerOutputElement;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // A copy of the desc the operator is created from, which is otherwise opaque once created.
+            AbstractOperatorDesc desc;
+#endif
         };
 
         // Used for representing reshapes and type punning
@@ -560,7 +903,8 @@ namespace dml
             // This node does not own the memory to avoid copying large amounts of data.
             Span<const Byte> data;
 
-            std::string name;
+            // Interned in the GraphBuilder's arena; null if the node was created outside of a name scope.
+            const char* name = nullptr;
         };
 
         enum class NodeType
@@ -620,6 +964,24 @@ namespace dml
             std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> outputEdges;
             std::vector<DML_INTERMEDIATE_GRAPH_EDGE_DESC> intermediateEdges;
 
+            // For each of operatorNodes: the index of the GraphBuilder operator node it was made from, or UINT32_MAX for
+            // transposes added by layout assignment.
+            std::vector<uint32_t> builderOperatorIndices;
+
+            // Operators recreated with a fused activation, which operatorNodes refers to.
+            std::vector<Microsoft::WRL::ComPtr<IDMLOperator>> fusedOperators;
+            uint32_t fusedActivationCount = 0;
+
+            // Data of the constants produced by constant folding, which constantNodes refers to.
+            std::vector<std::vector<Byte>> foldedConstantData;
+            ConstantFoldingStats constantFoldingStats;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // Operators recreated with another layout, and the transposes added, by layout assignment.
+            std::vector<Microsoft::WRL::ComPtr<IDMLOperator>> layoutOperators;
+            LayoutAssignmentReport layoutAssignmentReport;
+#endif
+
             // Offset of the first operator node in the merged node list.
             constexpr uint32_t BaseOperatorNodeIndexInMergedNodes() const
             {
@@ -689,6 +1051,78 @@ namespace dml
             {
                 return Edges(DML_GRAPH_EDGE_TYPE_INTERMEDIATE, Span<const DML_INTERMEDIATE_GRAPH_EDGE_DESC>(intermediateEdges));
             }
+
+            // Fills out a DML_GRAPH_DESC for this graph in one pass, storing the merged nodes (as in Nodes()) in `nodes`
+            // and all edges in `edges`. The result is only valid so long as this GraphDesc, `nodes` and `edges` are
+            // alive and not modified.
+            DML_GRAPH_DESC GetDmlGraphDesc(
+                uint32_t inputCount,
+                std::vector<DML_GRAPH_NODE_DESC>& nodes,
+                std::vector<DML_GRAPH_EDGE_DESC>& edges) const
+            {
+#if DML_TARGET_VERSION >= 0x6200
+                const size_t constantNodeCount = constantNodes.size();
+#else
+                const size_t constantNodeCount = 0;
+#endif // DML_TARGET_VERSION >= 0x6200
+
+                nodes.clear();
+                nodes.reserve(operatorNodes.size() + constantNodeCount);
+                for (const DML_OPERATOR_GRAPH_NODE_DESC& node : operatorNodes)
+                {
+                    nodes.push_back({ DML_GRAPH_NODE_TYPE_OPERATOR, &node });
+                }
+#if DML_TARGET_VERSION >= 0x6200
+                for (const DML_CONSTANT_DATA_GRAPH_NODE_DESC& node : constantNodes)
+                {
+                    nodes.push_back({ DML_GRAPH_NODE_TYPE_CONSTANT, &node });
+                }
+#endif // DML_TARGET_VERSION >= 0x6200
+
+                edges.clear();
+                edges.reserve(inputEdges.size() + outputEdges.size() + intermediateEdges.size());
+                for (const DML_INPUT_GRAPH_EDGE_DESC& edge : inputEdges)
+                {
+                    edges.push_back({ DML_GRAPH_EDGE_TYPE_INPUT, &edge });
+                }
+                for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : outputEdges)
+                {
+                    edges.push_back({ DML_GRAPH_EDGE_TYPE_OUTPUT, &edge });
+                }
+                for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : intermediateEdges)
+                {
+                    edges.push_back({ DML_GRAPH_EDGE_TYPE_INTERMEDIATE, &edge });
+                }
+
+                DML_GRAPH_DESC graphDesc = {};
+                graphDesc.InputCount = inputCount ? inputCount : this->inputCount;
+                graphDesc.OutputCount = outputCount;
+                graphDesc.NodeCount = static_cast<UINT>(nodes.size());
+                graphDesc.Nodes = nodes.data();
+                graphDesc.InputEdgeCount = static_cast<UINT>(inputEdges.size());
+                graphDesc.InputEdges = edges.data();
+                graphDesc.OutputEdgeCount = static_cast<UINT>(outputEdges.size());
+                graphDesc.OutputEdges = edges.data() + inputEdges.size();
+                graphDesc.IntermediateEdgeCount = static_cast<UINT>(intermediateEdges.size());
+                graphDesc.IntermediateEdges = edges.data() + inputEdges.size() + outputEdges.size();
+                return graphDesc;
+            }
+        };
+
+        // Transformations applied by GraphBuilder::GetGraphDesc.
+        struct GraphDescOptions
+        {
+            bool fuseActivations = false;
+            bool foldConstants = false;
+
+            // Operators that haven't been created yet are created unless this is false, in which case their nodes have
+            // a null operator (for inspecting the graph without a device).
+            bool createOperators = true;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // Assigns layouts using this cost function (or the default costs, if it's empty) when not null.
+            const LayoutCostFn* layoutCost = nullptr;
+#endif
         };
 
         class GraphBuilder
@@ -704,6 +1138,11 @@ namespace dml
                 return m_device.Get();
             }
 
+            void SetDevice(IDMLDevice* device)
+            {
+                m_device = device;
+            }
+
             void PushName(StringView name)
             {
                 m_nameSubLengths.push(m_name.size());
@@ -712,6 +1151,7 @@ namespace dml
                     m_name += "_";
                 }
                 m_name += name;
+                m_internedName = nullptr;
             }
 
             void PopName()
@@ -720,6 +1160,7 @@ namespace dml
                 {
                     m_name.resize(m_nameSubLengths.top());
                     m_nameSubLengths.pop();
+                    m_internedName = nullptr;
                 }
             }
 
@@ -730,39 +1171,179 @@ namespace dml
             // Creates a DML operator node owned by this graph builder and returns a NodeInfo identifier. The
             // inputs to this node must be supplied in the correct order matching the DML operator.
             NodeID CreateOperatorNode(DML_OPERATOR_TYPE type, const void* desc, Span<NodeOutput* const> inputs);
+
+            // Creates a node for an operator that supports a fused activation. The desc is built by `makeDesc` with
+            // `fusedActivation`; if that is None, `makeDesc` is kept so the node is a candidate for activation fusion.
+            NodeID CreateFusibleOperatorNode(FusibleOperatorDescFn makeDesc, FusedActivation fusedActivation, Span<NodeOutput* const> inputs);
+
+            // Lets constant folding evaluate an operator node on the CPU. A null evaluator is ignored.
+            void SetConstantEvaluator(NodeID node, ConstantEvaluatorFn evaluator)
+            {
+                assert(node.type == NodeType::Operator);
+                m_operatorNodes[node.index].evaluateConstant = std::move(evaluator);
+            }
+
             NodeID CreateInputNode(uint32_t inputIndex);
             NodeID CreateReinterpretNode(NodeOutput* input);
 #if DML_TARGET_VERSION >= 0x6200
             NodeID CreateConstantNode(Span<const Byte> data);
 #endif // DML_TARGET_VERSION >= 0x6200
             NodeOutput* CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc);
-            GraphDesc GetGraphDesc(Span<const Expression> outputs) const;
+            // Builds the graph desc for `outputs`, leaving out operators that don't contribute to them.
+            GraphDesc GetGraphDesc(Span<const Expression> outputs, const GraphDescOptions& options = GraphDescOptions()) const;
+#if DMLX_USE_GRAPH_SERIALIZATION
+            DmlSerializedGraphDesc GetSerializedGraphDesc(Span<const Expression> outputs, std::vector<SerializedConstant>* externalConstants) const;
+#endif
+            MemoryAnalysis AnalyzeMemory(Span<const Expression> outputs) const;
 
         private:
-            Microsoft::WRL::ComPtr<IDMLDevice> m_device;
-            TensorPolicy m_tensorPolicy;
-            std::vector<InputNode> m_inputNodes;
-            std::vector<OperatorNode> m_operatorNodes;
-            std::vector<ReinterpretNode> m_reinterpretNodes;
-            std::vector<ConstantNode> m_constantNodes;
-            std::deque<NodeOutput> m_nodeOutputs; // deque doesn't invalidate references to elements when it resizes
+            struct ActivationFusion
+            {
+                // For each operator node: the index of the operator node it was folded into, or UINT32_MAX.
+                std::vector<uint32_t> fusedInto;
 
-            std::string m_name;
-            std::stack<size_t> m_nameSubLengths;
-        };
+                // For each operator node: the operator recreated with an activation fused in, or null.
+                std::vector<Microsoft::WRL::ComPtr<IDMLOperator>> fusedOperators;
+            };
 
-    } // namespace detail
+            // Finds standalone activations that consume the only use of an operator's output, where that operator
+            // supports a fused activation, and recreates those operators with the activation fused in. Operators
+            // removed by constant folding are skipped. Without `createOperators`, every such pair is fused and no
+            // operators are created, so the result assumes DML accepts each fused operator.
+            ActivationFusion FuseActivations(Span<const Expression> outputs, const std::vector<uint32_t>& foldedInto, bool createOperators) const;
 
-    class Expression
-    {
-    public:
-        /*implicit*/ Expression(detail::NodeOutput* nodeOutput = nullptr)
-            : m_nodeOutput(nodeOutput)
-        {}
+            struct ConstantFolding
+            {
+                // For each operator node: the index in `data` of the constant holding its output, or UINT32_MAX.
+                std::vector<uint32_t> foldedInto;
+                std::vector<std::vector<Byte>> data;
+            };
 
-        // Returns a struct containing the required properties of the tensor to hold the output of this expression,
-        // once evaluated.
-        const TensorDesc& GetOutputDesc() const { return Impl()->GetOutputDesc(); }
+            // Evaluates, in creation order, each operator with a constant evaluator whose inputs are all constants or
+            // previously folded operators. Operators producing graph outputs are never folded.
+            ConstantFolding FoldConstants(Span<const Expression> outputs) const;
+
+            // Returns, for each operator node, whether it contributes to one of `outputs`.
+            std::vector<bool> FindUsedOperators(Span<const Expression> outputs) const;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // Creates the operator of a node whose creation was deferred. The converted DML desc is allocated from
+            // `allocator`.
+            void CreateOperator(const OperatorNode& node, BucketAllocator& allocator) const;
+
+            struct LayoutAssignment
+            {
+                // A copy of an operator output into the layout its producer doesn't use.
+                struct Transpose
+                {
+                    uint32_t producer;
+                    uint32_t outputIndex;
+                    const DmlBufferTensorDesc* tensor; // The producer's output desc
+                };
+
+                // For each operator node: whether it executes with TensorLayout::InterleavedChannel.
+                std::vector<bool> isInterleaved;
+
+                // For each operator node: the ID of the tensor for its first output; its other outputs follow. An
+                // activation fused into its producer shares the producer's tensors.
+                std::vector<uint32_t> firstTensorIds;
+
+                // For each tensor: whether it's stored in the layout of its producer, rather than always packed.
+                std::vector<bool> isFlexible;
+
+                // For each tensor: the index in `transposes` of its copy, or UINT32_MAX.
+                std::vector<uint32_t> transposeIndices;
+
+                std::vector<Transpose> transposes;
+
+                // Returns the index in `transposes` of the copy of an operator output that `consumer` reads, or
+                // UINT32_MAX if it reads the output itself.
+                uint32_t GetTransposeIndex(NodeOutput* output, uint32_t consumer) const
+                {
+                    if (transposes.empty())
+                    {
+                        return UINT32_MAX;
+                    }
+
+                    const uint32_t transposeIndex = transposeIndices[firstTensorIds[output->GetNode().index] + output->GetOutputIndex()];
+                    if (transposeIndex == UINT32_MAX || isInterleaved[consumer] == isInterleaved[transposes[transposeIndex].producer])
+                    {
+                        return UINT32_MAX;
+                    }
+                    return transposeIndex;
+                }
+            };
+
+            // Chooses a layout for each emitted operator (those with an index in `operatorNodeIndices`) that reads or
+            // writes an intermediate tensor free to change layout, minimizing the operators' cost plus the cost of
+            // the transposes needed between operators that disagree.
+            LayoutAssignment AssignLayouts(
+                Span<const Expression> outputs,
+                const std::vector<uint32_t>& operatorNodeIndices,
+                const ActivationFusion& fusion,
+                const LayoutCostFn& layoutCost) const;
+
+            // Creates an operator with its flexible tensors in TensorLayout::InterleavedChannel.
+            Microsoft::WRL::ComPtr<IDMLOperator> CreateInterleavedOperator(
+                uint32_t operatorIndex,
+                const LayoutAssignment& layouts,
+                BucketAllocator& allocator) const;
+
+            // Creates an element-wise identity that copies `tensor` between the packed and interleaved layouts.
+            Microsoft::WRL::ComPtr<IDMLOperator> CreateTranspose(const DmlBufferTensorDesc& tensor, bool toInterleaved) const;
+#endif
+
+            NodeOutput* SkipReinterprets(NodeOutput* output) const
+            {
+                while (output->GetNode().type == NodeType::Reinterpret)
+                {
+                    output = m_reinterpretNodes[output->GetNode().index].input;
+                }
+                return output;
+            }
+
+            // Returns the current name interned in the arena, or null if it's empty. Consecutive nodes in the same name
+            // scope share one copy.
+            const char* GetInternedName()
+            {
+                if (m_name.empty())
+                {
+                    return nullptr;
+                }
+
+                if (!m_internedName)
+                {
+                    m_internedName = m_arena.Copy(m_name.c_str(), m_name.size() + 1);
+                }
+                return m_internedName;
+            }
+
+            Microsoft::WRL::ComPtr<IDMLDevice> m_device;
+            TensorPolicy m_tensorPolicy;
+            Arena m_arena;
+            std::vector<InputNode> m_inputNodes;
+            std::deque<OperatorNode> m_operatorNodes; // deque doesn't move existing nodes when it grows
+            std::vector<ReinterpretNode> m_reinterpretNodes;
+            std::vector<ConstantNode> m_constantNodes;
+            std::deque<NodeOutput> m_nodeOutputs; // deque doesn't invalidate references to elements when it resizes
+
+            std::string m_name;
+            std::stack<size_t> m_nameSubLengths;
+            const char* m_internedName = nullptr; // m_name in the arena, or null if it changed since it was interned
+        };
+
+    } // namespace detail
+
+    class Expression
+    {
+    public:
+        /*implicit*/ Expression(detail::NodeOutput* nodeOutput = nullptr)
+            : m_nodeOutput(nodeOutput)
+        {}
+
+        // Returns a struct containing the required properties of the tensor to hold the output of this expression,
+        // once evaluated.
+        const TensorDesc& GetOutputDesc() const { return Impl()->GetOutputDesc(); }
 
         // For internal use only
         detail::NodeOutput* Impl() const { return m_nodeOutput; }
@@ -795,6 +1376,10 @@ namespace dml
     class Graph
     {
     public:
+        // With DMLX_USE_GRAPH_SERIALIZATION, the graph keeps a copy of each operator's desc and only creates operators
+        // when compiling, so the device may be null for building, analyzing and serializing graphs on machines without
+        // DirectML hardware; supply one with SetDevice before compiling. Without it, operators are created as they're
+        // added, which requires a device.
         explicit Graph(IDMLDevice* device, TensorPolicy tensorPolicy = {})
             : m_graphBuilder(make_unique<detail::GraphBuilder>(device, tensorPolicy))
         {}
@@ -810,36 +1395,89 @@ namespace dml
 
         NameScope CreateNameScope(StringView name) { return NameScope(m_graphBuilder.get(), name); }
 
+#if DMLX_USE_GRAPH_SERIALIZATION
+        // Sets the device that Compile creates operators on. Operators already created by an earlier Compile belong to
+        // the previous device, so this should only be used on graphs that haven't been compiled.
+        void SetDevice(IDMLDevice* device) { m_graphBuilder->SetDevice(device); }
+#endif
+
         void PushName(StringView name) { m_graphBuilder->PushName(name); }
         void PopName() { m_graphBuilder->PopName(); }
 
+        // Controls whether Compile evaluates operators whose inputs all come from ConstantData, directly or through
+        // other folded operators, on the CPU and replaces them with constant nodes holding their results. This removes
+        // dispatches and intermediate allocations for weight preprocessing. Only some operators can be folded: casts,
+        // joins, slices, fills, element-wise identity, and on float data a few element-wise math operators.
+        // Reinterprets (including transposes expressed as strided reinterprets) are folded into the operator that
+        // reads them. Disabled by default; requires DML_TARGET_VERSION >= 0x6200 for constant nodes.
+        void SetConstantFolding(bool enabled) { m_foldConstants = enabled; }
+        bool GetConstantFolding() const { return m_foldConstants; }
+
+        // Returns what constant folding did in the most recent call to Compile.
+        const ConstantFoldingStats& GetConstantFoldingStats() const { return m_constantFoldingStats; }
+
+        // Controls whether Compile folds a standalone activation (e.g. ActivationRelu) into the operator producing its
+        // input, when that operator supports a fused activation and the activation is the only consumer of its
+        // output. This removes an intermediate tensor and a pass over memory per activation. Not every operator
+        // supports every fused activation for every data type; a pair that DML rejects is left unfused, so check
+        // GetFusedActivationCount to see what was fused. Disabled by default.
+        void SetActivationFusion(bool enabled) { m_fuseActivations = enabled; }
+        bool GetActivationFusion() const { return m_fuseActivations; }
+
+        // Returns the number of activations fused into their producer in the most recent call to Compile.
+        uint32_t GetFusedActivationCount() const { return m_fusedActivationCount; }
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+        // Controls whether Compile chooses a layout (TensorLayout) for each operator instead of using the strides the
+        // graph was built with. Only intermediate tensors with 3 to 5 dimensions and no explicit strides are given
+        // another layout; graph inputs and outputs, constants, and tensors read through a reinterpret keep theirs.
+        // Where an operator prefers a different layout than the producer of one of its inputs, a transpose (an
+        // element-wise identity) is inserted, shared by all consumers wanting that layout. Layouts are chosen greedily
+        // to minimize the sum of each operator's cost (from `layoutCost`, or by default a preference for
+        // InterleavedChannel in convolution, pooling and batch normalization) and the transposes' cost. Disabled by
+        // default.
+        void SetLayoutAssignment(bool enabled, LayoutCostFn layoutCost = nullptr)
+        {
+            m_assignLayouts = enabled;
+            m_layoutCost = std::move(layoutCost);
+        }
+        bool GetLayoutAssignment() const { return m_assignLayouts; }
+
+        // Returns the layouts chosen and the transposes added in the most recent call to Compile.
+        const LayoutAssignmentReport& GetLayoutAssignmentReport() const { return m_layoutAssignmentReport; }
+#endif
+
         Microsoft::WRL::ComPtr<IDMLCompiledOperator> Compile(
             DML_EXECUTION_FLAGS flags,
             Span<const Expression> outputs,
             uint32_t inputCount = 0) const
         {
-            detail::GraphDesc graph = m_graphBuilder->GetGraphDesc(outputs);
+            if (!m_graphBuilder->GetDevice())
+            {
+                DMLX_THROW(E_INVALIDARG); // See SetDevice
+            }
+
+            detail::GraphDescOptions options;
+            options.fuseActivations = m_fuseActivations;
+            options.foldConstants = m_foldConstants;
+#if DMLX_USE_GRAPH_SERIALIZATION
+            options.layoutCost = m_assignLayouts ? &m_layoutCost : nullptr;
+#endif
+
+            detail::GraphDesc graph = m_graphBuilder->GetGraphDesc(outputs, options);
+            m_constantFoldingStats = graph.constantFoldingStats;
+            m_fusedActivationCount = graph.fusedActivationCount;
+#if DMLX_USE_GRAPH_SERIALIZATION
+            m_layoutAssignmentReport = std::move(graph.layoutAssignmentReport);
+#endif
 
             // If supplied, the requested number of inputs to the compiled operator can be larger than the actual
             // number of input nodes on the graph (e.g. in the case of unused empty inputs), but never smaller.
             assert(inputCount == 0 || inputCount >= graph.inputCount);
 
-            std::vector<DML_GRAPH_NODE_DESC> graphNodes = graph.Nodes();
-            std::vector<DML_GRAPH_EDGE_DESC> inputEdges = graph.InputEdges();
-            std::vector<DML_GRAPH_EDGE_DESC> outputEdges = graph.OutputEdges();
-            std::vector<DML_GRAPH_EDGE_DESC> intermediateEdges = graph.IntermediateEdges();
-
-            DML_GRAPH_DESC graphDesc = {};
-            graphDesc.InputCount = inputCount ? inputCount : graph.inputCount;
-            graphDesc.OutputCount = graph.outputCount;
-            graphDesc.NodeCount = static_cast<UINT>(graphNodes.size());
-            graphDesc.Nodes = graphNodes.data();
-            graphDesc.InputEdgeCount = static_cast<UINT>(inputEdges.size());
-            graphDesc.InputEdges = inputEdges.data();
-            graphDesc.OutputEdgeCount = static_cast<UINT>(outputEdges.size());
-            graphDesc.OutputEdges = outputEdges.data();
-            graphDesc.IntermediateEdgeCount = static_cast<UINT>(intermediateEdges.size());
-            graphDesc.IntermediateEdges = intermediateEdges.data();
+            std::vector<DML_GRAPH_NODE_DESC> graphNodes;
+            std::vector<DML_GRAPH_EDGE_DESC> graphEdges;
+            DML_GRAPH_DESC graphDesc = graph.GetDmlGraphDesc(inputCount, graphNodes, graphEdges);
 
             Microsoft::WRL::ComPtr<IDMLDevice1> device1;
             DMLX_THROW_IF_FAILED(m_graphBuilder->GetDevice()->QueryInterface(IID_PPV_ARGS(&device1)));
@@ -850,122 +1488,50 @@ namespace dml
             return compiledGraph;
         }
 
-    private:
-        std::unique_ptr<detail::GraphBuilder> m_graphBuilder;
-    };
-
-    // Represents an activation to be fused with an existing operator. The meaning of param1 and param2 depend on the
-    // activation to be fused.
-    // 
-    // For HARD_SIGMOID, LINEAR, PARAMETRIC_SOFTPLUS, and SCALED_TANH: param1 = Alpha and param2 = Beta
-    // For ELU, LEAKY_RELU, THRESHOLDED_RELU, and CELU: param1 = Alpha. param2 is unused.
-    // For SCALED_ELU, param1 = Alpha and param2 = Gamma.
-    // For SHRINK, param1 = Bias and param2 = Threshold
-    // For SOFTPLUS, param1 = Steepness.
-    // For all other activations, both param1 and param2 are unused.
-    struct FusedActivation
-    {
-        DML_OPERATOR_TYPE activation = DML_OPERATOR_INVALID;
-        float param1 = 0.0f;
-        float param2 = 0.0f;
-
-        FusedActivation() = default;
-
-        explicit FusedActivation(DML_OPERATOR_TYPE activation, float param1 = 0.0f, float param2 = 0.0f)
-            : activation(activation), param1(param1), param2(param2)
-        {}
-
-        static FusedActivation None()
-        {
-            return FusedActivation();
-        }
-
-        static FusedActivation Elu(float alpha = 1.0f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_ELU, alpha);
-        }
-
-        static FusedActivation HardSigmoid(float alpha = 0.2f, float beta = 0.5f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_HARD_SIGMOID, alpha, beta);
-        }
-
-        static FusedActivation Identity()
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_IDENTITY);
-        }
-
-        static FusedActivation LeakyRelu(float alpha = 0.01f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_LEAKY_RELU, alpha);
-        }
-
-        static FusedActivation Linear(float alpha, float beta)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_LINEAR, alpha, beta);
-        }
-
-        static FusedActivation ParametricSoftplus(float alpha, float beta)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS, alpha, beta);
-        }
-
-        static FusedActivation Relu()
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_RELU);
-        }
-
-        static FusedActivation ScaledElu(float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_ELU, alpha, gamma);
-        }
-
-        static FusedActivation ScaledTanh(float alpha = 1.0f, float beta = 0.5f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_TANH, alpha, beta);
-        }
-
-        static FusedActivation Sigmoid()
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SIGMOID);
-        }
-
-        static FusedActivation Softplus(float steepness = 1.0f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTPLUS, steepness);
-        }
-
-        static FusedActivation Softsign()
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTSIGN);
-        }
-
-        static FusedActivation Tanh()
+        // Computes the memory footprint of evaluating `outputs` from the tensor descs alone, without compiling the
+        // graph or using the device: the execution order, the lifetime and size of every intermediate tensor, the peak
+        // intermediate memory with perfect reuse, an arena layout that achieves close to it, and per-node estimates of
+        // arithmetic and memory traffic. This describes the graph as built, before Compile fuses activations or folds
+        // constants, so it is an upper bound of what the compiled graph needs; DML may also need temporary memory of
+        // its own (IDMLCompiledOperator::GetBindingProperties).
+        MemoryAnalysis AnalyzeMemory(Span<const Expression> outputs) const
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_TANH);
+            return m_graphBuilder->AnalyzeMemory(outputs);
         }
 
-        static FusedActivation ThresholdedRelu(float alpha = 1.0f)
+#if DMLX_USE_GRAPH_SERIALIZATION
+        // Serializes the graph to the DmlGraphDesc flatbuffer format read by DeserializeDmlGraph, which DxDispatch
+        // executes with a "dmlSerializedGraph" dispatchable. Graph inputs and outputs are named "input<i>" and
+        // "output<i>". Constant data is embedded in the flatbuffer unless externalConstants is supplied, in which case
+        // each constant is referenced by name and returned in externalConstants; write each one to "<name>.bin" next
+        // to the serialized graph.
+        std::vector<uint8_t> Serialize(
+            Span<const Expression> outputs,
+            std::vector<SerializedConstant>* externalConstants = nullptr,
+            uint32_t inputCount = 0) const
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU, alpha);
-        }
+            DmlSerializedGraphDesc graph = m_graphBuilder->GetSerializedGraphDesc(outputs, externalConstants);
 
-        static FusedActivation Shrink(float bias = 0.0f, float threshold = 0.5f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SHRINK, bias, threshold);
-        }
+            // As with Compile, the requested number of inputs can be larger than the number of input nodes.
+            assert(inputCount == 0 || inputCount >= graph.InputCount);
+            graph.InputCount = inputCount ? inputCount : graph.InputCount;
 
-        static FusedActivation Celu(float alpha = 1.0f)
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_CELU, alpha);
+            flatbuffers::DetachedBuffer buffer = SerializeDmlGraph(graph);
+            return std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size());
         }
+#endif
 
-#if DML_TARGET_VERSION >= 0x5100
-        static FusedActivation Gelu()
-        {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_GELU);
-        }
-#endif // DML_TARGET_VERSION >= 0x5100
+    private:
+        std::unique_ptr<detail::GraphBuilder> m_graphBuilder;
+        bool m_fuseActivations = false;
+        mutable uint32_t m_fusedActivationCount = 0;
+        bool m_foldConstants = false;
+        mutable ConstantFoldingStats m_constantFoldingStats;
+#if DMLX_USE_GRAPH_SERIALIZATION
+        bool m_assignLayouts = false;
+        LayoutCostFn m_layoutCost;
+        mutable LayoutAssignmentReport m_layoutAssignmentReport;
+#endif
     };
 
     // Implementation detail helper for determining if a list of expressions share the same GraphBuilder.
@@ -1025,67 +1591,574 @@ namespace dml
     // Expression implementation helpers
     namespace detail
     {
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseUnary(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias)
-        {
-            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        // CPU kernels for constant folding. Tensors are read and written through their element strides, so broadcast
+        // and transposed views need no copies; rows along the innermost dimension take a unit-stride loop when every
+        // tensor is packed along it, which compilers vectorize.
 
-            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-            TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+        // Calls fn with a value of the C++ type matching the data type and returns its result, or returns false for
+        // data types without one (e.g. FLOAT16).
+        template <typename Fn>
+        bool VisitDataType(DML_TENSOR_DATA_TYPE dataType, Fn&& fn)
+        {
+            switch (dataType)
+            {
+            case DML_TENSOR_DATA_TYPE_FLOAT32: return fn(float{});
+            case DML_TENSOR_DATA_TYPE_FLOAT64: return fn(double{});
+            case DML_TENSOR_DATA_TYPE_INT8: return fn(int8_t{});
+            case DML_TENSOR_DATA_TYPE_UINT8: return fn(uint8_t{});
+            case DML_TENSOR_DATA_TYPE_INT16: return fn(int16_t{});
+            case DML_TENSOR_DATA_TYPE_UINT16: return fn(uint16_t{});
+            case DML_TENSOR_DATA_TYPE_INT32: return fn(int32_t{});
+            case DML_TENSOR_DATA_TYPE_UINT32: return fn(uint32_t{});
+            case DML_TENSOR_DATA_TYPE_INT64: return fn(int64_t{});
+            case DML_TENSOR_DATA_TYPE_UINT64: return fn(uint64_t{});
+            default: return false;
+            }
+        }
 
-            TDesc desc = {};
-            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+        // Same as VisitDataType, but only for floating-point data types.
+        template <typename Fn>
+        bool VisitFloatDataType(DML_TENSOR_DATA_TYPE dataType, Fn&& fn)
+        {
+            switch (dataType)
+            {
+            case DML_TENSOR_DATA_TYPE_FLOAT32: return fn(float{});
+            case DML_TENSOR_DATA_TYPE_FLOAT64: return fn(double{});
+            default: return false;
+            }
+        }
 
-            detail::NodeOutput* const inputs[] = { input.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        inline TensorStrides GetElementStrides(const TensorDesc& desc)
+        {
+            if (desc.strides)
+            {
+                return *desc.strides;
+            }
 
-            return output;
+            TensorStrides strides(desc.sizes.size());
+            uint32_t stride = 1;
+            for (size_t i = desc.sizes.size(); i-- > 0;)
+            {
+                strides[i] = stride;
+                stride *= desc.sizes[i];
+            }
+            return strides;
         }
 
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseUnary(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UNKNOWN)
+        // Returns whether `data` holds every element addressed by the sizes, strides, and base element offset.
+        inline bool CoversElements(
+            Span<const Byte> data,
+            const TensorDimensions& sizes,
+            const TensorStrides& strides,
+            uint64_t offset,
+            size_t elementSize)
         {
-            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            uint64_t lastElement = offset;
+            for (size_t i = 0; i < sizes.size(); ++i)
+            {
+                if (sizes[i] == 0)
+                {
+                    return true;
+                }
+                lastElement += static_cast<uint64_t>(sizes[i] - 1) * strides[i];
+            }
+            return data.size() >= (lastElement + 1) * elementSize;
+        }
 
-            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        // Calls rowFn(offsets) for each run of elements along the innermost dimension of `sizes`, with the element
+        // offset of the run's first element in each tensor.
+        template <size_t TensorCount, typename Fn>
+        void ForEachRow(
+            const TensorDimensions& sizes,
+            const std::array<uint64_t, TensorCount>& baseOffsets,
+            const std::array<const TensorStrides*, TensorCount>& strides,
+            Fn&& rowFn)
+        {
+            assert(!sizes.empty());
+            const size_t outerDimensionCount = sizes.size() - 1;
 
-            if (outputDataType == DML_TENSOR_DATA_TYPE_UNKNOWN)
+            uint64_t rowCount = sizes.back() == 0 ? 0 : 1;
+            for (size_t i = 0; i < outerDimensionCount; ++i)
             {
-                outputDataType = inputTensor.dataType;
+                rowCount *= sizes[i];
             }
-            TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
 
-            TDesc desc = {};
-            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            SmallVector<uint32_t, 4> coordinates(outerDimensionCount);
+            std::array<uint64_t, TensorCount> offsets = baseOffsets;
+            for (uint64_t row = 0; row < rowCount; ++row)
+            {
+                rowFn(offsets);
 
-            detail::NodeOutput* const inputs[] = { input.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+                // Advance the coordinates like an odometer, updating the offsets to match.
+                for (size_t i = outerDimensionCount; i-- > 0;)
+                {
+                    if (++coordinates[i] < sizes[i])
+                    {
+                        for (size_t t = 0; t < TensorCount; ++t)
+                        {
+                            offsets[t] += (*strides[t])[i];
+                        }
+                        break;
+                    }
 
-            return output;
+                    coordinates[i] = 0;
+                    for (size_t t = 0; t < TensorCount; ++t)
+                    {
+                        offsets[t] -= static_cast<uint64_t>(sizes[i] - 1) * (*strides[t])[i];
+                    }
+                }
+            }
         }
 
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseBinary(Expression a, Expression b)
+        // output[i] = fn(input[i]) for every element of `sizes`.
+        template <typename TOut, typename TIn, typename Fn>
+        void MapElements(
+            const TensorDimensions& sizes,
+            Byte* output, uint64_t outputOffset, const TensorStrides& outputStrides,
+            const Byte* input, uint64_t inputOffset, const TensorStrides& inputStrides,
+            Fn fn)
         {
-            assert(detail::HasSameOwner({ a, b }));
-            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+            TOut* out = reinterpret_cast<TOut*>(output);
+            const TIn* in = reinterpret_cast<const TIn*>(input);
+            const size_t rowSize = sizes.back();
+            const size_t outStride = outputStrides.back();
+            const size_t inStride = inputStrides.back();
 
-            TensorDesc aTensor = a.Impl()->GetOutputDesc();
-            TensorDesc bTensor = b.Impl()->GetOutputDesc();
-            TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
+            ForEachRow<2>(sizes, { outputOffset, inputOffset }, { &outputStrides, &inputStrides }, [&](const std::array<uint64_t, 2>& offsets)
+            {
+                TOut* o = out + offsets[0];
+                const TIn* a = in + offsets[1];
+                if (outStride == 1 && inStride == 1)
+                {
+                    for (size_t i = 0; i < rowSize; ++i) { o[i] = fn(a[i]); }
+                }
+                else
+                {
+                    for (size_t i = 0; i < rowSize; ++i) { o[i * outStride] = fn(a[i * inStride]); }
+                }
+            });
+        }
 
-            TDesc desc = {};
-            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        // output[i] = fn(a[i], b[i]) for every element of `sizes`.
+        template <typename T, typename Fn>
+        void MapElements(
+            const TensorDimensions& sizes,
+            Byte* output, const TensorStrides& outputStrides,
+            const Byte* a, const TensorStrides& aStrides,
+            const Byte* b, const TensorStrides& bStrides,
+            Fn fn)
+        {
+            T* out = reinterpret_cast<T*>(output);
+            const T* inA = reinterpret_cast<const T*>(a);
+            const T* inB = reinterpret_cast<const T*>(b);
+            const size_t rowSize = sizes.back();
+            const size_t outStride = outputStrides.back();
+            const size_t aStride = aStrides.back();
+            const size_t bStride = bStrides.back();
+
+            ForEachRow<3>(sizes, { 0, 0, 0 }, { &outputStrides, &aStrides, &bStrides }, [&](const std::array<uint64_t, 3>& offsets)
+            {
+                T* o = out + offsets[0];
+                const T* x = inA + offsets[1];
+                const T* y = inB + offsets[2];
+                if (outStride == 1 && aStride == 1 && bStride == 1)
+                {
+                    for (size_t i = 0; i < rowSize; ++i) { o[i] = fn(x[i], y[i]); }
+                }
+                else
+                {
+                    for (size_t i = 0; i < rowSize; ++i) { o[i * outStride] = fn(x[i * aStride], y[i * bStride]); }
+                }
+            });
+        }
+
+        // Evaluates an operator with one input whose output has the same sizes, e.g. element-wise unary or cast.
+        template <typename TOut, typename TIn, typename Fn>
+        bool EvaluateUnary(
+            const TensorDesc& inputTensor,
+            Span<const Byte> input,
+            const TensorDesc& outputTensor,
+            std::vector<Byte>& output,
+            Fn fn)
+        {
+            const TensorStrides inputStrides = GetElementStrides(inputTensor);
+            if (!CoversElements(input, inputTensor.sizes, inputStrides, 0, sizeof(TIn)))
+            {
+                return false;
+            }
+
+            output.assign(static_cast<size_t>(outputTensor.totalTensorSizeInBytes), Byte(0));
+            MapElements<TOut, TIn>(
+                outputTensor.sizes,
+                output.data(), 0, GetElementStrides(outputTensor),
+                input.data(), 0, inputStrides,
+                fn);
+            return true;
+        }
+
+        template <typename T>
+        T ReadScalar(const DML_SCALAR_UNION& value)
+        {
+            T result;
+            std::memcpy(&result, &value, sizeof(T));
+            return result;
+        }
+
+        inline ConstantEvaluatorFn MakeUnaryElementWiseEvaluator(
+            DML_OPERATOR_TYPE type,
+            const TensorDesc& inputTensor,
+            const TensorDesc& outputTensor,
+            const Optional<DML_SCALE_BIAS>& scaleBias)
+        {
+            if (inputTensor.dataType != outputTensor.dataType)
+            {
+                return nullptr;
+            }
+
+            if (type == DML_OPERATOR_ELEMENT_WISE_IDENTITY && !scaleBias)
+            {
+                return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+                {
+                    return VisitDataType(outputTensor.dataType, [&](auto zero)
+                    {
+                        using T = decltype(zero);
+                        return EvaluateUnary<T, T>(inputTensor, inputs[0], outputTensor, output, [](T x) { return x; });
+                    });
+                };
+            }
+
+            // Other operators apply the scale and bias too, but only identity is folded with one.
+            if (scaleBias && type != DML_OPERATOR_ELEMENT_WISE_IDENTITY)
+            {
+                return nullptr;
+            }
+
+            switch (type)
+            {
+            case DML_OPERATOR_ELEMENT_WISE_IDENTITY:
+            case DML_OPERATOR_ELEMENT_WISE_ABS:
+            case DML_OPERATOR_ELEMENT_WISE_CEIL:
+            case DML_OPERATOR_ELEMENT_WISE_FLOOR:
+            case DML_OPERATOR_ELEMENT_WISE_SQRT:
+            case DML_OPERATOR_ELEMENT_WISE_EXP:
+            case DML_OPERATOR_ELEMENT_WISE_LOG:
+            case DML_OPERATOR_ELEMENT_WISE_RECIP:
+#if DML_TARGET_VERSION >= 0x5000
+            case DML_OPERATOR_ELEMENT_WISE_NEGATE:
+#endif // DML_TARGET_VERSION >= 0x5000
+                break;
+
+            default:
+                return nullptr;
+            }
+
+            const float scale = scaleBias ? scaleBias->Scale : 1.0f;
+            const float bias = scaleBias ? scaleBias->Bias : 0.0f;
+
+            return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+            {
+                return VisitFloatDataType(outputTensor.dataType, [&](auto zero)
+                {
+                    using T = decltype(zero);
+                    auto Evaluate = [&](auto fn) { return EvaluateUnary<T, T>(inputTensor, inputs[0], outputTensor, output, fn); };
+
+                    switch (type)
+                    {
+                    case DML_OPERATOR_ELEMENT_WISE_IDENTITY: return Evaluate([=](T x) { return static_cast<T>(x * scale + bias); });
+                    case DML_OPERATOR_ELEMENT_WISE_ABS: return Evaluate([](T x) { return std::abs(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_CEIL: return Evaluate([](T x) { return std::ceil(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_FLOOR: return Evaluate([](T x) { return std::floor(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_SQRT: return Evaluate([](T x) { return std::sqrt(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_EXP: return Evaluate([](T x) { return std::exp(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_LOG: return Evaluate([](T x) { return std::log(x); });
+                    case DML_OPERATOR_ELEMENT_WISE_RECIP: return Evaluate([](T x) { return T(1) / x; });
+#if DML_TARGET_VERSION >= 0x5000
+                    case DML_OPERATOR_ELEMENT_WISE_NEGATE: return Evaluate([](T x) { return -x; });
+#endif // DML_TARGET_VERSION >= 0x5000
+                    default: return false;
+                    }
+                });
+            };
+        }
+
+        inline ConstantEvaluatorFn MakeBinaryElementWiseEvaluator(
+            DML_OPERATOR_TYPE type,
+            const TensorDesc& aTensor,
+            const TensorDesc& bTensor,
+            const TensorDesc& outputTensor)
+        {
+            switch (type)
+            {
+            case DML_OPERATOR_ELEMENT_WISE_ADD:
+            case DML_OPERATOR_ELEMENT_WISE_SUBTRACT:
+            case DML_OPERATOR_ELEMENT_WISE_MULTIPLY:
+            case DML_OPERATOR_ELEMENT_WISE_DIVIDE:
+            case DML_OPERATOR_ELEMENT_WISE_MAX:
+            case DML_OPERATOR_ELEMENT_WISE_MIN:
+                break;
+
+            default:
+                return nullptr;
+            }
+
+            if (aTensor.dataType != outputTensor.dataType || bTensor.dataType != outputTensor.dataType ||
+                aTensor.sizes != outputTensor.sizes || bTensor.sizes != outputTensor.sizes)
+            {
+                return nullptr;
+            }
+
+            return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+            {
+                const TensorStrides aStrides = GetElementStrides(aTensor);
+                const TensorStrides bStrides = GetElementStrides(bTensor);
+
+                auto Evaluate = [&](auto zero, auto fn)
+                {
+                    using T = decltype(zero);
+                    if (!CoversElements(inputs[0], aTensor.sizes, aStrides, 0, sizeof(T)) ||
+                        !CoversElements(inputs[1], bTensor.sizes, bStrides, 0, sizeof(T)))
+                    {
+                        return false;
+                    }
+
+                    output.assign(static_cast<size_t>(outputTensor.totalTensorSizeInBytes), Byte(0));
+                    MapElements<T>(
+                        outputTensor.sizes,
+                        output.data(), GetElementStrides(outputTensor),
+                        inputs[0].data(), aStrides,
+                        inputs[1].data(), bStrides,
+                        fn);
+                    return true;
+                };
+
+                // Min and max are exact for every type; arithmetic is only folded on float data, where the CPU
+                // matches DML without having to reproduce its integer overflow and division behavior.
+                if (type == DML_OPERATOR_ELEMENT_WISE_MAX || type == DML_OPERATOR_ELEMENT_WISE_MIN)
+                {
+                    const bool isMax = (type == DML_OPERATOR_ELEMENT_WISE_MAX);
+                    return VisitDataType(outputTensor.dataType, [&](auto zero)
+                    {
+                        using T = decltype(zero);
+                        return Evaluate(zero, [=](T x, T y) { return (isMax == (x < y)) ? y : x; });
+                    });
+                }
+
+                return VisitFloatDataType(outputTensor.dataType, [&](auto zero)
+                {
+                    using T = decltype(zero);
+                    switch (type)
+                    {
+                    case DML_OPERATOR_ELEMENT_WISE_ADD: return Evaluate(zero, [](T x, T y) { return x + y; });
+                    case DML_OPERATOR_ELEMENT_WISE_SUBTRACT: return Evaluate(zero, [](T x, T y) { return x - y; });
+                    case DML_OPERATOR_ELEMENT_WISE_MULTIPLY: return Evaluate(zero, [](T x, T y) { return x * y; });
+                    case DML_OPERATOR_ELEMENT_WISE_DIVIDE: return Evaluate(zero, [](T x, T y) { return x / y; });
+                    default: return false;
+                    }
+                });
+            };
+        }
+
+        inline ConstantEvaluatorFn MakeCastEvaluator(const TensorDesc& inputTensor, const TensorDesc& outputTensor)
+        {
+            return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+            {
+                return VisitDataType(outputTensor.dataType, [&](auto outputZero)
+                {
+                    using TOut = decltype(outputZero);
+                    return VisitDataType(inputTensor.dataType, [&](auto inputZero)
+                    {
+                        using TIn = decltype(inputZero);
+
+                        // Float to integer casts depend on DML's rounding and saturation, so those aren't folded.
+                        if (std::is_floating_point<TIn>::value && !std::is_floating_point<TOut>::value)
+                        {
+                            return false;
+                        }
+
+                        return EvaluateUnary<TOut, TIn>(inputTensor, inputs[0], outputTensor, output, [](TIn x) { return static_cast<TOut>(x); });
+                    });
+                });
+            };
+        }
+
+        inline ConstantEvaluatorFn MakeSliceEvaluator(
+            const TensorDesc& inputTensor,
+            const TensorDesc& outputTensor,
+            Span<const uint32_t> inputWindowOffsets,
+            Span<const int32_t> inputWindowStrides)
+        {
+            // A slice reads a strided window of the input: offset the input by the window's start, and scale its
+            // strides by the window's strides. Reversed windows (negative strides) aren't folded.
+            const TensorStrides inputStrides = GetElementStrides(inputTensor);
+            uint64_t windowOffset = 0;
+            TensorStrides windowStrides(inputStrides.size());
+            for (size_t i = 0; i < inputStrides.size(); ++i)
+            {
+                if (inputWindowStrides[i] < 0)
+                {
+                    return nullptr;
+                }
+                windowOffset += static_cast<uint64_t>(inputWindowOffsets[i]) * inputStrides[i];
+                windowStrides[i] = inputStrides[i] * static_cast<uint32_t>(inputWindowStrides[i]);
+            }
+
+            return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+            {
+                return VisitDataType(outputTensor.dataType, [&](auto zero)
+                {
+                    using T = decltype(zero);
+                    if (!CoversElements(inputs[0], outputTensor.sizes, windowStrides, windowOffset, sizeof(T)))
+                    {
+                        return false;
+                    }
+
+                    output.assign(static_cast<size_t>(outputTensor.totalTensorSizeInBytes), Byte(0));
+                    MapElements<T, T>(
+                        outputTensor.sizes,
+                        output.data(), 0, GetElementStrides(outputTensor),
+                        inputs[0].data(), windowOffset, windowStrides,
+                        [](T x) { return x; });
+                    return true;
+                });
+            };
+        }
+
+        inline ConstantEvaluatorFn MakeJoinEvaluator(
+            std::vector<TensorDesc> inputTensors,
+            const TensorDesc& outputTensor,
+            uint32_t axis)
+        {
+            return [=](const std::vector<Span<const Byte>>& inputs, std::vector<Byte>& output)
+            {
+                return VisitDataType(outputTensor.dataType, [&](auto zero)
+                {
+                    using T = decltype(zero);
+                    const TensorStrides outputStrides = GetElementStrides(outputTensor);
+                    output.assign(static_cast<size_t>(outputTensor.totalTensorSizeInBytes), Byte(0));
+
+                    // Copy each input into its range of the output along the join axis.
+                    uint64_t outputOffset = 0;
+                    for (size_t i = 0; i < inputTensors.size(); ++i)
+                    {
+                        const TensorDesc& inputTensor = inputTensors[i];
+                        const TensorStrides inputStrides = GetElementStrides(inputTensor);
+                        if (!CoversElements(inputs[i], inputTensor.sizes, inputStrides, 0, sizeof(T)))
+                        {
+                            return false;
+                        }
+
+                        MapElements<T, T>(
+                            inputTensor.sizes,
+                            output.data(), outputOffset, outputStrides,
+                            inputs[i].data(), 0, inputStrides,
+                            [](T x) { return x; });
+                        outputOffset += static_cast<uint64_t>(inputTensor.sizes[axis]) * outputStrides[axis];
+                    }
+                    return true;
+                });
+            };
+        }
+
+        // Evaluates FILL_VALUE_SEQUENCE, or FILL_VALUE_CONSTANT when valueDelta is zero. Elements are numbered in
+        // row-major order of the output sizes, regardless of the output strides.
+        inline ConstantEvaluatorFn MakeFillValueEvaluator(
+            const TensorDesc& outputTensor,
+            DML_TENSOR_DATA_TYPE valueDataType,
+            DML_SCALAR_UNION valueStart,
+            DML_SCALAR_UNION valueDelta)
+        {
+            return [=](const std::vector<Span<const Byte>>&, std::vector<Byte>& output)
+            {
+                return VisitDataType(valueDataType, [&](auto zero)
+                {
+                    using T = decltype(zero);
+                    const T start = ReadScalar<T>(valueStart);
+                    const T delta = ReadScalar<T>(valueDelta);
+                    const TensorStrides outputStrides = GetElementStrides(outputTensor);
+                    const size_t rowSize = outputTensor.sizes.back();
+                    const size_t outStride = outputStrides.back();
+
+                    output.assign(static_cast<size_t>(outputTensor.totalTensorSizeInBytes), Byte(0));
+                    T* out = reinterpret_cast<T*>(output.data());
+                    uint64_t index = 0;
+
+                    ForEachRow<1>(outputTensor.sizes, { 0 }, { &outputStrides }, [&](const std::array<uint64_t, 1>& offsets)
+                    {
+                        T* o = out + offsets[0];
+                        for (size_t i = 0; i < rowSize; ++i, ++index)
+                        {
+                            o[i * outStride] = static_cast<T>(start + delta * static_cast<T>(index));
+                        }
+                    });
+                    return true;
+                });
+            };
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseUnary(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias)
+        {
+            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+            TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+            TDesc desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+
+            detail::NodeOutput* const inputs[] = { input.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            builder->SetConstantEvaluator(node, MakeUnaryElementWiseEvaluator(OperatorType, inputTensor, outputTensor, scaleBias));
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseUnary(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UNKNOWN)
+        {
+            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+            if (outputDataType == DML_TENSOR_DATA_TYPE_UNKNOWN)
+            {
+                outputDataType = inputTensor.dataType;
+            }
+            TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+            TDesc desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+            detail::NodeOutput* const inputs[] = { input.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            builder->SetConstantEvaluator(node, MakeUnaryElementWiseEvaluator(OperatorType, inputTensor, outputTensor, NullOpt));
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseBinary(Expression a, Expression b)
+        {
+            assert(detail::HasSameOwner({ a, b }));
+            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+
+            TensorDesc aTensor = a.Impl()->GetOutputDesc();
+            TensorDesc bTensor = b.Impl()->GetOutputDesc();
+            TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+            TDesc desc = {};
+            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
 
             detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
             detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            builder->SetConstantEvaluator(node, MakeBinaryElementWiseEvaluator(OperatorType, aTensor, bTensor, outputTensor));
             detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
             return output;
@@ -1146,6 +2219,190 @@ namespace dml
             return &storage->opDesc;
         }
 
+        inline bool HasSameLayout(const DML_TENSOR_DESC& a, const DML_TENSOR_DESC& b)
+        {
+            if (a.Type != DML_TENSOR_TYPE_BUFFER || b.Type != DML_TENSOR_TYPE_BUFFER)
+            {
+                return false;
+            }
+
+            const auto& bufferA = *static_cast<const DML_BUFFER_TENSOR_DESC*>(a.Desc);
+            const auto& bufferB = *static_cast<const DML_BUFFER_TENSOR_DESC*>(b.Desc);
+            const uint32_t dimensionCount = bufferA.DimensionCount;
+
+            return bufferA.DataType == bufferB.DataType &&
+                bufferA.DimensionCount == bufferB.DimensionCount &&
+                bufferA.TotalTensorSizeInBytes == bufferB.TotalTensorSizeInBytes &&
+                std::equal(bufferA.Sizes, bufferA.Sizes + dimensionCount, bufferB.Sizes) &&
+                (bufferA.Strides == nullptr) == (bufferB.Strides == nullptr) &&
+                (bufferA.Strides == nullptr || std::equal(bufferA.Strides, bufferA.Strides + dimensionCount, bufferB.Strides));
+        }
+
+        // Returns the fused activation that computes the same result as a standalone activation operator, or None if
+        // the operator can't be expressed as a fused activation. Fused activations only support float data and write
+        // in place to the fused operator's output, so the activation's input and output must share a layout.
+        inline FusedActivation GetEquivalentFusedActivation(DML_OPERATOR_TYPE type, const void* desc)
+        {
+            // All fuseable activation descs have a common layout (see FusedActivationStorage), but only as many float
+            // parameters as the activation uses.
+            const auto& activationDesc = *static_cast<const DML_ACTIVATION_LINEAR_OPERATOR_DESC*>(desc);
+            uint32_t paramCount = 0;
+
+            switch (type)
+            {
+            case DML_OPERATOR_ACTIVATION_IDENTITY:
+            case DML_OPERATOR_ACTIVATION_RELU:
+            case DML_OPERATOR_ACTIVATION_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_SOFTSIGN:
+            case DML_OPERATOR_ACTIVATION_TANH:
+#if DML_TARGET_VERSION >= 0x5100
+            case DML_OPERATOR_ACTIVATION_GELU:
+#endif // DML_TARGET_VERSION >= 0x5100
+                paramCount = 0;
+                break;
+
+            case DML_OPERATOR_ACTIVATION_ELU:
+            case DML_OPERATOR_ACTIVATION_LEAKY_RELU:
+            case DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU:
+            case DML_OPERATOR_ACTIVATION_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_CELU:
+                paramCount = 1;
+                break;
+
+            case DML_OPERATOR_ACTIVATION_HARD_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_LINEAR:
+            case DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_SCALED_ELU:
+            case DML_OPERATOR_ACTIVATION_SCALED_TANH:
+            case DML_OPERATOR_ACTIVATION_SHRINK:
+                paramCount = 2;
+                break;
+
+            default:
+                return FusedActivation::None();
+            }
+
+            if (!HasSameLayout(*activationDesc.InputTensor, *activationDesc.OutputTensor))
+            {
+                return FusedActivation::None();
+            }
+
+            const auto& inputDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(activationDesc.InputTensor->Desc);
+            if (inputDesc.DataType != DML_TENSOR_DATA_TYPE_FLOAT32 && inputDesc.DataType != DML_TENSOR_DATA_TYPE_FLOAT16)
+            {
+                return FusedActivation::None();
+            }
+
+            return FusedActivation(
+                type,
+                paramCount >= 1 ? activationDesc.Alpha : 0.0f,
+                paramCount >= 2 ? activationDesc.Beta : 0.0f);
+        }
+
+        inline uint64_t GetElementCount(const uint32_t* sizes, uint32_t dimensionCount)
+        {
+            uint64_t elementCount = 1;
+            for (uint32_t i = 0; i < dimensionCount; ++i)
+            {
+                elementCount *= sizes[i];
+            }
+            return elementCount;
+        }
+
+        // Returns a rough estimate of the arithmetic operations needed per element of an operator's first output. Only
+        // operators that reduce over a window of their input (GEMM, convolution, pooling and reduce) are modeled; every
+        // other operator counts as one operation per output element.
+        inline uint64_t EstimateOpsPerOutputElement(DML_OPERATOR_TYPE type, const void* desc)
+        {
+            auto BufferDesc = [](const DML_TENSOR_DESC* tensor)
+            {
+                return *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+            };
+
+            switch (type)
+            {
+            case DML_OPERATOR_GEMM:
+            {
+                // A multiply-add per element of the shared K dimension.
+                const auto& gemmDesc = *static_cast<const DML_GEMM_OPERATOR_DESC*>(desc);
+                const auto aDesc = BufferDesc(gemmDesc.ATensor);
+                const uint32_t kDimension = aDesc.DimensionCount - (gemmDesc.TransA == DML_MATRIX_TRANSFORM_NONE ? 1 : 2);
+                return 2 * uint64_t(aDesc.Sizes[kDimension]);
+            }
+
+            case DML_OPERATOR_CONVOLUTION:
+            {
+                // A multiply-add per filter element feeding the output channel: {C / groups, spatial...}. This is exact
+                // for forward convolution and an upper bound for backward (transposed) convolution.
+                const auto& convolutionDesc = *static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc);
+                const auto filterDesc = BufferDesc(convolutionDesc.FilterTensor);
+                return 2 * GetElementCount(filterDesc.Sizes + 1, filterDesc.DimensionCount - 1);
+            }
+
+            case DML_OPERATOR_AVERAGE_POOLING:
+            {
+                const auto& poolingDesc = *static_cast<const DML_AVERAGE_POOLING_OPERATOR_DESC*>(desc);
+                return GetElementCount(poolingDesc.WindowSize, poolingDesc.DimensionCount);
+            }
+
+#if DML_TARGET_VERSION >= 0x6200
+            case DML_OPERATOR_AVERAGE_POOLING1:
+            {
+                const auto& poolingDesc = *static_cast<const DML_AVERAGE_POOLING1_OPERATOR_DESC*>(desc);
+                return GetElementCount(poolingDesc.WindowSize, poolingDesc.DimensionCount);
+            }
+#endif // DML_TARGET_VERSION >= 0x6200
+
+            case DML_OPERATOR_MAX_POOLING2:
+            {
+                const auto& poolingDesc = *static_cast<const DML_MAX_POOLING2_OPERATOR_DESC*>(desc);
+                return GetElementCount(poolingDesc.WindowSize, poolingDesc.DimensionCount);
+            }
+
+            case DML_OPERATOR_REDUCE:
+            {
+                const auto& reduceDesc = *static_cast<const DML_REDUCE_OPERATOR_DESC*>(desc);
+                const auto inputDesc = BufferDesc(reduceDesc.InputTensor);
+                uint64_t reducedElementCount = 1;
+                for (uint32_t i = 0; i < reduceDesc.AxisCount; ++i)
+                {
+                    reducedElementCount *= inputDesc.Sizes[reduceDesc.Axes[i]];
+                }
+                return reducedElementCount;
+            }
+
+            default:
+                return 1;
+            }
+        }
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+        // Layout costs used when Graph::SetLayoutAssignment is given no cost function: convolution, pooling and batch
+        // normalization are assumed to run faster with channels interleaved (NHWC), and everything else to not care.
+        inline float GetDefaultLayoutCost(DML_OPERATOR_TYPE type, TensorLayout layout)
+        {
+            switch (type)
+            {
+            case DML_OPERATOR_CONVOLUTION:
+            case DML_OPERATOR_CONVOLUTION_INTEGER:
+            case DML_OPERATOR_QUANTIZED_LINEAR_CONVOLUTION:
+            case DML_OPERATOR_AVERAGE_POOLING:
+#if DML_TARGET_VERSION >= 0x6200
+            case DML_OPERATOR_AVERAGE_POOLING1:
+#endif // DML_TARGET_VERSION >= 0x6200
+            case DML_OPERATOR_MAX_POOLING:
+            case DML_OPERATOR_MAX_POOLING1:
+            case DML_OPERATOR_MAX_POOLING2:
+            case DML_OPERATOR_LP_POOLING:
+            case DML_OPERATOR_BATCH_NORMALIZATION:
+                return layout == TensorLayout::InterleavedChannel ? 0.8f : 1.0f;
+
+            default:
+                return 1.0f;
+            }
+        }
+#endif
+
     } // namespace detail
 
     inline Expression InputTensor(Graph& graph, uint32_t inputIndex, TensorDesc desc)
@@ -1195,13 +2452,33 @@ namespace dml
         TensorDesc bTensor = b.Impl()->GetOutputDesc();
         TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
 
-        DML_ELEMENT_WISE_ADD_OPERATOR_DESC desc = {};
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        // An activation fused at compile time turns this into ELEMENT_WISE_ADD1.
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            if (activation.activation == DML_OPERATOR_INVALID)
+            {
+                DML_ELEMENT_WISE_ADD_OPERATOR_DESC desc = {};
+                desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+                desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+                desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+                use({ DML_OPERATOR_ELEMENT_WISE_ADD, &desc });
+            }
+            else
+            {
+                detail::FusedActivationStorage storage;
+
+                DML_ELEMENT_WISE_ADD1_OPERATOR_DESC desc = {};
+                desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+                desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+                desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+                desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+                use({ DML_OPERATOR_ELEMENT_WISE_ADD1, &desc });
+            }
+        };
 
         detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ADD, &desc, inputs);
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), FusedActivation::None(), inputs);
+        builder->SetConstantEvaluator(node, detail::MakeBinaryElementWiseEvaluator(DML_OPERATOR_ELEMENT_WISE_ADD, aTensor, bTensor, outputTensor));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -1215,16 +2492,21 @@ namespace dml
         TensorDesc aTensor = a.Impl()->GetOutputDesc();
         TensorDesc bTensor = b.Impl()->GetOutputDesc();
         TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
-        detail::FusedActivationStorage storage;
 
-        DML_ELEMENT_WISE_ADD1_OPERATOR_DESC desc = {};
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            detail::FusedActivationStorage storage;
+
+            DML_ELEMENT_WISE_ADD1_OPERATOR_DESC desc = {};
+            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+            use({ DML_OPERATOR_ELEMENT_WISE_ADD1, &desc });
+        };
 
         detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ADD1, &desc, inputs);
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), fusedActivation, inputs);
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -2008,26 +3290,39 @@ namespace dml
         }
 
         TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
-        detail::FusedActivationStorage storage;
 
-        DML_CONVOLUTION_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.FilterTensor = filterTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Mode = mode;
-        desc.Direction = direction;
-        desc.DimensionCount = spatialDimensionCount;
-        desc.Strides = strides.data();
-        desc.Dilations = dilations.data();
-        desc.StartPadding = startPadding.data();
-        desc.EndPadding = endPadding.data();
-        desc.OutputPadding = outputPadding.data();
-        desc.GroupCount = groupCount;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+        // The desc may be rebuilt at compile time, after the caller's spans are gone, so keep copies.
+        const bool hasBias = bias.has_value();
+        SmallVector<uint32_t, 3> stridesCopy(strides.begin(), strides.end());
+        SmallVector<uint32_t, 3> dilationsCopy(dilations.begin(), dilations.end());
+        SmallVector<uint32_t, 3> startPaddingCopy(startPadding.begin(), startPadding.end());
+        SmallVector<uint32_t, 3> endPaddingCopy(endPadding.begin(), endPadding.end());
+        SmallVector<uint32_t, 3> outputPaddingCopy(outputPadding.begin(), outputPadding.end());
+
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            detail::FusedActivationStorage storage;
+
+            DML_CONVOLUTION_OPERATOR_DESC desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.FilterTensor = filterTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BiasTensor = hasBias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.Mode = mode;
+            desc.Direction = direction;
+            desc.DimensionCount = spatialDimensionCount;
+            desc.Strides = stridesCopy.data();
+            desc.Dilations = dilationsCopy.data();
+            desc.StartPadding = startPaddingCopy.data();
+            desc.EndPadding = endPaddingCopy.data();
+            desc.OutputPadding = outputPaddingCopy.data();
+            desc.GroupCount = groupCount;
+            desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+            use({ DML_OPERATOR_CONVOLUTION, &desc });
+        };
 
         detail::NodeOutput* const inputs[] = { input.Impl(), filter.Impl(), bias ? bias->Impl() : nullptr };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CONVOLUTION, &desc, inputs);
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), fusedActivation, inputs);
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -2126,21 +3421,27 @@ namespace dml
         outputSizes.push_back(transB == DML_MATRIX_TRANSFORM_NONE ? bTensor.sizes[3] : bTensor.sizes[2]);
 
         TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
-        detail::FusedActivationStorage storage;
+        const bool hasC = c.has_value();
 
-        DML_GEMM_OPERATOR_DESC desc = {};
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.CTensor = c ? cTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.TransA = transA;
-        desc.TransB = transB;
-        desc.Alpha = alpha;
-        desc.Beta = beta;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            detail::FusedActivationStorage storage;
+
+            DML_GEMM_OPERATOR_DESC desc = {};
+            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.CTensor = hasC ? cTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.TransA = transA;
+            desc.TransB = transB;
+            desc.Alpha = alpha;
+            desc.Beta = beta;
+            desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+            use({ DML_OPERATOR_GEMM, &desc });
+        };
 
         detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl(), c ? c->Impl() : nullptr };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GEMM, &desc, inputs);
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), fusedActivation, inputs);
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -2493,6 +3794,7 @@ namespace dml
 
         detail::NodeOutput* const inputs[] = { input.Impl() };
         detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SLICE1, &sliceDesc, inputs);
+        builder->SetConstantEvaluator(node, detail::MakeSliceEvaluator(inputTensor, outputTensor, inputWindowOffsets, inputWindowStrides));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -2511,6 +3813,7 @@ namespace dml
 
         detail::NodeOutput* const inputs[] = { input.Impl() };
         detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CAST, &desc, inputs);
+        builder->SetConstantEvaluator(node, detail::MakeCastEvaluator(inputTensor, outputTensor));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -2604,6 +3907,7 @@ namespace dml
         desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
 
         detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_JOIN, &desc, inputNodes);
+        builder->SetConstantEvaluator(node, detail::MakeJoinEvaluator(inputTensors, outputTensor, axis));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -3020,21 +4324,25 @@ namespace dml
         TensorDesc biasTensor = bias.Impl()->GetOutputDesc();
         TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
 
-        detail::FusedActivationStorage storage;
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            detail::FusedActivationStorage storage;
 
-        DML_BATCH_NORMALIZATION_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.MeanTensor = meanTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.VarianceTensor = varianceTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BiasTensor = biasTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Spatial = spatial;
-        desc.Epsilon = epsilon;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+            DML_BATCH_NORMALIZATION_OPERATOR_DESC desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.MeanTensor = meanTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.VarianceTensor = varianceTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BiasTensor = biasTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.Spatial = spatial;
+            desc.Epsilon = epsilon;
+            desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+            use({ DML_OPERATOR_BATCH_NORMALIZATION, &desc });
+        };
 
         detail::NodeOutput* const inputs[] = { input.Impl(), mean.Impl(), variance.Impl(), scale.Impl(), bias.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_BATCH_NORMALIZATION, &desc, inputs);
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), fusedActivation, inputs);
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -3214,24 +4522,38 @@ namespace dml
             biasTensor = bias->Impl()->GetOutputDesc();
         }
 
-        detail::FusedActivationStorage storage;
+        // The desc may be rebuilt at compile time, after the caller's axes are gone, so keep a copy.
+        const bool hasScale = scale.has_value();
+        const bool hasBias = bias.has_value();
+        SmallVector<uint32_t, 4> axesCopy(axes.begin(), axes.end());
+
+        auto makeDesc = [=](FusedActivation activation, const std::function<void(const DML_OPERATOR_DESC&)>& use) mutable
+        {
+            detail::FusedActivationStorage storage;
 
 #if DML_TARGET_VERSION >= 0x6300
-        DML_MEAN_VARIANCE_NORMALIZATION2_OPERATOR_DESC desc = {};
-        desc.UseMean = normalizeMean;
-        desc.UseVariance = normalizeVariance;
+            DML_MEAN_VARIANCE_NORMALIZATION2_OPERATOR_DESC desc = {};
+            desc.UseMean = normalizeMean;
+            desc.UseVariance = normalizeVariance;
 #else
-        DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC desc = {};
-        desc.NormalizeVariance = normalizeVariance;
+            DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC desc = {};
+            desc.NormalizeVariance = normalizeVariance;
 #endif
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scale ? scaleTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.AxisCount = static_cast<UINT>(axes.size());
-        desc.Axes = axes.data();
-        desc.Epsilon = epsilon;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.ScaleTensor = hasScale ? scaleTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+            desc.BiasTensor = hasBias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.AxisCount = static_cast<UINT>(axesCopy.size());
+            desc.Axes = axesCopy.data();
+            desc.Epsilon = epsilon;
+            desc.FusedActivation = detail::GetFusedActivationPtr(activation, &storage);
+
+#if DML_TARGET_VERSION >= 0x6300
+            use({ DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION2, &desc });
+#else
+            use({ DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1, &desc });
+#endif
+        };
 
         detail::NodeOutput* const inputs[] =
         {
@@ -3240,11 +4562,7 @@ namespace dml
             bias ? bias->Impl() : nullptr
         };
 
-#if DML_TARGET_VERSION >= 0x6300
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION2, &desc, inputs);
-#else
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1, &desc, inputs);
-#endif
+        detail::NodeID node = builder->CreateFusibleOperatorNode(std::move(makeDesc), fusedActivation, inputs);
 
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
@@ -3548,6 +4866,7 @@ namespace dml
         desc.Value = value;
 
         detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_CONSTANT, &desc, {});
+        builder->SetConstantEvaluator(node, detail::MakeFillValueEvaluator(outputTensor, valueDataType, value, DML_SCALAR_UNION{}));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -3570,6 +4889,7 @@ namespace dml
         desc.ValueDelta = valueDelta;
 
         detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_SEQUENCE, &desc, {});
+        builder->SetConstantEvaluator(node, detail::MakeFillValueEvaluator(outputTensor, valueDataType, valueStart, valueDelta));
         detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
         return output;
@@ -4409,16 +5729,22 @@ namespace dml
         {
             DML_OPERATOR_DESC opDesc = { type, desc };
 
-            Microsoft::WRL::ComPtr<IDMLOperator> op;
-            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&op)));
-
             OperatorNode node = {};
-            node.op = std::move(op);
-            node.inputs.assign(inputs.begin(), inputs.end());
-            if (!m_name.empty())
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // The desc is deep-copied, so creating the operator can wait until a graph that uses it is compiled.
+            node.desc = SchemaHelpers::ConvertOperatorDesc(opDesc);
+#else
+            if (!m_device)
             {
-                node.name = m_name;
+                DMLX_THROW(E_INVALIDARG); // Building a graph without a device requires DMLX_USE_GRAPH_SERIALIZATION
             }
+            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&node.op)));
+#endif
+            node.inputs = Span<NodeOutput* const>(m_arena.Copy(inputs.data(), inputs.size()), inputs.size());
+            node.equivalentFusedActivation = GetEquivalentFusedActivation(type, desc);
+            node.type = type;
+            node.opsPerOutputElement = EstimateOpsPerOutputElement(type, desc);
+            node.name = GetInternedName();
 
             uint32_t index = static_cast<uint32_t>(m_operatorNodes.size());
             m_operatorNodes.push_back(std::move(node));
@@ -4426,170 +5752,1377 @@ namespace dml
             return { NodeType::Operator, index };
         }
 
-        inline NodeID GraphBuilder::CreateInputNode(uint32_t inputIndex)
+        inline NodeID GraphBuilder::CreateFusibleOperatorNode(
+            FusibleOperatorDescFn makeDesc,
+            FusedActivation fusedActivation,
+            Span<NodeOutput* const> inputs)
         {
-            uint32_t index = static_cast<uint32_t>(m_inputNodes.size());
-            m_inputNodes.push_back(InputNode{ inputIndex });
-            return { NodeType::Input, index };
-        }
+            NodeID node = {};
+            makeDesc(fusedActivation, [&](const DML_OPERATOR_DESC& opDesc)
+            {
+                node = CreateOperatorNode(opDesc.Type, opDesc.Desc, inputs);
+            });
 
-        inline NodeID GraphBuilder::CreateReinterpretNode(NodeOutput* input)
-        {
-            uint32_t index = static_cast<uint32_t>(m_reinterpretNodes.size());
-            m_reinterpretNodes.push_back(ReinterpretNode{ input });
-            return { NodeType::Reinterpret, index };
+            if (fusedActivation.activation == DML_OPERATOR_INVALID)
+            {
+                m_operatorNodes[node.index].makeDescWithFusedActivation = std::move(makeDesc);
+            }
+
+            return node;
         }
 
-#if DML_TARGET_VERSION >= 0x6200
-        inline NodeID GraphBuilder::CreateConstantNode(Span<const Byte> data)
+        inline GraphBuilder::ActivationFusion GraphBuilder::FuseActivations(
+            Span<const Expression> outputs,
+            const std::vector<uint32_t>& foldedInto,
+            bool createOperators) const
         {
-            uint32_t index = static_cast<uint32_t>(m_constantNodes.size());
-            m_constantNodes.push_back(ConstantNode{ data });
+            const uint32_t operatorCount = static_cast<uint32_t>(m_operatorNodes.size());
+
+            ActivationFusion fusion;
+            fusion.fusedInto.assign(operatorCount, UINT32_MAX);
+            fusion.fusedOperators.resize(operatorCount);
+
+            // Count the uses of each operator's first output (the only one a fused activation applies to), including
+            // uses through reinterpret nodes and as graph outputs.
+            std::vector<uint32_t> useCounts(operatorCount);
+            auto CountUse = [&](NodeOutput* output)
+            {
+                output = SkipReinterprets(output);
+                if (output->GetNode().type == NodeType::Operator && output->GetOutputIndex() == 0)
+                {
+                    ++useCounts[output->GetNode().index];
+                }
+            };
+
+            for (const OperatorNode& node : m_operatorNodes)
+            {
+                for (NodeOutput* input : node.inputs)
+                {
+                    if (input)
+                    {
+                        CountUse(input);
+                    }
+                }
+            }
 
-            if (!m_name.empty())
+            for (const Expression& output : outputs)
             {
-                m_constantNodes.back().name = m_name;
+                if (output)
+                {
+                    CountUse(output.Impl());
+                }
             }
 
-            return { NodeType::Constant, index };
-        }
-#endif // DML_TARGET_VERSION >= 0x6200
+            for (uint32_t activationIndex = 0; activationIndex < operatorCount; ++activationIndex)
+            {
+                const OperatorNode& activation = m_operatorNodes[activationIndex];
+                if (activation.equivalentFusedActivation.activation == DML_OPERATOR_INVALID || foldedInto[activationIndex] != UINT32_MAX)
+                {
+                    continue;
+                }
 
-        inline NodeOutput* GraphBuilder::CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
-        {
-            // Construct the object in the deque, which doesn't invalidate references to elements as it grows
-            m_nodeOutputs.emplace_back(this, node, outputIndex, std::move(tensorDesc));
+                // The activation must read the producer's output directly: a reinterpret in between could change
+                // the shape or strides the activation sees.
+                NodeOutput* input = activation.inputs[0];
+                if (input->GetNode().type != NodeType::Operator || input->GetOutputIndex() != 0)
+                {
+                    continue;
+                }
 
-            return &m_nodeOutputs.back();
+                const uint32_t producerIndex = input->GetNode().index;
+                const OperatorNode& producer = m_operatorNodes[producerIndex];
+                if (!producer.makeDescWithFusedActivation || useCounts[producerIndex] != 1 || foldedInto[producerIndex] != UINT32_MAX)
+                {
+                    continue;
+                }
+
+                if (!createOperators)
+                {
+                    fusion.fusedInto[activationIndex] = producerIndex;
+                    continue;
+                }
+
+                // Not every operator supports every fused activation for every data type, so leave the pair as is
+                // if DML rejects the fused operator.
+                Microsoft::WRL::ComPtr<IDMLOperator> fusedOp;
+                producer.makeDescWithFusedActivation(activation.equivalentFusedActivation, [&](const DML_OPERATOR_DESC& opDesc)
+                {
+                    if (FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&fusedOp))))
+                    {
+                        fusedOp = nullptr;
+                    }
+                });
+
+                if (fusedOp)
+                {
+                    fusion.fusedOperators[producerIndex] = std::move(fusedOp);
+                    fusion.fusedInto[activationIndex] = producerIndex;
+                }
+            }
+
+            return fusion;
         }
 
-        inline GraphDesc GraphBuilder::GetGraphDesc(Span<const Expression> outputs) const
+        inline GraphBuilder::ConstantFolding GraphBuilder::FoldConstants(Span<const Expression> outputs) const
         {
-            GraphDesc desc = {};
-            desc.inputCount = static_cast<uint32_t>(m_inputNodes.size());
-            desc.outputCount = static_cast<uint32_t>(outputs.size());
+            const uint32_t operatorCount = static_cast<uint32_t>(m_operatorNodes.size());
 
-            // GraphDesc merges nodes into a single list, with all operator nodes appearing before constant nodes.
-            constexpr uint32_t baseOperatorNodeIndex = 0;
-            const uint32_t baseConstantNodeIndex = static_cast<uint32_t>(m_operatorNodes.size());
+            ConstantFolding folding;
+            folding.foldedInto.assign(operatorCount, UINT32_MAX);
 
-            for (const OperatorNode& node : m_operatorNodes)
+#if DML_TARGET_VERSION >= 0x6200
+            // Graph outputs can't be connected to constant nodes.
+            std::vector<bool> producesGraphOutput(operatorCount);
+            for (const Expression& output : outputs)
             {
-                uint32_t nodeIndex = static_cast<uint32_t>(desc.operatorNodes.size());
+                if (output)
+                {
+                    NodeOutput* source = SkipReinterprets(output.Impl());
+                    if (source->GetNode().type == NodeType::Operator)
+                    {
+                        producesGraphOutput[source->GetNode().index] = true;
+                    }
+                }
+            }
 
-                desc.operatorNodes.push_back(DML_OPERATOR_GRAPH_NODE_DESC{ node.op.Get(), (!node.name.empty() ? node.name.c_str() : nullptr) });
+            // Operator nodes are created after the nodes they consume, so a single pass in creation order also folds
+            // chains of operators.
+            std::vector<Span<const Byte>> inputData;
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                const OperatorNode& node = m_operatorNodes[operatorIndex];
+                if (!node.evaluateConstant || producesGraphOutput[operatorIndex])
+                {
+                    continue;
+                }
 
-                // Walk through each of this node's inputs and add it as an edge
-                const uint32_t inputCount = static_cast<uint32_t>(node.inputs.size());
-                for (uint32_t inputIndex = 0; inputIndex < inputCount; ++inputIndex)
+                // Reinterprets don't change the data, only how the operator reads it (which its evaluator already
+                // accounts for), so constants are read through them as is.
+                inputData.clear();
+                bool hasOnlyConstantInputs = true;
+                for (NodeOutput* input : node.inputs)
                 {
-                    NodeOutput* input = node.inputs[inputIndex];
                     if (input == nullptr)
                     {
+                        inputData.emplace_back();
                         continue;
                     }
-                    NodeID inputNode = input->GetNode();
-
-                    // Reinterpret nodes aren't "real" nodes, they're just used to modify TensorDescs across
-                    // edges. So we follow this node backwards until it hits a real node.
-                    while (inputNode.type == NodeType::Reinterpret)
-                    {
-                        input = m_reinterpretNodes[inputNode.index].input;
-                        inputNode = input->GetNode();
-                    }
-
-                    if (inputNode.type == NodeType::Input)
-                    {
-                        DML_INPUT_GRAPH_EDGE_DESC inputEdge = {};
-                        inputEdge.GraphInputIndex = m_inputNodes[inputNode.index].inputIndex;
-                        inputEdge.ToNodeIndex = nodeIndex;
-                        inputEdge.ToNodeInputIndex = inputIndex;
 
-                        desc.inputEdges.push_back(inputEdge);
-                    }
-                    else if (inputNode.type == NodeType::Operator)
+                    NodeID source = SkipReinterprets(input)->GetNode();
+                    if (source.type == NodeType::Constant)
                     {
-                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
-                        intermediateEdge.FromNodeIndex = baseOperatorNodeIndex + inputNode.index;
-                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
-                        intermediateEdge.ToNodeIndex = nodeIndex;
-                        intermediateEdge.ToNodeInputIndex = inputIndex;
-
-                        desc.intermediateEdges.push_back(intermediateEdge);
+                        inputData.push_back(m_constantNodes[source.index].data);
                     }
-                    else if (inputNode.type == NodeType::Constant)
+                    else if (source.type == NodeType::Operator && folding.foldedInto[source.index] != UINT32_MAX)
                     {
-                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
-                        intermediateEdge.FromNodeIndex = baseConstantNodeIndex + inputNode.index;
-                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
-                        intermediateEdge.ToNodeIndex = nodeIndex;
-                        intermediateEdge.ToNodeInputIndex = inputIndex;
-
-                        desc.intermediateEdges.push_back(intermediateEdge);
+                        const std::vector<Byte>& data = folding.data[folding.foldedInto[source.index]];
+                        inputData.push_back(Span<const Byte>(data.data(), data.size()));
                     }
                     else
                     {
-                        assert(false); // Invalid node type
-                        DMLX_THROW(E_UNEXPECTED);
+                        hasOnlyConstantInputs = false;
+                        break;
                     }
                 }
-            }
 
-#if DML_TARGET_VERSION >= 0x6200
-            for (const ConstantNode& node : m_constantNodes)
-            {
-                desc.constantNodes.push_back(DML_CONSTANT_DATA_GRAPH_NODE_DESC{ node.data.data(), node.data.size(), (!node.name.empty() ? node.name.c_str() : nullptr)});
+                std::vector<Byte> output;
+                if (hasOnlyConstantInputs && node.evaluateConstant(inputData, output))
+                {
+                    folding.foldedInto[operatorIndex] = static_cast<uint32_t>(folding.data.size());
+                    folding.data.push_back(std::move(output));
+                }
             }
+#else
+            (void)outputs;
 #endif // DML_TARGET_VERSION >= 0x6200
 
-            // Add output edges
-            for (uint32_t outputIndex = 0; outputIndex < desc.outputCount; ++outputIndex)
+            return folding;
+        }
+
+        inline std::vector<bool> GraphBuilder::FindUsedOperators(Span<const Expression> outputs) const
+        {
+            // Nodes are created after the nodes they consume, so visiting operators in reverse creation order finds
+            // every contributing operator in one pass.
+            std::vector<bool> isUsed(m_operatorNodes.size());
+            auto MarkUsed = [&](NodeOutput* output)
             {
-                NodeOutput* output = outputs[outputIndex].Impl();
-                if (output == nullptr)
+                NodeID source = SkipReinterprets(output)->GetNode();
+                if (source.type == NodeType::Operator)
                 {
-                    continue;
+                    isUsed[source.index] = true;
                 }
-                NodeID outputNode = output->GetNode();
+            };
 
-                // Reinterpret nodes are meaningless on outputs (they're no-ops), so just follow them back until we
-                // get to a real operator node.
-                while (outputNode.type == NodeType::Reinterpret)
+            for (const Expression& output : outputs)
+            {
+                if (output)
                 {
-                    output = m_reinterpretNodes[outputNode.index].input;
-                    outputNode = output->GetNode();
+                    MarkUsed(output.Impl());
                 }
+            }
 
-                if (outputNode.type == NodeType::Input)
+            for (size_t operatorIndex = m_operatorNodes.size(); operatorIndex-- > 0;)
+            {
+                if (isUsed[operatorIndex])
                 {
-                    // It's not valid to connect an output of the graph directly to an input without an intervening
-                    // node. If this behavior is desired, it should instead be accomplished with a copy e.g. using
-                    // the elementwise identity operator.
-                    DMLX_THROW(E_INVALIDARG);
+                    for (NodeOutput* input : m_operatorNodes[operatorIndex].inputs)
+                    {
+                        if (input)
+                        {
+                            MarkUsed(input);
+                        }
+                    }
                 }
+            }
 
-                assert(outputNode.type == NodeType::Operator);
+            return isUsed;
+        }
 
-                DML_OUTPUT_GRAPH_EDGE_DESC outputEdge = {};
-                outputEdge.FromNodeIndex = output->GetNode().index;
-                outputEdge.FromNodeOutputIndex = output->GetOutputIndex();
-                outputEdge.GraphOutputIndex = outputIndex;
+#if DMLX_USE_GRAPH_SERIALIZATION
+        inline void GraphBuilder::CreateOperator(const OperatorNode& node, BucketAllocator& allocator) const
+        {
+            if (!m_device)
+            {
+                DMLX_THROW(E_INVALIDARG); // The graph was built without a device; see Graph::SetDevice
+            }
 
-                desc.outputEdges.push_back(outputEdge);
+            DML_OPERATOR_DESC opDesc = SchemaHelpers::ConvertOperatorDesc(node.desc, &allocator);
+            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&node.op)));
+        }
+
+        inline GraphBuilder::LayoutAssignment GraphBuilder::AssignLayouts(
+            Span<const Expression> outputs,
+            const std::vector<uint32_t>& operatorNodeIndices,
+            const ActivationFusion& fusion,
+            const LayoutCostFn& layoutCost) const
+        {
+            const uint32_t operatorCount = static_cast<uint32_t>(m_operatorNodes.size());
+
+            LayoutAssignment assignment;
+            assignment.isInterleaved.assign(operatorCount, false);
+            assignment.firstTensorIds.resize(operatorCount);
+
+            // Fused activations are created after the operator they're fused into, so their tensor IDs are known.
+            uint32_t tensorCount = 0;
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (fusion.fusedInto[i] != UINT32_MAX)
+                {
+                    assignment.firstTensorIds[i] = assignment.firstTensorIds[fusion.fusedInto[i]];
+                }
+                else
+                {
+                    assignment.firstTensorIds[i] = tensorCount;
+                    tensorCount += static_cast<uint32_t>(m_operatorNodes[i].desc.GetOutputTensors().size());
+                }
             }
 
-            // Sanity
-            assert(desc.operatorNodes.size() == m_operatorNodes.size());
-#if DML_TARGET_VERSION >= 0x6200
-            assert(desc.constantNodes.size() == m_constantNodes.size());
-#endif // DML_TARGET_VERSION >= 0x6200
-            assert(desc.outputEdges.size() == desc.outputCount);
-            assert(desc.outputCount == outputs.size());
-            assert(baseOperatorNodeIndex == desc.BaseOperatorNodeIndexInMergedNodes());
-            assert(baseConstantNodeIndex == desc.BaseConstantNodeIndexInMergedNodes());
+            auto IsEmitted = [&](uint32_t operatorIndex) { return operatorNodeIndices[operatorIndex] != UINT32_MAX; };
+            auto TensorId = [&](NodeOutput* output) { return assignment.firstTensorIds[output->GetNode().index] + output->GetOutputIndex(); };
+
+            // Operators recreated with a fused activation have no desc to rewrite, so they keep the default layout.
+            std::vector<bool> hasFusedActivation(operatorCount);
+            for (uint32_t producer : fusion.fusedInto)
+            {
+                if (producer != UINT32_MAX)
+                {
+                    hasFusedActivation[producer] = true;
+                }
+            }
+            auto IsChangeable = [&](uint32_t operatorIndex) { return IsEmitted(operatorIndex) && !hasFusedActivation[operatorIndex]; };
+
+            // A tensor is flexible if its producer is in the graph and writes it packed, with a rank and data type that
+            // the interleaved layout and the element-wise identity used for transposes apply to.
+            std::vector<bool>& isFlexible = assignment.isFlexible;
+            isFlexible.assign(tensorCount, false);
+            std::vector<uint32_t> tensorProducers(tensorCount);
+            std::vector<const DmlBufferTensorDesc*> tensorDescs(tensorCount);
+            std::vector<uint64_t> operatorBytes(operatorCount);
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (fusion.fusedInto[i] != UINT32_MAX)
+                {
+                    continue;
+                }
+
+                std::vector<const DmlBufferTensorDesc*> outputTensors = m_operatorNodes[i].desc.GetOutputTensors();
+                for (uint32_t outputIndex = 0; outputIndex < outputTensors.size(); ++outputIndex)
+                {
+                    const DmlBufferTensorDesc* tensor = outputTensors[outputIndex];
+                    if (!tensor)
+                    {
+                        continue;
+                    }
+
+                    const uint32_t tensorId = assignment.firstTensorIds[i] + outputIndex;
+                    tensorProducers[tensorId] = i;
+                    tensorDescs[tensorId] = tensor;
+                    operatorBytes[i] += tensor->totalTensorSizeInBytes;
+                    isFlexible[tensorId] = IsEmitted(i) &&
+                        !tensor->strides &&
+                        tensor->sizes.size() >= 3 && tensor->sizes.size() <= 5 &&
+                        (tensor->dataType == DML_TENSOR_DATA_TYPE_FLOAT32 || tensor->dataType == DML_TENSOR_DATA_TYPE_FLOAT16);
+                }
+            }
+
+            // Every consumer must read the tensor directly and expect it packed: a reinterpret may change the shape or
+            // strides it's read with.
+            std::vector<std::vector<uint32_t>> tensorConsumers(tensorCount);
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (!IsEmitted(i))
+                {
+                    continue;
+                }
+
+                const OperatorNode& node = m_operatorNodes[i];
+                std::vector<const DmlBufferTensorDesc*> inputTensors = node.desc.GetInputTensors();
+                for (uint32_t inputIndex = 0; inputIndex < node.inputs.size(); ++inputIndex)
+                {
+                    NodeOutput* input = node.inputs[inputIndex];
+                    const DmlBufferTensorDesc* inputTensor = inputIndex < inputTensors.size() ? inputTensors[inputIndex] : nullptr;
+                    if (!input)
+                    {
+                        continue;
+                    }
+
+                    if (inputTensor)
+                    {
+                        operatorBytes[i] += inputTensor->totalTensorSizeInBytes;
+                    }
+
+                    NodeOutput* source = SkipReinterprets(input);
+                    if (source->GetNode().type != NodeType::Operator)
+                    {
+                        continue;
+                    }
+
+                    const uint32_t tensorId = TensorId(source);
+                    if (!isFlexible[tensorId])
+                    {
+                        continue;
+                    }
+
+                    if (source != input || !inputTensor || inputTensor->strides || inputTensor->sizes != tensorDescs[tensorId]->sizes)
+                    {
+                        isFlexible[tensorId] = false;
+                    }
+                    else
+                    {
+                        tensorConsumers[tensorId].push_back(i);
+                    }
+                }
+            }
+
+            // Graph outputs keep the layout the caller expects.
+            for (const Expression& output : outputs)
+            {
+                if (output)
+                {
+                    NodeOutput* source = SkipReinterprets(output.Impl());
+                    if (source->GetNode().type == NodeType::Operator)
+                    {
+                        isFlexible[TensorId(source)] = false;
+                    }
+                }
+            }
+
+            // The flexible tensors each operator reads or writes.
+            std::vector<std::vector<uint32_t>> operatorTensors(operatorCount);
+            for (uint32_t tensorId = 0; tensorId < tensorCount; ++tensorId)
+            {
+                if (!isFlexible[tensorId] || tensorConsumers[tensorId].empty())
+                {
+                    continue;
+                }
+
+                operatorTensors[tensorProducers[tensorId]].push_back(tensorId);
+                for (uint32_t consumer : tensorConsumers[tensorId])
+                {
+                    operatorTensors[consumer].push_back(tensorId);
+                }
+            }
+
+            std::vector<uint32_t> candidates;
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (IsChangeable(i) && !operatorTensors[i].empty())
+                {
+                    candidates.push_back(i);
+                }
+            }
+
+            std::vector<bool>& isInterleaved = assignment.isInterleaved;
+            auto OperatorCost = [&](uint32_t operatorIndex, bool interleaved)
+            {
+                const TensorLayout layout = interleaved ? TensorLayout::InterleavedChannel : TensorLayout::Default;
+                return double(layoutCost(m_operatorNodes[operatorIndex].type, layout)) * double(operatorBytes[operatorIndex]);
+            };
+
+            // A transpose reads and writes the tensor once, and is shared by every consumer that needs it.
+            auto TransposeCost = [&](uint32_t tensorId)
+            {
+                const bool producerInterleaved = isInterleaved[tensorProducers[tensorId]];
+                for (uint32_t consumer : tensorConsumers[tensorId])
+                {
+                    if (isInterleaved[consumer] != producerInterleaved)
+                    {
+                        return 2.0 * double(tensorDescs[tensorId]->totalTensorSizeInBytes);
+                    }
+                }
+                return 0.0;
+            };
+
+            auto LocalCost = [&](uint32_t operatorIndex)
+            {
+                double cost = OperatorCost(operatorIndex, isInterleaved[operatorIndex]);
+                for (uint32_t tensorId : operatorTensors[operatorIndex])
+                {
+                    cost += TransposeCost(tensorId);
+                }
+                return cost;
+            };
+
+            // Start each operator in its cheaper layout. Operators indifferent to layout follow the producer of their
+            // first flexible input, which creation order has already visited.
+            for (uint32_t i : candidates)
+            {
+                const double defaultCost = OperatorCost(i, false);
+                const double interleavedCost = OperatorCost(i, true);
+                if (defaultCost != interleavedCost)
+                {
+                    isInterleaved[i] = interleavedCost < defaultCost;
+                    continue;
+                }
+
+                for (uint32_t tensorId : operatorTensors[i])
+                {
+                    if (tensorProducers[tensorId] != i)
+                    {
+                        isInterleaved[i] = isInterleaved[tensorProducers[tensorId]];
+                        break;
+                    }
+                }
+            }
+
+            // Then flip single operators while that lowers the total cost. This finds a local minimum, which is enough
+            // to remove the transposes between runs of operators that prefer the same layout.
+            constexpr uint32_t maxRounds = 8;
+            for (uint32_t round = 0; round < maxRounds; ++round)
+            {
+                bool changed = false;
+                for (uint32_t i : candidates)
+                {
+                    const double cost = LocalCost(i);
+                    isInterleaved[i] = !isInterleaved[i];
+                    if (LocalCost(i) < cost)
+                    {
+                        changed = true;
+                    }
+                    else
+                    {
+                        isInterleaved[i] = !isInterleaved[i];
+                    }
+                }
+
+                if (!changed)
+                {
+                    break;
+                }
+            }
+
+            assignment.transposeIndices.assign(tensorCount, UINT32_MAX);
+            for (uint32_t tensorId = 0; tensorId < tensorCount; ++tensorId)
+            {
+                if (isFlexible[tensorId] && TransposeCost(tensorId) > 0)
+                {
+                    const uint32_t producer = tensorProducers[tensorId];
+                    const uint32_t outputIndex = tensorId - assignment.firstTensorIds[producer];
+                    assignment.transposeIndices[tensorId] = static_cast<uint32_t>(assignment.transposes.size());
+                    assignment.transposes.push_back({ producer, outputIndex, tensorDescs[tensorId] });
+                }
+            }
+
+            return assignment;
+        }
+
+        inline Microsoft::WRL::ComPtr<IDMLOperator> GraphBuilder::CreateInterleavedOperator(
+            uint32_t operatorIndex,
+            const LayoutAssignment& layouts,
+            BucketAllocator& allocator) const
+        {
+            if (!m_device)
+            {
+                DMLX_THROW(E_INVALIDARG); // The graph was built without a device; see Graph::SetDevice
+            }
+
+            auto Interleave = [](DmlBufferTensorDesc* tensor)
+            {
+                TensorProperties props = TensorPolicy::InterleavedChannel().Get(
+                    tensor->dataType,
+                    tensor->flags,
+                    Span<const uint32_t>(tensor->sizes.data(), tensor->sizes.size()));
+
+                tensor->strides.emplace(props.strides->begin(), props.strides->end());
+                tensor->totalTensorSizeInBytes = props.totalTensorSizeInBytes;
+            };
+
+            const OperatorNode& node = m_operatorNodes[operatorIndex];
+            AbstractOperatorDesc interleavedDesc = node.desc;
+
+            std::vector<DmlBufferTensorDesc*> inputTensors = interleavedDesc.GetInputTensors();
+            for (uint32_t inputIndex = 0; inputIndex < node.inputs.size(); ++inputIndex)
+            {
+                NodeOutput* input = node.inputs[inputIndex];
+                if (input && input->GetNode().type == NodeType::Operator &&
+                    layouts.isFlexible[layouts.firstTensorIds[input->GetNode().index] + input->GetOutputIndex()])
+                {
+                    Interleave(inputTensors[inputIndex]);
+                }
+            }
+
+            std::vector<DmlBufferTensorDesc*> outputTensors = interleavedDesc.GetOutputTensors();
+            for (uint32_t outputIndex = 0; outputIndex < outputTensors.size(); ++outputIndex)
+            {
+                if (outputTensors[outputIndex] && layouts.isFlexible[layouts.firstTensorIds[operatorIndex] + outputIndex])
+                {
+                    Interleave(outputTensors[outputIndex]);
+                }
+            }
+
+            Microsoft::WRL::ComPtr<IDMLOperator> op;
+            DML_OPERATOR_DESC opDesc = SchemaHelpers::ConvertOperatorDesc(interleavedDesc, &allocator);
+            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&op)));
+            return op;
+        }
+
+        inline Microsoft::WRL::ComPtr<IDMLOperator> GraphBuilder::CreateTranspose(const DmlBufferTensorDesc& tensor, bool toInterleaved) const
+        {
+            if (!m_device)
+            {
+                DMLX_THROW(E_INVALIDARG); // The graph was built without a device; see Graph::SetDevice
+            }
+
+            const uint32_t dimensionCount = static_cast<uint32_t>(tensor.sizes.size());
+            TensorProperties interleaved = TensorPolicy::InterleavedChannel().Get(
+                tensor.dataType,
+                tensor.flags,
+                Span<const uint32_t>(tensor.sizes.data(), tensor.sizes.size()));
+
+            DML_BUFFER_TENSOR_DESC packedDesc = {};
+            packedDesc.DataType = tensor.dataType;
+            packedDesc.Flags = tensor.flags;
+            packedDesc.DimensionCount = dimensionCount;
+            packedDesc.Sizes = tensor.sizes.data();
+            packedDesc.TotalTensorSizeInBytes = tensor.totalTensorSizeInBytes;
+
+            DML_BUFFER_TENSOR_DESC interleavedDesc = packedDesc;
+            interleavedDesc.Strides = interleaved.strides->data();
+            interleavedDesc.TotalTensorSizeInBytes = interleaved.totalTensorSizeInBytes;
+
+            DML_TENSOR_DESC packedTensor = { DML_TENSOR_TYPE_BUFFER, &packedDesc };
+            DML_TENSOR_DESC interleavedTensor = { DML_TENSOR_TYPE_BUFFER, &interleavedDesc };
+
+            DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC identityDesc = {};
+            identityDesc.InputTensor = toInterleaved ? &packedTensor : &interleavedTensor;
+            identityDesc.OutputTensor = toInterleaved ? &interleavedTensor : &packedTensor;
+
+            Microsoft::WRL::ComPtr<IDMLOperator> op;
+            DML_OPERATOR_DESC opDesc = { DML_OPERATOR_ELEMENT_WISE_IDENTITY, &identityDesc };
+            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&op)));
+            return op;
+        }
+#endif
+
+        inline NodeID GraphBuilder::CreateInputNode(uint32_t inputIndex)
+        {
+            uint32_t index = static_cast<uint32_t>(m_inputNodes.size());
+            m_inputNodes.push_back(InputNode{ inputIndex });
+            return { NodeType::Input, index };
+        }
+
+        inline NodeID GraphBuilder::CreateReinterpretNode(NodeOutput* input)
+        {
+            uint32_t index = static_cast<uint32_t>(m_reinterpretNodes.size());
+            m_reinterpretNodes.push_back(ReinterpretNode{ input });
+            return { NodeType::Reinterpret, index };
+        }
+
+#if DML_TARGET_VERSION >= 0x6200
+        inline NodeID GraphBuilder::CreateConstantNode(Span<const Byte> data)
+        {
+            uint32_t index = static_cast<uint32_t>(m_constantNodes.size());
+            m_constantNodes.push_back(ConstantNode{ data, GetInternedName() });
+
+            return { NodeType::Constant, index };
+        }
+#endif // DML_TARGET_VERSION >= 0x6200
+
+        inline NodeOutput* GraphBuilder::CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
+        {
+            // Construct the object in the deque, which doesn't invalidate references to elements as it grows
+            m_nodeOutputs.emplace_back(this, node, outputIndex, std::move(tensorDesc));
+
+            return &m_nodeOutputs.back();
+        }
+
+        inline GraphDesc GraphBuilder::GetGraphDesc(Span<const Expression> outputs, const GraphDescOptions& options) const
+        {
+            GraphDesc desc = {};
+            desc.inputCount = static_cast<uint32_t>(m_inputNodes.size());
+            desc.outputCount = static_cast<uint32_t>(outputs.size());
+
+            const uint32_t operatorCount = static_cast<uint32_t>(m_operatorNodes.size());
+
+            // Operators evaluated by constant folding are replaced by constant nodes holding their output.
+            ConstantFolding folding;
+            if (options.foldConstants)
+            {
+                folding = FoldConstants(outputs);
+            }
+            else
+            {
+                folding.foldedInto.assign(operatorCount, UINT32_MAX);
+            }
+
+            // Activations folded into their producer are left out of the graph, and their output is replaced by the
+            // producer's output.
+            ActivationFusion fusion;
+            if (options.fuseActivations)
+            {
+                fusion = FuseActivations(outputs, folding.foldedInto, options.createOperators);
+            }
+            else
+            {
+                fusion.fusedInto.assign(operatorCount, UINT32_MAX);
+                fusion.fusedOperators.resize(operatorCount);
+            }
+
+            // Operators that don't contribute to an output are left out, as are constants only they read.
+            const std::vector<bool> isOperatorUsed = FindUsedOperators(outputs);
+
+            std::vector<uint32_t> operatorNodeIndices(operatorCount, UINT32_MAX);
+            uint32_t operatorNodeCount = 0;
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (isOperatorUsed[i] && fusion.fusedInto[i] == UINT32_MAX && folding.foldedInto[i] == UINT32_MAX)
+                {
+                    operatorNodeIndices[i] = operatorNodeCount++;
+                }
+            }
+
+            // Only the constants (original or folded) that a remaining operator reads are kept; the indices are relative
+            // to the first constant node.
+            std::vector<uint32_t> constantNodeIndices(m_constantNodes.size(), UINT32_MAX);
+            std::vector<uint32_t> foldedConstantNodeIndices(folding.data.size(), UINT32_MAX);
+            uint32_t constantNodeCount = 0;
+            {
+                std::vector<bool> isConstantUsed(m_constantNodes.size());
+                std::vector<bool> isFoldedConstantUsed(folding.data.size());
+                for (uint32_t i = 0; i < operatorCount; ++i)
+                {
+                    if (operatorNodeIndices[i] == UINT32_MAX)
+                    {
+                        continue;
+                    }
+
+                    for (NodeOutput* input : m_operatorNodes[i].inputs)
+                    {
+                        NodeID source = input ? SkipReinterprets(input)->GetNode() : NodeID{ NodeType::Invalid, 0 };
+                        if (source.type == NodeType::Constant)
+                        {
+                            isConstantUsed[source.index] = true;
+                        }
+                        else if (source.type == NodeType::Operator && folding.foldedInto[source.index] != UINT32_MAX)
+                        {
+                            isFoldedConstantUsed[folding.foldedInto[source.index]] = true;
+                        }
+                    }
+                }
+
+                for (size_t i = 0; i < constantNodeIndices.size(); ++i)
+                {
+                    if (isConstantUsed[i])
+                    {
+                        constantNodeIndices[i] = constantNodeCount++;
+                    }
+                    else if (options.foldConstants)
+                    {
+                        desc.constantFoldingStats.removedConstantBytes += m_constantNodes[i].data.size();
+                    }
+                }
+
+                for (size_t i = 0; i < foldedConstantNodeIndices.size(); ++i)
+                {
+                    if (isFoldedConstantUsed[i])
+                    {
+                        foldedConstantNodeIndices[i] = constantNodeCount++;
+                        desc.constantFoldingStats.foldedConstantCount++;
+                        desc.constantFoldingStats.foldedConstantBytes += folding.data[i].size();
+                    }
+                }
+
+                for (uint32_t foldedIndex : folding.foldedInto)
+                {
+                    if (foldedIndex != UINT32_MAX)
+                    {
+                        desc.constantFoldingStats.foldedOperatorCount++;
+                    }
+                }
+            }
+
+            // Returns the index in desc.operatorNodes of the node producing an operator's output.
+            auto OperatorNodeIndex = [&](uint32_t operatorIndex)
+            {
+                if (fusion.fusedInto[operatorIndex] != UINT32_MAX)
+                {
+                    operatorIndex = fusion.fusedInto[operatorIndex];
+                }
+                return operatorNodeIndices[operatorIndex];
+            };
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // Transposes added by layout assignment follow the operator nodes made from the builder's operators.
+            LayoutAssignment layouts;
+            if (options.layoutCost)
+            {
+                const LayoutCostFn layoutCost = *options.layoutCost ? *options.layoutCost : LayoutCostFn(GetDefaultLayoutCost);
+                layouts = AssignLayouts(outputs, operatorNodeIndices, fusion, layoutCost);
+            }
+            const uint32_t baseTransposeNodeIndex = operatorNodeCount;
+            operatorNodeCount += static_cast<uint32_t>(layouts.transposes.size());
+#endif
+
+            // GraphDesc merges nodes into a single list, with all operator nodes appearing before constant nodes.
+            constexpr uint32_t baseOperatorNodeIndex = 0;
+            const uint32_t baseConstantNodeIndex = operatorNodeCount;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            // Holds the DML descs converted from each node's AbstractOperatorDesc while creating its operator.
+            BucketAllocator allocator;
+#endif
+
+            // Reserve every array up front; large graphs otherwise spend much of this function reallocating.
+            size_t inputEdgeCount = 0;
+            size_t intermediateEdgeCount = 0;
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                if (operatorNodeIndices[operatorIndex] != UINT32_MAX)
+                {
+                    for (NodeOutput* input : m_operatorNodes[operatorIndex].inputs)
+                    {
+                        if (input && SkipReinterprets(input)->GetNode().type == NodeType::Input)
+                        {
+                            ++inputEdgeCount;
+                        }
+                        else if (input)
+                        {
+                            ++intermediateEdgeCount;
+                        }
+                    }
+                }
+            }
+#if DMLX_USE_GRAPH_SERIALIZATION
+            intermediateEdgeCount += layouts.transposes.size();
+#endif
+
+            desc.operatorNodes.reserve(operatorNodeCount);
+            desc.builderOperatorIndices.reserve(operatorNodeCount);
+#if DML_TARGET_VERSION >= 0x6200
+            desc.constantNodes.reserve(constantNodeCount);
+#endif // DML_TARGET_VERSION >= 0x6200
+            desc.inputEdges.reserve(inputEdgeCount);
+            desc.intermediateEdges.reserve(intermediateEdgeCount);
+            desc.outputEdges.reserve(outputs.size());
+
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                if (operatorNodeIndices[operatorIndex] == UINT32_MAX)
+                {
+                    continue;
+                }
+
+                const OperatorNode& node = m_operatorNodes[operatorIndex];
+                uint32_t nodeIndex = static_cast<uint32_t>(desc.operatorNodes.size());
+
+                IDMLOperator* op = fusion.fusedOperators[operatorIndex].Get();
+#if DMLX_USE_GRAPH_SERIALIZATION
+                if (!layouts.isInterleaved.empty() && layouts.isInterleaved[operatorIndex])
+                {
+                    if (options.createOperators)
+                    {
+                        desc.layoutOperators.push_back(CreateInterleavedOperator(operatorIndex, layouts, allocator));
+                        op = desc.layoutOperators.back().Get();
+                    }
+                }
+                else if (!op)
+                {
+                    if (options.createOperators && !node.op)
+                    {
+                        CreateOperator(node, allocator);
+                    }
+                    op = node.op.Get();
+                }
+#else
+                if (!op)
+                {
+                    op = node.op.Get();
+                }
+#endif
+                desc.operatorNodes.push_back(DML_OPERATOR_GRAPH_NODE_DESC{ op, node.name });
+                desc.builderOperatorIndices.push_back(operatorIndex);
+
+                // Walk through each of this node's inputs and add it as an edge
+                const uint32_t inputCount = static_cast<uint32_t>(node.inputs.size());
+                for (uint32_t inputIndex = 0; inputIndex < inputCount; ++inputIndex)
+                {
+                    NodeOutput* input = node.inputs[inputIndex];
+                    if (input == nullptr)
+                    {
+                        continue;
+                    }
+                    NodeID inputNode = input->GetNode();
+
+                    // Reinterpret nodes aren't "real" nodes, they're just used to modify TensorDescs across
+                    // edges. So we follow this node backwards until it hits a real node.
+                    while (inputNode.type == NodeType::Reinterpret)
+                    {
+                        input = m_reinterpretNodes[inputNode.index].input;
+                        inputNode = input->GetNode();
+                    }
+
+                    if (inputNode.type == NodeType::Input)
+                    {
+                        DML_INPUT_GRAPH_EDGE_DESC inputEdge = {};
+                        inputEdge.GraphInputIndex = m_inputNodes[inputNode.index].inputIndex;
+                        inputEdge.ToNodeIndex = nodeIndex;
+                        inputEdge.ToNodeInputIndex = inputIndex;
+
+                        desc.inputEdges.push_back(inputEdge);
+                    }
+                    else if (inputNode.type == NodeType::Operator && folding.foldedInto[inputNode.index] != UINT32_MAX)
+                    {
+                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                        intermediateEdge.FromNodeIndex = baseConstantNodeIndex + foldedConstantNodeIndices[folding.foldedInto[inputNode.index]];
+                        intermediateEdge.FromNodeOutputIndex = 0;
+                        intermediateEdge.ToNodeIndex = nodeIndex;
+                        intermediateEdge.ToNodeInputIndex = inputIndex;
+
+                        desc.intermediateEdges.push_back(intermediateEdge);
+                    }
+                    else if (inputNode.type == NodeType::Operator)
+                    {
+                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                        intermediateEdge.FromNodeIndex = baseOperatorNodeIndex + OperatorNodeIndex(inputNode.index);
+                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
+                        intermediateEdge.ToNodeIndex = nodeIndex;
+                        intermediateEdge.ToNodeInputIndex = inputIndex;
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+                        // Read the copy in this operator's layout if it differs from the producer's.
+                        const uint32_t transposeIndex = layouts.GetTransposeIndex(input, operatorIndex);
+                        if (transposeIndex != UINT32_MAX)
+                        {
+                            intermediateEdge.FromNodeIndex = baseOperatorNodeIndex + baseTransposeNodeIndex + transposeIndex;
+                            intermediateEdge.FromNodeOutputIndex = 0;
+                        }
+#endif
+
+                        desc.intermediateEdges.push_back(intermediateEdge);
+                    }
+                    else if (inputNode.type == NodeType::Constant)
+                    {
+                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                        intermediateEdge.FromNodeIndex = baseConstantNodeIndex + constantNodeIndices[inputNode.index];
+                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
+                        intermediateEdge.ToNodeIndex = nodeIndex;
+                        intermediateEdge.ToNodeInputIndex = inputIndex;
+
+                        desc.intermediateEdges.push_back(intermediateEdge);
+                    }
+                    else
+                    {
+                        assert(false); // Invalid node type
+                        DMLX_THROW(E_UNEXPECTED);
+                    }
+                }
+            }
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+            for (const LayoutAssignment::Transpose& transpose : layouts.transposes)
+            {
+                const uint32_t nodeIndex = static_cast<uint32_t>(desc.operatorNodes.size());
+                const bool toInterleaved = !layouts.isInterleaved[transpose.producer];
+                const char* name = m_operatorNodes[transpose.producer].name;
+
+                IDMLOperator* op = nullptr;
+                if (options.createOperators)
+                {
+                    desc.layoutOperators.push_back(CreateTranspose(*transpose.tensor, toInterleaved));
+                    op = desc.layoutOperators.back().Get();
+                }
+                desc.operatorNodes.push_back(DML_OPERATOR_GRAPH_NODE_DESC{ op, name });
+                desc.builderOperatorIndices.push_back(UINT32_MAX);
+
+                DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                intermediateEdge.FromNodeIndex = baseOperatorNodeIndex + OperatorNodeIndex(transpose.producer);
+                intermediateEdge.FromNodeOutputIndex = transpose.outputIndex;
+                intermediateEdge.ToNodeIndex = nodeIndex;
+                intermediateEdge.ToNodeInputIndex = 0;
+                desc.intermediateEdges.push_back(intermediateEdge);
+
+                LayoutTranspose reported;
+                reported.producer = name ? name : "";
+                reported.outputIndex = transpose.outputIndex;
+                reported.from = toInterleaved ? TensorLayout::Default : TensorLayout::InterleavedChannel;
+                reported.to = toInterleaved ? TensorLayout::InterleavedChannel : TensorLayout::Default;
+                reported.sizeInBytes = transpose.tensor->totalTensorSizeInBytes;
+                desc.layoutAssignmentReport.transposes.push_back(std::move(reported));
+            }
+
+            for (bool isInterleaved : layouts.isInterleaved)
+            {
+                if (isInterleaved)
+                {
+                    desc.layoutAssignmentReport.interleavedOperatorCount++;
+                }
+            }
+#endif
+
+#if DML_TARGET_VERSION >= 0x6200
+            for (size_t i = 0; i < m_constantNodes.size(); ++i)
+            {
+                const ConstantNode& node = m_constantNodes[i];
+                if (constantNodeIndices[i] != UINT32_MAX)
+                {
+                    desc.constantNodes.push_back(DML_CONSTANT_DATA_GRAPH_NODE_DESC{ node.data.data(), node.data.size(), node.name});
+                }
+            }
+
+            // Folded constants take the name of the operator they replace.
+            desc.foldedConstantData = std::move(folding.data);
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                const uint32_t foldedIndex = folding.foldedInto[operatorIndex];
+                if (foldedIndex != UINT32_MAX && foldedConstantNodeIndices[foldedIndex] != UINT32_MAX)
+                {
+                    const OperatorNode& node = m_operatorNodes[operatorIndex];
+                    const std::vector<Byte>& data = desc.foldedConstantData[foldedIndex];
+                    desc.constantNodes.push_back(DML_CONSTANT_DATA_GRAPH_NODE_DESC{ data.data(), data.size(), node.name});
+                }
+            }
+#endif // DML_TARGET_VERSION >= 0x6200
+
+            // Add output edges
+            for (uint32_t outputIndex = 0; outputIndex < desc.outputCount; ++outputIndex)
+            {
+                NodeOutput* output = outputs[outputIndex].Impl();
+                if (output == nullptr)
+                {
+                    continue;
+                }
+                NodeID outputNode = output->GetNode();
+
+                // Reinterpret nodes are meaningless on outputs (they're no-ops), so just follow them back until we
+                // get to a real operator node.
+                while (outputNode.type == NodeType::Reinterpret)
+                {
+                    output = m_reinterpretNodes[outputNode.index].input;
+                    outputNode = output->GetNode();
+                }
+
+                if (outputNode.type == NodeType::Input)
+                {
+                    // It's not valid to connect an output of the graph directly to an input without an intervening
+                    // node. If this behavior is desired, it should instead be accomplished with a copy e.g. using
+                    // the elementwise identity operator.
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                assert(outputNode.type == NodeType::Operator);
+
+                DML_OUTPUT_GRAPH_EDGE_DESC outputEdge = {};
+                outputEdge.FromNodeIndex = baseOperatorNodeIndex + OperatorNodeIndex(output->GetNode().index);
+                outputEdge.FromNodeOutputIndex = output->GetOutputIndex();
+                outputEdge.GraphOutputIndex = outputIndex;
+
+                desc.outputEdges.push_back(outputEdge);
+            }
+
+            desc.fusedOperators = std::move(fusion.fusedOperators);
+            for (uint32_t i = 0; i < operatorCount; ++i)
+            {
+                if (isOperatorUsed[i] && fusion.fusedInto[i] != UINT32_MAX)
+                {
+                    desc.fusedActivationCount++;
+                }
+            }
+
+            // Sanity
+            assert(desc.operatorNodes.size() == operatorNodeCount);
+#if DML_TARGET_VERSION >= 0x6200
+            assert(desc.constantNodes.size() == constantNodeCount);
+#endif // DML_TARGET_VERSION >= 0x6200
+            assert(desc.outputEdges.size() == desc.outputCount);
+            assert(desc.outputCount == outputs.size());
+            assert(baseOperatorNodeIndex == desc.BaseOperatorNodeIndexInMergedNodes());
+            assert(baseConstantNodeIndex == desc.BaseConstantNodeIndexInMergedNodes());
+
+            return desc;
+        }
+
+        inline MemoryAnalysis GraphBuilder::AnalyzeMemory(Span<const Expression> outputs) const
+        {
+            MemoryAnalysis analysis;
+            const uint32_t operatorCount = static_cast<uint32_t>(m_operatorNodes.size());
+
+            // Only operators that contribute to an output are executed. Nodes are created after the nodes they consume,
+            // so visiting operators in reverse creation order finds every contributing operator in one pass, and
+            // creation order is a topological order.
+            std::vector<bool> isUsed(operatorCount);
+            std::vector<bool> isConstantUsed(m_constantNodes.size());
+            std::vector<bool> isInputUsed(m_inputNodes.size());
+            auto MarkUsed = [&](NodeOutput* output)
+            {
+                NodeID source = SkipReinterprets(output)->GetNode();
+                switch (source.type)
+                {
+                case NodeType::Operator: isUsed[source.index] = true; break;
+                case NodeType::Constant: isConstantUsed[source.index] = true; break;
+                case NodeType::Input: isInputUsed[source.index] = true; break;
+                default: break;
+                }
+            };
+
+            for (const Expression& output : outputs)
+            {
+                if (output)
+                {
+                    MarkUsed(output.Impl());
+                    analysis.outputBytes += output.GetOutputDesc().totalTensorSizeInBytes;
+                }
+            }
+
+            for (uint32_t operatorIndex = operatorCount; operatorIndex-- > 0;)
+            {
+                if (isUsed[operatorIndex])
+                {
+                    for (NodeOutput* input : m_operatorNodes[operatorIndex].inputs)
+                    {
+                        if (input)
+                        {
+                            MarkUsed(input);
+                        }
+                    }
+                }
+            }
+
+            std::vector<uint32_t> operatorSteps(operatorCount, UINT32_MAX);
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                if (isUsed[operatorIndex])
+                {
+                    const OperatorNode& node = m_operatorNodes[operatorIndex];
+                    const uint32_t step = static_cast<uint32_t>(analysis.nodes.size());
+                    operatorSteps[operatorIndex] = step;
+
+                    MemoryAnalysis::Node analyzedNode = {};
+                    analyzedNode.name = node.name ? node.name : "node" + std::to_string(step);
+                    analyzedNode.type = node.type;
+                    analysis.nodes.push_back(std::move(analyzedNode));
+                }
+            }
+
+            // Create a tensor for each output of the executed operators, and account for the graph's inputs (an input
+            // node may have more than one input index bound to it, but each is counted once).
+            std::vector<SmallVector<uint32_t, 2>> tensorIndices(operatorCount);
+            for (const NodeOutput& output : m_nodeOutputs)
+            {
+                const NodeID node = output.GetNode();
+                if (node.type == NodeType::Input && isInputUsed[node.index])
+                {
+                    analysis.inputBytes += output.GetOutputDesc().totalTensorSizeInBytes;
+                }
+                else if (node.type == NodeType::Operator && isUsed[node.index])
+                {
+                    const uint32_t step = operatorSteps[node.index];
+                    const TensorDesc& desc = output.GetOutputDesc();
+
+                    MemoryAnalysis::Tensor tensor = {};
+                    tensor.node = step;
+                    tensor.outputIndex = output.GetOutputIndex();
+                    tensor.sizeInBytes = desc.totalTensorSizeInBytes;
+                    tensor.firstStep = step;
+                    tensor.lastStep = step;
+
+                    auto& indices = tensorIndices[node.index];
+                    if (indices.size() <= tensor.outputIndex)
+                    {
+                        indices.resize(tensor.outputIndex + 1, UINT32_MAX);
+                    }
+                    indices[tensor.outputIndex] = static_cast<uint32_t>(analysis.tensors.size());
+
+                    MemoryAnalysis::Node& analyzedNode = analysis.nodes[step];
+                    analyzedNode.bytesWritten += tensor.sizeInBytes;
+                    if (tensor.outputIndex == 0)
+                    {
+                        uint64_t elementCount = 1;
+                        for (uint32_t size : desc.sizes)
+                        {
+                            elementCount *= size;
+                        }
+                        analyzedNode.estimatedOps = m_operatorNodes[node.index].opsPerOutputElement * elementCount;
+                        analysis.estimatedOps += analyzedNode.estimatedOps;
+                    }
+
+                    analysis.tensors.push_back(tensor);
+                }
+            }
+
+            for (size_t i = 0; i < m_constantNodes.size(); ++i)
+            {
+                if (isConstantUsed[i])
+                {
+                    analysis.constantBytes += m_constantNodes[i].data.size();
+                }
+            }
+
+            auto FindTensor = [&](NodeOutput* output) -> MemoryAnalysis::Tensor*
+            {
+                output = SkipReinterprets(output);
+                if (output->GetNode().type != NodeType::Operator)
+                {
+                    return nullptr;
+                }
+                return &analysis.tensors[tensorIndices[output->GetNode().index][output->GetOutputIndex()]];
+            };
+
+            // A tensor lives until its last consumer has executed. Inputs are read through the consumer's view, which
+            // may be smaller than the producer's tensor (e.g. a strided reinterpret).
+            for (uint32_t operatorIndex = 0; operatorIndex < operatorCount; ++operatorIndex)
+            {
+                if (!isUsed[operatorIndex])
+                {
+                    continue;
+                }
+
+                const uint32_t step = operatorSteps[operatorIndex];
+                for (NodeOutput* input : m_operatorNodes[operatorIndex].inputs)
+                {
+                    if (input)
+                    {
+                        analysis.nodes[step].bytesRead += input->GetOutputDesc().totalTensorSizeInBytes;
+                        if (MemoryAnalysis::Tensor* tensor = FindTensor(input))
+                        {
+                            tensor->lastStep = std::max(tensor->lastStep, step);
+                        }
+                    }
+                }
+            }
+
+            // Graph outputs are written to buffers bound by the caller, so they aren't intermediates.
+            const uint32_t stepCount = static_cast<uint32_t>(analysis.nodes.size());
+            for (const Expression& output : outputs)
+            {
+                if (output)
+                {
+                    if (MemoryAnalysis::Tensor* tensor = FindTensor(output.Impl()))
+                    {
+                        tensor->isGraphOutput = true;
+                        tensor->lastStep = stepCount - 1;
+                    }
+                }
+            }
+
+            // Sum the intermediates live at each step.
+            std::vector<int64_t> liveBytesDelta(stepCount + 1);
+            for (const MemoryAnalysis::Tensor& tensor : analysis.tensors)
+            {
+                if (!tensor.isGraphOutput)
+                {
+                    liveBytesDelta[tensor.firstStep] += static_cast<int64_t>(tensor.sizeInBytes);
+                    liveBytesDelta[tensor.lastStep + 1] -= static_cast<int64_t>(tensor.sizeInBytes);
+                }
+            }
+
+            int64_t liveBytes = 0;
+            for (uint32_t step = 0; step < stepCount; ++step)
+            {
+                liveBytes += liveBytesDelta[step];
+                analysis.nodes[step].liveIntermediateBytes = static_cast<uint64_t>(liveBytes);
+                if (analysis.nodes[step].liveIntermediateBytes > analysis.peakIntermediateBytes)
+                {
+                    analysis.peakIntermediateBytes = analysis.nodes[step].liveIntermediateBytes;
+                    analysis.peakStep = step;
+                }
+            }
+
+            // Place intermediates in an arena largest first, each at the lowest aligned offset that doesn't overlap a
+            // placed tensor whose lifetime overlaps its own.
+            std::vector<uint32_t> placementOrder;
+            for (uint32_t i = 0; i < analysis.tensors.size(); ++i)
+            {
+                if (!analysis.tensors[i].isGraphOutput)
+                {
+                    placementOrder.push_back(i);
+                }
+            }
+            std::stable_sort(placementOrder.begin(), placementOrder.end(), [&](uint32_t a, uint32_t b)
+            {
+                return analysis.tensors[a].sizeInBytes > analysis.tensors[b].sizeInBytes;
+            });
+
+            // Placed tensors are listed under every step they're live in, so finding the ones whose lifetime overlaps a
+            // tensor only visits those rather than every tensor placed so far.
+            std::vector<std::vector<uint32_t>> placedAtStep(stepCount);
+            std::vector<uint32_t> conflictStamps(analysis.tensors.size(), UINT32_MAX);
+            std::vector<const MemoryAnalysis::Tensor*> conflicts;
+            for (uint32_t tensorIndex : placementOrder)
+            {
+                MemoryAnalysis::Tensor& tensor = analysis.tensors[tensorIndex];
+
+                conflicts.clear();
+                for (uint32_t step = tensor.firstStep; step <= tensor.lastStep; ++step)
+                {
+                    for (uint32_t otherIndex : placedAtStep[step])
+                    {
+                        if (conflictStamps[otherIndex] != tensorIndex)
+                        {
+                            conflictStamps[otherIndex] = tensorIndex;
+                            conflicts.push_back(&analysis.tensors[otherIndex]);
+                        }
+                    }
+                }
+
+                // Sweep the conflicts in offset order for the lowest aligned gap the tensor fits in.
+                std::sort(conflicts.begin(), conflicts.end(), [](const MemoryAnalysis::Tensor* a, const MemoryAnalysis::Tensor* b)
+                {
+                    return a->arenaOffset < b->arenaOffset;
+                });
+
+                uint64_t offset = 0;
+                for (const MemoryAnalysis::Tensor* other : conflicts)
+                {
+                    if (offset + tensor.sizeInBytes <= other->arenaOffset)
+                    {
+                        break;
+                    }
+                    const uint64_t end = other->arenaOffset + other->sizeInBytes;
+                    const uint64_t alignment = DML_MINIMUM_BUFFER_TENSOR_ALIGNMENT;
+                    offset = std::max(offset, (end + alignment - 1) / alignment * alignment);
+                }
+
+                tensor.arenaOffset = offset;
+                analysis.arenaSizeInBytes = std::max(analysis.arenaSizeInBytes, offset + tensor.sizeInBytes);
+                for (uint32_t step = tensor.firstStep; step <= tensor.lastStep; ++step)
+                {
+                    placedAtStep[step].push_back(tensorIndex);
+                }
+            }
+
+            return analysis;
+        }
+
+#if DMLX_USE_GRAPH_SERIALIZATION
+        inline DmlSerializedGraphDesc GraphBuilder::GetSerializedGraphDesc(
+            Span<const Expression> outputs,
+            std::vector<SerializedConstant>* externalConstants) const
+        {
+            // Serialization only needs the descs, so no operators are created.
+            GraphDescOptions options;
+            options.createOperators = false;
+            GraphDesc graph = GetGraphDesc(outputs, options);
+
+            // Serialized nodes must be in topological order. Constants have no inputs, and operator nodes are always
+            // created after the nodes they consume, so constants are placed first followed by operators in creation
+            // order (the reverse of the merged node list in GraphDesc).
+#if DML_TARGET_VERSION >= 0x6200
+            const uint32_t constantCount = static_cast<uint32_t>(graph.constantNodes.size());
+#else
+            const uint32_t constantCount = 0;
+#endif // DML_TARGET_VERSION >= 0x6200
+            const uint32_t baseConstantNodeIndex = graph.BaseConstantNodeIndexInMergedNodes();
+            auto SerializedNodeIndex = [&](uint32_t mergedNodeIndex)
+            {
+                return mergedNodeIndex < baseConstantNodeIndex ? constantCount + mergedNodeIndex : mergedNodeIndex - baseConstantNodeIndex;
+            };
+
+            // Nodes created in the same name scope share a name, but serialized nodes need unique names since named
+            // constants are bound (and loaded from files) by name.
+            std::unordered_set<std::string> usedNames;
+            auto UniqueNodeName = [&](const char* name, const char* defaultPrefix, uint32_t index)
+            {
+                std::string uniqueName = name ? name : defaultPrefix + std::to_string(index);
+                if (!usedNames.insert(uniqueName).second)
+                {
+                    uniqueName += "_" + std::to_string(index);
+                    usedNames.insert(uniqueName);
+                }
+                return uniqueName;
+            };
+
+            DmlSerializedGraphDesc desc = {};
+            desc.InputCount = graph.inputCount;
+            desc.OutputCount = graph.outputCount;
+
+#if DML_TARGET_VERSION >= 0x6200
+            for (uint32_t i = 0; i < constantCount; ++i)
+            {
+                const DML_CONSTANT_DATA_GRAPH_NODE_DESC& node = graph.constantNodes[i];
+
+                DmlSerializedGraphNode serializedNode = {};
+                serializedNode.Name = UniqueNodeName(node.Name, "constant", i);
+                if (externalConstants)
+                {
+                    serializedNode.Desc = DmlSerializedGraphNodeConstantVariant(ConstantName{ serializedNode.Name });
+                    externalConstants->push_back(SerializedConstant{
+                        serializedNode.Name,
+                        Span<const Byte>(static_cast<const Byte*>(node.Data), static_cast<size_t>(node.DataSize)) });
+                }
+                else
+                {
+                    // The serializer only reads constant data.
+                    ConstantData data = {};
+                    data.data = static_cast<std::byte*>(const_cast<void*>(node.Data));
+                    data.dataSize = node.DataSize;
+                    serializedNode.Desc = DmlSerializedGraphNodeConstantVariant(data);
+                }
+                desc.Nodes.push_back(std::move(serializedNode));
+            }
+#endif // DML_TARGET_VERSION >= 0x6200
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(graph.builderOperatorIndices.size()); ++i)
+            {
+                const OperatorNode& node = m_operatorNodes[graph.builderOperatorIndices[i]];
+
+                DmlSerializedGraphNode serializedNode = {};
+                serializedNode.Name = UniqueNodeName(node.name, "op", i);
+                serializedNode.Desc = node.desc;
+                desc.Nodes.push_back(std::move(serializedNode));
+            }
+
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graph.inputEdges)
+            {
+                desc.InputEdges.push_back({ edge.GraphInputIndex, SerializedNodeIndex(edge.ToNodeIndex), edge.ToNodeInputIndex });
+            }
+
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graph.intermediateEdges)
+            {
+                desc.IntermediateEdges.push_back({
+                    SerializedNodeIndex(edge.FromNodeIndex),
+                    edge.FromNodeOutputIndex,
+                    SerializedNodeIndex(edge.ToNodeIndex),
+                    edge.ToNodeInputIndex });
+            }
+
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                desc.OutputEdges.push_back({ SerializedNodeIndex(edge.FromNodeIndex), edge.FromNodeOutputIndex, edge.GraphOutputIndex });
+            }
 
             return desc;
         }
+#endif // DMLX_USE_GRAPH_SERIALIZATION
     } // namespace detail
 
 } // namespace dml
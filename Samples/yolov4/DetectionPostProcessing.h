@@ -0,0 +1,754 @@
+//-----------------------------------------------------------------------------
+//
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+// CPU post-processing for the YOLOv4 detection outputs: decodes bounding boxes from the raw NHWC output tensors,
+// discards low scoring boxes, and applies per-class non-maximal suppression (NMS). This header has no dependencies
+// on Windows, D3D12 or DirectML, so it can also be built into tools such as PostProcessingBenchmark.
+//
+// The hot loops use SSE2 on x86/x64 and NEON on ARM64, with a scalar fallback elsewhere (or when
+// YOLO_POSTPROCESSING_NO_SIMD is defined). All paths evaluate the same operations in the same order.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#if !defined(YOLO_POSTPROCESSING_NO_SIMD)
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define YOLO_POSTPROCESSING_SSE2 1
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define YOLO_POSTPROCESSING_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace YoloPostProcessing
+{
+    struct Detection
+    {
+        // Bounding box coordinates
+        float xmin;
+        float ymin;
+        float xmax;
+        float ymax;
+        float score;
+        uint32_t predictedClass;
+    };
+
+    // One element of an output tensor along its C dimension. DirectML writes the outputs in NHWC, where the C
+    // channel contains the bounding box, a confidence score, the probability for the max class, and the class index.
+    struct RawPrediction
+    {
+        float bx;
+        float by;
+        float bw;
+        float bh;
+        float confidence;
+        float classMaxProbability;
+        uint32_t classIndex;
+    };
+
+    static_assert(sizeof(RawPrediction) == 7 * sizeof(float), "RawPrediction must match the 7 channels of the output");
+
+    // YoloV4 predicts 3 boxes per grid cell on each scale, each relative to a different anchor.
+    static constexpr uint32_t c_anchorsPerScale = 3;
+
+    // YoloV4 produces bounding boxes on different scales (small, medium, large), and each scale's boxes are decoded
+    // with its own constants. Each anchor is an (x,y) pair.
+    struct ScaleConstants
+    {
+        float xyScale;
+        float stride;
+        std::array<float, c_anchorsPerScale * 2> anchors;
+    };
+
+    // One output tensor of the model with sizes [3, height, width, 7]. For a model with a batch dimension, each
+    // image has its own OutputTensor that points at that image's slice of the output.
+    struct OutputTensor
+    {
+        const RawPrediction* data;
+        uint32_t height;
+        uint32_t width;
+        ScaleConstants constants;
+    };
+
+    // The outputs of the model for one image, and the size of the image the boxes are scaled and clipped to.
+    struct ImageOutputs
+    {
+        const OutputTensor* tensors;
+        size_t tensorCount;
+        float imageWidth;
+        float imageHeight;
+    };
+
+    struct Options
+    {
+        // Size of the model input, which the decoded boxes are relative to.
+        float inputWidth;
+        float inputHeight;
+
+        // Boxes whose score (confidence * class probability) is below this are discarded.
+        float scoreThreshold;
+
+        // Boxes whose intersection over union with a higher scoring box of the same class is above this are
+        // discarded.
+        float nmsThreshold;
+
+        // At most this many boxes are returned by NMS; these are the highest scoring of the selected boxes.
+        uint32_t maxDetections = std::numeric_limits<uint32_t>::max();
+    };
+
+    namespace Detail
+    {
+        // A prediction that passed the score threshold, and the grid cell and anchor it belongs to.
+        struct Candidate
+        {
+            uint32_t index;
+            uint32_t x;
+            uint32_t y;
+            uint32_t anchor;
+        };
+
+        // Tracks the (anchor, y, x) position of a cell while walking an output tensor in memory order, so that
+        // positions are never computed with divisions.
+        struct GridPosition
+        {
+            uint32_t x;
+            uint32_t y;
+            uint32_t anchor;
+
+            // Returns the position of the cell that is offset cells after this one.
+            GridPosition Advance(uint32_t offset, uint32_t height, uint32_t width) const
+            {
+                GridPosition position = { x + offset, y, anchor };
+                while (position.x >= width)
+                {
+                    position.x -= width;
+                    if (++position.y == height)
+                    {
+                        position.y = 0;
+                        ++position.anchor;
+                    }
+                }
+                return position;
+            }
+        };
+
+        struct DecodeParameters
+        {
+            float xyScale;
+            float stride;
+            const float* anchors;
+            float xScale;
+            float yScale;
+            float clipWidth;
+            float clipHeight;
+        };
+
+        // Appends every prediction in [begin, end) whose score is at least the threshold.
+        inline void SelectCandidatesScalar(
+            const RawPrediction* predictions,
+            uint32_t begin,
+            uint32_t end,
+            GridPosition position,
+            uint32_t height,
+            uint32_t width,
+            float scoreThreshold,
+            std::vector<Candidate>& candidates)
+        {
+            for (uint32_t i = begin; i < end; ++i, position = position.Advance(1, height, width))
+            {
+                float score = predictions[i].confidence * predictions[i].classMaxProbability;
+                if (score >= scoreThreshold)
+                {
+                    candidates.push_back({ i, position.x, position.y, position.anchor });
+                }
+            }
+        }
+
+        inline void SelectCandidates(
+            const RawPrediction* predictions,
+            uint32_t height,
+            uint32_t width,
+            float scoreThreshold,
+            std::vector<Candidate>& candidates)
+        {
+            const uint32_t count = c_anchorsPerScale * height * width;
+            GridPosition position = {};
+            uint32_t i = 0;
+
+#if defined(YOLO_POSTPROCESSING_SSE2) || defined(YOLO_POSTPROCESSING_NEON)
+            // The confidence and class probability of a prediction are adjacent, so each pair is a single 64-bit
+            // load. Four pairs are deinterleaved into a vector of confidences and a vector of probabilities.
+            // Nearly every prediction is below the threshold, so most blocks are rejected by one comparison.
+            const float* values = reinterpret_cast<const float*>(predictions);
+            constexpr uint32_t stride = sizeof(RawPrediction) / sizeof(float);
+
+#if defined(YOLO_POSTPROCESSING_SSE2)
+            const __m128 threshold = _mm_set1_ps(scoreThreshold);
+#else
+            const float32x4_t threshold = vdupq_n_f32(scoreThreshold);
+            static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+#endif
+
+            for (; i + 4 <= count; i += 4, position = position.Advance(4, height, width))
+            {
+                const float* p = values + i * stride + 4;
+
+#if defined(YOLO_POSTPROCESSING_SSE2)
+                __m128 lo = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)),
+                    reinterpret_cast<const __m64*>(p + stride));
+                __m128 hi = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p + 2 * stride)),
+                    reinterpret_cast<const __m64*>(p + 3 * stride));
+                __m128 confidence = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 probability = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+                uint32_t selected = (uint32_t)_mm_movemask_ps(_mm_cmpge_ps(_mm_mul_ps(confidence, probability), threshold));
+#else
+                float32x4_t lo = vcombine_f32(vld1_f32(p), vld1_f32(p + stride));
+                float32x4_t hi = vcombine_f32(vld1_f32(p + 2 * stride), vld1_f32(p + 3 * stride));
+                float32x4x2_t deinterleaved = vuzpq_f32(lo, hi);
+                uint32x4_t mask = vcgeq_f32(vmulq_f32(deinterleaved.val[0], deinterleaved.val[1]), threshold);
+                uint32_t selected = vaddvq_u32(vandq_u32(mask, vld1q_u32(laneBits)));
+#endif
+
+                for (uint32_t lane = 0; selected != 0; ++lane, selected >>= 1)
+                {
+                    if (selected & 1)
+                    {
+                        GridPosition lanePosition = position.Advance(lane, height, width);
+                        candidates.push_back({ i + lane, lanePosition.x, lanePosition.y, lanePosition.anchor });
+                    }
+                }
+            }
+#endif
+
+            SelectCandidatesScalar(predictions, i, count, position, height, width, scoreThreshold, candidates);
+        }
+
+        // Decodes candidates into boxes in image coordinates, and writes the boxes that are still valid after
+        // clipping. The output must have room for every candidate; returns the number of boxes written.
+        inline size_t DecodeCandidatesScalar(
+            const RawPrediction* predictions,
+            const Candidate* candidates,
+            size_t candidateCount,
+            const DecodeParameters& params,
+            Detection* detections)
+        {
+            size_t detectionCount = 0;
+            for (size_t c = 0; c < candidateCount; ++c)
+            {
+                const Candidate& candidate = candidates[c];
+                const RawPrediction& pred = predictions[candidate.index];
+
+                // Apply xyScale. Need to apply offsets of half a grid cell here, to ensure the scaling is centered
+                // around zero.
+                float bx = params.xyScale * (pred.bx - 0.5f) + 0.5f;
+                float by = params.xyScale * (pred.by - 0.5f) + 0.5f;
+
+                // Transform the x/y from being relative to the grid cell, to being relative to the whole image
+                bx = (bx + (float)candidate.x) * params.stride;
+                by = (by + (float)candidate.y) * params.stride;
+
+                // Scale the w/h by the supplied anchors
+                float halfWidth = pred.bw * params.anchors[candidate.anchor * 2] * 0.5f;
+                float halfHeight = pred.bh * params.anchors[candidate.anchor * 2 + 1] * 0.5f;
+
+                // Convert x,y,w,h to xmin,ymin,xmax,ymax, scaled to the image size
+                float xmin = (bx - halfWidth) * params.xScale;
+                float ymin = (by - halfHeight) * params.yScale;
+                float xmax = (bx + halfWidth) * params.xScale;
+                float ymax = (by + halfHeight) * params.yScale;
+
+                // Discard boxes with NaN coordinates; infinite coordinates are clipped below.
+                if (std::isnan(xmin) || std::isnan(ymin) || std::isnan(xmax) || std::isnan(ymax))
+                {
+                    continue;
+                }
+
+                // Clip values out of range
+                xmin = std::clamp(xmin, 0.0f, params.clipWidth);
+                ymin = std::clamp(ymin, 0.0f, params.clipHeight);
+                xmax = std::clamp(xmax, 0.0f, params.clipWidth);
+                ymax = std::clamp(ymax, 0.0f, params.clipHeight);
+
+                // Discard empty boxes
+                if (xmax <= xmin || ymax <= ymin)
+                {
+                    continue;
+                }
+
+                detections[detectionCount++] = { xmin, ymin, xmax, ymax, pred.confidence * pred.classMaxProbability, pred.classIndex };
+            }
+            return detectionCount;
+        }
+
+        inline size_t DecodeCandidates(
+            const RawPrediction* predictions,
+            const Candidate* candidates,
+            size_t candidateCount,
+            const DecodeParameters& params,
+            Detection* detections)
+        {
+            size_t c = 0;
+            size_t detectionCount = 0;
+
+#if defined(YOLO_POSTPROCESSING_SSE2) || defined(YOLO_POSTPROCESSING_NEON)
+            // Boxes are decoded four at a time: the (bx, by, bw, bh) of four predictions are loaded and transposed
+            // so that each vector holds one coordinate of all four boxes. The grid cell offsets and anchors differ
+            // per prediction, so they are gathered first.
+            const float* values = reinterpret_cast<const float*>(predictions);
+            constexpr uint32_t stride = sizeof(RawPrediction) / sizeof(float);
+
+            for (; c + 4 <= candidateCount; c += 4)
+            {
+                alignas(16) float gridX[4];
+                alignas(16) float gridY[4];
+                alignas(16) float anchorWidth[4];
+                alignas(16) float anchorHeight[4];
+                for (uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    const Candidate& candidate = candidates[c + lane];
+                    gridX[lane] = (float)candidate.x;
+                    gridY[lane] = (float)candidate.y;
+                    anchorWidth[lane] = params.anchors[candidate.anchor * 2];
+                    anchorHeight[lane] = params.anchors[candidate.anchor * 2 + 1];
+                }
+
+                alignas(16) float xmin[4];
+                alignas(16) float ymin[4];
+                alignas(16) float xmax[4];
+                alignas(16) float ymax[4];
+                uint32_t valid;
+
+#if defined(YOLO_POSTPROCESSING_SSE2)
+                __m128 bx = _mm_loadu_ps(values + candidates[c + 0].index * stride);
+                __m128 by = _mm_loadu_ps(values + candidates[c + 1].index * stride);
+                __m128 bw = _mm_loadu_ps(values + candidates[c + 2].index * stride);
+                __m128 bh = _mm_loadu_ps(values + candidates[c + 3].index * stride);
+                _MM_TRANSPOSE4_PS(bx, by, bw, bh);
+
+                const __m128 half = _mm_set1_ps(0.5f);
+                const __m128 xyScale = _mm_set1_ps(params.xyScale);
+                const __m128 gridStride = _mm_set1_ps(params.stride);
+                bx = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(xyScale, _mm_sub_ps(bx, half)), half), _mm_load_ps(gridX)), gridStride);
+                by = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(xyScale, _mm_sub_ps(by, half)), half), _mm_load_ps(gridY)), gridStride);
+                __m128 halfWidth = _mm_mul_ps(_mm_mul_ps(bw, _mm_load_ps(anchorWidth)), half);
+                __m128 halfHeight = _mm_mul_ps(_mm_mul_ps(bh, _mm_load_ps(anchorHeight)), half);
+
+                const __m128 xScale = _mm_set1_ps(params.xScale);
+                const __m128 yScale = _mm_set1_ps(params.yScale);
+                __m128 x0 = _mm_mul_ps(_mm_sub_ps(bx, halfWidth), xScale);
+                __m128 y0 = _mm_mul_ps(_mm_sub_ps(by, halfHeight), yScale);
+                __m128 x1 = _mm_mul_ps(_mm_add_ps(bx, halfWidth), xScale);
+                __m128 y1 = _mm_mul_ps(_mm_add_ps(by, halfHeight), yScale);
+                __m128 ordered = _mm_and_ps(_mm_cmpord_ps(x0, x1), _mm_cmpord_ps(y0, y1));
+
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 clipWidth = _mm_set1_ps(params.clipWidth);
+                const __m128 clipHeight = _mm_set1_ps(params.clipHeight);
+                x0 = _mm_max_ps(_mm_min_ps(x0, clipWidth), zero);
+                y0 = _mm_max_ps(_mm_min_ps(y0, clipHeight), zero);
+                x1 = _mm_max_ps(_mm_min_ps(x1, clipWidth), zero);
+                y1 = _mm_max_ps(_mm_min_ps(y1, clipHeight), zero);
+                __m128 nonEmpty = _mm_and_ps(_mm_cmpgt_ps(x1, x0), _mm_cmpgt_ps(y1, y0));
+                valid = (uint32_t)_mm_movemask_ps(_mm_and_ps(ordered, nonEmpty));
+
+                _mm_store_ps(xmin, x0);
+                _mm_store_ps(ymin, y0);
+                _mm_store_ps(xmax, x1);
+                _mm_store_ps(ymax, y1);
+#else
+                float32x4x2_t rows01 = vtrnq_f32(vld1q_f32(values + candidates[c + 0].index * stride), vld1q_f32(values + candidates[c + 1].index * stride));
+                float32x4x2_t rows23 = vtrnq_f32(vld1q_f32(values + candidates[c + 2].index * stride), vld1q_f32(values + candidates[c + 3].index * stride));
+                float32x4_t bx = vcombine_f32(vget_low_f32(rows01.val[0]), vget_low_f32(rows23.val[0]));
+                float32x4_t by = vcombine_f32(vget_low_f32(rows01.val[1]), vget_low_f32(rows23.val[1]));
+                float32x4_t bw = vcombine_f32(vget_high_f32(rows01.val[0]), vget_high_f32(rows23.val[0]));
+                float32x4_t bh = vcombine_f32(vget_high_f32(rows01.val[1]), vget_high_f32(rows23.val[1]));
+
+                const float32x4_t half = vdupq_n_f32(0.5f);
+                const float32x4_t xyScale = vdupq_n_f32(params.xyScale);
+                const float32x4_t gridStride = vdupq_n_f32(params.stride);
+                bx = vmulq_f32(vaddq_f32(vaddq_f32(vmulq_f32(xyScale, vsubq_f32(bx, half)), half), vld1q_f32(gridX)), gridStride);
+                by = vmulq_f32(vaddq_f32(vaddq_f32(vmulq_f32(xyScale, vsubq_f32(by, half)), half), vld1q_f32(gridY)), gridStride);
+                float32x4_t halfWidth = vmulq_f32(vmulq_f32(bw, vld1q_f32(anchorWidth)), half);
+                float32x4_t halfHeight = vmulq_f32(vmulq_f32(bh, vld1q_f32(anchorHeight)), half);
+
+                const float32x4_t xScale = vdupq_n_f32(params.xScale);
+                const float32x4_t yScale = vdupq_n_f32(params.yScale);
+                float32x4_t x0 = vmulq_f32(vsubq_f32(bx, halfWidth), xScale);
+                float32x4_t y0 = vmulq_f32(vsubq_f32(by, halfHeight), yScale);
+                float32x4_t x1 = vmulq_f32(vaddq_f32(bx, halfWidth), xScale);
+                float32x4_t y1 = vmulq_f32(vaddq_f32(by, halfHeight), yScale);
+                uint32x4_t ordered = vandq_u32(
+                    vandq_u32(vceqq_f32(x0, x0), vceqq_f32(x1, x1)),
+                    vandq_u32(vceqq_f32(y0, y0), vceqq_f32(y1, y1)));
+
+                const float32x4_t zero = vdupq_n_f32(0.0f);
+                const float32x4_t clipWidth = vdupq_n_f32(params.clipWidth);
+                const float32x4_t clipHeight = vdupq_n_f32(params.clipHeight);
+                x0 = vmaxq_f32(vminq_f32(x0, clipWidth), zero);
+                y0 = vmaxq_f32(vminq_f32(y0, clipHeight), zero);
+                x1 = vmaxq_f32(vminq_f32(x1, clipWidth), zero);
+                y1 = vmaxq_f32(vminq_f32(y1, clipHeight), zero);
+                uint32x4_t nonEmpty = vandq_u32(vcgtq_f32(x1, x0), vcgtq_f32(y1, y0));
+
+                static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+                valid = vaddvq_u32(vandq_u32(vandq_u32(ordered, nonEmpty), vld1q_u32(laneBits)));
+
+                vst1q_f32(xmin, x0);
+                vst1q_f32(ymin, y0);
+                vst1q_f32(xmax, x1);
+                vst1q_f32(ymax, y1);
+#endif
+
+                // Every lane is written, but the output only advances past the valid ones.
+                for (uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    const RawPrediction& pred = predictions[candidates[c + lane].index];
+                    float score = pred.confidence * pred.classMaxProbability;
+                    detections[detectionCount] = { xmin[lane], ymin[lane], xmax[lane], ymax[lane], score, pred.classIndex };
+                    detectionCount += (valid >> lane) & 1;
+                }
+            }
+#endif
+
+            return detectionCount + DecodeCandidatesScalar(predictions, candidates + c, candidateCount - c, params, detections + detectionCount);
+        }
+
+        // The boxes of one class during NMS, stored as separate arrays so that a box can be compared against
+        // several others at once. Boxes that have been selected or suppressed have a score of -infinity.
+        struct ClassBoxes
+        {
+            std::vector<float> xmin;
+            std::vector<float> ymin;
+            std::vector<float> xmax;
+            std::vector<float> ymax;
+            std::vector<float> area;
+            std::vector<float> score;
+            std::vector<uint32_t> detectionIndex;
+
+            void Clear()
+            {
+                xmin.clear();
+                ymin.clear();
+                xmax.clear();
+                ymax.clear();
+                area.clear();
+                score.clear();
+                detectionIndex.clear();
+            }
+
+            void Push(const Detection& box, uint32_t index)
+            {
+                xmin.push_back(box.xmin);
+                ymin.push_back(box.ymin);
+                xmax.push_back(box.xmax);
+                ymax.push_back(box.ymax);
+                area.push_back((box.xmax - box.xmin) * (box.ymax - box.ymin));
+                score.push_back(box.score);
+                detectionIndex.push_back(index);
+            }
+
+            // Drops the boxes that have been selected or suppressed, keeping the remaining boxes in order.
+            void Compact()
+            {
+                size_t remainingCount = 0;
+                for (size_t i = 0; i < score.size(); ++i)
+                {
+                    if (score[i] != -std::numeric_limits<float>::infinity())
+                    {
+                        xmin[remainingCount] = xmin[i];
+                        ymin[remainingCount] = ymin[i];
+                        xmax[remainingCount] = xmax[i];
+                        ymax[remainingCount] = ymax[i];
+                        area[remainingCount] = area[i];
+                        score[remainingCount] = score[i];
+                        detectionIndex[remainingCount] = detectionIndex[i];
+                        ++remainingCount;
+                    }
+                }
+
+                xmin.resize(remainingCount);
+                ymin.resize(remainingCount);
+                xmax.resize(remainingCount);
+                ymax.resize(remainingCount);
+                area.resize(remainingCount);
+                score.resize(remainingCount);
+                detectionIndex.resize(remainingCount);
+            }
+
+            // Removes the boxes in [begin, end) whose intersection over union with the box at the index is above
+            // the threshold, and returns how many were removed.
+            size_t SuppressOverlapsScalar(size_t index, size_t begin, size_t end, float threshold)
+            {
+                size_t suppressedCount = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    if (score[i] == -std::numeric_limits<float>::infinity())
+                    {
+                        continue;
+                    }
+
+                    float intersectionWidth = std::max(0.0f, std::min(xmax[index], xmax[i]) - std::max(xmin[index], xmin[i]));
+                    float intersectionHeight = std::max(0.0f, std::min(ymax[index], ymax[i]) - std::max(ymin[index], ymin[i]));
+                    float intersectionArea = intersectionWidth * intersectionHeight;
+                    float unionArea = area[index] + area[i] - intersectionArea;
+                    if (intersectionArea / unionArea > threshold)
+                    {
+                        score[i] = -std::numeric_limits<float>::infinity();
+                        ++suppressedCount;
+                    }
+                }
+                return suppressedCount;
+            }
+
+            size_t SuppressOverlaps(size_t index, float threshold)
+            {
+                size_t i = 0;
+                size_t suppressedCount = 0;
+                const size_t count = score.size();
+
+#if defined(YOLO_POSTPROCESSING_SSE2)
+                const __m128 boxXMin = _mm_set1_ps(xmin[index]);
+                const __m128 boxYMin = _mm_set1_ps(ymin[index]);
+                const __m128 boxXMax = _mm_set1_ps(xmax[index]);
+                const __m128 boxYMax = _mm_set1_ps(ymax[index]);
+                const __m128 boxArea = _mm_set1_ps(area[index]);
+                const __m128 thresholds = _mm_set1_ps(threshold);
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 removed = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128 scores = _mm_loadu_ps(score.data() + i);
+                    __m128 remaining = _mm_cmpneq_ps(scores, removed);
+                    __m128 intersectionWidth = _mm_max_ps(zero, _mm_sub_ps(
+                        _mm_min_ps(boxXMax, _mm_loadu_ps(xmax.data() + i)),
+                        _mm_max_ps(boxXMin, _mm_loadu_ps(xmin.data() + i))));
+                    __m128 intersectionHeight = _mm_max_ps(zero, _mm_sub_ps(
+                        _mm_min_ps(boxYMax, _mm_loadu_ps(ymax.data() + i)),
+                        _mm_max_ps(boxYMin, _mm_loadu_ps(ymin.data() + i))));
+                    __m128 intersectionArea = _mm_mul_ps(intersectionWidth, intersectionHeight);
+                    __m128 unionArea = _mm_sub_ps(_mm_add_ps(boxArea, _mm_loadu_ps(area.data() + i)), intersectionArea);
+                    __m128 suppressed = _mm_and_ps(remaining, _mm_cmpgt_ps(_mm_div_ps(intersectionArea, unionArea), thresholds));
+                    int mask = _mm_movemask_ps(suppressed);
+                    if (mask != 0)
+                    {
+                        _mm_storeu_ps(score.data() + i, _mm_or_ps(_mm_and_ps(suppressed, removed), _mm_andnot_ps(suppressed, scores)));
+                        suppressedCount += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+                    }
+                }
+#elif defined(YOLO_POSTPROCESSING_NEON)
+                const float32x4_t boxXMin = vdupq_n_f32(xmin[index]);
+                const float32x4_t boxYMin = vdupq_n_f32(ymin[index]);
+                const float32x4_t boxXMax = vdupq_n_f32(xmax[index]);
+                const float32x4_t boxYMax = vdupq_n_f32(ymax[index]);
+                const float32x4_t boxArea = vdupq_n_f32(area[index]);
+                const float32x4_t thresholds = vdupq_n_f32(threshold);
+                const float32x4_t zero = vdupq_n_f32(0.0f);
+                const float32x4_t removed = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+
+                for (; i + 4 <= count; i += 4)
+                {
+                    float32x4_t scores = vld1q_f32(score.data() + i);
+                    uint32x4_t remaining = vmvnq_u32(vceqq_f32(scores, removed));
+                    float32x4_t intersectionWidth = vmaxq_f32(zero, vsubq_f32(
+                        vminq_f32(boxXMax, vld1q_f32(xmax.data() + i)),
+                        vmaxq_f32(boxXMin, vld1q_f32(xmin.data() + i))));
+                    float32x4_t intersectionHeight = vmaxq_f32(zero, vsubq_f32(
+                        vminq_f32(boxYMax, vld1q_f32(ymax.data() + i)),
+                        vmaxq_f32(boxYMin, vld1q_f32(ymin.data() + i))));
+                    float32x4_t intersectionArea = vmulq_f32(intersectionWidth, intersectionHeight);
+                    float32x4_t unionArea = vsubq_f32(vaddq_f32(boxArea, vld1q_f32(area.data() + i)), intersectionArea);
+                    uint32x4_t suppressed = vandq_u32(remaining, vcgtq_f32(vdivq_f32(intersectionArea, unionArea), thresholds));
+                    if (vmaxvq_u32(suppressed) != 0)
+                    {
+                        vst1q_f32(score.data() + i, vbslq_f32(suppressed, removed, scores));
+                        suppressedCount += vaddvq_u32(vshrq_n_u32(suppressed, 31));
+                    }
+                }
+#endif
+
+                return suppressedCount + SuppressOverlapsScalar(index, i, count, threshold);
+            }
+        };
+    }
+
+    // Post-processes the outputs of the model. The scratch memory is kept between calls, so processing a frame
+    // does not allocate once the buffers have grown to fit the largest frame.
+    class PostProcessor
+    {
+    public:
+        // Appends the decoded boxes of one output tensor that score at least the threshold and are not empty after
+        // clipping to the image.
+        void DecodeBoxes(
+            const OutputTensor& tensor,
+            const Options& options,
+            float imageWidth,
+            float imageHeight,
+            std::vector<Detection>& detections)
+        {
+            Detail::DecodeParameters params = {};
+            params.xyScale = tensor.constants.xyScale;
+            params.stride = tensor.constants.stride;
+            params.anchors = tensor.constants.anchors.data();
+            params.xScale = imageWidth / options.inputWidth;
+            params.yScale = imageHeight / options.inputHeight;
+            params.clipWidth = imageWidth;
+            params.clipHeight = imageHeight;
+
+            // Scoring is done for every prediction, but decoding only for the few that pass the threshold.
+            m_candidates.clear();
+            Detail::SelectCandidates(tensor.data, tensor.height, tensor.width, options.scoreThreshold, m_candidates);
+            size_t previousCount = detections.size();
+            detections.resize(previousCount + m_candidates.size());
+            size_t decodedCount = Detail::DecodeCandidates(tensor.data, m_candidates.data(), m_candidates.size(), params, detections.data() + previousCount);
+            detections.resize(previousCount + decodedCount);
+        }
+
+        // Applies the non-maximal suppression (NMS) algorithm to select the "best" of multiple overlapping boxes
+        // of the same class. The selected boxes are returned in order of decreasing score.
+        //
+        // Rather than collecting each class in its own list, the boxes of all classes are sorted by class once,
+        // with a counting sort that keeps boxes of the same class in the order they were decoded. Each class is
+        // then processed as a batch: the highest scoring remaining box is selected, and the remaining boxes that
+        // overlap it are removed several at a time. A class is done as soon as no boxes remain, which is usually
+        // after a few selections since most boxes overlap a better box of the same object.
+        void ApplyNonMaximalSuppression(std::vector<Detection>& detections, float threshold, uint32_t maxDetections)
+        {
+            SortByClass(detections);
+
+            m_selected.clear();
+            for (size_t begin = 0; begin < m_order.size();)
+            {
+                const uint32_t predictedClass = detections[m_order[begin]].predictedClass;
+
+                auto& boxes = m_classBoxes;
+                boxes.Clear();
+
+                size_t end = begin;
+                for (; end < m_order.size() && detections[m_order[end]].predictedClass == predictedClass; ++end)
+                {
+                    boxes.Push(detections[m_order[end]], m_order[end]);
+                }
+
+                for (size_t remainingCount = end - begin; remainingCount > 0;)
+                {
+                    // On equal scores the first box wins, as with std::max_element.
+                    size_t best = static_cast<size_t>(std::max_element(boxes.score.begin(), boxes.score.end()) - boxes.score.begin());
+                    m_selected.push_back(detections[boxes.detectionIndex[best]]);
+                    boxes.score[best] = -std::numeric_limits<float>::infinity();
+                    remainingCount -= 1 + boxes.SuppressOverlaps(best, threshold);
+
+                    // When many boxes of a class are selected (e.g. a crowd), most of the arrays are soon removed
+                    // boxes, so they're dropped rather than scanned again for every selection.
+                    if (remainingCount < boxes.score.size() / 2)
+                    {
+                        boxes.Compact();
+                    }
+                }
+
+                begin = end;
+            }
+
+            // Each class is suppressed independently, so truncating the result is the same as stopping the
+            // selection once maxDetections boxes of any class have been selected in order of score.
+            std::stable_sort(m_selected.begin(), m_selected.end(), [](const Detection& lhs, const Detection& rhs) {
+                return lhs.score > rhs.score;
+            });
+            if (m_selected.size() > maxDetections)
+            {
+                m_selected.resize(maxDetections);
+            }
+
+            detections.assign(m_selected.begin(), m_selected.end());
+        }
+
+        // Decodes the boxes of every output tensor of an image and applies NMS to them.
+        void Process(const ImageOutputs& image, const Options& options, std::vector<Detection>& detections)
+        {
+            detections.clear();
+            for (size_t i = 0; i < image.tensorCount; ++i)
+            {
+                DecodeBoxes(image.tensors[i], options, image.imageWidth, image.imageHeight, detections);
+            }
+
+            ApplyNonMaximalSuppression(detections, options.nmsThreshold, options.maxDetections);
+        }
+
+        // Processes a batch of images; detections[i] receives the boxes of images[i]. The capacity of each image's
+        // result vector is reused across calls.
+        void ProcessBatch(
+            const ImageOutputs* images,
+            size_t imageCount,
+            const Options& options,
+            std::vector<std::vector<Detection>>& detections)
+        {
+            detections.resize(imageCount);
+            for (size_t i = 0; i < imageCount; ++i)
+            {
+                Process(images[i], options, detections[i]);
+            }
+        }
+
+    private:
+        // Fills m_order with the indices of the detections, grouped by class. Within a class, the indices stay in
+        // increasing order.
+        void SortByClass(const std::vector<Detection>& detections)
+        {
+            m_order.resize(detections.size());
+
+            uint32_t maxClass = 0;
+            for (const auto& detection : detections)
+            {
+                maxClass = std::max(maxClass, detection.predictedClass);
+            }
+
+            // Class indices are dense (80 for the COCO classes), but they come from the model's output, so a bad
+            // output cannot make the histogram arbitrarily large.
+            if (maxClass >= std::max<size_t>(detections.size(), 1024))
+            {
+                std::iota(m_order.begin(), m_order.end(), 0);
+                std::stable_sort(m_order.begin(), m_order.end(), [&](uint32_t lhs, uint32_t rhs) {
+                    return detections[lhs].predictedClass < detections[rhs].predictedClass;
+                });
+                return;
+            }
+
+            m_classOffsets.assign(size_t(maxClass) + 1, 0);
+            for (const auto& detection : detections)
+            {
+                m_classOffsets[detection.predictedClass]++;
+            }
+
+            uint32_t offset = 0;
+            for (auto& classOffset : m_classOffsets)
+            {
+                offset += std::exchange(classOffset, offset);
+            }
+
+            for (size_t i = 0; i < detections.size(); ++i)
+            {
+                m_order[m_classOffsets[detections[i].predictedClass]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+    private:
+        std::vector<Detail::Candidate> m_candidates;
+        std::vector<uint32_t> m_classOffsets;
+        std::vector<uint32_t> m_order;
+        Detail::ClassBoxes m_classBoxes;
+        std::vector<Detection> m_selected;
+    };
+}
@@ -0,0 +1,399 @@
+//-----------------------------------------------------------------------------
+//
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+
+// Measures the CPU post-processing of the YOLOv4 sample (DetectionPostProcessing.h) without a GPU. The inputs are
+// output tensors recorded by the sample (press R while it runs), or synthetic tensors when no files are given. Each
+// image is also processed by a scalar reference implementation, which is the sample's original post-processing, to
+// check that both select exactly the same boxes.
+
+#include "../DetectionPostProcessing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+using namespace YoloPostProcessing;
+
+namespace
+{
+    constexpr float c_inputSize = 608;
+    constexpr float c_scoreThreshold = 0.25f;
+    constexpr float c_nmsThreshold = 0.213f;
+    constexpr float c_imageWidth = 1920;
+    constexpr float c_imageHeight = 1080;
+
+    // Same as YoloV4Constants::BBoxData in the sample.
+    const ScaleConstants c_scales[] =
+    {
+        { 1.2f, 8, { 12,16,   19,36,   40,28   } },
+        { 1.1f, 16, { 36,75,   76,55,   72,146  } },
+        { 1.05f, 32, { 142,110, 192,243, 459,401 } },
+    };
+
+    constexpr size_t c_scaleCount = sizeof(c_scales) / sizeof(c_scales[0]);
+
+    uint32_t GetGridSize(size_t scale)
+    {
+        return static_cast<uint32_t>(c_inputSize / c_scales[scale].stride);
+    }
+
+    size_t GetTensorElementCount(size_t scale)
+    {
+        return c_anchorsPerScale * GetGridSize(scale) * GetGridSize(scale);
+    }
+
+    // The outputs of the model for one image, in the order the sample records them (small, medium, large).
+    struct RecordedImage
+    {
+        std::vector<RawPrediction> tensors[c_scaleCount];
+    };
+
+    RecordedImage LoadRecordedImage(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        RecordedImage image;
+        for (size_t scale = 0; scale < c_scaleCount; ++scale)
+        {
+            image.tensors[scale].resize(GetTensorElementCount(scale));
+            file.read(reinterpret_cast<char*>(image.tensors[scale].data()), image.tensors[scale].size() * sizeof(RawPrediction));
+        }
+
+        if (!file)
+        {
+            throw std::runtime_error(path + " is smaller than the three output tensors of the model");
+        }
+        return image;
+    }
+
+    // Generates outputs that resemble a crowded scene: background cells score well below the threshold, and each
+    // object produces a cluster of overlapping, high scoring boxes in neighboring cells of every scale.
+    RecordedImage GenerateSyntheticImage(std::mt19937& rng, uint32_t objectCount)
+    {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        RecordedImage image;
+        for (size_t scale = 0; scale < c_scaleCount; ++scale)
+        {
+            auto& tensor = image.tensors[scale];
+            tensor.resize(GetTensorElementCount(scale));
+            for (auto& pred : tensor)
+            {
+                pred = { unit(rng), unit(rng), unit(rng) * 2, unit(rng) * 2, unit(rng) * 0.1f, 0.3f + unit(rng) * 0.7f, static_cast<uint32_t>(rng() % 80) };
+            }
+        }
+
+        for (uint32_t object = 0; object < objectCount; ++object)
+        {
+            float centerX = unit(rng) * c_inputSize;
+            float centerY = unit(rng) * c_inputSize;
+            float width = 16 + unit(rng) * 200;
+            float height = 16 + unit(rng) * 200;
+            uint32_t classIndex = rng() % 80;
+
+            for (size_t scale = 0; scale < c_scaleCount; ++scale)
+            {
+                const auto& constants = c_scales[scale];
+                uint32_t grid = GetGridSize(scale);
+                int cellX = static_cast<int>(centerX / constants.stride);
+                int cellY = static_cast<int>(centerY / constants.stride);
+                for (uint32_t n = 0; n < c_anchorsPerScale; ++n)
+                {
+                    for (int dy = -1; dy <= 1; ++dy)
+                    {
+                        for (int dx = -1; dx <= 1; ++dx)
+                        {
+                            int x = cellX + dx;
+                            int y = cellY + dy;
+                            if (x < 0 || y < 0 || x >= static_cast<int>(grid) || y >= static_cast<int>(grid))
+                            {
+                                continue;
+                            }
+
+                            auto& pred = image.tensors[scale][(n * grid + y) * grid + x];
+                            pred.bx = (centerX / constants.stride - x - 0.5f) / constants.xyScale + 0.5f + (unit(rng) - 0.5f) * 0.2f;
+                            pred.by = (centerY / constants.stride - y - 0.5f) / constants.xyScale + 0.5f + (unit(rng) - 0.5f) * 0.2f;
+                            pred.bw = width / constants.anchors[n * 2] * (0.9f + unit(rng) * 0.2f);
+                            pred.bh = height / constants.anchors[n * 2 + 1] * (0.9f + unit(rng) * 0.2f);
+                            pred.confidence = 0.3f + unit(rng) * 0.7f;
+                            pred.classMaxProbability = 0.5f + unit(rng) * 0.5f;
+                            pred.classIndex = classIndex;
+                        }
+                    }
+                }
+            }
+        }
+
+        return image;
+    }
+
+    // The sample's original post-processing: decodes every prediction in turn, then repeatedly selects the highest
+    // scoring box of each class and erases the boxes that overlap it.
+    void ReferenceDecodeBoxes(const OutputTensor& tensor, std::vector<Detection>& out)
+    {
+        float xScale = c_imageWidth / c_inputSize;
+        float yScale = c_imageHeight / c_inputSize;
+
+        uint32_t currentPredIndex = 0;
+        for (uint32_t n = 0; n < c_anchorsPerScale; ++n)
+        {
+            for (uint32_t h = 0; h < tensor.height; ++h)
+            {
+                for (uint32_t w = 0; w < tensor.width; ++w)
+                {
+                    const RawPrediction& currentPred = tensor.data[currentPredIndex++];
+
+                    float score = currentPred.confidence * currentPred.classMaxProbability;
+                    if (score < c_scoreThreshold)
+                    {
+                        continue;
+                    }
+
+                    float bx = tensor.constants.xyScale * (currentPred.bx - 0.5f) + 0.5f;
+                    float by = tensor.constants.xyScale * (currentPred.by - 0.5f) + 0.5f;
+                    bx = (bx + (float)w) * tensor.constants.stride;
+                    by = (by + (float)h) * tensor.constants.stride;
+                    float bw = currentPred.bw * tensor.constants.anchors[n * 2];
+                    float bh = currentPred.bh * tensor.constants.anchors[n * 2 + 1];
+
+                    float xmin = std::clamp((bx - bw / 2) * xScale, 0.0f, c_imageWidth);
+                    float ymin = std::clamp((by - bh / 2) * yScale, 0.0f, c_imageHeight);
+                    float xmax = std::clamp((bx + bw / 2) * xScale, 0.0f, c_imageWidth);
+                    float ymax = std::clamp((by + bh / 2) * yScale, 0.0f, c_imageHeight);
+
+                    if (xmax <= xmin || ymax <= ymin || std::isnan(xmin) || std::isnan(ymin) || std::isnan(xmax) || std::isnan(ymax))
+                    {
+                        continue;
+                    }
+
+                    out.push_back({ xmin, ymin, xmax, ymax, score, currentPred.classIndex });
+                }
+            }
+        }
+    }
+
+    float ReferenceIntersectionOverUnion(const Detection& a, const Detection& b)
+    {
+        float aArea = (a.xmax - a.xmin) * (a.ymax - a.ymin);
+        float bArea = (b.xmax - b.xmin) * (b.ymax - b.ymin);
+        float interXMin = std::max(a.xmin, b.xmin);
+        float interYMin = std::max(a.ymin, b.ymin);
+        float interXMax = std::min(a.xmax, b.xmax);
+        float interYMax = std::min(a.ymax, b.ymax);
+        float intersectionArea = std::max(0.0f, interXMax - interXMin) * std::max(0.0f, interYMax - interYMin);
+        float unionArea = aArea + bArea - intersectionArea;
+        return intersectionArea / unionArea;
+    }
+
+    std::vector<Detection> ReferenceNonMaximalSuppression(const std::vector<Detection>& allPredictions, float threshold)
+    {
+        std::unordered_map<uint32_t, std::vector<Detection>> predsByClass;
+        for (const auto& pred : allPredictions)
+        {
+            predsByClass[pred.predictedClass].push_back(pred);
+        }
+
+        std::vector<Detection> selected;
+        for (auto& kvp : predsByClass)
+        {
+            std::vector<Detection>& proposals = kvp.second;
+            while (!proposals.empty())
+            {
+                auto maxIter = std::max_element(proposals.begin(), proposals.end(), [](const Detection& lhs, const Detection& rhs) {
+                    return lhs.score < rhs.score;
+                });
+                selected.push_back(*maxIter);
+                proposals.erase(maxIter);
+
+                for (auto it = proposals.begin(); it != proposals.end();)
+                {
+                    if (ReferenceIntersectionOverUnion(selected.back(), *it) > threshold)
+                    {
+                        it = proposals.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        return selected;
+    }
+
+    void ReferenceProcess(const ImageOutputs& image, std::vector<Detection>& detections)
+    {
+        detections.clear();
+        for (size_t i = 0; i < image.tensorCount; ++i)
+        {
+            ReferenceDecodeBoxes(image.tensors[i], detections);
+        }
+        detections = ReferenceNonMaximalSuppression(detections, c_nmsThreshold);
+    }
+
+    bool SameDetections(std::vector<Detection> a, std::vector<Detection> b)
+    {
+        auto key = [](const Detection& d) { return std::make_tuple(d.score, d.predictedClass, d.xmin, d.ymin, d.xmax, d.ymax); };
+        auto byKey = [&](const Detection& lhs, const Detection& rhs) { return key(lhs) < key(rhs); };
+        std::sort(a.begin(), a.end(), byKey);
+        std::sort(b.begin(), b.end(), byKey);
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [&](const Detection& lhs, const Detection& rhs) {
+            return key(lhs) == key(rhs);
+        });
+    }
+
+    // Returns the mean time of one call of the function, in microseconds.
+    double Measure(uint32_t iterations, const std::function<void()>& function)
+    {
+        function();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            function();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    void PrintUsage()
+    {
+        printf("Usage: PostProcessingBenchmark [--iterations <count>] [--batch <count>] [--objects <count>] [recorded outputs...]\n");
+        printf("  Each recorded outputs file holds the small, medium and large output tensors of one frame, as written\n");
+        printf("  by the yolov4 sample when R is pressed. Without files, <batch> synthetic frames with <objects> objects\n");
+        printf("  each are generated.\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 200;
+    uint32_t batchSize = 8;
+    uint32_t objectCount = 40;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--iterations" || arg == "--batch" || arg == "--objects") && i + 1 < argc)
+        {
+            uint32_t value = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            (arg == "--iterations" ? iterations : arg == "--batch" ? batchSize : objectCount) = std::max(value, 1u);
+        }
+        else if (arg == "--help" || arg == "-?")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    std::vector<RecordedImage> recordedImages;
+    try
+    {
+        for (const auto& path : paths)
+        {
+            recordedImages.push_back(LoadRecordedImage(path));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    if (recordedImages.empty())
+    {
+        std::mt19937 rng(1234);
+        for (uint32_t i = 0; i < batchSize; ++i)
+        {
+            recordedImages.push_back(GenerateSyntheticImage(rng, objectCount));
+        }
+    }
+
+    std::vector<std::array<OutputTensor, c_scaleCount>> tensors(recordedImages.size());
+    std::vector<ImageOutputs> images(recordedImages.size());
+    for (size_t i = 0; i < recordedImages.size(); ++i)
+    {
+        for (size_t scale = 0; scale < c_scaleCount; ++scale)
+        {
+            tensors[i][scale] = { recordedImages[i].tensors[scale].data(), GetGridSize(scale), GetGridSize(scale), c_scales[scale] };
+        }
+        images[i] = { tensors[i].data(), c_scaleCount, c_imageWidth, c_imageHeight };
+    }
+
+    Options options = {};
+    options.inputWidth = c_inputSize;
+    options.inputHeight = c_inputSize;
+    options.scoreThreshold = c_scoreThreshold;
+    options.nmsThreshold = c_nmsThreshold;
+
+    PostProcessor postProcessor;
+    std::vector<std::vector<Detection>> detections;
+    std::vector<Detection> referenceDetections;
+
+    // Check the results before measuring anything.
+    postProcessor.ProcessBatch(images.data(), images.size(), options, detections);
+    size_t candidateCount = 0;
+    size_t detectionCount = 0;
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        std::vector<Detection> decoded;
+        for (const auto& tensor : tensors[i])
+        {
+            postProcessor.DecodeBoxes(tensor, options, c_imageWidth, c_imageHeight, decoded);
+        }
+        candidateCount += decoded.size();
+        detectionCount += detections[i].size();
+
+        ReferenceProcess(images[i], referenceDetections);
+        if (!SameDetections(detections[i], referenceDetections))
+        {
+            fprintf(stderr, "Image %zu: %zu detections differ from the %zu of the reference implementation\n",
+                i, detections[i].size(), referenceDetections.size());
+            return 1;
+        }
+    }
+
+#if defined(YOLO_POSTPROCESSING_SSE2)
+    const char* simd = "SSE2";
+#elif defined(YOLO_POSTPROCESSING_NEON)
+    const char* simd = "NEON";
+#else
+    const char* simd = "none";
+#endif
+
+    printf("%zu image(s) (%s), %zu boxes above the score threshold, %zu after NMS; SIMD: %s\n",
+        images.size(), paths.empty() ? "synthetic" : "recorded", candidateCount, detectionCount, simd);
+
+    double reference = Measure(iterations, [&] {
+        for (const auto& image : images)
+        {
+            ReferenceProcess(image, referenceDetections);
+        }
+    });
+    double batch = Measure(iterations, [&] {
+        postProcessor.ProcessBatch(images.data(), images.size(), options, detections);
+    });
+
+    printf("  reference:  %10.1f us per batch, %8.1f us per image\n", reference, reference / images.size());
+    printf("  ProcessBatch: %8.1f us per batch, %8.1f us per image (%.1fx)\n", batch, batch / images.size(), reference / batch);
+    return 0;
+}
@@ -93,109 +93,6 @@ namespace
         return (a + b - 1) / b;
     }
 
-    // Maps and copies the contents out of a readback heap.
-    template <typename T>
-    std::vector<T> CopyReadbackHeap(ID3D12Resource* readbackHeap)
-    {
-        static_assert(std::is_pod_v<T>);
-
-        uint64_t sizeInBytes = readbackHeap->GetDesc().Width;
-        size_t sizeInElements = static_cast<size_t>(sizeInBytes / sizeof(T));
-
-        void* src;
-        DX::ThrowIfFailed(readbackHeap->Map(0, nullptr, &src));
-
-        std::vector<T> dst(sizeInElements);
-        memcpy(dst.data(), src, sizeInElements * sizeof(T));
-
-        readbackHeap->Unmap(0, nullptr);
-
-        return dst;
-    }
-
-    // Returns true if any of the supplied floats are inf or NaN, false otherwise.
-    static bool IsInfOrNan(dml::Span<const float> vals)
-    {
-        for (float val : vals)
-        {
-            if (std::isinf(val) || std::isnan(val))
-            {
-                return true;
-            }
-        }
-
-        return false;
-    }
-
-    // Given two axis-aligned bounding boxes, computes the area of intersection divided by the area of the union of
-    // the two boxes.
-    static float ComputeIntersectionOverUnion(const Prediction& a, const Prediction& b)
-    {
-        float aArea = (a.xmax - a.xmin) * (a.ymax - a.ymin);
-        float bArea = (b.xmax - b.xmin) * (b.ymax - b.ymin);
-
-        // Determine the bounds of the intersection rectangle
-        float interXMin = std::max(a.xmin, b.xmin);
-        float interYMin = std::max(a.ymin, b.ymin);
-        float interXMax = std::min(a.xmax, b.xmax);
-        float interYMax = std::min(a.ymax, b.ymax);
-
-        float intersectionArea = std::max(0.0f, interXMax - interXMin) * std::max(0.0f, interYMax - interYMin);
-        float unionArea = aArea + bArea - intersectionArea;
-
-        return (intersectionArea / unionArea);
-    }
-
-    // Given a set of predictions, applies the non-maximal suppression (NMS) algorithm to select the "best" of
-    // multiple overlapping predictions.
-    static std::vector<Prediction> ApplyNonMaximalSuppression(dml::Span<const Prediction> allPredictions, float threshold)
-    {
-        std::unordered_map<uint32_t, std::vector<Prediction>> predsByClass;
-        for (const auto& pred : allPredictions)
-        {
-            predsByClass[pred.predictedClass].push_back(pred);
-        }
-
-        std::vector<Prediction> selected;
-
-        for (auto& kvp : predsByClass)
-        {
-            std::vector<Prediction>& proposals = kvp.second;
-
-            while (!proposals.empty())
-            {
-                // Find the proposal with the highest score
-                auto max_iter = std::max_element(proposals.begin(), proposals.end(),
-                    [](const Prediction& lhs, const Prediction& rhs) {
-                        return lhs.score < rhs.score;
-                    });
-
-                // Move it into the "selected" array
-                selected.push_back(*max_iter);
-                proposals.erase(max_iter);
-
-                // Compare this selected prediction with all the remaining propsals. Compute their IOU and remove any
-                // that are greater than the threshold.
-                for (auto it = proposals.begin(); it != proposals.end(); it)
-                {
-                    float iou = ComputeIntersectionOverUnion(selected.back(), *it);
-
-                    if (iou > threshold)
-                    {
-                        // Remove this element
-                        it = proposals.erase(it);
-                    }
-                    else
-                    {
-                        ++it;
-                    }
-                }
-            }
-        }
-
-        return selected;
-    }
-
     // Helper function for fomatting strings. Format(os, a, b, c) is equivalent to os << a << b << c.
     template <typename T>
     std::ostream& Format(std::ostream& os, T&& arg)
@@ -316,126 +213,95 @@ void Sample::Update(DX::StepTimer const& timer)
         }
     }
 
+    if (m_keyboardButtons.IsKeyPressed(Keyboard::R))
+    {
+        m_recordModelOutputs = true;
+    }
+
     PIXEndEvent();
 }
 #pragma endregion
 
-void Sample::GetModelPredictions(
-    const ModelOutput& modelOutput,
-    const YoloV4Constants::BBoxData& constants,
-    std::vector<Prediction>* out)
+void Sample::GetModelPredictions(std::vector<Prediction>* out)
 {
-    // Convenience
-    float xyScale = constants.xyScale;
-    float stride = constants.stride;
-    const auto& anchors = constants.anchors;
-
-    // There are 3 anchors per scale, and each anchor is an (x,y) coordinate, so the anchors array should have 6
-    // values total.
-    assert(anchors.size() == 6);
-
-    // DirectML writes the final output data in NHWC, where the C channel contains the bounding box & probabilities 
-    // for each prediction.
-    const uint32_t predTensorN = modelOutput.desc.sizes[0];
-    const uint32_t predTensorH = modelOutput.desc.sizes[1];
-    const uint32_t predTensorW = modelOutput.desc.sizes[2];
-#if _DEBUG
-    const uint32_t predTensorC = modelOutput.desc.sizes[3];
-#endif
-
-    // YoloV4 predicts 3 boxes per scale, so we expect 3 separate predictions here
-    assert(predTensorN == 3);
-
-    // Width should contain the bounding box x/y/w/h, a confidence score, the probability for max class, and the class index
-    assert(predTensorC == 7);
-
-    struct PotentialPrediction
+    const std::pair<const ModelOutput*, YoloV4Constants::BBoxData> outputs[] =
     {
-        float bx;
-        float by;
-        float bw;
-        float bh;
-        float confidence;
-        float classMaxProbability;
-        uint32_t classIndex;
+        { &m_modelSOutput, YoloV4Constants::BBoxData::Small() },
+        { &m_modelMOutput, YoloV4Constants::BBoxData::Medium() },
+        { &m_modelLOutput, YoloV4Constants::BBoxData::Large() },
     };
 
-    // The output tensor should be large enough to hold the expected number of predictions.
-    assert(predTensorN * predTensorH * predTensorW * sizeof(PotentialPrediction) <= modelOutput.desc.totalTensorSizeInBytes);
-    std::vector<PotentialPrediction> tensorData = CopyReadbackHeap<PotentialPrediction>(modelOutput.readback.Get());
+    // The readback heaps are decoded in place, while they're mapped, rather than copied out first.
+    YoloPostProcessing::OutputTensor tensors[ARRAYSIZE(outputs)] = {};
+    for (size_t i = 0; i < ARRAYSIZE(outputs); ++i)
+    {
+        const ModelOutput& modelOutput = *outputs[i].first;
+
+        // DirectML writes the final output data in NHWC, where the C channel contains the bounding box &
+        // probabilities for each prediction. YoloV4 predicts 3 boxes per scale, so we expect 3 separate predictions
+        // here, and C should contain the bounding box x/y/w/h, a confidence score, the probability for max class,
+        // and the class index.
+        const uint32_t predTensorH = modelOutput.desc.sizes[1];
+        const uint32_t predTensorW = modelOutput.desc.sizes[2];
+        assert(modelOutput.desc.sizes[0] == YoloPostProcessing::c_anchorsPerScale);
+        assert(modelOutput.desc.sizes[3] == 7);
+
+        // The output tensor should be large enough to hold the expected number of predictions.
+        assert(modelOutput.desc.sizes[0] * predTensorH * predTensorW * sizeof(YoloPostProcessing::RawPrediction) <= modelOutput.desc.totalTensorSizeInBytes);
+
+        void* data;
+        DX::ThrowIfFailed(modelOutput.readback->Map(0, nullptr, &data));
+
+        tensors[i].data = static_cast<const YoloPostProcessing::RawPrediction*>(data);
+        tensors[i].height = predTensorH;
+        tensors[i].width = predTensorW;
+        tensors[i].constants = outputs[i].second;
+    }
+
+    if (m_recordModelOutputs)
+    {
+        RecordModelOutputs(tensors, ARRAYSIZE(tensors));
+        m_recordModelOutputs = false;
+    }
 
     // Scale the boxes to be relative to the original image size
     auto viewport = m_deviceResources->GetScreenViewport();
-    float xScale = (float)viewport.Width / YoloV4Constants::c_inputWidth;
-    float yScale = (float)viewport.Height / YoloV4Constants::c_inputHeight;
 
-    uint32_t currentPredIndex = 0;
-    for (uint32_t n = 0; n < predTensorN; ++n)
+    YoloPostProcessing::ImageOutputs image = {};
+    image.tensors = tensors;
+    image.tensorCount = ARRAYSIZE(tensors);
+    image.imageWidth = (float)viewport.Width;
+    image.imageHeight = (float)viewport.Height;
+
+    YoloPostProcessing::Options options = {};
+    options.inputWidth = YoloV4Constants::c_inputWidth;
+    options.inputHeight = YoloV4Constants::c_inputHeight;
+    options.scoreThreshold = YoloV4Constants::c_scoreThreshold;
+    options.nmsThreshold = YoloV4Constants::c_nmsThreshold;
+
+    m_postProcessor.Process(image, options, *out);
+
+    for (const auto& output : outputs)
     {
-        for (uint32_t h = 0; h < predTensorH; ++h)
-        {
-            for (uint32_t w = 0; w < predTensorW; ++w)
-            {
-                const PotentialPrediction& currentPred = tensorData[currentPredIndex++];
-
-                // Discard boxes with low scores
-                float score = currentPred.confidence * currentPred.classMaxProbability;
-                if (score < YoloV4Constants::c_scoreThreshold)
-                {
-                    continue;
-                }
-
-                // We need to do some postprocessing on the raw values before we return them
-
-                // Apply xyScale. Need to apply offsets of half a grid cell here, to ensure the scaling is
-                // centered around zero.
-                float bx = xyScale * (currentPred.bx - 0.5f) + 0.5f;
-                float by = xyScale * (currentPred.by - 0.5f) + 0.5f;
-
-                // Transform the x/y from being relative to the grid cell, to being relative to the whole image
-                bx = (bx + (float)w) * stride;
-                by = (by + (float)h) * stride;
-
-                // Scale the w/h by the supplied anchors
-                float bw = currentPred.bw * anchors[n * 2];
-                float bh = currentPred.bh * anchors[n * 2 + 1];
-
-                // Convert x,y,w,h to xmin,ymin,xmax,ymax
-                float xmin = bx - bw / 2;
-                float ymin = by - bh / 2;
-                float xmax = bx + bw / 2;
-                float ymax = by + bh / 2;
-
-                xmin *= xScale;
-                ymin *= yScale;
-                xmax *= xScale;
-                ymax *= yScale;
-
-                // Clip values out of range
-                xmin = std::clamp(xmin, 0.0f, (float)viewport.Width);
-                ymin = std::clamp(ymin, 0.0f, (float)viewport.Height);
-                xmax = std::clamp(xmax, 0.0f, (float)viewport.Width);
-                ymax = std::clamp(ymax, 0.0f, (float)viewport.Height);
-
-                // Discard invalid boxes
-                if (xmax <= xmin || ymax <= ymin || IsInfOrNan({ xmin, ymin, xmax, ymax }))
-                {
-                    continue;
-                }
-
-                Prediction pred = {};
-                pred.xmin = xmin;
-                pred.ymin = ymin;
-                pred.xmax = xmax;
-                pred.ymax = ymax;
-                pred.score = score;
-                pred.predictedClass = currentPred.classIndex;
-                out->push_back(pred);
-            }
-        }
+        output.first->readback->Unmap(0, nullptr);
     }
 }
 
+void Sample::RecordModelOutputs(const YoloPostProcessing::OutputTensor* tensors, size_t tensorCount)
+{
+    const wchar_t* path = L"RecordedOutputs.bin";
+    std::ofstream file(path, std::ios::binary);
+    for (size_t i = 0; i < tensorCount; ++i)
+    {
+        size_t sizeInBytes = YoloPostProcessing::c_anchorsPerScale * tensors[i].height * tensors[i].width * sizeof(YoloPostProcessing::RawPrediction);
+        file.write(reinterpret_cast<const char*>(tensors[i].data), sizeInBytes);
+    }
+
+    std::wstringstream ss;
+    ss << (file ? L"Recorded model outputs to " : L"Failed to record model outputs to ") << path << L"\n";
+    OutputDebugStringW(ss.str().c_str());
+}
+
 #pragma region Frame Render
 // Draws the scene.
 void Sample::Render()
@@ -505,7 +371,7 @@ void Sample::Render()
 
         const wchar_t* mainLegend = m_ctrlConnected ?
             L"[View] Exit   [X] Play/Pause"
-            : L"ESC - Exit     ENTER - Play/Pause";
+            : L"ESC - Exit     ENTER - Play/Pause     R - Record outputs";
         SimpleMath::Vector2 mainLegendSize = m_legendFont->MeasureString(mainLegend);
         auto mainLegendPos = SimpleMath::Vector2(xCenter - mainLegendSize.x / 2, static_cast<float>(safe.bottom) - m_legendFont->GetLineSpacing());
 
@@ -548,12 +414,7 @@ void Sample::Render()
 
         // Retrieve the predictions from the raw model outputs
         std::vector<Prediction> preds;
-        GetModelPredictions(m_modelSOutput, YoloV4Constants::BBoxData::Small(), &preds);
-        GetModelPredictions(m_modelMOutput, YoloV4Constants::BBoxData::Medium(), &preds);
-        GetModelPredictions(m_modelLOutput, YoloV4Constants::BBoxData::Large(), &preds);
-
-        // Apply NMS to select the best boxes
-        preds = ApplyNonMaximalSuppression(preds, YoloV4Constants::c_nmsThreshold);
+        GetModelPredictions(&preds);
 
         // Print some debug information about the predictions
         if (preds.size() != 0)
@@ -9,6 +9,7 @@
 #include "StepTimer.h"
 #include "MediaEnginePlayer.h"
 #include "WeightData.h"
+#include "DetectionPostProcessing.h"
 
 namespace YoloV4Constants
 {
@@ -41,12 +42,8 @@ namespace YoloV4Constants
 
     // YoloV4 produces bounding boxes on different scales (small, medium, large) and the outputs of the model need
     // to be scaled according to their appropriate constants.
-    struct BBoxData
+    struct BBoxData : YoloPostProcessing::ScaleConstants
     {
-        float xyScale;
-        float stride;
-        std::array<float, 6> anchors;
-
         static BBoxData Small()
         {
             BBoxData data;
@@ -120,16 +117,7 @@ enum class TensorLayout
     NHWC
 };
 
-struct Prediction
-{
-    // Bounding box coordinates
-    float xmin;
-    float ymin;
-    float xmax;
-    float ymax;
-    float score;
-    uint32_t predictedClass;
-};
+using Prediction = YoloPostProcessing::Detection;
 
 // A basic sample implementation that creates a D3D12 device and
 // provides a render loop.
@@ -187,12 +175,12 @@ private:
         dml::TensorDesc                             desc;
     };
 
-    // Given a raw output of the model, retrieves the predictions (a bounding box, detected class, and score) of the
-    // model.
-    void GetModelPredictions(
-        const ModelOutput& modelOutput,
-        const YoloV4Constants::BBoxData& constants,
-        std::vector<Prediction>* out);
+    // Given the raw outputs of the model, retrieves the predictions (a bounding box, detected class, and score) of
+    // the model, after NMS.
+    void GetModelPredictions(std::vector<Prediction>* out);
+
+    // Writes the raw outputs of the model to a file, which PostProcessingBenchmark can replay.
+    void RecordModelOutputs(const YoloPostProcessing::OutputTensor* tensors, size_t tensorCount);
 
     // Device resources
     std::unique_ptr<DX::DeviceResources>            m_deviceResources;
@@ -258,6 +246,10 @@ private:
     ModelOutput                                     m_modelMOutput;
     ModelOutput                                     m_modelLOutput;
 
+    // CPU post-processing of the model outputs
+    YoloPostProcessing::PostProcessor               m_postProcessor;
+    bool                                            m_recordModelOutputs = false;
+
     std::optional<WeightData>                       m_modelWeights;
 
     Microsoft::WRL::ComPtr<ID3D12Resource>          m_modelPersistentResource;